@@ -0,0 +1,167 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if ENABLE_ALLOCATION_COUNTER
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount(0);
+
+    void CountAllocation()
+    {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* CountedAlloc(size_t size)
+    {
+#ifndef __GLIBC__
+        // The C allocation functions are only counted on glibc, where malloc below already does it
+        CountAllocation();
+#endif
+        return malloc(size != 0 ? size : 1);
+    }
+}
+
+#ifdef __GLIBC__
+
+// glibc lets the program replace the C allocation functions too, which also catches those the standard library and
+// C code call directly. Sanitizers replace them as well, so the counter cannot be combined with them.
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) noexcept
+    {
+        CountAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        CountAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size) noexcept
+    {
+        CountAllocation();
+        return __libc_realloc(p, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        CountAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pp, size_t alignment, size_t size) noexcept
+    {
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        {
+            return EINVAL;
+        }
+        CountAllocation();
+        void* p = __libc_memalign(alignment, size);
+        if (p == nullptr)
+        {
+            return ENOMEM;
+        }
+        *pp = p;
+        return 0;
+    }
+}
+
+#endif
+
+uint64_t GetHeapAllocationCount()
+{
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+// Replacements of the global allocation functions, the rest of the forms forward to these
+void* operator new(size_t size)
+{
+    // Like the default one, give the new handler a chance to free memory before failing
+    for (;;)
+    {
+        void* p = CountedAlloc(size);
+        if (p != nullptr)
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+#else
+
+uint64_t GetHeapAllocationCount()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Define ENABLE_ALLOCATION_COUNTER to 1 to replace the global operator new with one that counts its calls, and with
+// glibc malloc and the other C allocation functions too. It costs an atomic increment per allocation on every thread,
+// so only benchmark builds turn it on: the Benchmark configuration of the project (any other one with
+// msbuild /p:EnableAllocationCounter=1) and the headless build line in HeadlessMain.cpp.
+#ifndef ENABLE_ALLOCATION_COUNTER
+#define ENABLE_ALLOCATION_COUNTER 0
+#endif
+
+// Number of global operator new calls, and C allocations with glibc, made on any thread so far.
+// Compare the value before and after a piece of code to check it does not allocate;
+// always zero when the counter is compiled out.
+uint64_t GetHeapAllocationCount();
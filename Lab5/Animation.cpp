@@ -0,0 +1,218 @@
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    void InterpolatePoses(const JointPose& a, const JointPose& b, float factor, JointPose& result)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            result.translation[i] = a.translation[i] + (b.translation[i] - a.translation[i]) * factor;
+            result.scale[i] = a.scale[i] + (b.scale[i] - a.scale[i]) * factor;
+        }
+
+        // q and -q are the same rotation, blending towards the closer one takes the shorter arc
+        float dot = a.rotation[0] * b.rotation[0] + a.rotation[1] * b.rotation[1] + a.rotation[2] * b.rotation[2] +
+            a.rotation[3] * b.rotation[3];
+        float weightB = dot < 0.0f ? -factor : factor;
+        float weightA = 1.0f - factor;
+        float lengthSquared = 0.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            result.rotation[i] = a.rotation[i] * weightA + b.rotation[i] * weightB;
+            lengthSquared += result.rotation[i] * result.rotation[i];
+        }
+        float scale = lengthSquared > 0.0f ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            result.rotation[i] *= scale;
+        }
+    }
+
+    void SampleTrack(const AnimationTrack& track, float time, JointPose& pose)
+    {
+        size_t keyCount = std::min(track.times.size(), track.poses.size());
+        if (keyCount == 1 || time <= track.times[0])
+        {
+            pose = track.poses[0];
+            return;
+        }
+        if (time >= track.times[keyCount - 1])
+        {
+            pose = track.poses[keyCount - 1];
+            return;
+        }
+
+        // First key after time, the one before it exists because time is past the first key
+        size_t next = std::upper_bound(track.times.begin(), track.times.begin() + keyCount, time) - track.times.begin();
+        float start = track.times[next - 1];
+        float length = track.times[next] - start;
+        float factor = length > 0.0f ? (time - start) / length : 0.0f;
+        InterpolatePoses(track.poses[next - 1], track.poses[next], factor, pose);
+    }
+}
+
+void SetIdentity(JointMatrix& matrix)
+{
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            matrix.columns[column][row] = column == row ? 1.0f : 0.0f;
+        }
+    }
+}
+
+void GetPoseMatrix(const JointPose& pose, JointMatrix& matrix)
+{
+    float x = pose.rotation[0];
+    float y = pose.rotation[1];
+    float z = pose.rotation[2];
+    float w = pose.rotation[3];
+
+    matrix.columns[0][0] = (1.0f - 2.0f * (y * y + z * z)) * pose.scale[0];
+    matrix.columns[0][1] = 2.0f * (x * y + w * z) * pose.scale[0];
+    matrix.columns[0][2] = 2.0f * (x * z - w * y) * pose.scale[0];
+    matrix.columns[0][3] = 0.0f;
+
+    matrix.columns[1][0] = 2.0f * (x * y - w * z) * pose.scale[1];
+    matrix.columns[1][1] = (1.0f - 2.0f * (x * x + z * z)) * pose.scale[1];
+    matrix.columns[1][2] = 2.0f * (y * z + w * x) * pose.scale[1];
+    matrix.columns[1][3] = 0.0f;
+
+    matrix.columns[2][0] = 2.0f * (x * z + w * y) * pose.scale[2];
+    matrix.columns[2][1] = 2.0f * (y * z - w * x) * pose.scale[2];
+    matrix.columns[2][2] = (1.0f - 2.0f * (x * x + y * y)) * pose.scale[2];
+    matrix.columns[2][3] = 0.0f;
+
+    matrix.columns[3][0] = pose.translation[0];
+    matrix.columns[3][1] = pose.translation[1];
+    matrix.columns[3][2] = pose.translation[2];
+    matrix.columns[3][3] = 1.0f;
+}
+
+void MultiplyJointMatrices(const JointMatrix& a, const JointMatrix& b, JointMatrix& result)
+{
+    JointMatrix product;
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            product.columns[column][row] = a.columns[0][row] * b.columns[column][0] +
+                a.columns[1][row] * b.columns[column][1] + a.columns[2][row] * b.columns[column][2] +
+                a.columns[3][row] * b.columns[column][3];
+        }
+    }
+    result = product;
+}
+
+bool InvertJointMatrix(const JointMatrix& matrix, JointMatrix& result)
+{
+    const float* c0 = matrix.columns[0];
+    const float* c1 = matrix.columns[1];
+    const float* c2 = matrix.columns[2];
+
+    // Rows of the inverse are the cross products of column pairs divided by the determinant
+    float r0[3] = { c1[1] * c2[2] - c1[2] * c2[1], c1[2] * c2[0] - c1[0] * c2[2], c1[0] * c2[1] - c1[1] * c2[0] };
+    float r1[3] = { c2[1] * c0[2] - c2[2] * c0[1], c2[2] * c0[0] - c2[0] * c0[2], c2[0] * c0[1] - c2[1] * c0[0] };
+    float r2[3] = { c0[1] * c1[2] - c0[2] * c1[1], c0[2] * c1[0] - c0[0] * c1[2], c0[0] * c1[1] - c0[1] * c1[0] };
+    float determinant = c0[0] * r0[0] + c0[1] * r0[1] + c0[2] * r0[2];
+    if (determinant == 0.0f)
+    {
+        return false;
+    }
+
+    float scale = 1.0f / determinant;
+    const float* translation = matrix.columns[3];
+    JointMatrix inverse;
+    for (int column = 0; column < 3; column++)
+    {
+        inverse.columns[column][0] = r0[column] * scale;
+        inverse.columns[column][1] = r1[column] * scale;
+        inverse.columns[column][2] = r2[column] * scale;
+        inverse.columns[column][3] = 0.0f;
+    }
+    for (int row = 0; row < 3; row++)
+    {
+        inverse.columns[3][row] = -(inverse.columns[0][row] * translation[0] + inverse.columns[1][row] * translation[1] +
+            inverse.columns[2][row] * translation[2]);
+    }
+    inverse.columns[3][3] = 1.0f;
+    result = inverse;
+    return true;
+}
+
+bool Skeleton::Finalize()
+{
+    size_t jointCount = parents.size();
+    if (bindPose.size() != jointCount)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        if (parents[i] >= int32_t(i) || parents[i] < -1)
+        {
+            return false;
+        }
+    }
+
+    std::vector<JointMatrix> globals(jointCount);
+    inverseBindMatrices.resize(jointCount);
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        GetPoseMatrix(bindPose[i], globals[i]);
+        if (parents[i] >= 0)
+        {
+            MultiplyJointMatrices(globals[parents[i]], globals[i], globals[i]);
+        }
+        if (!InvertJointMatrix(globals[i], inverseBindMatrices[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SampleClip(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* pPoses)
+{
+    if (clip.duration > 0.0f)
+    {
+        time = fmodf(time, clip.duration);
+        if (time < 0.0f)
+        {
+            time += clip.duration;
+        }
+    }
+
+    size_t jointCount = skeleton.GetJointCount();
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        if (i < clip.tracks.size() && !clip.tracks[i].times.empty() && !clip.tracks[i].poses.empty())
+        {
+            SampleTrack(clip.tracks[i], time, pPoses[i]);
+        }
+        else
+        {
+            pPoses[i] = skeleton.bindPose[i];
+        }
+    }
+}
+
+void ComputeSkinningPalette(const Skeleton& skeleton, const JointPose* pPoses, JointMatrix* pGlobals,
+    JointMatrix* pPalette)
+{
+    size_t jointCount = skeleton.GetJointCount();
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        GetPoseMatrix(pPoses[i], pGlobals[i]);
+        int32_t parent = skeleton.parents[i];
+        if (parent >= 0)
+        {
+            MultiplyJointMatrices(pGlobals[parent], pGlobals[i], pGlobals[i]);
+        }
+        MultiplyJointMatrices(pGlobals[i], skeleton.inverseBindMatrices[i], pPalette[i]);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Local transform of a joint relative to its parent
+struct JointPose
+{
+    // Unit quaternion xyzw
+    float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float translation[3] = { 0.0f, 0.0f, 0.0f };
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+// Affine 4x4 matrix stored by columns, transforms column vectors: p' = columns[0] * x + columns[1] * y +
+// columns[2] * z + columns[3]. Aligned so the skinning kernels load a column per instruction.
+struct alignas(16) JointMatrix
+{
+    float columns[4][4];
+};
+
+void SetIdentity(JointMatrix& matrix);
+void GetPoseMatrix(const JointPose& pose, JointMatrix& matrix);
+// result = a * b, result may alias either input
+void MultiplyJointMatrices(const JointMatrix& a, const JointMatrix& b, JointMatrix& result);
+// Inverse of the upper 3x3 and translation, returns false if the matrix is singular
+bool InvertJointMatrix(const JointMatrix& matrix, JointMatrix& result);
+
+// Joints are stored parents first, so the global transforms can be computed in a single forward pass
+struct Skeleton
+{
+    // Index of the parent of each joint, -1 for roots
+    std::vector<int32_t> parents;
+    std::vector<JointPose> bindPose;
+    // Model space to joint space in the bind pose
+    std::vector<JointMatrix> inverseBindMatrices;
+
+    size_t GetJointCount() const { return parents.size(); }
+    // Validates the hierarchy order and fills inverseBindMatrices from the bind pose
+    bool Finalize();
+};
+
+// Keyframes of a single joint, times ascending and in seconds
+struct AnimationTrack
+{
+    std::vector<float> times;
+    std::vector<JointPose> poses;
+};
+
+// One track per joint, joints with an empty track stay in the bind pose
+struct AnimationClip
+{
+    float duration = 0.0f;
+    std::vector<AnimationTrack> tracks;
+};
+
+// Local poses of every joint at time, wrapped into the clip duration. Keys are found by binary search, translation
+// and scale interpolate linearly and rotation with a normalized lerp along the shorter arc.
+void SampleClip(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* pPoses);
+
+// Skinning matrices: the global transform of each joint times its inverse bind matrix. pGlobals is scratch space of
+// one matrix per joint; nothing is allocated, so it can run per character per frame.
+void ComputeSkinningPalette(const Skeleton& skeleton, const JointPose* pPoses, JointMatrix* pGlobals,
+    JointMatrix* pPalette);
@@ -0,0 +1,314 @@
+#include "Benchmark.h"
+#include "HeadlessScene.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "utils.h"
+#include "Profiler.h"
+#include "AllocationCounter.h"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+
+namespace
+{
+    struct FrameRecord
+    {
+        double updateTime = 0.0;
+        double renderTime = 0.0;
+        // Global operator new calls made while updating and rendering the frame
+        uint64_t heapAllocations = 0;
+        RenderStats stats;
+    };
+
+    const wchar_t* GetBackendName(RENDER_BACKEND backend)
+    {
+        switch (backend)
+        {
+        case RENDER_BACKEND::HARDWARE:
+            return L"hardware";
+        case RENDER_BACKEND::WARP:
+            return L"warp";
+        case RENDER_BACKEND::NULL_DEVICE:
+            return L"null";
+        default:
+            return L"unknown";
+        }
+    }
+
+    const wchar_t* GetTransparencyModeName(TRANSPARENCY_MODE mode)
+    {
+        switch (mode)
+        {
+        case TRANSPARENCY_MODE::SORTED:
+            return L"sorted";
+        case TRANSPARENCY_MODE::WEIGHTED_BLENDED:
+            return L"oit";
+        default:
+            return L"unknown";
+        }
+    }
+
+    double Percentile(std::vector<double> values, double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        size_t idx = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return values[idx];
+    }
+
+    double Mean(const std::vector<double>& values)
+    {
+        double sum = 0.0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        return values.empty() ? 0.0 : sum / values.size();
+    }
+
+    bool WriteJsonReport(FILE* pFile, const AppOptions& options, size_t objectCount, double zoneOverhead, const std::vector<FrameRecord>& frames)
+    {
+        std::vector<double> frameTimes;
+        std::vector<double> updateTimes;
+        double drawCalls = 0.0;
+        double primitives = 0.0;
+        uint64_t heapAllocations = 0;
+        uint64_t maxHeapAllocations = 0;
+        double bytesUploaded = 0.0;
+        frameTimes.reserve(frames.size());
+        updateTimes.reserve(frames.size());
+        for (const FrameRecord& frame : frames)
+        {
+            frameTimes.push_back((frame.updateTime + frame.renderTime) * 1000.0);
+            updateTimes.push_back(frame.updateTime * 1000.0);
+            PassStats total = frame.stats.GetTotal();
+            drawCalls += total.drawCalls;
+            primitives += static_cast<double>(total.primitives);
+            bytesUploaded += static_cast<double>(total.bytesUploaded);
+            heapAllocations += frame.heapAllocations;
+            maxHeapAllocations = max(maxHeapAllocations, frame.heapAllocations);
+        }
+        double count = frames.empty() ? 1.0 : static_cast<double>(frames.size());
+
+        fprintf(pFile, "{\n");
+        fprintf(pFile, "  \"frames\": %zu,\n", frames.size());
+        fprintf(pFile, "  \"objects\": %zu,\n", objectCount);
+        fprintf(pFile, "  \"width\": %u,\n", options.width);
+        fprintf(pFile, "  \"height\": %u,\n", options.height);
+        fprintf(pFile, "  \"backend\": \"%ls\",\n", GetBackendName(options.backend));
+        fprintf(pFile, "  \"transparency\": \"%ls\",\n", GetTransparencyModeName(options.transparencyMode));
+        fprintf(pFile, "  \"vertexFormat\": \"%ls\",\n", options.vertexPrecision == VERTEX_PRECISION::COMPACT ? L"compact" : L"float");
+        fprintf(pFile, "  \"cpuFrameTimeMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            Mean(frameTimes), Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.9), Percentile(frameTimes, 0.99), Percentile(frameTimes, 1.0));
+        fprintf(pFile, "  \"updateTimeMs\": { \"mean\": %.4f, \"p99\": %.4f },\n", Mean(updateTimes), Percentile(updateTimes, 0.99));
+        fprintf(pFile, "  \"drawCallsPerFrame\": %.2f,\n", drawCalls / count);
+        fprintf(pFile, "  \"primitivesPerFrame\": %.2f,\n", primitives / count);
+        fprintf(pFile, "  \"bytesUploadedPerFrame\": %.2f,\n", bytesUploaded / count);
+        fprintf(pFile, "  \"heapAllocationsPerFrame\": { \"mean\": %.2f, \"max\": %llu },\n",
+            heapAllocations / count, static_cast<unsigned long long>(maxHeapAllocations));
+        if (zoneOverhead > 0.0)
+        {
+            fprintf(pFile, "  \"profilerZoneOverheadNs\": %.2f,\n", zoneOverhead);
+        }
+        fprintf(pFile, "  \"passes\": {\n");
+        for (size_t passIdx = 0; passIdx < RenderStats::PassCount; passIdx++)
+        {
+            std::vector<double> passTimes;
+            passTimes.reserve(frames.size());
+            double passDrawCalls = 0.0;
+            double passPrimitives = 0.0;
+            double passBytes = 0.0;
+            double passBinds = 0.0;
+            double passCulled = 0.0;
+            for (const FrameRecord& frame : frames)
+            {
+                const PassStats& stats = frame.stats.passes[passIdx];
+                passTimes.push_back(stats.cpuTime * 1000.0);
+                passDrawCalls += stats.drawCalls;
+                passPrimitives += static_cast<double>(stats.primitives);
+                passBytes += static_cast<double>(stats.bytesUploaded);
+                passBinds += stats.shaderBinds + stats.stateBinds + stats.resourceBinds;
+                passCulled += stats.culledObjects;
+            }
+            fprintf(pFile, "    \"%s\": { \"cpuTimeMs\": %.4f, \"cpuTimeP99Ms\": %.4f, \"drawCalls\": %.2f, \"primitives\": %.2f, "
+                "\"bytesUploaded\": %.2f, \"binds\": %.2f, \"culledObjects\": %.2f }%s\n",
+                GetRenderPassName(static_cast<RENDER_PASS>(passIdx)), Mean(passTimes), Percentile(passTimes, 0.99),
+                passDrawCalls / count, passPrimitives / count, passBytes / count, passBinds / count, passCulled / count,
+                passIdx + 1 < RenderStats::PassCount ? "," : "");
+        }
+        fprintf(pFile, "  }\n");
+        fprintf(pFile, "}\n");
+        return ferror(pFile) == 0;
+    }
+
+    bool WriteCsvReport(FILE* pFile, const std::vector<FrameRecord>& frames)
+    {
+        fprintf(pFile, "frame,cpu_frame_ms,update_ms,render_ms,draw_calls,primitives,bytes_uploaded,culled_objects,heap_allocations");
+        for (size_t passIdx = 0; passIdx < RenderStats::PassCount; passIdx++)
+        {
+            fprintf(pFile, ",%s_ms", GetRenderPassName(static_cast<RENDER_PASS>(passIdx)));
+        }
+        fprintf(pFile, "\n");
+
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            const FrameRecord& frame = frames[i];
+            PassStats total = frame.stats.GetTotal();
+            fprintf(pFile, "%zu,%.4f,%.4f,%.4f,%u,%llu,%llu,%u,%llu", i, (frame.updateTime + frame.renderTime) * 1000.0,
+                frame.updateTime * 1000.0, frame.renderTime * 1000.0, total.drawCalls, static_cast<unsigned long long>(total.primitives),
+                static_cast<unsigned long long>(total.bytesUploaded), total.culledObjects,
+                static_cast<unsigned long long>(frame.heapAllocations));
+            for (size_t passIdx = 0; passIdx < RenderStats::PassCount; passIdx++)
+            {
+                fprintf(pFile, ",%.4f", frame.stats.passes[passIdx].cpuTime * 1000.0);
+            }
+            fprintf(pFile, "\n");
+        }
+        return ferror(pFile) == 0;
+    }
+}
+
+int RunBenchmark(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const double SimulationStep = 1. / 60;
+    const size_t WarmupFrames = 10;
+
+    double zoneOverhead = Profiler::MeasureZoneOverhead(1000000);
+
+    std::unique_ptr<Scene> pScene = std::make_unique<Scene>();
+    pScene->SetTransparentObjectCount(options.objectCount);
+
+    std::unique_ptr<Renderer> pRenderer = std::make_unique<Renderer>();
+    pRenderer->SetTransparencyMode(options.transparencyMode);
+    pRenderer->SetVertexPrecision(options.vertexPrecision);
+    pRenderer->SetModelPath(options.modelPath);
+    if (!pRenderer->InitHeadless(options.width, options.height, options.backend))
+    {
+        pRenderer->Term();
+        wprintf(L"Failed to initialize the %s backend\n", GetBackendName(options.backend));
+        return 1;
+    }
+
+    std::vector<FrameRecord> frames;
+    frames.reserve(options.benchmarkFrames);
+    std::vector<InputEvent> events;
+    SceneSnapshot snapshot;
+
+    bool result = true;
+    for (size_t frame = 0; frame < WarmupFrames + options.benchmarkFrames && result; frame++)
+    {
+        PROFILE_SCOPE("BenchmarkFrame");
+
+        GenerateBenchmarkInput(frame, WarmupFrames + options.benchmarkFrames, events);
+        for (const InputEvent& event : events)
+        {
+            pScene->PostInput(event);
+        }
+
+        uint64_t allocationsBefore = GetHeapAllocationCount();
+        Clock::time_point start = Clock::now();
+        pScene->Update(SimulationStep);
+        pScene->GetSnapshot(snapshot);
+        Clock::time_point updated = Clock::now();
+        result = pRenderer->Render(snapshot.state);
+        Clock::time_point rendered = Clock::now();
+        uint64_t allocationsAfter = GetHeapAllocationCount();
+
+        if (frame >= WarmupFrames)
+        {
+            FrameRecord record;
+            record.updateTime = std::chrono::duration<double>(updated - start).count();
+            record.renderTime = std::chrono::duration<double>(rendered - updated).count();
+            record.heapAllocations = allocationsAfter - allocationsBefore;
+            record.stats = pRenderer->GetStats();
+            frames.push_back(record);
+        }
+    }
+    if (!options.statsPath.empty() && !pRenderer->WriteStatsHistory(options.statsPath))
+    {
+        wprintf(L"Failed to write render stats to %s\n", options.statsPath.c_str());
+    }
+    pRenderer->Term();
+
+    if (!result)
+    {
+        wprintf(L"Rendering failed after %zu frames\n", frames.size());
+        return 1;
+    }
+
+    if (!options.reportPath.empty())
+    {
+        FILE* pFile = nullptr;
+        _wfopen_s(&pFile, options.reportPath.c_str(), L"w");
+        if (pFile == nullptr)
+        {
+            wprintf(L"Failed to open report file %s\n", options.reportPath.c_str());
+            return 1;
+        }
+        std::wstring extension = Extension(options.reportPath);
+        std::transform(extension.begin(), extension.end(), extension.begin(), towlower);
+        bool written = extension == L"json" ? WriteJsonReport(pFile, options, pScene->GetTransparentObjects().size(), zoneOverhead, frames) : WriteCsvReport(pFile, frames);
+        fclose(pFile);
+        if (!written)
+        {
+            return 1;
+        }
+    }
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frames.size());
+    size_t allocatingFrames = 0;
+    for (const FrameRecord& frame : frames)
+    {
+        frameTimes.push_back((frame.updateTime + frame.renderTime) * 1000.0);
+        allocatingFrames += frame.heapAllocations != 0 ? 1 : 0;
+    }
+    wprintf(L"%zu frames, %s backend, %zu objects, %s transparency: CPU frame time p50 %.3f ms, p99 %.3f ms\n",
+        frames.size(), GetBackendName(options.backend), pScene->GetTransparentObjects().size(), GetTransparencyModeName(options.transparencyMode),
+        Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.99));
+    if (zoneOverhead > 0.0)
+    {
+        wprintf(L"Profiler zone overhead %.1f ns\n", zoneOverhead);
+    }
+
+#if !ENABLE_ALLOCATION_COUNTER
+    wprintf(L"Heap allocations per frame were not checked, use the Benchmark configuration or ENABLE_ALLOCATION_COUNTER=1 to check them\n");
+#endif
+
+    // Steady state frames must not touch the heap, the profiler is the only expected exception
+    if (allocatingFrames != 0 && !Profiler::IsCapturing())
+    {
+        wprintf(L"FAILED: %zu of %zu frames performed heap allocations\n", allocatingFrames, frames.size());
+        return 2;
+    }
+    return 0;
+}
+
+int RunPacingTest(const AppOptions& options)
+{
+    if (options.targetFrameRate <= 0.0)
+    {
+        wprintf(L"The pacing test needs a target frame rate\n");
+        return 1;
+    }
+
+    PacingAccuracy accuracy;
+    MeasurePacingAccuracy(options.targetFrameRate, options.spinTimeMs / 1000.0, options.benchmarkFrames, accuracy);
+    wprintf(L"%zu frames at %.1f FPS, %.2f ms spin: lateness p50 %.3f ms, p99 %.3f ms, max %.3f ms, %zu deadlines missed\n",
+        accuracy.frameCount, options.targetFrameRate, options.spinTimeMs, accuracy.p50Lateness * 1000.0,
+        accuracy.p99Lateness * 1000.0, accuracy.maxLateness * 1000.0, accuracy.missedDeadlines);
+
+    if (accuracy.p99Lateness * 1000.0 > options.maxLatenessMs || accuracy.missedDeadlines * 100 > accuracy.frameCount)
+    {
+        wprintf(L"FAILED: pacing is outside the bounds of %.3f ms p99 lateness and 1%% missed deadlines\n",
+            options.maxLatenessMs);
+        return 2;
+    }
+    return 0;
+}
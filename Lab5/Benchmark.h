@@ -0,0 +1,10 @@
+#pragma once
+
+#include "CommandLine.h"
+
+// Renders a scripted camera path offscreen for a fixed number of frames and writes a report
+int RunBenchmark(const AppOptions& options);
+
+// Paces options.benchmarkFrames empty frames at options.targetFrameRate and prints how late the waits return.
+// Returns 2 if the p99 lateness exceeds options.maxLatenessMs or more than 1% of the deadlines are missed.
+int RunPacingTest(const AppOptions& options);
@@ -0,0 +1,791 @@
+#include "BufferCodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSSE3_FUNCTION
+#else
+#define SSSE3_FUNCTION __attribute__((target("ssse3")))
+#endif
+
+namespace
+{
+    // First byte of an encoded buffer, the low nibble is the format version
+    const uint8_t IndexCodecHeader = 0xE0;
+    const uint8_t VertexCodecHeader = 0xA0;
+
+    const uint32_t FifoSize = 16;
+    // Code nibble values: 0 is the next new vertex, 1 to 14 the vertex FIFO, 15 an explicit delta or no shared edge
+    const uint32_t EdgeFifoReferences = 15;
+    const uint32_t VertexFifoReferences = 14;
+    const uint8_t NextVertexCode = 0;
+    const uint8_t ExplicitVertexCode = 15;
+    const uint8_t NoEdgeCode = 15;
+    // Worst case bytes of a triangle: the code and three explicit references of a varint each
+    const size_t MaxVarintBytes = 5;
+    const size_t MaxTriangleBytes = 1 + 3 * (1 + MaxVarintBytes);
+
+    const size_t VertexBlockMaxBytes = 8192;
+    const size_t VertexBlockMaxVertices = 256;
+    const size_t VertexGroupSize = 16;
+    const size_t MaxVertexSize = 256;
+    // Bits per delta for each 2-bit group header
+    const uint32_t GroupBits[4] = { 0, 2, 4, 8 };
+
+    // Edges are stored the way the triangle on their other side walks them, so a match continues its winding
+    struct IndexCodecState
+    {
+        uint32_t edges[FifoSize][2] = {};
+        uint32_t vertices[FifoSize] = {};
+        uint32_t edgeOffset = 0;
+        uint32_t vertexOffset = 0;
+        // Lowest vertex not referenced yet, assuming vertices are numbered in first use order
+        uint32_t next = 0;
+        // Last explicitly referenced vertex, the base of the next delta
+        uint32_t last = 0;
+
+        void PushEdge(uint32_t a, uint32_t b)
+        {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) % FifoSize;
+        }
+
+        void PushVertex(uint32_t vertex)
+        {
+            vertices[vertexOffset] = vertex;
+            vertexOffset = (vertexOffset + 1) % FifoSize;
+        }
+
+        // 0 is the most recent entry
+        const uint32_t* GetEdge(uint32_t i) const { return edges[(edgeOffset - 1 - i) % FifoSize]; }
+        uint32_t GetVertex(uint32_t i) const { return vertices[(vertexOffset - 1 - i) % FifoSize]; }
+    };
+
+    uint32_t ZigZag(uint32_t delta)
+    {
+        return (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+    }
+
+    uint32_t UnZigZag(uint32_t value)
+    {
+        return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    void WriteVarint(std::vector<uint8_t>& buffer, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool ReadVarint(const uint8_t*& pData, const uint8_t* pEnd, uint32_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; shift < 7 * MaxVarintBytes && pData != pEnd; shift += 7)
+        {
+            uint8_t byte = *pData++;
+            value |= uint32_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Explicit deltas go to the end of buffer
+    uint8_t EncodeVertexReference(IndexCodecState& state, uint32_t vertex, std::vector<uint8_t>& buffer)
+    {
+        if (vertex == state.next)
+        {
+            state.next++;
+            state.PushVertex(vertex);
+            return NextVertexCode;
+        }
+        for (uint32_t i = 0; i < VertexFifoReferences; i++)
+        {
+            if (state.GetVertex(i) == vertex)
+            {
+                return static_cast<uint8_t>(i + 1);
+            }
+        }
+        WriteVarint(buffer, ZigZag(vertex - state.last));
+        state.last = vertex;
+        state.PushVertex(vertex);
+        return ExplicitVertexCode;
+    }
+
+    bool DecodeVertexReference(IndexCodecState& state, uint32_t code, const uint8_t*& pData, const uint8_t* pEnd,
+        uint32_t& vertex)
+    {
+        if (code == NextVertexCode)
+        {
+            vertex = state.next++;
+            state.PushVertex(vertex);
+        }
+        else if (code != ExplicitVertexCode)
+        {
+            vertex = state.GetVertex(code - 1);
+        }
+        else
+        {
+            uint32_t delta;
+            if (!ReadVarint(pData, pEnd, delta))
+            {
+                return false;
+            }
+            vertex = state.last + UnZigZag(delta);
+            state.last = vertex;
+            state.PushVertex(vertex);
+        }
+        return true;
+    }
+
+    template <typename Index>
+    bool DecodeIndices(Index* pIndices, size_t triangleCount, const uint8_t* pCodes, const uint8_t* pData,
+        const uint8_t* pEnd)
+    {
+        IndexCodecState state;
+        for (size_t i = 0; i < triangleCount; i++)
+        {
+            uint8_t code = pCodes[i];
+            uint32_t edge = code >> 4;
+            uint32_t a, b, c;
+            if (edge != NoEdgeCode)
+            {
+                const uint32_t* pEdge = state.GetEdge(edge);
+                a = pEdge[0];
+                b = pEdge[1];
+                uint32_t vertexCode = code & 15;
+                if (vertexCode != ExplicitVertexCode)
+                {
+                    // New and reused vertices mix unpredictably, so both are resolved without a branch: a new one
+                    // always lands in the slot after the newest FIFO entry, which only advances when it was new
+                    uint32_t isNext = vertexCode == NextVertexCode;
+                    c = isNext ? state.next : state.GetVertex(vertexCode - 1);
+                    state.next += isNext;
+                    state.vertices[state.vertexOffset] = c;
+                    state.vertexOffset = (state.vertexOffset + isNext) % FifoSize;
+                }
+                else if (!DecodeVertexReference(state, vertexCode, pData, pEnd, c))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                uint32_t* corners[3] = { &a, &b, &c };
+                for (uint32_t* pCorner : corners)
+                {
+                    if (pData == pEnd)
+                    {
+                        return false;
+                    }
+                    uint8_t reference = *pData++;
+                    if (!DecodeVertexReference(state, reference & 15, pData, pEnd, *pCorner))
+                    {
+                        return false;
+                    }
+                }
+                state.PushEdge(b, a);
+            }
+            state.PushEdge(c, b);
+            state.PushEdge(a, c);
+
+            pIndices[3 * i + 0] = static_cast<Index>(a);
+            pIndices[3 * i + 1] = static_cast<Index>(b);
+            pIndices[3 * i + 2] = static_cast<Index>(c);
+        }
+        return pData == pEnd;
+    }
+
+    bool IsVertexSizeSupported(size_t vertexSize)
+    {
+        return vertexSize > 0 && vertexSize % 4 == 0 && vertexSize <= MaxVertexSize;
+    }
+
+    // Whole groups of vertices that fit the block budget
+    size_t GetVertexBlockSize(size_t vertexSize)
+    {
+        return std::min(VertexBlockMaxBytes / vertexSize / VertexGroupSize * VertexGroupSize, VertexBlockMaxVertices);
+    }
+
+    uint8_t ZigZag8(uint8_t delta)
+    {
+        return static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7));
+    }
+
+    uint8_t UnZigZag8(uint8_t value)
+    {
+        return static_cast<uint8_t>((value >> 1) ^ (0 - (value & 1)));
+    }
+
+    // Packed bytes plus escapes, SIZE_MAX if the group does not fit
+    size_t GetGroupBytes(const uint8_t* pDeltas, uint32_t bits)
+    {
+        if (bits == 0)
+        {
+            return std::all_of(pDeltas, pDeltas + VertexGroupSize, [](uint8_t delta) { return delta == 0; }) ? 0 : SIZE_MAX;
+        }
+        if (bits == 8)
+        {
+            return VertexGroupSize;
+        }
+        uint8_t escape = static_cast<uint8_t>((1 << bits) - 1);
+        return VertexGroupSize * bits / 8 + std::count_if(pDeltas, pDeltas + VertexGroupSize,
+            [escape](uint8_t delta) { return delta >= escape; });
+    }
+
+    // The first delta goes to the highest bits of a byte, which lets the SSE decoder unpack with whole register shifts
+    void EncodeGroup(const uint8_t* pDeltas, uint32_t bits, std::vector<uint8_t>& buffer)
+    {
+        if (bits == 0)
+        {
+            return;
+        }
+        if (bits == 8)
+        {
+            buffer.insert(buffer.end(), pDeltas, pDeltas + VertexGroupSize);
+            return;
+        }
+        uint8_t escape = static_cast<uint8_t>((1 << bits) - 1);
+        uint32_t deltasPerByte = 8 / bits;
+        for (size_t i = 0; i < VertexGroupSize; i += deltasPerByte)
+        {
+            uint8_t packed = 0;
+            for (uint32_t j = 0; j < deltasPerByte; j++)
+            {
+                packed = static_cast<uint8_t>((packed << bits) | std::min(pDeltas[i + j], escape));
+            }
+            buffer.push_back(packed);
+        }
+        for (size_t i = 0; i < VertexGroupSize; i++)
+        {
+            if (pDeltas[i] >= escape)
+            {
+                buffer.push_back(pDeltas[i]);
+            }
+        }
+    }
+
+    // pLast holds the bytes of the vertex before the block and is updated to its last vertex
+    void EncodeVertexBlock(const uint8_t* pVertices, size_t count, size_t vertexSize, uint8_t* pLast,
+        std::vector<uint8_t>& buffer)
+    {
+        uint8_t deltas[VertexBlockMaxVertices];
+        size_t groupCount = (count + VertexGroupSize - 1) / VertexGroupSize;
+        for (size_t k = 0; k < vertexSize; k++)
+        {
+            uint8_t previous = pLast[k];
+            for (size_t i = 0; i < count; i++)
+            {
+                uint8_t value = pVertices[i * vertexSize + k];
+                deltas[i] = ZigZag8(static_cast<uint8_t>(value - previous));
+                previous = value;
+            }
+            memset(deltas + count, 0, groupCount * VertexGroupSize - count);
+            pLast[k] = previous;
+
+            size_t headerOffset = buffer.size();
+            buffer.resize(headerOffset + (groupCount + 3) / 4, 0);
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                const uint8_t* pGroup = deltas + g * VertexGroupSize;
+                uint32_t best = 3;
+                size_t bestBytes = VertexGroupSize;
+                for (uint32_t code = 0; code < 3; code++)
+                {
+                    size_t bytes = GetGroupBytes(pGroup, GroupBits[code]);
+                    if (bytes < bestBytes)
+                    {
+                        best = code;
+                        bestBytes = bytes;
+                    }
+                }
+                buffer[headerOffset + g / 4] |= static_cast<uint8_t>(best << (g % 4 * 2));
+                EncodeGroup(pGroup, GroupBits[best], buffer);
+            }
+        }
+    }
+
+    const uint8_t* DecodeGroupScalar(const uint8_t* pData, const uint8_t* pEnd, uint32_t bits, uint8_t* pDeltas)
+    {
+        if (bits == 0)
+        {
+            memset(pDeltas, 0, VertexGroupSize);
+            return pData;
+        }
+        size_t packedBytes = VertexGroupSize * bits / 8;
+        if (size_t(pEnd - pData) < packedBytes)
+        {
+            return nullptr;
+        }
+        if (bits == 8)
+        {
+            memcpy(pDeltas, pData, VertexGroupSize);
+            return pData + VertexGroupSize;
+        }
+
+        uint8_t escape = static_cast<uint8_t>((1 << bits) - 1);
+        uint32_t deltasPerByte = 8 / bits;
+        for (size_t i = 0; i < VertexGroupSize; i++)
+        {
+            uint32_t shift = 8 - bits * (i % deltasPerByte + 1);
+            pDeltas[i] = static_cast<uint8_t>(pData[i / deltasPerByte] >> shift) & escape;
+        }
+        pData += packedBytes;
+        for (size_t i = 0; i < VertexGroupSize; i++)
+        {
+            if (pDeltas[i] == escape)
+            {
+                if (pData == pEnd)
+                {
+                    return nullptr;
+                }
+                pDeltas[i] = *pData++;
+            }
+        }
+        return pData;
+    }
+
+    const uint8_t* DecodeVertexBlockScalar(const uint8_t* pData, const uint8_t* pEnd, uint8_t* pVertices, size_t count,
+        size_t vertexSize, uint8_t* pLast)
+    {
+        uint8_t deltas[VertexGroupSize];
+        size_t groupCount = (count + VertexGroupSize - 1) / VertexGroupSize;
+        size_t headerBytes = (groupCount + 3) / 4;
+        for (size_t k = 0; k < vertexSize; k++)
+        {
+            if (size_t(pEnd - pData) < headerBytes)
+            {
+                return nullptr;
+            }
+            const uint8_t* pHeader = pData;
+            pData += headerBytes;
+
+            uint8_t previous = pLast[k];
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                uint32_t bits = GroupBits[(pHeader[g / 4] >> (g % 4 * 2)) & 3];
+                pData = DecodeGroupScalar(pData, pEnd, bits, deltas);
+                if (pData == nullptr)
+                {
+                    return nullptr;
+                }
+                size_t first = g * VertexGroupSize;
+                size_t groupVertices = std::min(VertexGroupSize, count - first);
+                for (size_t i = 0; i < groupVertices; i++)
+                {
+                    previous = static_cast<uint8_t>(previous + UnZigZag8(deltas[i]));
+                    pVertices[(first + i) * vertexSize + k] = previous;
+                }
+            }
+            pLast[k] = previous;
+        }
+        return pData;
+    }
+
+    // Escapes of a group with the given bits set in one half: where each position takes its byte from
+    struct EscapeShuffleTable
+    {
+        uint8_t shuffles[256][8];
+        uint8_t counts[256];
+
+        EscapeShuffleTable()
+        {
+            for (uint32_t mask = 0; mask < 256; mask++)
+            {
+                uint8_t count = 0;
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    // Indices with the top bit set make the shuffle write zero
+                    shuffles[mask][i] = static_cast<uint8_t>((mask & (1 << i)) != 0 ? count++ : 0x80);
+                }
+                counts[mask] = count;
+            }
+        }
+    };
+
+    const EscapeShuffleTable EscapeShuffles;
+
+    bool DetectSsse3()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3") != 0;
+#endif
+    }
+
+    bool IsSsse3Supported()
+    {
+        static const bool IsSupported = DetectSsse3();
+        return IsSupported;
+    }
+
+    // Replaces the escaped deltas with the bytes that follow the packed ones, without a branch per escape
+    SSSE3_FUNCTION const uint8_t* PatchEscapes(const uint8_t* pData, const uint8_t* pEnd, __m128i escape,
+        __m128i& deltas)
+    {
+        __m128i isEscape = _mm_cmpeq_epi8(deltas, escape);
+        int mask = _mm_movemask_epi8(isEscape);
+        int lowCount = EscapeShuffles.counts[mask & 0xFF];
+        int count = lowCount + EscapeShuffles.counts[mask >> 8];
+        if (pEnd - pData < count)
+        {
+            return nullptr;
+        }
+
+        // Only the last groups of a buffer have fewer than 16 bytes left to load
+        __m128i escapes;
+        if (pEnd - pData >= 16)
+        {
+            escapes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData));
+        }
+        else
+        {
+            alignas(16) uint8_t tail[16] = {};
+            memcpy(tail, pData, pEnd - pData);
+            escapes = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+        __m128i low = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(EscapeShuffles.shuffles[mask & 0xFF]));
+        __m128i high = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(EscapeShuffles.shuffles[mask >> 8]));
+        // The second half continues after the escapes of the first
+        high = _mm_add_epi8(high, _mm_set1_epi8(static_cast<char>(lowCount)));
+        __m128i shuffled = _mm_shuffle_epi8(escapes, _mm_unpacklo_epi64(low, high));
+        deltas = _mm_or_si128(_mm_andnot_si128(isEscape, deltas), shuffled);
+        return pData + count;
+    }
+
+    SSSE3_FUNCTION const uint8_t* DecodeGroupSsse3(const uint8_t* pData, const uint8_t* pEnd, uint32_t code,
+        __m128i& deltas)
+    {
+        switch (code)
+        {
+        case 0:
+            deltas = _mm_setzero_si128();
+            return pData;
+        case 1:
+        {
+            if (pEnd - pData < 4)
+            {
+                return nullptr;
+            }
+            int32_t packed;
+            memcpy(&packed, pData, sizeof(packed));
+            __m128i bytes = _mm_cvtsi32_si128(packed);
+            __m128i mask = _mm_set1_epi8(3);
+            // 16-bit shifts pull bits of the neighbouring byte into the top, the mask drops them
+            __m128i bits6 = _mm_and_si128(_mm_srli_epi16(bytes, 6), mask);
+            __m128i bits4 = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+            __m128i bits2 = _mm_and_si128(_mm_srli_epi16(bytes, 2), mask);
+            __m128i bits0 = _mm_and_si128(bytes, mask);
+            deltas = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bits6, bits4), _mm_unpacklo_epi8(bits2, bits0));
+            return PatchEscapes(pData + 4, pEnd, mask, deltas);
+        }
+        case 2:
+        {
+            if (pEnd - pData < 8)
+            {
+                return nullptr;
+            }
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pData));
+            __m128i mask = _mm_set1_epi8(15);
+            __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+            __m128i low = _mm_and_si128(bytes, mask);
+            deltas = _mm_unpacklo_epi8(high, low);
+            return PatchEscapes(pData + 8, pEnd, mask, deltas);
+        }
+        default:
+            if (pEnd - pData < 16)
+            {
+                return nullptr;
+            }
+            deltas = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData));
+            return pData + 16;
+        }
+    }
+
+    SSSE3_FUNCTION void StoreVertexWord(uint8_t* pVertex, __m128i words)
+    {
+        int32_t word = _mm_cvtsi128_si32(words);
+        memcpy(pVertex, &word, sizeof(word));
+    }
+
+    // Lanes are decoded into pTransposed, one after the other with room for every group, then four lanes at a time
+    // are interleaved into 32-bit words per vertex
+    SSSE3_FUNCTION const uint8_t* DecodeVertexBlockSsse3(const uint8_t* pData, const uint8_t* pEnd, uint8_t* pVertices,
+        size_t count, size_t vertexSize, uint8_t* pLast, uint8_t* pTransposed)
+    {
+        size_t groupCount = (count + VertexGroupSize - 1) / VertexGroupSize;
+        size_t headerBytes = (groupCount + 3) / 4;
+        size_t laneBytes = groupCount * VertexGroupSize;
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i low7 = _mm_set1_epi8(0x7F);
+        for (size_t k = 0; k < vertexSize; k++)
+        {
+            if (size_t(pEnd - pData) < headerBytes)
+            {
+                return nullptr;
+            }
+            const uint8_t* pHeader = pData;
+            pData += headerBytes;
+
+            uint8_t* pLane = pTransposed + k * laneBytes;
+            __m128i previous = _mm_set1_epi8(static_cast<char>(pLast[k]));
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                __m128i deltas;
+                pData = DecodeGroupSsse3(pData, pEnd, (pHeader[g / 4] >> (g % 4 * 2)) & 3, deltas);
+                if (pData == nullptr)
+                {
+                    return nullptr;
+                }
+                __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(deltas, one));
+                __m128i values = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(deltas, 1), low7), sign);
+                // Prefix sum across the 16 vertices, then the last vertex of the previous group
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+                values = _mm_add_epi8(values, previous);
+                _mm_store_si128(reinterpret_cast<__m128i*>(pLane + g * VertexGroupSize), values);
+                // Broadcast byte 15
+                previous = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_unpackhi_epi8(values, values), 0xFF), 0xFF);
+            }
+            pLast[k] = pLane[count - 1];
+        }
+
+        for (size_t k = 0; k < vertexSize; k += 4)
+        {
+            const uint8_t* pLanes = pTransposed + k * laneBytes;
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                size_t offset = g * VertexGroupSize;
+                __m128i lane0 = _mm_load_si128(reinterpret_cast<const __m128i*>(pLanes + offset));
+                __m128i lane1 = _mm_load_si128(reinterpret_cast<const __m128i*>(pLanes + laneBytes + offset));
+                __m128i lane2 = _mm_load_si128(reinterpret_cast<const __m128i*>(pLanes + 2 * laneBytes + offset));
+                __m128i lane3 = _mm_load_si128(reinterpret_cast<const __m128i*>(pLanes + 3 * laneBytes + offset));
+                __m128i pairs01Low = _mm_unpacklo_epi8(lane0, lane1);
+                __m128i pairs01High = _mm_unpackhi_epi8(lane0, lane1);
+                __m128i pairs23Low = _mm_unpacklo_epi8(lane2, lane3);
+                __m128i pairs23High = _mm_unpackhi_epi8(lane2, lane3);
+                __m128i words[4] = {
+                    _mm_unpacklo_epi16(pairs01Low, pairs23Low),
+                    _mm_unpackhi_epi16(pairs01Low, pairs23Low),
+                    _mm_unpacklo_epi16(pairs01High, pairs23High),
+                    _mm_unpackhi_epi16(pairs01High, pairs23High),
+                };
+
+                uint8_t* pVertex = pVertices + offset * vertexSize + k;
+                size_t groupVertices = std::min(VertexGroupSize, count - offset);
+                if (groupVertices == VertexGroupSize)
+                {
+                    for (__m128i quad : words)
+                    {
+                        StoreVertexWord(pVertex, quad);
+                        StoreVertexWord(pVertex + vertexSize, _mm_srli_si128(quad, 4));
+                        StoreVertexWord(pVertex + 2 * vertexSize, _mm_srli_si128(quad, 8));
+                        StoreVertexWord(pVertex + 3 * vertexSize, _mm_srli_si128(quad, 12));
+                        pVertex += 4 * vertexSize;
+                    }
+                }
+                else
+                {
+                    for (size_t i = 0; i < groupVertices; i++)
+                    {
+                        __m128i quad = words[i / 4];
+                        for (size_t j = 0; j < i % 4; j++)
+                        {
+                            quad = _mm_srli_si128(quad, 4);
+                        }
+                        StoreVertexWord(pVertex + i * vertexSize, quad);
+                    }
+                }
+            }
+        }
+        return pData;
+    }
+}
+
+size_t GetIndexBufferEncodeBound(size_t indexCount)
+{
+    return 1 + indexCount / 3 * MaxTriangleBytes;
+}
+
+bool EncodeIndexBuffer(const uint32_t* pIndices, size_t indexCount, std::vector<uint8_t>& buffer)
+{
+    if (indexCount % 3 != 0)
+    {
+        return false;
+    }
+    size_t triangleCount = indexCount / 3;
+
+    // The code bytes come first, one per triangle, and the data stream is appended behind them
+    buffer.clear();
+    buffer.reserve(1 + triangleCount * 2);
+    buffer.resize(1 + triangleCount);
+    buffer[0] = IndexCodecHeader;
+
+    IndexCodecState state;
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        uint32_t a = pIndices[3 * i + 0];
+        uint32_t b = pIndices[3 * i + 1];
+        uint32_t c = pIndices[3 * i + 2];
+
+        // Rotating the triangle to start at the shared edge keeps its winding
+        uint32_t edge = NoEdgeCode;
+        for (uint32_t j = 0; j < EdgeFifoReferences && edge == NoEdgeCode; j++)
+        {
+            const uint32_t* pEdge = state.GetEdge(j);
+            uint32_t rotated[3] = { a, b, c };
+            for (uint32_t r = 0; r < 3; r++)
+            {
+                if (pEdge[0] == rotated[r] && pEdge[1] == rotated[(r + 1) % 3])
+                {
+                    a = rotated[r];
+                    b = rotated[(r + 1) % 3];
+                    c = rotated[(r + 2) % 3];
+                    edge = j;
+                    break;
+                }
+            }
+        }
+
+        if (edge != NoEdgeCode)
+        {
+            uint8_t vertexCode = EncodeVertexReference(state, c, buffer);
+            buffer[1 + i] = static_cast<uint8_t>(edge << 4 | vertexCode);
+        }
+        else
+        {
+            buffer[1 + i] = static_cast<uint8_t>(NoEdgeCode << 4);
+            for (uint32_t vertex : { a, b, c })
+            {
+                // The reference byte goes before the delta it may announce
+                size_t referenceOffset = buffer.size();
+                buffer.push_back(0);
+                uint8_t reference = EncodeVertexReference(state, vertex, buffer);
+                buffer[referenceOffset] = reference;
+            }
+            state.PushEdge(b, a);
+        }
+        state.PushEdge(c, b);
+        state.PushEdge(a, c);
+    }
+    return true;
+}
+
+bool DecodeIndexBuffer(void* pDestination, size_t indexCount, size_t indexSize, const uint8_t* pBuffer, size_t size)
+{
+    size_t triangleCount = indexCount / 3;
+    if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4) || size < 1 + triangleCount ||
+        pBuffer[0] != IndexCodecHeader)
+    {
+        return false;
+    }
+    const uint8_t* pCodes = pBuffer + 1;
+    const uint8_t* pData = pCodes + triangleCount;
+    const uint8_t* pEnd = pBuffer + size;
+    if (indexSize == 2)
+    {
+        return DecodeIndices(static_cast<uint16_t*>(pDestination), triangleCount, pCodes, pData, pEnd);
+    }
+    return DecodeIndices(static_cast<uint32_t*>(pDestination), triangleCount, pCodes, pData, pEnd);
+}
+
+size_t GetVertexBufferEncodeBound(size_t vertexCount, size_t vertexSize)
+{
+    if (!IsVertexSizeSupported(vertexSize))
+    {
+        return 0;
+    }
+    // Every group stored as whole bytes, which the encoder never exceeds
+    size_t blockSize = GetVertexBlockSize(vertexSize);
+    size_t blockGroups = blockSize / VertexGroupSize;
+    size_t blockCount = (vertexCount + blockSize - 1) / blockSize;
+    return 1 + blockCount * vertexSize * ((blockGroups + 3) / 4 + blockGroups * VertexGroupSize);
+}
+
+bool EncodeVertexBuffer(const void* pVertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>& buffer)
+{
+    if (!IsVertexSizeSupported(vertexSize))
+    {
+        return false;
+    }
+    buffer.clear();
+    buffer.reserve(1 + vertexCount * vertexSize);
+    buffer.push_back(VertexCodecHeader);
+
+    // Deltas of the first vertex are taken against zero
+    uint8_t last[MaxVertexSize] = {};
+    size_t blockSize = GetVertexBlockSize(vertexSize);
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pVertices);
+    for (size_t first = 0; first < vertexCount; first += blockSize)
+    {
+        size_t count = std::min(blockSize, vertexCount - first);
+        EncodeVertexBlock(pBytes + first * vertexSize, count, vertexSize, last, buffer);
+    }
+    return true;
+}
+
+bool DecodeVertexBuffer(void* pDestination, size_t vertexCount, size_t vertexSize, const uint8_t* pBuffer, size_t size)
+{
+    if (!IsSsse3Supported())
+    {
+        return DecodeVertexBufferScalar(pDestination, vertexCount, vertexSize, pBuffer, size);
+    }
+    if (!IsVertexSizeSupported(vertexSize) || size < 1 || pBuffer[0] != VertexCodecHeader)
+    {
+        return false;
+    }
+    const uint8_t* pData = pBuffer + 1;
+    const uint8_t* pEnd = pBuffer + size;
+    uint8_t last[MaxVertexSize] = {};
+    alignas(16) uint8_t transposed[VertexBlockMaxBytes];
+    size_t blockSize = GetVertexBlockSize(vertexSize);
+    uint8_t* pBytes = static_cast<uint8_t*>(pDestination);
+    for (size_t first = 0; first < vertexCount; first += blockSize)
+    {
+        size_t count = std::min(blockSize, vertexCount - first);
+        pData = DecodeVertexBlockSsse3(pData, pEnd, pBytes + first * vertexSize, count, vertexSize, last, transposed);
+        if (pData == nullptr)
+        {
+            return false;
+        }
+    }
+    return pData == pEnd;
+}
+
+bool DecodeVertexBufferScalar(void* pDestination, size_t vertexCount, size_t vertexSize, const uint8_t* pBuffer,
+    size_t size)
+{
+    if (!IsVertexSizeSupported(vertexSize) || size < 1 || pBuffer[0] != VertexCodecHeader)
+    {
+        return false;
+    }
+    const uint8_t* pData = pBuffer + 1;
+    const uint8_t* pEnd = pBuffer + size;
+    uint8_t last[MaxVertexSize] = {};
+    size_t blockSize = GetVertexBlockSize(vertexSize);
+    uint8_t* pBytes = static_cast<uint8_t*>(pDestination);
+    for (size_t first = 0; first < vertexCount; first += blockSize)
+    {
+        size_t count = std::min(blockSize, vertexCount - first);
+        pData = DecodeVertexBlockScalar(pData, pEnd, pBytes + first * vertexSize, count, vertexSize, last);
+        if (pData == nullptr)
+        {
+            return false;
+        }
+    }
+    return pData == pEnd;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless compression of index and vertex buffers for storage. Both decoders write straight into the destination,
+// which can be mapped upload memory, and check every read against the encoded size, so a truncated or corrupt
+// buffer makes them return false instead of reading past it. Output may be partially written in that case.
+
+// Triangle lists only. Each triangle is one code byte: the high nibble names the edge it shares with a recent
+// triangle (an edge FIFO of 15), the low nibble where its third vertex comes from: the next vertex not seen yet, one
+// of the last 14 new vertices or an explicit varint delta that follows in a separate data stream. Strips and
+// cache-optimized meshes mostly take the first two, at a little over one byte per triangle.
+size_t GetIndexBufferEncodeBound(size_t indexCount);
+// Fails if indexCount is not a multiple of 3
+bool EncodeIndexBuffer(const uint32_t* pIndices, size_t indexCount, std::vector<uint8_t>& buffer);
+// indexSize is 2 or 4, 16-bit indices keep the low half of the encoded values
+bool DecodeIndexBuffer(void* pDestination, size_t indexCount, size_t indexSize, const uint8_t* pBuffer, size_t size);
+
+// Interleaved vertices in blocks of up to 8 KB. Within a block every byte of the vertex is a separate lane holding
+// the zigzag delta to the same byte of the previous vertex; each lane is split into groups of 16 that store their
+// deltas in 0, 2, 4 or 8 bits, with larger values escaped into whole bytes. vertexSize is a multiple of 4 up to 256.
+size_t GetVertexBufferEncodeBound(size_t vertexCount, size_t vertexSize);
+bool EncodeVertexBuffer(const void* pVertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>& buffer);
+// Decodes a group of 16 deltas per instruction sequence with SSSE3 and transposes four lanes at a time into the
+// vertices; falls back to the scalar version on CPUs without SSSE3
+bool DecodeVertexBuffer(void* pDestination, size_t vertexCount, size_t vertexSize, const uint8_t* pBuffer, size_t size);
+// Byte at a time reference of the same format, exposed for validation and benchmarks
+bool DecodeVertexBufferScalar(void* pDestination, size_t vertexCount, size_t vertexSize, const uint8_t* pBuffer,
+    size_t size);
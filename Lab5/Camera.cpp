@@ -0,0 +1,130 @@
+#include "Camera.h"
+
+bool Frustum::IsSphereVisible(DirectX::FXMVECTOR center, float radius) const
+{
+    for (const DirectX::XMVECTOR& plane : planes)
+    {
+        if (DirectX::XMVectorGetX(DirectX::XMPlaneDotCoord(plane, center)) < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Camera::Camera()
+    : m_position(DirectX::XMVectorZero())
+    , m_orientation(DirectX::XMQuaternionIdentity())
+{
+    m_tanHalfFovX = tanf(m_fovX / 2);
+    m_tanHalfFovY = m_tanHalfFovX * m_aspectRatio;
+}
+
+void Camera::SetPose(DirectX::FXMVECTOR position, DirectX::FXMVECTOR orientation)
+{
+    // Same pose keeps the cached matrices, e.g. for a still camera over an animated scene
+    if (DirectX::XMVector4Equal(position, m_position) && DirectX::XMVector4Equal(orientation, m_orientation))
+    {
+        return;
+    }
+    m_position = position;
+    m_orientation = orientation;
+    m_isViewDirty = true;
+    m_isViewProjectionDirty = true;
+}
+
+bool Camera::HasSamePose(const Camera& other) const
+{
+    return DirectX::XMVector4Equal(m_position, other.m_position) && DirectX::XMVector4Equal(m_orientation, other.m_orientation);
+}
+
+void Camera::SetPerspective(float fovX, float aspectRatio, float nearZ, float farZ)
+{
+    if (fovX == m_fovX && aspectRatio == m_aspectRatio && nearZ == m_nearZ && farZ == m_farZ)
+    {
+        return;
+    }
+    m_fovX = fovX;
+    m_aspectRatio = aspectRatio;
+    m_nearZ = nearZ;
+    m_farZ = farZ;
+    m_tanHalfFovX = tanf(fovX / 2);
+    m_tanHalfFovY = m_tanHalfFovX * aspectRatio;
+    m_isProjectionDirty = true;
+    m_isViewProjectionDirty = true;
+}
+
+DirectX::XMMATRIX Camera::GetWorld() const
+{
+    DirectX::XMMATRIX world = DirectX::XMMatrixRotationQuaternion(m_orientation);
+    world.r[3] = DirectX::XMVectorSetW(m_position, 1.0f);
+    return world;
+}
+
+const DirectX::XMMATRIX& Camera::GetView() const
+{
+    if (m_isViewDirty)
+    {
+        // Inverse of a rotation and translation: transposed rotation and the position rotated back
+        DirectX::XMMATRIX view = DirectX::XMMatrixTranspose(DirectX::XMMatrixRotationQuaternion(m_orientation));
+        view.r[3] = DirectX::XMVectorSetW(DirectX::XMVectorNegate(DirectX::XMVector3TransformNormal(m_position, view)), 1.0f);
+        m_view = view;
+        m_isViewDirty = false;
+    }
+    return m_view;
+}
+
+const DirectX::XMMATRIX& Camera::GetProjection() const
+{
+    if (m_isProjectionDirty)
+    {
+        // Near and far are swapped for reversed depth, the view size is given at the far plane
+        m_projection = DirectX::XMMatrixPerspectiveLH(m_tanHalfFovX * 2 * m_farZ, m_tanHalfFovY * 2 * m_farZ, m_farZ, m_nearZ);
+        m_isProjectionDirty = false;
+    }
+    return m_projection;
+}
+
+const DirectX::XMMATRIX& Camera::GetViewProjection() const
+{
+    if (m_isViewProjectionDirty || m_isViewDirty || m_isProjectionDirty)
+    {
+        m_viewProjection = DirectX::XMMatrixMultiply(GetView(), GetProjection());
+
+        // Clip space planes -w <= x <= w, -w <= y <= w, 0 <= z <= w as rows of the transposed matrix
+        DirectX::XMMATRIX columns = DirectX::XMMatrixTranspose(m_viewProjection);
+        m_frustum.planes[Frustum::LEFT_PLANE] = DirectX::XMVectorAdd(columns.r[3], columns.r[0]);
+        m_frustum.planes[Frustum::RIGHT_PLANE] = DirectX::XMVectorSubtract(columns.r[3], columns.r[0]);
+        m_frustum.planes[Frustum::BOTTOM_PLANE] = DirectX::XMVectorAdd(columns.r[3], columns.r[1]);
+        m_frustum.planes[Frustum::TOP_PLANE] = DirectX::XMVectorSubtract(columns.r[3], columns.r[1]);
+        // Depth is reversed, z = w is the near plane
+        m_frustum.planes[Frustum::NEAR_PLANE] = DirectX::XMVectorSubtract(columns.r[3], columns.r[2]);
+        m_frustum.planes[Frustum::FAR_PLANE] = columns.r[2];
+        for (DirectX::XMVECTOR& plane : m_frustum.planes)
+        {
+            plane = DirectX::XMPlaneNormalize(plane);
+        }
+        m_isViewProjectionDirty = false;
+    }
+    return m_viewProjection;
+}
+
+const Frustum& Camera::GetFrustum() const
+{
+    GetViewProjection();
+    return m_frustum;
+}
+
+DirectX::XMFLOAT4 Camera::GetViewDepthRow() const
+{
+    DirectX::XMFLOAT4 row;
+    DirectX::XMStoreFloat4(&row, DirectX::XMMatrixTranspose(GetView()).r[2]);
+    return row;
+}
+
+Camera Camera::Interpolate(const Camera& a, const Camera& b, float t)
+{
+    Camera result = b;
+    result.SetPose(DirectX::XMVectorLerp(a.m_position, b.m_position, t), DirectX::XMQuaternionSlerp(a.m_orientation, b.m_orientation, t));
+    return result;
+}
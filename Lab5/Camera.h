@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Platform.h"
+
+// Planes face inwards and are normalized, in world space
+struct Frustum
+{
+    enum PLANE
+    {
+        LEFT_PLANE,
+        RIGHT_PLANE,
+        BOTTOM_PLANE,
+        TOP_PLANE,
+        NEAR_PLANE,
+        FAR_PLANE,
+        PLANE_COUNT
+    };
+
+    DirectX::XMVECTOR planes[PLANE_COUNT];
+
+    bool IsSphereVisible(DirectX::FXMVECTOR center, float radius) const;
+};
+
+// Rigid camera pose with a reversed depth perspective projection. Derived matrices and the frustum
+// are computed on first use after a change and cached, so any number of queries per frame cost one update.
+class Camera
+{
+    DirectX::XMVECTOR m_position;
+    DirectX::XMVECTOR m_orientation;
+
+    float m_fovX = (float)M_PI / 2;
+    // Height over width
+    float m_aspectRatio = 1.0f;
+    float m_nearZ = 0.1f;
+    float m_farZ = 100.0f;
+    float m_tanHalfFovX = 0.0f;
+    float m_tanHalfFovY = 0.0f;
+
+    mutable DirectX::XMMATRIX m_view;
+    mutable DirectX::XMMATRIX m_projection;
+    mutable DirectX::XMMATRIX m_viewProjection;
+    mutable Frustum m_frustum;
+    mutable bool m_isViewDirty = true;
+    mutable bool m_isProjectionDirty = true;
+    mutable bool m_isViewProjectionDirty = true;
+
+public:
+    Camera();
+
+    // Orientation is a unit quaternion rotating camera space into world space
+    void SetPose(DirectX::FXMVECTOR position, DirectX::FXMVECTOR orientation);
+    DirectX::XMVECTOR GetPosition() const { return m_position; }
+    DirectX::XMVECTOR GetOrientation() const { return m_orientation; }
+    bool HasSamePose(const Camera& other) const;
+
+    // Horizontal field of view in radians, aspect ratio is height over width
+    void SetPerspective(float fovX, float aspectRatio, float nearZ, float farZ);
+    float GetNearZ() const { return m_nearZ; }
+    float GetFarZ() const { return m_farZ; }
+    float GetTanHalfFovX() const { return m_tanHalfFovX; }
+    float GetTanHalfFovY() const { return m_tanHalfFovY; }
+
+    // Camera to world transform
+    DirectX::XMMATRIX GetWorld() const;
+    const DirectX::XMMATRIX& GetView() const;
+    const DirectX::XMMATRIX& GetProjection() const;
+    const DirectX::XMMATRIX& GetViewProjection() const;
+    const Frustum& GetFrustum() const;
+    // Depth column of the view matrix: view space z = dot(row, (x, y, z, 1))
+    DirectX::XMFLOAT4 GetViewDepthRow() const;
+
+    // Pose between two cameras, the projection is taken from b
+    static Camera Interpolate(const Camera& a, const Camera& b, float t);
+};
@@ -0,0 +1,217 @@
+#include "CommandLine.h"
+
+#include <shellapi.h>
+
+//
+//  --fps <rate>        target frame rate, 0 disables the cap
+//  --spin <ms>         busy-wait the last part of every frame interval
+//  --record <file>     record input and update timing to a file
+//  --replay <file>     drive the scene from a recording instead of live input
+//  --headless          replay without creating a window
+//  --max-rendered <count>  frames the headless replay may render before it fails
+//  --benchmark         render a scripted camera path offscreen and report timings
+//  --frames <count>    number of benchmark frames
+//  --objects <count>   number of transparent objects in the scene
+//  --resolution <w> <h>
+//  --backend <hardware|warp|null>
+//  --transparency <sorted|oit>
+//  --vertex-format <float|compact>
+//  --model <file>      draw an .obj or .glb model instead of the opaque cubes
+//  --report <file>     benchmark report, JSON summary for .json files, per-frame CSV otherwise
+//  --pacing-test       pace empty frames at --fps and report how late the waits return
+//  --max-lateness <ms> p99 lateness the pacing test accepts
+//  --self-test [filter]    run the portable correctness and stress tests
+//  --microbench [filter]   run microbenchmarks, the report is written as JSON
+//  --mesh-report       print size, generation time and vertex cache stats of the procedural meshes
+//  --mesh-export <dir> write the procedural meshes as compressed binary mesh files and check that they decode
+//  --lod-report        simplify the procedural meshes and the model into LOD chains, print their size and error
+//  --skinning-bench    animate and skin characters without rendering and report timings
+//  --characters <count> number of skinned characters
+//  --bones <count>     joints per character
+//  --profile <file>    capture CPU zones and write them as a Chrome trace
+//  --stats <file>      dump per-frame render stats of the last frames on exit
+//
+bool ParseCommandLine(LPCWSTR lpCmdLine, AppOptions& options)
+{
+    if (lpCmdLine == nullptr || *lpCmdLine == L'\0')
+    {
+        return true;
+    }
+
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(lpCmdLine, &argc);
+    if (argv == nullptr)
+    {
+        return false;
+    }
+
+    bool result = true;
+    for (int i = 0; i < argc && result; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (wcscmp(argv[i], L"--fps") == 0 && hasValue)
+        {
+            options.targetFrameRate = _wtof(argv[++i]);
+        }
+        else if (wcscmp(argv[i], L"--spin") == 0 && hasValue)
+        {
+            options.spinTimeMs = _wtof(argv[++i]);
+        }
+        else if (wcscmp(argv[i], L"--record") == 0 && hasValue)
+        {
+            options.recordPath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--replay") == 0 && hasValue)
+        {
+            options.replayPath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--headless") == 0)
+        {
+            options.headless = true;
+        }
+        else if (wcscmp(argv[i], L"--max-rendered") == 0 && hasValue)
+        {
+            options.maxRenderedFrames = static_cast<size_t>(_wtoi64(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--benchmark") == 0)
+        {
+            options.benchmark = true;
+        }
+        else if (wcscmp(argv[i], L"--pacing-test") == 0)
+        {
+            options.pacingTest = true;
+        }
+        else if (wcscmp(argv[i], L"--max-lateness") == 0 && hasValue)
+        {
+            options.maxLatenessMs = _wtof(argv[++i]);
+        }
+        else if (wcscmp(argv[i], L"--self-test") == 0)
+        {
+            options.selfTest = true;
+            if (hasValue && wcsncmp(argv[i + 1], L"--", 2) != 0)
+            {
+                options.selfTestFilter = argv[++i];
+            }
+        }
+        else if (wcscmp(argv[i], L"--microbench") == 0)
+        {
+            options.microbench = true;
+            if (hasValue && wcsncmp(argv[i + 1], L"--", 2) != 0)
+            {
+                options.microbenchFilter = argv[++i];
+            }
+        }
+        else if (wcscmp(argv[i], L"--mesh-report") == 0)
+        {
+            options.meshReport = true;
+        }
+        else if (wcscmp(argv[i], L"--lod-report") == 0)
+        {
+            options.lodReport = true;
+        }
+        else if (wcscmp(argv[i], L"--skinning-bench") == 0)
+        {
+            options.skinningBenchmark = true;
+        }
+        else if (wcscmp(argv[i], L"--characters") == 0 && hasValue)
+        {
+            options.characterCount = static_cast<size_t>(_wtoi64(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--bones") == 0 && hasValue)
+        {
+            options.boneCount = static_cast<size_t>(_wtoi64(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--mesh-export") == 0 && hasValue)
+        {
+            options.meshExportPath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--model") == 0 && hasValue)
+        {
+            options.modelPath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--frames") == 0 && hasValue)
+        {
+            options.benchmarkFrames = static_cast<size_t>(_wtoi64(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--objects") == 0 && hasValue)
+        {
+            options.objectCount = static_cast<size_t>(_wtoi64(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--resolution") == 0 && i + 2 < argc)
+        {
+            options.width = static_cast<UINT>(_wtoi(argv[++i]));
+            options.height = static_cast<UINT>(_wtoi(argv[++i]));
+        }
+        else if (wcscmp(argv[i], L"--backend") == 0 && hasValue)
+        {
+            i++;
+            if (wcscmp(argv[i], L"hardware") == 0)
+            {
+                options.backend = RENDER_BACKEND::HARDWARE;
+            }
+            else if (wcscmp(argv[i], L"warp") == 0)
+            {
+                options.backend = RENDER_BACKEND::WARP;
+            }
+            else if (wcscmp(argv[i], L"null") == 0)
+            {
+                options.backend = RENDER_BACKEND::NULL_DEVICE;
+            }
+            else
+            {
+                result = false;
+            }
+        }
+        else if (wcscmp(argv[i], L"--transparency") == 0 && hasValue)
+        {
+            i++;
+            if (wcscmp(argv[i], L"sorted") == 0)
+            {
+                options.transparencyMode = TRANSPARENCY_MODE::SORTED;
+            }
+            else if (wcscmp(argv[i], L"oit") == 0)
+            {
+                options.transparencyMode = TRANSPARENCY_MODE::WEIGHTED_BLENDED;
+            }
+            else
+            {
+                result = false;
+            }
+        }
+        else if (wcscmp(argv[i], L"--vertex-format") == 0 && hasValue)
+        {
+            i++;
+            if (wcscmp(argv[i], L"float") == 0)
+            {
+                options.vertexPrecision = VERTEX_PRECISION::FULL;
+            }
+            else if (wcscmp(argv[i], L"compact") == 0)
+            {
+                options.vertexPrecision = VERTEX_PRECISION::COMPACT;
+            }
+            else
+            {
+                result = false;
+            }
+        }
+        else if (wcscmp(argv[i], L"--report") == 0 && hasValue)
+        {
+            options.reportPath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--profile") == 0 && hasValue)
+        {
+            options.profilePath = argv[++i];
+        }
+        else if (wcscmp(argv[i], L"--stats") == 0 && hasValue)
+        {
+            options.statsPath = argv[++i];
+        }
+        else
+        {
+            result = false;
+        }
+    }
+
+    LocalFree(argv);
+    return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "framework.h"
+#include "Renderer.h"
+
+struct AppOptions
+{
+    // Frame pacing
+    double targetFrameRate = 60.0;
+    double spinTimeMs = 1.0;
+
+    // Input recording and replay
+    std::wstring recordPath;
+    std::wstring replayPath;
+    bool headless = false;
+    // Headless replay fails if idle rendering would draw more frames than this, 0 leaves it unchecked
+    size_t maxRenderedFrames = 0;
+
+    // Benchmark mode
+    bool benchmark = false;
+    size_t benchmarkFrames = 1000;
+    size_t objectCount = 0;
+    UINT width = 1280;
+    UINT height = 720;
+    RENDER_BACKEND backend = RENDER_BACKEND::HARDWARE;
+    TRANSPARENCY_MODE transparencyMode = TRANSPARENCY_MODE::SORTED;
+    VERTEX_PRECISION vertexPrecision = VERTEX_PRECISION::COMPACT;
+    // OBJ or glTF binary model drawn instead of the opaque cubes
+    std::wstring modelPath;
+    std::wstring reportPath;
+
+    // Pacing accuracy of empty frames at targetFrameRate, fails when the p99 lateness exceeds the bound
+    bool pacingTest = false;
+    double maxLatenessMs = 1.0;
+
+    // Portable correctness and stress tests, optionally only those whose name contains the filter
+    bool selfTest = false;
+    std::wstring selfTestFilter;
+
+    // Microbenchmarks of hot path building blocks, optionally only those whose name contains the filter
+    bool microbench = false;
+    std::wstring microbenchFilter;
+
+    // Vertex cache report of the procedural meshes
+    bool meshReport = false;
+    // Directory the procedural meshes are written to as mesh files
+    std::wstring meshExportPath;
+    // Simplification speed and error of the LOD chains of the procedural meshes and the model
+    bool lodReport = false;
+
+    // Headless skeletal animation benchmark, reuses benchmarkFrames and reportPath
+    bool skinningBenchmark = false;
+    size_t characterCount = 64;
+    size_t boneCount = 32;
+
+    // Chrome trace / Perfetto JSON of the whole run
+    std::wstring profilePath;
+
+    // Render stats of the last frames as JSON, written on exit
+    std::wstring statsPath;
+};
+
+bool ParseCommandLine(LPCWSTR lpCmdLine, AppOptions& options);
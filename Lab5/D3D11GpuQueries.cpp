@@ -0,0 +1,92 @@
+#include "D3D11GpuQueries.h"
+#include "utils.h"
+
+D3D11GpuQueries::D3D11GpuQueries(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext)
+    : m_pDevice(pDevice)
+    , m_pDeviceContext(pDeviceContext)
+{
+}
+
+D3D11GpuQueries::~D3D11GpuQueries()
+{
+    ReleaseQueries();
+}
+
+bool D3D11GpuQueries::CreateQueries(uint32_t slotCount, uint32_t timestampsPerSlot)
+{
+    ReleaseQueries();
+    m_timestampsPerSlot = timestampsPerSlot;
+    m_disjointQueries.resize(slotCount, NULL);
+    m_timestampQueries.resize(slotCount * timestampsPerSlot, NULL);
+
+    HRESULT result = S_OK;
+    for (size_t i = 0; i < m_disjointQueries.size() && SUCCEEDED(result); i++)
+    {
+        D3D11_QUERY_DESC desc = {};
+        desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+        result = m_pDevice->CreateQuery(&desc, &m_disjointQueries[i]);
+    }
+    for (size_t i = 0; i < m_timestampQueries.size() && SUCCEEDED(result); i++)
+    {
+        D3D11_QUERY_DESC desc = {};
+        desc.Query = D3D11_QUERY_TIMESTAMP;
+        result = m_pDevice->CreateQuery(&desc, &m_timestampQueries[i]);
+    }
+    assert(SUCCEEDED(result));
+    return SUCCEEDED(result);
+}
+
+void D3D11GpuQueries::ReleaseQueries()
+{
+    for (ID3D11Query*& pQuery : m_disjointQueries)
+    {
+        SAFE_RELEASE(pQuery);
+    }
+    for (ID3D11Query*& pQuery : m_timestampQueries)
+    {
+        SAFE_RELEASE(pQuery);
+    }
+    m_disjointQueries.clear();
+    m_timestampQueries.clear();
+}
+
+void D3D11GpuQueries::BeginDisjoint(uint32_t slot)
+{
+    m_pDeviceContext->Begin(m_disjointQueries[slot]);
+}
+
+void D3D11GpuQueries::EndDisjoint(uint32_t slot)
+{
+    m_pDeviceContext->End(m_disjointQueries[slot]);
+}
+
+void D3D11GpuQueries::WriteTimestamp(uint32_t slot, uint32_t index)
+{
+    // Timestamp queries only have an End
+    m_pDeviceContext->End(m_timestampQueries[slot * m_timestampsPerSlot + index]);
+}
+
+bool D3D11GpuQueries::ReadResults(uint32_t slot, uint32_t count, uint64_t* pTimestamps, uint64_t& frequency, bool& isDisjoint)
+{
+    // DONOTFLUSH keeps GetData from forcing submission, Present and the frame queries flush anyway
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    if (m_pDeviceContext->GetData(m_disjointQueries[slot], &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+    {
+        return false;
+    }
+
+    // Timestamps of the slot were issued before its disjoint query ended, so they are ready as well
+    for (uint32_t i = 0; i < count; i++)
+    {
+        UINT64 timestamp = 0;
+        if (m_pDeviceContext->GetData(m_timestampQueries[slot * m_timestampsPerSlot + i], &timestamp, sizeof(timestamp), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+        {
+            return false;
+        }
+        pTimestamps[i] = timestamp;
+    }
+
+    frequency = disjoint.Frequency;
+    isDisjoint = disjoint.Disjoint != FALSE;
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "framework.h"
+#include "GpuProfiler.h"
+
+// D3D11_QUERY_TIMESTAMP_DISJOINT and D3D11_QUERY_TIMESTAMP queries for GpuProfiler
+class D3D11GpuQueries : public GpuQueryBackend
+{
+    ID3D11Device* m_pDevice = NULL;
+    ID3D11DeviceContext* m_pDeviceContext = NULL;
+
+    std::vector<ID3D11Query*> m_disjointQueries;
+    std::vector<ID3D11Query*> m_timestampQueries;
+    uint32_t m_timestampsPerSlot = 0;
+
+public:
+    D3D11GpuQueries(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext);
+    ~D3D11GpuQueries();
+
+    bool CreateQueries(uint32_t slotCount, uint32_t timestampsPerSlot) override;
+    void ReleaseQueries() override;
+
+    void BeginDisjoint(uint32_t slot) override;
+    void EndDisjoint(uint32_t slot) override;
+    void WriteTimestamp(uint32_t slot, uint32_t index) override;
+
+    bool ReadResults(uint32_t slot, uint32_t count, uint64_t* pTimestamps, uint64_t& frequency, bool& isDisjoint) override;
+};
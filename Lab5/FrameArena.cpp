@@ -0,0 +1,64 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+namespace
+{
+    char* AlignPointer(char* p, size_t alignment)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : m_pBuffer(new char[capacity])
+    , m_capacity(capacity)
+{
+}
+
+FrameArena& FrameArena::GetThreadArena()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    char* pBegin = m_pBuffer.get();
+    char* p = AlignPointer(pBegin + m_offset, alignment);
+    size_t end = static_cast<size_t>(p - pBegin) + size;
+    if (end > m_capacity)
+    {
+        return AllocateOverflow(size, alignment);
+    }
+
+    m_offset = end;
+    m_peak = std::max(m_peak, GetUsed());
+    return p;
+}
+
+void* FrameArena::AllocateOverflow(size_t size, size_t alignment)
+{
+    // One block per request keeps the fallback simple, it only happens until the next reset grows the arena
+    m_overflowBlocks.emplace_back(new char[size + alignment]);
+    m_overflowUsed += size + alignment;
+    m_peak = std::max(m_peak, GetUsed());
+    return AlignPointer(m_overflowBlocks.back().get(), alignment);
+}
+
+void FrameArena::Reset()
+{
+    if (!m_overflowBlocks.empty())
+    {
+        m_overflowBlocks.clear();
+        m_overflowBlocks.shrink_to_fit();
+
+        // 1.5x the peak leaves headroom so that slowly growing frames do not reallocate every time, without
+        // doubling an already large arena after a single spike. The peak exceeded the capacity, so this grows.
+        m_capacity = m_peak + m_peak / 2;
+        m_pBuffer.reset(new char[m_capacity]);
+    }
+    m_offset = 0;
+    m_overflowUsed = 0;
+}
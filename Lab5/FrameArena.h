@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for data that lives no longer than a frame. Each thread has its own arena,
+// the owner of the frame resets it once everything allocated from it has been destroyed.
+// Running out of space falls back to overflow blocks and the arena grows to fit on the next
+// reset, so after a few frames the steady state performs no heap allocations.
+class FrameArena
+{
+public:
+    static const size_t DefaultCapacity = 256 * 1024;
+
+    explicit FrameArena(size_t capacity = DefaultCapacity);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Arena of the calling thread
+    static FrameArena& GetThreadArena();
+
+    void* Allocate(size_t size, size_t alignment);
+    // Releases everything allocated since the previous reset
+    void Reset();
+
+    size_t GetCapacity() const { return m_capacity; }
+    // Bytes allocated since the previous reset, including overflow
+    size_t GetUsed() const { return m_offset + m_overflowUsed; }
+    size_t GetPeak() const { return m_peak; }
+
+private:
+    void* AllocateOverflow(size_t size, size_t alignment);
+
+    std::unique_ptr<char[]> m_pBuffer;
+    size_t m_capacity = 0;
+    size_t m_offset = 0;
+
+    std::vector<std::unique_ptr<char[]>> m_overflowBlocks;
+    size_t m_overflowUsed = 0;
+    size_t m_peak = 0;
+};
+
+// STL allocator on top of a FrameArena, deallocation is a no-op until the arena is reset
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() : m_pArena(&FrameArena::GetThreadArena()) {}
+    explicit ArenaAllocator(FrameArena& arena) : m_pArena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_pArena(other.GetArena()) {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(m_pArena->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    FrameArena* GetArena() const { return m_pArena; }
+
+private:
+    FrameArena* m_pArena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.GetArena() == b.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.GetArena() != b.GetArena();
+}
+
+// Vector for transient per-frame data, allocates from the calling thread's arena by default
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
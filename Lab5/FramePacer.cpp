@@ -0,0 +1,206 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+FramePacer::FramePacer()
+{
+    m_frameTimes.reserve(HistorySize);
+    m_lastFrame = Clock::now();
+    m_deadline = m_lastFrame;
+
+#ifdef _WIN32
+    // High resolution timers are available starting from Windows 10 1803, fall back to the regular one
+    m_hTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (m_hTimer == NULL)
+    {
+        m_hTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    if (m_hTimer != NULL)
+    {
+        CloseHandle(m_hTimer);
+    }
+#endif
+}
+
+void FramePacer::SetTargetRate(double framesPerSecond)
+{
+    m_targetRate = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+    if (m_targetRate > 0.0)
+    {
+        m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetRate));
+    }
+    else
+    {
+        m_period = Clock::duration::zero();
+    }
+    m_deadline = Clock::now();
+}
+
+double FramePacer::WaitForNextFrame()
+{
+    m_lastLateness = 0.0;
+    if (m_period != Clock::duration::zero())
+    {
+        m_deadline += m_period;
+
+        // Missed the deadline by more than a frame, start over instead of trying to catch up
+        Clock::time_point now = Clock::now();
+        if (now > m_deadline + m_period)
+        {
+            m_deadline = now;
+            m_missedDeadlines++;
+        }
+        else
+        {
+            SleepUntil(m_deadline);
+        }
+    }
+
+    Clock::time_point now = Clock::now();
+    if (m_period != Clock::duration::zero())
+    {
+        m_lastLateness = std::chrono::duration<double>(now - m_deadline).count();
+    }
+    double frameTime = std::chrono::duration<double>(now - m_lastFrame).count();
+    m_lastFrame = now;
+
+    if (m_frameTimes.size() < HistorySize)
+    {
+        m_frameTimes.push_back(static_cast<float>(frameTime));
+    }
+    else
+    {
+        m_frameTimes[m_frameCount % HistorySize] = static_cast<float>(frameTime);
+    }
+    m_frameCount++;
+
+    return frameTime;
+}
+
+void FramePacer::Resume()
+{
+    m_lastFrame = Clock::now();
+    m_deadline = m_lastFrame;
+}
+
+void FramePacer::SleepUntil(Clock::time_point deadline)
+{
+    Clock::time_point sleepDeadline = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_spinTime));
+    Clock::time_point now = Clock::now();
+
+    if (sleepDeadline > now)
+    {
+#ifdef _WIN32
+        // Relative due time in 100 ns units
+        LONGLONG ticks = std::chrono::duration_cast<std::chrono::duration<LONGLONG, std::ratio<1, 10000000>>>(sleepDeadline - now).count();
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -ticks;
+        if (m_hTimer != NULL && SetWaitableTimer(m_hTimer, &dueTime, 0, NULL, NULL, FALSE))
+        {
+            WaitForSingleObject(m_hTimer, INFINITE);
+        }
+        else
+        {
+            std::this_thread::sleep_until(sleepDeadline);
+        }
+#else
+        // steady_clock is CLOCK_MONOTONIC, so its epoch can be used as an absolute deadline
+        std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(sleepDeadline.time_since_epoch());
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+#endif
+    }
+
+    while (Clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::ResetStats()
+{
+    m_frameTimes.clear();
+    m_frameCount = 0;
+    m_missedDeadlines = 0;
+}
+
+double FramePacer::GetFrameTimePercentile(double percentile) const
+{
+    if (m_frameTimes.empty())
+    {
+        return 0.0;
+    }
+    std::vector<float> sorted = m_frameTimes;
+    size_t idx = static_cast<size_t>(std::min(std::max(percentile, 0.0), 1.0) * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+    return sorted[idx];
+}
+
+double FramePacer::GetAverageFrameTime() const
+{
+    if (m_frameTimes.empty())
+    {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (float frameTime : m_frameTimes)
+    {
+        sum += frameTime;
+    }
+    return sum / m_frameTimes.size();
+}
+
+void MeasurePacingAccuracy(double framesPerSecond, double spinTime, size_t frameCount, PacingAccuracy& result)
+{
+    FramePacer pacer;
+    pacer.SetTargetRate(framesPerSecond);
+    pacer.SetSpinTime(spinTime);
+
+    std::vector<double> lateness;
+    lateness.reserve(frameCount);
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        pacer.WaitForNextFrame();
+        lateness.push_back(pacer.GetLastLateness());
+    }
+
+    result = PacingAccuracy();
+    result.frameCount = frameCount;
+    result.missedDeadlines = pacer.GetMissedDeadlineCount();
+    if (lateness.empty())
+    {
+        return;
+    }
+    std::sort(lateness.begin(), lateness.end());
+    result.p50Lateness = lateness[static_cast<size_t>(0.5 * (lateness.size() - 1) + 0.5)];
+    result.p99Lateness = lateness[static_cast<size_t>(0.99 * (lateness.size() - 1) + 0.5)];
+    result.maxLateness = lateness.back();
+}
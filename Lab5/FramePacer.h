@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Paces frames against absolute deadlines instead of sleeping a fixed interval after each frame,
+// so render time is absorbed by the wait and error does not accumulate.
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FramePacer();
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Frames per second to aim for, zero or negative value disables the cap
+    void SetTargetRate(double framesPerSecond);
+    double GetTargetRate() const { return m_targetRate; }
+
+    // Part of the interval that is busy-waited instead of slept to hide OS timer granularity
+    void SetSpinTime(double seconds) { m_spinTime = seconds; }
+    double GetSpinTime() const { return m_spinTime; }
+
+    // Blocks until the next frame deadline, returns the time since the previous frame in seconds
+    double WaitForNextFrame();
+    // How far past its deadline the last wait returned, in seconds, zero when uncapped
+    double GetLastLateness() const { return m_lastLateness; }
+    // Deadlines missed by more than a whole frame, after which pacing restarted from the current time
+    size_t GetMissedDeadlineCount() const { return m_missedDeadlines; }
+    // Restarts pacing from now after a pause, so the pause is not recorded as a frame
+    void Resume();
+
+    void ResetStats();
+    size_t GetFrameCount() const { return m_frameCount; }
+    // Percentile in [0, 1] over the recent frame history, in seconds
+    double GetFrameTimePercentile(double percentile) const;
+    double GetAverageFrameTime() const;
+
+private:
+    void SleepUntil(Clock::time_point deadline);
+
+    static const size_t HistorySize = 1024;
+
+    double m_targetRate = 0.0;
+    double m_spinTime = 0.001;
+    Clock::duration m_period = Clock::duration::zero();
+    Clock::time_point m_deadline;
+    Clock::time_point m_lastFrame;
+
+    std::vector<float> m_frameTimes;
+    size_t m_frameCount = 0;
+    double m_lastLateness = 0.0;
+    size_t m_missedDeadlines = 0;
+
+#ifdef _WIN32
+    void* m_hTimer = nullptr;
+#endif
+};
+
+struct PacingAccuracy
+{
+    size_t frameCount = 0;
+    size_t missedDeadlines = 0;
+    // Seconds between a deadline and the moment the wait for it returned
+    double p50Lateness = 0.0;
+    double p99Lateness = 0.0;
+    double maxLateness = 0.0;
+};
+
+// Paces frameCount empty frames at framesPerSecond with the given spin time and measures how late every wait returns.
+// Uses the same sleep and spin path as the render thread, so it shows the accuracy of the timers of the machine.
+void MeasurePacingAccuracy(double framesPerSecond, double spinTime, size_t frameCount, PacingAccuracy& result);
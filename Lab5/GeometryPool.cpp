@@ -0,0 +1,184 @@
+#include "GeometryPool.h"
+#include "utils.h"
+
+#include <string>
+
+HRESULT GeometryPool::Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, UINT vertexPageBytes, UINT indexPageBytes)
+{
+    m_pDevice = pDevice;
+    m_pDeviceContext = pDeviceContext;
+    m_vertexPageBytes = vertexPageBytes;
+    m_indexPageBytes = indexPageBytes;
+    m_boundPage = NoPage;
+    return AddPage(m_vertexPageBytes, m_indexPageBytes);
+}
+
+void GeometryPool::Term()
+{
+    for (Page& page : m_pages)
+    {
+        SAFE_RELEASE(page.pVertexBuffer);
+        SAFE_RELEASE(page.pIndexBuffer);
+    }
+    m_pages.clear();
+    m_boundPage = NoPage;
+    m_pDevice = NULL;
+    m_pDeviceContext = NULL;
+}
+
+HRESULT GeometryPool::Add(const void* pVertices, UINT vertexCount, UINT stride, const void* pIndices, UINT indexCount,
+    DXGI_FORMAT indexFormat, PooledMesh& mesh)
+{
+    UINT indexSize = indexFormat == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(USHORT);
+    if (vertexCount == 0 || stride == 0 || indexCount == 0 || vertexCount > UINT_MAX / stride || indexCount > UINT_MAX / indexSize ||
+        (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT))
+    {
+        return E_INVALIDARG;
+    }
+    UINT vertexBytes = vertexCount * stride;
+    UINT indexBytes = indexCount * indexSize;
+
+    RangeAllocation vertices;
+    RangeAllocation indices;
+    UINT pageIndex = 0;
+    for (; pageIndex < m_pages.size(); pageIndex++)
+    {
+        Page& page = m_pages[pageIndex];
+        vertices = page.vertices.Allocate(vertexBytes, stride);
+        indices = vertices.IsValid() ? page.indices.Allocate(indexBytes, indexSize) : RangeAllocation();
+        if (indices.IsValid())
+        {
+            break;
+        }
+        if (vertices.IsValid())
+        {
+            page.vertices.Free(vertices.handle);
+        }
+    }
+
+    if (pageIndex == m_pages.size())
+    {
+        // Alignment padding needs at most a stride more than the vertices
+        UINT pageVertexBytes = vertexBytes + stride <= m_vertexPageBytes ? m_vertexPageBytes : vertexBytes + stride;
+        HRESULT result = AddPage(pageVertexBytes, max(indexBytes, m_indexPageBytes));
+        if (FAILED(result))
+        {
+            return result;
+        }
+        vertices = m_pages[pageIndex].vertices.Allocate(vertexBytes, stride);
+        indices = m_pages[pageIndex].indices.Allocate(indexBytes, indexSize);
+    }
+
+    Page& page = m_pages[pageIndex];
+    D3D11_BOX box = { vertices.offset, 0, 0, vertices.offset + vertexBytes, 1, 1 };
+    m_pDeviceContext->UpdateSubresource(page.pVertexBuffer, 0, &box, pVertices, 0, 0);
+    box.left = indices.offset;
+    box.right = indices.offset + indexBytes;
+    m_pDeviceContext->UpdateSubresource(page.pIndexBuffer, 0, &box, pIndices, 0, 0);
+
+    mesh.page = pageIndex;
+    mesh.stride = stride;
+    mesh.indexFormat = indexFormat;
+    mesh.baseVertex = vertices.offset / stride;
+    mesh.startIndex = indices.offset / indexSize;
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = indexCount;
+    mesh.vertexHandle = vertices.handle;
+    mesh.indexHandle = indices.handle;
+    return S_OK;
+}
+
+void GeometryPool::Remove(PooledMesh& mesh)
+{
+    if (mesh.IsValid() && mesh.page < m_pages.size())
+    {
+        m_pages[mesh.page].vertices.Free(mesh.vertexHandle);
+        m_pages[mesh.page].indices.Free(mesh.indexHandle);
+    }
+    mesh = PooledMesh();
+}
+
+UINT GeometryPool::Bind(const PooledMesh& mesh)
+{
+    const Page& page = m_pages[mesh.page];
+    UINT binds = 0;
+    if (mesh.page != m_boundPage || mesh.indexFormat != m_boundIndexFormat)
+    {
+        m_pDeviceContext->IASetIndexBuffer(page.pIndexBuffer, mesh.indexFormat, 0);
+        binds++;
+    }
+    if (mesh.page != m_boundPage || mesh.stride != m_boundStride)
+    {
+        UINT offset = 0;
+        m_pDeviceContext->IASetVertexBuffers(0, 1, &page.pVertexBuffer, &mesh.stride, &offset);
+        binds++;
+    }
+    m_boundPage = mesh.page;
+    m_boundStride = mesh.stride;
+    m_boundIndexFormat = mesh.indexFormat;
+    return binds;
+}
+
+size_t GeometryPool::GetUsedBytes() const
+{
+    size_t bytes = 0;
+    for (const Page& page : m_pages)
+    {
+        bytes += page.vertices.GetCapacity() - page.vertices.GetFreeSize();
+        bytes += page.indices.GetCapacity() - page.indices.GetFreeSize();
+    }
+    return bytes;
+}
+
+size_t GeometryPool::GetCapacityBytes() const
+{
+    size_t bytes = 0;
+    for (const Page& page : m_pages)
+    {
+        bytes += page.vertices.GetCapacity() + page.indices.GetCapacity();
+    }
+    return bytes;
+}
+
+HRESULT GeometryPool::AddPage(UINT vertexBytes, UINT indexBytes)
+{
+    Page page;
+    std::string name = "GeometryPool" + std::to_string(m_pages.size());
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = vertexBytes;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+    desc.StructureByteStride = 0;
+    HRESULT result = m_pDevice->CreateBuffer(&desc, nullptr, &page.pVertexBuffer);
+    if (SUCCEEDED(result))
+    {
+        std::string bufferName = name + "VertexBuffer";
+        result = page.pVertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)bufferName.length(), bufferName.c_str());
+    }
+
+    if (SUCCEEDED(result))
+    {
+        desc.ByteWidth = indexBytes;
+        desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        result = m_pDevice->CreateBuffer(&desc, nullptr, &page.pIndexBuffer);
+    }
+    if (SUCCEEDED(result))
+    {
+        std::string bufferName = name + "IndexBuffer";
+        result = page.pIndexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)bufferName.length(), bufferName.c_str());
+    }
+
+    if (FAILED(result))
+    {
+        SAFE_RELEASE(page.pVertexBuffer);
+        SAFE_RELEASE(page.pIndexBuffer);
+        return result;
+    }
+    page.vertices.Reset(vertexBytes);
+    page.indices.Reset(indexBytes);
+    m_pages.push_back(std::move(page));
+    return S_OK;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "framework.h"
+#include "RangeAllocator.h"
+
+#include <vector>
+
+// Where a mesh lives in the pool, everything its draws need
+struct PooledMesh
+{
+    UINT page = 0;
+    UINT stride = 0;
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT;
+    // BaseVertexLocation and StartIndexLocation of DrawIndexed
+    UINT baseVertex = 0;
+    UINT startIndex = 0;
+    UINT vertexCount = 0;
+    UINT indexCount = 0;
+    uint32_t vertexHandle = RangeAllocation::InvalidHandle;
+    uint32_t indexHandle = RangeAllocation::InvalidHandle;
+
+    bool IsValid() const { return vertexHandle != RangeAllocation::InvalidHandle; }
+};
+
+// Static meshes sub-allocated from a few large vertex and index buffers. Each page is one pair of buffers with a
+// RangeAllocator per buffer; vertices are placed at a multiple of their stride and indices at a multiple of their
+// size, so a draw selects its mesh through the base vertex and start index alone and the input assembler is only
+// rebound when the page, the stride or the index format changes. 16 and 32-bit indices share the index buffers.
+// Meshes larger than a page get a page of their own size.
+class GeometryPool
+{
+public:
+    static const UINT DefaultVertexPageBytes = 4 << 20;
+    static const UINT DefaultIndexPageBytes = 2 << 20;
+
+    HRESULT Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext,
+        UINT vertexPageBytes = DefaultVertexPageBytes, UINT indexPageBytes = DefaultIndexPageBytes);
+    void Term();
+
+    // Copies the vertices and the indices, DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT, into the first page with
+    // room for both
+    HRESULT Add(const void* pVertices, UINT vertexCount, UINT stride, const void* pIndices, UINT indexCount,
+        DXGI_FORMAT indexFormat, PooledMesh& mesh);
+    void Remove(PooledMesh& mesh);
+
+    // Binds the buffers of the mesh page to slot 0 with the mesh stride, unless they are bound already.
+    // Returns the number of bindings made.
+    UINT Bind(const PooledMesh& mesh);
+    // Forgets what is bound, for when other code may have changed the input assembler state
+    void InvalidateBindings() { m_boundPage = NoPage; }
+
+    size_t GetPageCount() const { return m_pages.size(); }
+    // Bytes of vertex and index data in use and reserved by the pages
+    size_t GetUsedBytes() const;
+    size_t GetCapacityBytes() const;
+
+private:
+    static const UINT NoPage = UINT_MAX;
+
+    struct Page
+    {
+        ID3D11Buffer* pVertexBuffer = NULL;
+        ID3D11Buffer* pIndexBuffer = NULL;
+        // Bytes of the buffers
+        RangeAllocator vertices;
+        RangeAllocator indices;
+    };
+
+    HRESULT AddPage(UINT vertexBytes, UINT indexBytes);
+
+    ID3D11Device* m_pDevice = NULL;
+    ID3D11DeviceContext* m_pDeviceContext = NULL;
+    UINT m_vertexPageBytes = DefaultVertexPageBytes;
+    UINT m_indexPageBytes = DefaultIndexPageBytes;
+    std::vector<Page> m_pages;
+
+    UINT m_boundPage = NoPage;
+    UINT m_boundStride = 0;
+    DXGI_FORMAT m_boundIndexFormat = DXGI_FORMAT_UNKNOWN;
+};
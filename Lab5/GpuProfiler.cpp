@@ -0,0 +1,200 @@
+#include "GpuProfiler.h"
+
+#include <cassert>
+
+namespace
+{
+    uint64_t TicksToNanoseconds(uint64_t ticks, uint64_t frequency)
+    {
+        // Split to keep the full range, ticks * 1e9 overflows after a few seconds of uptime
+        return ticks / frequency * 1000000000ull + static_cast<uint64_t>((ticks % frequency) * 1e9 / frequency);
+    }
+}
+
+bool GpuProfiler::Init(GpuQueryBackend* pBackend)
+{
+    assert(m_pBackend == nullptr);
+    if (!pBackend->CreateQueries(SlotCount, TimestampsPerSlot))
+    {
+        pBackend->ReleaseQueries();
+        return false;
+    }
+    m_pBackend = pBackend;
+    if (m_pTrack == nullptr)
+    {
+        m_pTrack = Profiler::CreateTrack("GPU");
+    }
+    return true;
+}
+
+void GpuProfiler::Term()
+{
+    if (m_pBackend != nullptr)
+    {
+        m_pBackend->ReleaseQueries();
+        m_pBackend = nullptr;
+    }
+    for (Slot& slot : m_slots)
+    {
+        slot = Slot();
+    }
+    m_current = SlotCount;
+    m_resolvedCount = 0;
+    m_isClockCalibrated = false;
+}
+
+void GpuProfiler::BeginFrame()
+{
+    m_current = SlotCount;
+    if (m_pBackend == nullptr)
+    {
+        return;
+    }
+
+    ResolvePending();
+    if (!m_isEnabled)
+    {
+        return;
+    }
+
+    uint32_t slotIdx = static_cast<uint32_t>(m_frame % SlotCount);
+    Slot& slot = m_slots[slotIdx];
+    if (slot.state != SLOT_STATE::FREE)
+    {
+        // The GPU is more than SlotCount frames behind, waiting for it would serialize CPU and GPU
+        m_droppedFrames++;
+        return;
+    }
+
+    slot.state = SLOT_STATE::RECORDING;
+    slot.frame = m_frame;
+    slot.zoneCount = 1;
+    slot.endedZones = 0;
+    slot.names[0] = "Frame";
+    slot.submitTime = Profiler::Now();
+    m_pBackend->BeginDisjoint(slotIdx);
+    m_pBackend->WriteTimestamp(slotIdx, 0);
+    m_current = slotIdx;
+}
+
+void GpuProfiler::EndFrame()
+{
+    if (m_current != SlotCount)
+    {
+        Slot& slot = m_slots[m_current];
+        // A timestamp that is never written would never resolve and block the slot for good
+        for (uint32_t zone = 1; zone < slot.zoneCount; zone++)
+        {
+            if ((slot.endedZones & (1u << zone)) == 0)
+            {
+                m_pBackend->WriteTimestamp(m_current, zone * 2 + 1);
+            }
+        }
+        m_pBackend->WriteTimestamp(m_current, 1);
+        m_pBackend->EndDisjoint(m_current);
+        slot.state = SLOT_STATE::PENDING;
+        m_current = SlotCount;
+    }
+    m_frame++;
+}
+
+uint32_t GpuProfiler::BeginZone(const char* name)
+{
+    if (m_current == SlotCount)
+    {
+        return 0;
+    }
+    Slot& slot = m_slots[m_current];
+    if (slot.zoneCount > MaxZones)
+    {
+        return 0;
+    }
+
+    uint32_t zone = slot.zoneCount++;
+    slot.names[zone] = name;
+    m_pBackend->WriteTimestamp(m_current, zone * 2);
+    return zone;
+}
+
+void GpuProfiler::EndZone(uint32_t zone)
+{
+    // Zone 0 is returned for zones that are not recorded, the frame itself is closed by EndFrame
+    if (m_current == SlotCount || zone == 0)
+    {
+        return;
+    }
+    Slot& slot = m_slots[m_current];
+    assert(zone < slot.zoneCount);
+    slot.endedZones |= 1u << zone;
+    m_pBackend->WriteTimestamp(m_current, zone * 2 + 1);
+}
+
+void GpuProfiler::ResolvePending()
+{
+    // Slots are reused in frame order, so walking from the oldest one visits frames in submission order.
+    // The GPU finishes them in the same order, the first one that is not ready ends the walk.
+    for (uint32_t i = 0; i < SlotCount; i++)
+    {
+        uint32_t slotIdx = static_cast<uint32_t>((m_frame + i) % SlotCount);
+        Slot& slot = m_slots[slotIdx];
+        if (slot.state != SLOT_STATE::PENDING)
+        {
+            continue;
+        }
+        if (!ResolveSlot(slot, slotIdx))
+        {
+            break;
+        }
+    }
+}
+
+bool GpuProfiler::ResolveSlot(Slot& slot, uint32_t slotIdx)
+{
+    uint64_t timestamps[TimestampsPerSlot];
+    uint64_t frequency = 0;
+    bool isDisjoint = false;
+    if (!m_pBackend->ReadResults(slotIdx, slot.zoneCount * 2, timestamps, frequency, isDisjoint))
+    {
+        return false;
+    }
+
+    slot.state = SLOT_STATE::FREE;
+    m_resolveLatency = m_frame - slot.frame;
+
+    // Power state or clock changes make the timestamps of the frame meaningless
+    if (isDisjoint || frequency == 0)
+    {
+        m_disjointFrames++;
+        return true;
+    }
+
+    if (!m_isClockCalibrated || frequency != m_clockFrequency)
+    {
+        m_clockFrequency = frequency;
+        m_clockOffset = static_cast<int64_t>(slot.submitTime) - static_cast<int64_t>(TicksToNanoseconds(timestamps[0], frequency));
+        m_isClockCalibrated = true;
+    }
+    else
+    {
+        int64_t offset = static_cast<int64_t>(slot.submitTime) - static_cast<int64_t>(TicksToNanoseconds(timestamps[0], frequency));
+        if (offset > m_clockOffset)
+        {
+            m_clockOffset = offset;
+        }
+    }
+
+    bool isCapturing = Profiler::IsCapturing();
+    m_resolvedCount = slot.zoneCount;
+    for (uint32_t zone = 0; zone < slot.zoneCount; zone++)
+    {
+        ResolvedZone& resolved = m_resolved[zone];
+        resolved.name = slot.names[zone];
+        resolved.start = static_cast<uint64_t>(static_cast<int64_t>(TicksToNanoseconds(timestamps[zone * 2], frequency)) + m_clockOffset);
+        resolved.end = static_cast<uint64_t>(static_cast<int64_t>(TicksToNanoseconds(timestamps[zone * 2 + 1], frequency)) + m_clockOffset);
+        if (isCapturing)
+        {
+            Profiler::RecordTrackZone(m_pTrack, resolved.name, resolved.start, resolved.end);
+        }
+    }
+    return true;
+}
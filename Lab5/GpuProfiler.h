@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Profiler.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Timestamp queries of one graphics API. Every ring slot owns a disjoint query and a fixed number of
+// timestamp queries; GpuProfiler decides which slot is written and when it is read back.
+class GpuQueryBackend
+{
+public:
+    virtual ~GpuQueryBackend() {}
+
+    virtual bool CreateQueries(uint32_t slotCount, uint32_t timestampsPerSlot) = 0;
+    virtual void ReleaseQueries() = 0;
+
+    virtual void BeginDisjoint(uint32_t slot) = 0;
+    virtual void EndDisjoint(uint32_t slot) = 0;
+    virtual void WriteTimestamp(uint32_t slot, uint32_t index) = 0;
+
+    // Must not block. Returns false while the GPU has not reached the end of the slot yet,
+    // otherwise fills the first count timestamps, the tick frequency and the disjoint flag.
+    virtual bool ReadResults(uint32_t slot, uint32_t count, uint64_t* pTimestamps, uint64_t& frequency, bool& isDisjoint) = 0;
+};
+
+// Brackets GPU work with timestamp queries in a ring of SlotCount frames. Results are read back a few
+// frames later without waiting; when the oldest slot is still in flight the new frame is not recorded
+// instead of stalling. Resolved spans go to the CPU profiler on a "GPU" track.
+class GpuProfiler
+{
+public:
+    static const uint32_t SlotCount = 4;
+    static const uint32_t MaxZones = 16;
+
+    struct ResolvedZone
+    {
+        const char* name;
+        // CPU profiler timeline, nanoseconds
+        uint64_t start;
+        uint64_t end;
+    };
+
+    bool Init(GpuQueryBackend* pBackend);
+    void Term();
+
+    // Recording is skipped while disabled, pending frames are still resolved
+    void SetEnabled(bool enabled) { m_isEnabled = enabled; }
+    bool IsEnabled() const { return m_isEnabled; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Zone names must outlive the profiler. Returns the zone index to pass to EndZone.
+    uint32_t BeginZone(const char* name);
+    void EndZone(uint32_t zone);
+
+    // Zones of the most recently resolved frame, the whole frame first
+    size_t GetResolvedZoneCount() const { return m_resolvedCount; }
+    const ResolvedZone& GetResolvedZone(size_t idx) const { return m_resolved[idx]; }
+    // Frames since the previous one that was resolved, i.e. how far behind the results are
+    uint64_t GetResolveLatency() const { return m_resolveLatency; }
+    uint64_t GetDroppedFrameCount() const { return m_droppedFrames; }
+    uint64_t GetDisjointFrameCount() const { return m_disjointFrames; }
+
+private:
+    enum class SLOT_STATE
+    {
+        FREE,
+        RECORDING,
+        PENDING
+    };
+
+    struct Slot
+    {
+        SLOT_STATE state = SLOT_STATE::FREE;
+        uint64_t frame = 0;
+        // CPU time right before the first timestamp was issued
+        uint64_t submitTime = 0;
+        uint32_t zoneCount = 0;
+        // Bit per zone whose end timestamp has been written
+        uint32_t endedZones = 0;
+        const char* names[MaxZones + 1] = {};
+    };
+
+    // Zone 0 spans the frame, its timestamps are 0 and 1
+    static const uint32_t TimestampsPerSlot = (MaxZones + 1) * 2;
+
+    void ResolvePending();
+    bool ResolveSlot(Slot& slot, uint32_t slotIdx);
+
+    GpuQueryBackend* m_pBackend = nullptr;
+    bool m_isEnabled = false;
+    Profiler::Track* m_pTrack = nullptr;
+
+    Slot m_slots[SlotCount];
+    uint64_t m_frame = 0;
+    // Slot being recorded this frame, SlotCount when the frame is skipped
+    uint32_t m_current = SlotCount;
+
+    // Offset from GPU ticks converted to nanoseconds to the CPU profiler clock. GPU work cannot start
+    // before it was submitted, so every frame gives a lower bound and the largest one is the best estimate.
+    int64_t m_clockOffset = 0;
+    uint64_t m_clockFrequency = 0;
+    bool m_isClockCalibrated = false;
+
+    ResolvedZone m_resolved[MaxZones + 1];
+    size_t m_resolvedCount = 0;
+    uint64_t m_resolveLatency = 0;
+    uint64_t m_droppedFrames = 0;
+    uint64_t m_disjointFrames = 0;
+};
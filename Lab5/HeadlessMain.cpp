@@ -0,0 +1,81 @@
+// Entry point of the headless replay and scene benchmark outside the application, it is not part of the Visual Studio
+// project. On Linux, with DirectXMath on the include path (see Platform.h):
+//   g++ -std=c++14 -O2 -pthread -DENABLE_ALLOCATION_COUNTER=1 -I<DirectXMath>/Inc -o headless HeadlessMain.cpp
+//       HeadlessScene.cpp Scene.cpp Camera.cpp TransparentPass.cpp TransparencySorter.cpp ViewDepth.cpp
+//       FrameArena.cpp InputQueue.cpp InputRecording.cpp Profiler.cpp AllocationCounter.cpp
+//   ./headless --replay <file> [--max-rendered <count>]
+//   ./headless --benchmark [--frames <count>] [--objects <count>] [--report <file>]
+// Exit codes follow the application: 1 for bad arguments or files, 2 for a failed check.
+
+#include "HeadlessScene.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    std::string replayPath;
+    std::string reportPath;
+    bool benchmark = false;
+    size_t maxRenderedFrames = 0;
+    size_t frameCount = 1000;
+    size_t objectCount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-rendered") == 0 && hasValue)
+        {
+            maxRenderedFrames = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            frameCount = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--objects") == 0 && hasValue)
+        {
+            objectCount = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--report") == 0 && hasValue)
+        {
+            reportPath = argv[++i];
+        }
+        else
+        {
+            printf("Unrecognized argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!benchmark)
+    {
+        return RunHeadlessReplay(std::wstring(replayPath.begin(), replayPath.end()), maxRenderedFrames);
+    }
+
+    FILE* pReport = nullptr;
+    if (!reportPath.empty())
+    {
+        pReport = fopen(reportPath.c_str(), "w");
+        if (pReport == nullptr)
+        {
+            printf("Failed to open report file %s\n", reportPath.c_str());
+            return 1;
+        }
+    }
+    int result = RunSceneBenchmark(frameCount, objectCount, pReport);
+    if (pReport != nullptr)
+    {
+        fclose(pReport);
+    }
+    return result;
+}
@@ -0,0 +1,312 @@
+#include "HeadlessScene.h"
+#include "Scene.h"
+#include "TransparentPass.h"
+#include "TripleBuffer.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    // Aspect ratio and index count of what the renderer draws by default
+    const float BenchmarkAspectRatio = 720.0f / 1280.0f;
+    const uint32_t CubeIndexCount = 36;
+
+    // Per-object constants the null submission copies where the renderer calls UpdateSubresource
+    struct ObjectConstants
+    {
+        DirectX::XMMATRIX model;
+        DirectX::XMVECTOR color;
+    };
+
+    struct FrameRecord
+    {
+        double updateTime = 0.0;
+        double renderTime = 0.0;
+        uint64_t heapAllocations = 0;
+        PassStats stats;
+    };
+
+    InputEvent MakeEvent(InputEvent::TYPE type, uint32_t wParam, int x, int y)
+    {
+        InputEvent event;
+        event.type = type;
+        event.wParam = wParam;
+        event.lParam = static_cast<uint32_t>((x & 0xFFFF) | ((y & 0xFFFF) << 16));
+        return event;
+    }
+
+    double Percentile(std::vector<double> values, double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        size_t idx = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return values[idx];
+    }
+
+    double Mean(const std::vector<double>& values)
+    {
+        double sum = 0.0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        return values.empty() ? 0.0 : sum / values.size();
+    }
+
+    bool WriteJsonReport(FILE* pFile, size_t objectCount, const std::vector<FrameRecord>& frames)
+    {
+        std::vector<double> frameTimes;
+        std::vector<double> updateTimes;
+        std::vector<double> renderTimes;
+        double drawCalls = 0.0;
+        double bytesUploaded = 0.0;
+        double culledObjects = 0.0;
+        uint64_t heapAllocations = 0;
+        uint64_t maxHeapAllocations = 0;
+        frameTimes.reserve(frames.size());
+        updateTimes.reserve(frames.size());
+        renderTimes.reserve(frames.size());
+        for (const FrameRecord& frame : frames)
+        {
+            frameTimes.push_back((frame.updateTime + frame.renderTime) * 1000.0);
+            updateTimes.push_back(frame.updateTime * 1000.0);
+            renderTimes.push_back(frame.renderTime * 1000.0);
+            drawCalls += frame.stats.drawCalls;
+            bytesUploaded += static_cast<double>(frame.stats.bytesUploaded);
+            culledObjects += frame.stats.culledObjects;
+            heapAllocations += frame.heapAllocations;
+            maxHeapAllocations = (std::max)(maxHeapAllocations, frame.heapAllocations);
+        }
+        double count = frames.empty() ? 1.0 : static_cast<double>(frames.size());
+
+        fprintf(pFile, "{\n");
+        fprintf(pFile, "  \"frames\": %zu,\n", frames.size());
+        fprintf(pFile, "  \"objects\": %zu,\n", objectCount);
+        fprintf(pFile, "  \"backend\": \"none\",\n");
+        fprintf(pFile, "  \"cpuFrameTimeMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            Mean(frameTimes), Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.9), Percentile(frameTimes, 0.99), Percentile(frameTimes, 1.0));
+        fprintf(pFile, "  \"updateTimeMs\": { \"mean\": %.4f, \"p99\": %.4f },\n", Mean(updateTimes), Percentile(updateTimes, 0.99));
+        fprintf(pFile, "  \"transparentTimeMs\": { \"mean\": %.4f, \"p99\": %.4f },\n", Mean(renderTimes), Percentile(renderTimes, 0.99));
+        fprintf(pFile, "  \"drawCallsPerFrame\": %.2f,\n", drawCalls / count);
+        fprintf(pFile, "  \"bytesUploadedPerFrame\": %.2f,\n", bytesUploaded / count);
+        fprintf(pFile, "  \"culledObjectsPerFrame\": %.2f,\n", culledObjects / count);
+        fprintf(pFile, "  \"heapAllocationsPerFrame\": { \"mean\": %.2f, \"max\": %llu }\n",
+            heapAllocations / count, static_cast<unsigned long long>(maxHeapAllocations));
+        fprintf(pFile, "}\n");
+        return ferror(pFile) == 0;
+    }
+}
+
+void GenerateBenchmarkInput(size_t frame, size_t frameCount, std::vector<InputEvent>& events)
+{
+    const int CenterX = 640;
+    const int CenterY = 360;
+
+    events.clear();
+    if (frame == 0)
+    {
+        events.push_back(MakeEvent(InputEvent::TYPE::LMOUSE_DOWN, MK_LBUTTON, CenterX, CenterY));
+    }
+
+    int x = CenterX + static_cast<int>(frame * 4);
+    int y = CenterY + static_cast<int>(120.0 * sin(frame * 0.01));
+    events.push_back(MakeEvent(InputEvent::TYPE::MOUSE_MOVE, MK_LBUTTON, x, y));
+
+    if (frame % 60 == 30)
+    {
+        short delta = (frame / 60) % 2 == 0 ? WHEEL_DELTA : -WHEEL_DELTA;
+        events.push_back(MakeEvent(InputEvent::TYPE::MOUSE_WHEEL, static_cast<uint32_t>(static_cast<uint16_t>(delta)) << 16, x, y));
+    }
+
+    if (frame == frameCount / 3)
+    {
+        events.push_back(MakeEvent(InputEvent::TYPE::KEY_DOWN, 'F', 0, 0));
+        events.push_back(MakeEvent(InputEvent::TYPE::KEY_DOWN, 'W', 0, 0));
+    }
+    else if (frame == frameCount * 2 / 3)
+    {
+        events.push_back(MakeEvent(InputEvent::TYPE::KEY_UP, 'W', 0, 0));
+        events.push_back(MakeEvent(InputEvent::TYPE::KEY_DOWN, 'F', 0, 0));
+    }
+}
+
+int RunHeadlessReplay(const std::wstring& replayPath, size_t maxRenderedFrames)
+{
+    InputReplay replay;
+    if (replayPath.empty() || !replay.Open(replayPath))
+    {
+        printf("Headless mode requires a valid --replay file\n");
+        return 1;
+    }
+
+    std::unique_ptr<Scene> pScene = std::make_unique<Scene>();
+    std::vector<InputEvent> events;
+    double deltaTime = 0.0;
+    size_t frameCount = 0;
+    unsigned long long hash = 14695981039346656037ull;
+
+    // Frames the idle-aware render thread would draw at one frame per step
+    SceneSnapshot snapshot;
+    size_t renderedCount = 0;
+    uint64_t renderedVersion = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (replay.NextFrame(deltaTime, events))
+    {
+        for (const InputEvent& event : events)
+        {
+            pScene->PostInput(event);
+        }
+        pScene->Update(deltaTime);
+        frameCount++;
+
+        pScene->GetSnapshot(snapshot);
+        if (snapshot.NeedsRender(renderedVersion, renderedCount == 0))
+        {
+            renderedCount++;
+            renderedVersion = snapshot.version;
+        }
+
+        // FNV-1a over the model transform and the camera pose
+        DirectX::XMVECTOR cameraPose[] = { pScene->GetCamera().GetPosition(), pScene->GetCamera().GetOrientation() };
+        const std::pair<const void*, size_t> blocks[] = {
+            { &pScene->GetModelTransform(), sizeof(DirectX::XMMATRIX) },
+            { cameraPose, sizeof(cameraPose) },
+        };
+        for (const std::pair<const void*, size_t>& block : blocks)
+        {
+            const unsigned char* pBytes = reinterpret_cast<const unsigned char*>(block.first);
+            for (size_t i = 0; i < block.second; i++)
+            {
+                hash = (hash ^ pBytes[i]) * 1099511628211ull;
+            }
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Replayed %zu frames in %.3f ms (%.3f us per update), state hash %016llx\n",
+        frameCount, elapsed * 1000.0, frameCount > 0 ? elapsed * 1e6 / frameCount : 0.0, hash);
+    printf("%zu of %zu frames would be rendered, %zu skipped as unchanged\n",
+        renderedCount, frameCount, frameCount - renderedCount);
+
+    // A regression in idle detection shows up as frames rendered for a recording that sits still
+    if (maxRenderedFrames != 0 && renderedCount > maxRenderedFrames)
+    {
+        printf("FAILED: more than the expected %zu frames would be rendered\n", maxRenderedFrames);
+        return 2;
+    }
+    return 0;
+}
+
+int RunSceneBenchmark(size_t frameCount, size_t objectCount, FILE* pReport)
+{
+    using Clock = std::chrono::steady_clock;
+    const double SimulationStep = 1. / 60;
+    const size_t WarmupFrames = 10;
+
+    std::unique_ptr<Scene> pScene = std::make_unique<Scene>();
+    pScene->SetTransparentObjectCount(objectCount);
+    std::unique_ptr<TripleBuffer<SceneSnapshot>> pSnapshots = std::make_unique<TripleBuffer<SceneSnapshot>>();
+
+    // The render side of the frame, projection as the renderer sets it for the default resolution
+    Camera camera;
+    camera.SetPerspective(static_cast<float>(M_PI) / 2, BenchmarkAspectRatio, 0.1f, 100.0f);
+    TransparencySorter sorter;
+    SceneState state;
+    std::vector<ObjectConstants> uploads;
+    uploads.reserve(pScene->GetTransparentObjects().size());
+
+    std::vector<FrameRecord> frames;
+    frames.reserve(frameCount);
+    std::vector<InputEvent> events;
+
+    for (size_t frame = 0; frame < WarmupFrames + frameCount; frame++)
+    {
+        PROFILE_SCOPE("SceneBenchmarkFrame");
+
+        GenerateBenchmarkInput(frame, WarmupFrames + frameCount, events);
+        for (const InputEvent& event : events)
+        {
+            pScene->PostInput(event);
+        }
+
+        uint64_t allocationsBefore = GetHeapAllocationCount();
+        Clock::time_point start = Clock::now();
+        pScene->Update(SimulationStep);
+        SceneSnapshot& published = pSnapshots->GetWriteBuffer();
+        pScene->GetSnapshot(published);
+        published.stateTime = start;
+        published.step = SimulationStep;
+        pSnapshots->Publish();
+        Clock::time_point updated = Clock::now();
+
+        PassStats stats;
+        {
+            // Halfway between the two steps, like a render thread running at the simulation rate
+            pSnapshots->Acquire();
+            const SceneSnapshot& snapshot = pSnapshots->GetReadBuffer();
+            snapshot.Interpolate(snapshot.stateTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SimulationStep / 2)), state);
+            camera.SetPose(state.camera.GetPosition(), state.camera.GetOrientation());
+
+            FrameVector<const SceneObject*> visible;
+            CollectSortedTransparent(state, camera, sorter, visible, stats);
+            uploads.clear();
+            for (const SceneObject* pObject : visible)
+            {
+                ObjectConstants constants = { DirectX::XMMatrixTranslation(pObject->position.x, pObject->position.y, pObject->position.z), DirectX::XMLoadFloat4(&pObject->color) };
+                uploads.push_back(constants);
+                stats.CountUpload(sizeof(ObjectConstants));
+                stats.CountDraw(CubeIndexCount);
+            }
+        }
+        FrameArena::GetThreadArena().Reset();
+        Clock::time_point rendered = Clock::now();
+        uint64_t allocationsAfter = GetHeapAllocationCount();
+
+        if (frame >= WarmupFrames)
+        {
+            FrameRecord record;
+            record.updateTime = std::chrono::duration<double>(updated - start).count();
+            record.renderTime = std::chrono::duration<double>(rendered - updated).count();
+            record.heapAllocations = allocationsAfter - allocationsBefore;
+            record.stats = stats;
+            frames.push_back(record);
+        }
+    }
+
+    if (pReport != nullptr && !WriteJsonReport(pReport, pScene->GetTransparentObjects().size(), frames))
+    {
+        printf("Failed to write the report\n");
+        return 1;
+    }
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frames.size());
+    size_t allocatingFrames = 0;
+    for (const FrameRecord& frame : frames)
+    {
+        frameTimes.push_back((frame.updateTime + frame.renderTime) * 1000.0);
+        allocatingFrames += frame.heapAllocations != 0 ? 1 : 0;
+    }
+    printf("%zu frames, no graphics backend, %zu objects, sorted transparency: CPU frame time p50 %.3f ms, p99 %.3f ms\n",
+        frames.size(), pScene->GetTransparentObjects().size(), Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.99));
+
+#if !ENABLE_ALLOCATION_COUNTER
+    printf("Heap allocations per frame were not checked, use the Benchmark configuration or ENABLE_ALLOCATION_COUNTER=1 to check them\n");
+#endif
+
+    // Steady state frames must not touch the heap, the profiler is the only expected exception
+    if (allocatingFrames != 0 && !Profiler::IsCapturing())
+    {
+        printf("FAILED: %zu of %zu frames performed heap allocations\n", allocatingFrames, frames.size());
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "InputEvent.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Scene driving parts of the application that need neither a window nor a graphics device. They build on any
+// platform with DirectXMath, HeadlessMain.cpp runs them as a console program for CI on Linux.
+
+// Events of one frame of the scripted benchmark input: orbits the camera with a mouse drag for the whole run, zooms
+// in and out with the wheel and walks forward through the middle third in first person view
+void GenerateBenchmarkInput(size_t frame, size_t frameCount, std::vector<InputEvent>& events);
+
+// Drives the scene from a recording and prints a hash of the produced states so runs can be compared.
+// Returns 1 if the recording cannot be read and 2 if idle rendering would draw more frames than
+// maxRenderedFrames, 0 leaves that unchecked.
+int RunHeadlessReplay(const std::wstring& replayPath, size_t maxRenderedFrames);
+
+// Runs the scripted input through the scene update, snapshot handoff and interpolation, and the sorted transparency
+// pass up to submission, which only counts the draws and copies their constants. Prints CPU frame time percentiles,
+// writes a JSON summary to pReport unless it is null and returns 2 if any measured frame performed a heap allocation.
+int RunSceneBenchmark(size_t frameCount, size_t objectCount, FILE* pReport);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Window input captured by WndProc and consumed by the scene at the start of the next update.
+// Message parameters are kept as 32 bit values, which is all the handled messages use.
+struct InputEvent
+{
+    enum class TYPE : uint32_t
+    {
+        KEY_DOWN,
+        KEY_UP,
+        MOUSE_MOVE,
+        LMOUSE_DOWN,
+        LMOUSE_UP,
+        MOUSE_WHEEL
+    };
+
+    TYPE type = TYPE::KEY_DOWN;
+    uint32_t wParam = 0;
+    uint32_t lParam = 0;
+    // Seconds on the steady clock when the message was received
+    double time = 0.0;
+};
@@ -0,0 +1,116 @@
+#include "InputQueue.h"
+
+namespace
+{
+    // Repeat count 1 with the previous state and transition bits set, what WM_KEYUP carries for a single release
+    const uint32_t KeyUpLParam = 0xC0000001;
+}
+
+InputQueue::InputQueue()
+    : m_hasPendingMouseUp(false)
+    , m_pendingMouseUpLParam(0)
+    , m_droppedCount(0)
+{
+    for (std::atomic<uint64_t>& word : m_pendingKeyUps)
+    {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool InputQueue::Push(const InputEvent& event)
+{
+    if (!HasPendingReleases() && m_queue.Push(event))
+    {
+        return true;
+    }
+
+    if (event.type == InputEvent::TYPE::KEY_UP && event.wParam < 256)
+    {
+        m_pendingKeyUps[event.wParam / 64].fetch_or(1ull << (event.wParam % 64), std::memory_order_release);
+        return true;
+    }
+    if (event.type == InputEvent::TYPE::LMOUSE_UP)
+    {
+        m_pendingMouseUpLParam.store(event.lParam, std::memory_order_relaxed);
+        m_hasPendingMouseUp.store(true, std::memory_order_release);
+        return true;
+    }
+    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool InputQueue::Pop(InputEvent& event)
+{
+    if (!m_queue.Pop(event))
+    {
+        // Releases are only set aside while the queue is full, so everything queued before them is out by now
+        return PopPendingRelease(event);
+    }
+
+    // Only the latest position of a run of mouse moves matters
+    if (event.type == InputEvent::TYPE::MOUSE_MOVE)
+    {
+        const InputEvent* pNext = m_queue.Front();
+        while (pNext != nullptr && pNext->type == InputEvent::TYPE::MOUSE_MOVE)
+        {
+            m_queue.Pop(event);
+            pNext = m_queue.Front();
+        }
+    }
+    m_lastEventTime = event.time;
+    return true;
+}
+
+bool InputQueue::Empty() const
+{
+    return m_queue.Empty() && !HasPendingReleases();
+}
+
+bool InputQueue::HasPendingReleases() const
+{
+    if (m_hasPendingMouseUp.load(std::memory_order_acquire))
+    {
+        return true;
+    }
+    for (const std::atomic<uint64_t>& word : m_pendingKeyUps)
+    {
+        if (word.load(std::memory_order_acquire) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputQueue::PopPendingRelease(InputEvent& event)
+{
+    event = InputEvent();
+    event.time = m_lastEventTime;
+    for (size_t i = 0; i < KeyWordCount; i++)
+    {
+        uint64_t bits = m_pendingKeyUps[i].load(std::memory_order_acquire);
+        if (bits == 0)
+        {
+            continue;
+        }
+
+        uint32_t bit = 0;
+        while ((bits & (1ull << bit)) == 0)
+        {
+            bit++;
+        }
+        m_pendingKeyUps[i].fetch_and(~(1ull << bit), std::memory_order_acq_rel);
+        event.type = InputEvent::TYPE::KEY_UP;
+        event.wParam = static_cast<uint32_t>(i * 64 + bit);
+        event.lParam = KeyUpLParam;
+        return true;
+    }
+
+    if (m_hasPendingMouseUp.exchange(false, std::memory_order_acq_rel))
+    {
+        event.type = InputEvent::TYPE::LMOUSE_UP;
+        event.lParam = m_pendingMouseUpLParam.load(std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "InputEvent.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Input from the window thread to the scene update. When the queue is full a key or mouse button release is kept
+// aside and delivered once the queue has drained, so a held key can never get stuck down. Everything else that does
+// not fit is dropped and counted, as is everything pushed while a release is waiting, which keeps the releases in
+// order with the events around them.
+class InputQueue
+{
+public:
+    static const size_t Capacity = 1024;
+
+    InputQueue();
+
+    InputQueue(const InputQueue&) = delete;
+    InputQueue& operator=(const InputQueue&) = delete;
+
+    // Producer side, returns false if the event was dropped
+    bool Push(const InputEvent& event);
+
+    // Consumer side, returns false once nothing is left. A run of mouse moves comes out as its latest one.
+    bool Pop(InputEvent& event);
+
+    bool Empty() const;
+    uint64_t GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t KeyWordCount = 256 / 64;
+
+    bool HasPendingReleases() const;
+    bool PopPendingRelease(InputEvent& event);
+
+    SpscQueue<InputEvent, Capacity> m_queue;
+    // One bit per virtual key whose release is waiting
+    std::atomic<uint64_t> m_pendingKeyUps[KeyWordCount];
+    std::atomic<bool> m_hasPendingMouseUp;
+    std::atomic<uint32_t> m_pendingMouseUpLParam;
+    std::atomic<uint64_t> m_droppedCount;
+    // Consumer side, stamps the releases delivered late
+    double m_lastEventTime = 0.0;
+};
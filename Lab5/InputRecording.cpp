@@ -0,0 +1,204 @@
+#include "InputRecording.h"
+
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+
+static const char RecordingMagic[4] = { 'L', '5', 'I', 'R' };
+static const uint32_t RecordingVersion = 1;
+static const size_t HeaderSize = sizeof(RecordingMagic) + sizeof(uint32_t);
+static const size_t EventSize = sizeof(uint8_t) + 2 * sizeof(uint32_t) + sizeof(float);
+
+template <typename T>
+static void Append(std::vector<char>& buffer, const T& value)
+{
+    const char* pBytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), pBytes, pBytes + sizeof(T));
+}
+
+static FILE* OpenFile(const std::wstring& path, const wchar_t* mode)
+{
+    FILE* pFile = nullptr;
+#ifdef _WIN32
+    _wfopen_s(&pFile, path.c_str(), mode);
+#else
+    std::string mbPath(path.begin(), path.end());
+    std::string mbMode(mode, mode + wcslen(mode));
+    pFile = fopen(mbPath.c_str(), mbMode.c_str());
+#endif
+    return pFile;
+}
+
+static long long GetFileSize(FILE* pFile)
+{
+#ifdef _WIN32
+    _fseeki64(pFile, 0, SEEK_END);
+    long long size = _ftelli64(pFile);
+    _fseeki64(pFile, 0, SEEK_SET);
+#else
+    fseeko(pFile, 0, SEEK_END);
+    long long size = ftello(pFile);
+    fseeko(pFile, 0, SEEK_SET);
+#endif
+    return size;
+}
+
+template <typename T>
+static bool Read(const std::vector<char>& buffer, size_t& offset, T& value)
+{
+    if (offset + sizeof(T) > buffer.size())
+    {
+        return false;
+    }
+    memcpy(&value, buffer.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+InputRecorder::~InputRecorder()
+{
+    Close();
+}
+
+bool InputRecorder::Open(const std::wstring& path)
+{
+    Close();
+    m_pFile = OpenFile(path, L"wb");
+    if (m_pFile == nullptr)
+    {
+        return false;
+    }
+    fwrite(RecordingMagic, 1, sizeof(RecordingMagic), m_pFile);
+    fwrite(&RecordingVersion, sizeof(RecordingVersion), 1, m_pFile);
+    m_startTime = -1.0;
+    return true;
+}
+
+void InputRecorder::Close()
+{
+    if (m_pFile != nullptr)
+    {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+}
+
+void InputRecorder::BeginFrame(double deltaTime)
+{
+    m_deltaTime = deltaTime;
+    m_events.clear();
+}
+
+void InputRecorder::RecordEvent(const InputEvent& event)
+{
+    m_events.push_back(event);
+}
+
+void InputRecorder::EndFrame()
+{
+    if (m_pFile == nullptr)
+    {
+        return;
+    }
+
+    m_frameData.clear();
+    Append(m_frameData, m_deltaTime);
+    Append(m_frameData, static_cast<uint16_t>(m_events.size()));
+    for (const InputEvent& event : m_events)
+    {
+        if (m_startTime < 0.0)
+        {
+            m_startTime = event.time;
+        }
+        Append(m_frameData, static_cast<uint8_t>(event.type));
+        Append(m_frameData, event.wParam);
+        Append(m_frameData, event.lParam);
+        Append(m_frameData, static_cast<float>(event.time - m_startTime));
+    }
+    fwrite(m_frameData.data(), 1, m_frameData.size(), m_pFile);
+}
+
+bool InputReplay::Open(const std::wstring& path)
+{
+    FILE* pFile = OpenFile(path, L"rb");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    long long size = GetFileSize(pFile);
+    if (size < 0)
+    {
+        fclose(pFile);
+        return false;
+    }
+
+    m_data.resize(static_cast<size_t>(size));
+    size_t rd = fread(m_data.data(), 1, m_data.size(), pFile);
+    fclose(pFile);
+
+    uint32_t version = 0;
+    size_t offset = sizeof(RecordingMagic);
+    if (rd != m_data.size() || m_data.size() < HeaderSize ||
+        memcmp(m_data.data(), RecordingMagic, sizeof(RecordingMagic)) != 0 ||
+        !Read(m_data, offset, version) || version != RecordingVersion)
+    {
+        m_data.clear();
+        return false;
+    }
+
+    // Count frames up front so replays can report progress
+    m_frameCount = 0;
+    while (offset < m_data.size())
+    {
+        double deltaTime = 0.0;
+        uint16_t eventCount = 0;
+        if (!Read(m_data, offset, deltaTime) || !Read(m_data, offset, eventCount))
+        {
+            break;
+        }
+        offset += eventCount * EventSize;
+        if (offset > m_data.size())
+        {
+            break;
+        }
+        m_frameCount++;
+    }
+
+    Rewind();
+    return true;
+}
+
+void InputReplay::Rewind()
+{
+    m_offset = m_data.empty() ? 0 : HeaderSize;
+}
+
+bool InputReplay::NextFrame(double& deltaTime, std::vector<InputEvent>& events)
+{
+    events.clear();
+
+    uint16_t eventCount = 0;
+    if (!Read(m_data, m_offset, deltaTime) || !Read(m_data, m_offset, eventCount))
+    {
+        m_offset = m_data.size();
+        return false;
+    }
+
+    for (uint16_t i = 0; i < eventCount; i++)
+    {
+        uint8_t type = 0;
+        float time = 0.0f;
+        InputEvent event;
+        if (!Read(m_data, m_offset, type) || !Read(m_data, m_offset, event.wParam) ||
+            !Read(m_data, m_offset, event.lParam) || !Read(m_data, m_offset, time))
+        {
+            m_offset = m_data.size();
+            return false;
+        }
+        event.type = static_cast<InputEvent::TYPE>(type);
+        event.time = time;
+        events.push_back(event);
+    }
+    return true;
+}
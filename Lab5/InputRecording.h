@@ -0,0 +1,50 @@
+#pragma once
+
+#include "InputEvent.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary log of everything that drives the scene: the delta time of every update and
+// the input events consumed by it.
+//
+// Layout: header { "L5IR", version }, then per update:
+//   double deltaTime, uint16 eventCount, eventCount * { uint8 type, uint32 wParam, uint32 lParam, float time }
+// Event time is relative to the start of the recording.
+class InputRecorder
+{
+    FILE* m_pFile = nullptr;
+    double m_deltaTime = 0.0;
+    double m_startTime = -1.0;
+    std::vector<InputEvent> m_events;
+    // Serialized frame, kept to reuse its capacity so recording does not allocate every frame
+    std::vector<char> m_frameData;
+
+public:
+    ~InputRecorder();
+
+    bool Open(const std::wstring& path);
+    void Close();
+    bool IsOpen() const { return m_pFile != nullptr; }
+
+    void BeginFrame(double deltaTime);
+    void RecordEvent(const InputEvent& event);
+    void EndFrame();
+};
+
+class InputReplay
+{
+    std::vector<char> m_data;
+    size_t m_offset = 0;
+    size_t m_frameCount = 0;
+
+public:
+    bool Open(const std::wstring& path);
+
+    // Returns false once the recording is exhausted
+    bool NextFrame(double& deltaTime, std::vector<InputEvent>& events);
+    void Rewind();
+    bool IsFinished() const { return m_offset >= m_data.size(); }
+    size_t GetFrameCount() const { return m_frameCount; }
+};
@@ -0,0 +1,80 @@
+#include "JobPool.h"
+
+JobPool::JobPool(uint32_t threadCount) : m_next(0)
+{
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&JobPool::WorkerMain, this);
+    }
+}
+
+JobPool::~JobPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void JobPool::Dispatch(size_t count, JobFunction function, const void* pContext)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = function;
+        m_pContext = pContext;
+        m_count = count;
+        m_next = 0;
+        m_activeWorkers = static_cast<uint32_t>(m_threads.size());
+        m_batch++;
+    }
+    m_wake.notify_all();
+
+    Work();
+
+    // Workers may still be running their last item even once every item has been claimed
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_activeWorkers == 0; });
+}
+
+void JobPool::WorkerMain()
+{
+    uint64_t lastBatch = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_exit || m_batch != lastBatch; });
+            if (m_exit)
+            {
+                return;
+            }
+            lastBatch = m_batch;
+        }
+
+        Work();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_activeWorkers == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+void JobPool::Work()
+{
+    for (size_t item = m_next++; item < m_count; item = m_next++)
+    {
+        m_function(m_pContext, item);
+    }
+}
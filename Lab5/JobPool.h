@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads that stay alive between batches, for per frame work where starting threads like ParallelFor does
+// would cost more than the work itself. A batch still costs a wake up of every worker, so each call should carry
+// many items. Only one thread may run a batch at a time.
+class JobPool
+{
+public:
+    // threadCount includes the calling thread, which works on every batch too
+    explicit JobPool(uint32_t threadCount);
+    ~JobPool();
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+    // Calls function(item) for every item and returns once all of them have finished
+    template <typename Function>
+    void Run(size_t count, const Function& function)
+    {
+        Dispatch(count, &Invoke<Function>, &function);
+    }
+
+private:
+    typedef void (*JobFunction)(const void* pContext, size_t item);
+
+    template <typename Function>
+    static void Invoke(const void* pContext, size_t item)
+    {
+        (*static_cast<const Function*>(pContext))(item);
+    }
+
+    void Dispatch(size_t count, JobFunction function, const void* pContext);
+    void WorkerMain();
+    void Work();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    // Bumped for every batch, workers compare it with the last one they ran
+    uint64_t m_batch = 0;
+    uint32_t m_activeWorkers = 0;
+    bool m_exit = false;
+
+    JobFunction m_function = nullptr;
+    const void* m_pContext = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_next;
+};
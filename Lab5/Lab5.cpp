@@ -4,6 +4,18 @@
 #include "framework.h"
 #include "Lab5.h"
 #include "Renderer.h"
+#include "RenderThread.h"
+#include "CommandLine.h"
+#include "Benchmark.h"
+#include "HeadlessScene.h"
+#include "Microbench.h"
+#include "MeshReport.h"
+#include "SkinningBenchmark.h"
+#include "SelfTest.h"
+#include "Profiler.h"
+#include "InputRecording.h"
+
+#include <cstdio>
 
 #define MAX_LOADSTRING 100
 
@@ -11,6 +23,13 @@ struct MyWindowData
 {
     std::unique_ptr<Renderer> pRenderer;
     std::unique_ptr<Scene> pScene;
+    std::unique_ptr<RenderThread> pRenderThread;
+    HWND hWnd = NULL;
+
+    InputRecorder recorder;
+    InputReplay replay;
+    bool isReplaying = false;
+    std::vector<InputEvent> replayEvents;
 
     MyWindowData() : pRenderer(std::make_unique<Renderer>()), pScene(std::make_unique<Scene>()) { };
 };
@@ -24,6 +43,11 @@ WCHAR szWindowClass[MAX_LOADSTRING];            // the main window class name
 ATOM                MyRegisterClass(HINSTANCE hInstance);
 BOOL                InitInstance(HINSTANCE, int, MyWindowData*);
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
+bool                StepScene(MyWindowData* pMyWindowData, double deltaTime);
+void                AttachParentConsole();
+void                WriteProfile(const AppOptions& options);
+void                UpdateFrameStats(HWND hWnd, const RenderThread& renderThread, bool isIdle, uint64_t droppedInputCount);
+void                PostInputEvent(HWND hWnd, InputEvent::TYPE type, WPARAM wParam, LPARAM lParam);
 
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
@@ -32,7 +56,92 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_ int       nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
+
+    AppOptions options;
+    if (!ParseCommandLine(lpCmdLine, options))
+    {
+        AttachParentConsole();
+        wprintf(L"Unrecognized command line: %s\n", lpCmdLine);
+        return 1;
+    }
+
+    if (!options.profilePath.empty())
+    {
+        PROFILE_THREAD_NAME("Main");
+        Profiler::BeginCapture();
+    }
+
+    if (options.benchmark)
+    {
+        AttachParentConsole();
+        int result = RunBenchmark(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.pacingTest)
+    {
+        AttachParentConsole();
+        int result = RunPacingTest(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.selfTest)
+    {
+        AttachParentConsole();
+        int result = RunSelfTests(options.selfTestFilter);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.microbench)
+    {
+        AttachParentConsole();
+        int result = RunMicrobenchmarks(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.meshReport)
+    {
+        AttachParentConsole();
+        int result = RunMeshReport(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.lodReport)
+    {
+        AttachParentConsole();
+        int result = RunLodReport(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.skinningBenchmark)
+    {
+        AttachParentConsole();
+        int result = RunSkinningBenchmark(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (!options.meshExportPath.empty())
+    {
+        AttachParentConsole();
+        int result = RunMeshExport(options);
+        WriteProfile(options);
+        return result;
+    }
+
+    if (options.headless)
+    {
+        AttachParentConsole();
+        int result = RunHeadlessReplay(options.replayPath, options.maxRenderedFrames);
+        WriteProfile(options);
+        return result;
+    }
 
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
@@ -40,6 +149,34 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     MyRegisterClass(hInstance);
 
     MyWindowData* pMyWindowData = new struct MyWindowData();
+    pMyWindowData->pScene->SetTransparentObjectCount(options.objectCount);
+    pMyWindowData->pRenderer->SetTransparencyMode(options.transparencyMode);
+    pMyWindowData->pRenderer->SetVertexPrecision(options.vertexPrecision);
+    pMyWindowData->pRenderer->SetModelPath(options.modelPath);
+
+    // Falling back to live input would make a perf run measure something else than the recording it names
+    if (!options.replayPath.empty())
+    {
+        pMyWindowData->isReplaying = pMyWindowData->replay.Open(options.replayPath);
+        if (!pMyWindowData->isReplaying)
+        {
+            AttachParentConsole();
+            wprintf(L"Failed to open replay file %s\n", options.replayPath.c_str());
+            delete pMyWindowData;
+            return 1;
+        }
+    }
+    else if (!options.recordPath.empty())
+    {
+        if (!pMyWindowData->recorder.Open(options.recordPath))
+        {
+            AttachParentConsole();
+            wprintf(L"Failed to open record file %s\n", options.recordPath.c_str());
+            delete pMyWindowData;
+            return 1;
+        }
+        pMyWindowData->pScene->SetRecorder(&pMyWindowData->recorder);
+    }
 
     HWND hWnd = 0;
 
@@ -52,41 +189,230 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_LAB5));
 
-    MSG msg;
+    MSG msg = {};
+
+    // Simulation advances in fixed steps on this thread, rendering runs on its own thread
+    // and interpolates between the two latest published steps
+    using Clock = std::chrono::steady_clock;
+    const double SimulationStep = 1. / 60;
+    const double MaxFrameTime = 0.25;
+    double accumulator = 0.0;
+
+    pMyWindowData->pRenderThread = std::make_unique<RenderThread>(pMyWindowData->pRenderer.get(), pMyWindowData->hWnd);
+    pMyWindowData->pRenderThread->GetPacer().SetTargetRate(options.targetFrameRate);
+    pMyWindowData->pRenderThread->GetPacer().SetSpinTime(options.spinTimeMs / 1000.0);
+
+    {
+        SceneSnapshot& snapshot = pMyWindowData->pRenderThread->BeginSnapshot();
+        pMyWindowData->pScene->GetSnapshot(snapshot);
+        snapshot.stateTime = Clock::now();
+        snapshot.step = SimulationStep;
+        pMyWindowData->pRenderThread->PublishSnapshot();
+    }
+    pMyWindowData->pRenderThread->Start();
+
+    Clock::time_point lastTime = Clock::now();
+    Clock::time_point lastStatsTime = lastTime;
 
     // Main message loop:
     bool exit = false;
     while (!exit)
     {
-        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
-            if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+            PROFILE_SCOPE("ProcessMessages");
+            while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
             {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
+                if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+                {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                }
+                if (msg.message == WM_QUIT)
+                {
+                    exit = true;
+                    break;
+                }
             }
-            if (msg.message == WM_QUIT)
-                exit = true;
         }
-        //OutputDebugString(_T("Render\n"));
-        if (pMyWindowData->pRenderer->IsRunning())
+        if (exit)
         {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(unsigned long((1. / 60) * 1e9)));
-            pMyWindowData->pScene->Update(1. / 60);
-            if (!pMyWindowData->pRenderer->Render(pMyWindowData->pScene.get()))
+            break;
+        }
+
+        Clock::time_point now = Clock::now();
+        double frameTime = std::chrono::duration<double>(now - lastTime).count();
+        lastTime = now;
+
+        // Clamp long stalls (debugger, window drag) so the simulation does not spiral
+        accumulator += min(frameTime, MaxFrameTime);
+        if (accumulator >= SimulationStep)
+        {
+            PROFILE_SCOPE("Simulate");
+            while (accumulator >= SimulationStep)
             {
-                pMyWindowData->pRenderer->Term();
-                PostQuitMessage(0);
+                if (!StepScene(pMyWindowData, SimulationStep))
+                {
+                    // Replay is over
+                    DestroyWindow(pMyWindowData->hWnd);
+                    accumulator = 0.0;
+                    break;
+                }
+                accumulator -= SimulationStep;
             }
+
+            SceneSnapshot& snapshot = pMyWindowData->pRenderThread->BeginSnapshot();
+            pMyWindowData->pScene->GetSnapshot(snapshot);
+            snapshot.stateTime = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(accumulator));
+            snapshot.step = SimulationStep;
+            pMyWindowData->pRenderThread->PublishSnapshot();
         }
+
+        // A replay has to keep consuming recorded frames even when they change nothing
+        bool isIdle = pMyWindowData->pScene->IsIdle() && !pMyWindowData->isReplaying;
+
+        if (now - lastStatsTime >= std::chrono::seconds(1) || isIdle)
+        {
+            UpdateFrameStats(pMyWindowData->hWnd, *pMyWindowData->pRenderThread, isIdle,
+                pMyWindowData->pScene->GetDroppedInputCount());
+            lastStatsTime = now;
+        }
+
+        if (isIdle)
+        {
+            // Nothing changes until a message arrives, the render thread is asleep as well
+            PROFILE_SCOPE("Idle");
+            MsgWaitForMultipleObjects(0, nullptr, FALSE, INFINITE, QS_ALLINPUT);
+
+            // Time does not pass for a scene that does not change, step right away for the new input
+            lastTime = Clock::now();
+            accumulator = SimulationStep;
+            continue;
+        }
+
+        // Sleep until the next simulation step is due or a message arrives
+        DWORD timeout = static_cast<DWORD>(max(0.0, SimulationStep - accumulator) * 1000.0);
+        MsgWaitForMultipleObjects(0, nullptr, FALSE, timeout, QS_ALLINPUT);
+    }
+    pMyWindowData->pRenderThread->Stop();
+    if (!options.statsPath.empty())
+    {
+        bool result = pMyWindowData->pRenderer->WriteStatsHistory(options.statsPath);
+        assert(result);
     }
     pMyWindowData->pRenderer->Term();
     delete pMyWindowData;
+    WriteProfile(options);
     return (int)msg.wParam;
 }
 
+//
+//  FUNCTION: StepScene(MyWindowData*, double)
+//
+//  PURPOSE: Advances the scene by one simulation step, taking input and timing from the replay if one is active
+//
+bool StepScene(MyWindowData* pMyWindowData, double deltaTime)
+{
+    if (pMyWindowData->isReplaying)
+    {
+        if (!pMyWindowData->replay.NextFrame(deltaTime, pMyWindowData->replayEvents))
+        {
+            return false;
+        }
+        for (const InputEvent& event : pMyWindowData->replayEvents)
+        {
+            pMyWindowData->pScene->PostInput(event);
+        }
+    }
+    pMyWindowData->pScene->Update(deltaTime);
+    return true;
+}
+
+//
+//  FUNCTION: AttachParentConsole()
+//
+//  PURPOSE: Routes stdout to the console the application was started from, if any
+//
+void AttachParentConsole()
+{
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        FILE* pFile = nullptr;
+        freopen_s(&pFile, "CONOUT$", "w", stdout);
+        freopen_s(&pFile, "CONOUT$", "w", stderr);
+    }
+}
+
+//
+//  FUNCTION: WriteProfile(const AppOptions&)
+//
+//  PURPOSE: Stops the profiler capture and writes it if one was requested
+//
+void WriteProfile(const AppOptions& options)
+{
+    if (options.profilePath.empty())
+    {
+        return;
+    }
+    Profiler::EndCapture();
+    bool result = Profiler::WriteChromeTrace(options.profilePath);
+    assert(result);
+}
+
+//
+//  FUNCTION: UpdateFrameStats(HWND, const RenderThread&, bool, uint64_t)
+//
+//  PURPOSE: Shows frame rate and frame time jitter of the render thread in the window title, and how many input
+//           events were dropped because the scene fell behind, if any
+//
+void UpdateFrameStats(HWND hWnd, const RenderThread& renderThread, bool isIdle, uint64_t droppedInputCount)
+{
+    WCHAR title[MAX_LOADSTRING * 2];
+    if (isIdle)
+    {
+        swprintf_s(title, L"%s - idle, %llu frames rendered", szTitle,
+            static_cast<unsigned long long>(renderThread.GetRenderedFrameCount()));
+    }
+    else
+    {
+        FrameStats stats;
+        renderThread.GetFrameStats(stats);
+        swprintf_s(title, L"%s - %.1f FPS, p50 %.2f ms, p99 %.2f ms", szTitle,
+            stats.framesPerSecond, stats.p50FrameTime * 1000.0f, stats.p99FrameTime * 1000.0f);
+    }
+    if (droppedInputCount != 0)
+    {
+        size_t length = wcslen(title);
+        swprintf_s(title + length, _countof(title) - length, L", %llu input events dropped",
+            static_cast<unsigned long long>(droppedInputCount));
+    }
+    SetWindowTextW(hWnd, title);
+}
+
 
 
+//
+//  FUNCTION: PostInputEvent(HWND, InputEvent::TYPE, WPARAM, LPARAM)
+//
+//  PURPOSE: Queues window input for the next scene update
+//
+void PostInputEvent(HWND hWnd, InputEvent::TYPE type, WPARAM wParam, LPARAM lParam)
+{
+    struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+    if (pMyWindowData->isReplaying)
+    {
+        // Live input would break the determinism of the replay
+        return;
+    }
+
+    InputEvent event;
+    event.type = type;
+    event.wParam = static_cast<uint32_t>(wParam);
+    event.lParam = static_cast<uint32_t>(lParam);
+    event.time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    // A full queue drops the event unless it is a release, the window title shows how many were lost
+    pMyWindowData->pScene->PostInput(event);
+}
+
 //
 //  FUNCTION: MyRegisterClass()
 //
@@ -173,6 +499,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     {
         struct MyWindowData* pMyWindowData = (struct MyWindowData*)((LPCREATESTRUCT)lParam)->lpCreateParams;
         SetWindowLongPtr(hWnd, GWLP_USERDATA, (ULONG_PTR)pMyWindowData);
+        pMyWindowData->hWnd = hWnd;
     }
     switch (message)
     {
@@ -192,6 +519,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
         UINT width = LOWORD(lParam);
         UINT height = HIWORD(lParam);
+        if (pMyWindowData->pRenderThread && pMyWindowData->pRenderThread->IsRunning())
+        {
+            RenderCommand command;
+            command.type = RenderCommand::TYPE::RESIZE;
+            command.width = width;
+            command.height = height;
+            pMyWindowData->pRenderThread->PostCommand(command);
+            break;
+        }
         if (!pMyWindowData->pRenderer->Resize(width, height))
         {
             pMyWindowData->pRenderer->Term();
@@ -203,42 +539,42 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_KEYDOWN:
     {
         struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnKeyDown(wParam, lParam);
+        // F2 and F3 belong to the renderer rather than the scene, so they are neither recorded nor replayed
+        if ((wParam == VK_F2 || wParam == VK_F3) && pMyWindowData->pRenderThread)
+        {
+            RenderCommand command;
+            command.type = wParam == VK_F2 ? RenderCommand::TYPE::TOGGLE_STATS_OVERLAY : RenderCommand::TYPE::TOGGLE_TRANSPARENCY_MODE;
+            pMyWindowData->pRenderThread->PostCommand(command);
+            break;
+        }
+        PostInputEvent(hWnd, InputEvent::TYPE::KEY_DOWN, wParam, lParam);
         break;
     }
     case WM_KEYUP:
-    {
-        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnKeyUp(wParam, lParam);
+        PostInputEvent(hWnd, InputEvent::TYPE::KEY_UP, wParam, lParam);
         break;
-    }
     case WM_MOUSEMOVE:
-    {
-        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnMouseMove(wParam, lParam);
+        PostInputEvent(hWnd, InputEvent::TYPE::MOUSE_MOVE, wParam, lParam);
         break;
-    }
     case WM_LBUTTONDOWN:
-    {
-        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnLMouseDown(wParam, lParam);
+        PostInputEvent(hWnd, InputEvent::TYPE::LMOUSE_DOWN, wParam, lParam);
         break;
-    }
     case WM_LBUTTONUP:
-    {
-        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnLMouseUp(wParam, lParam);
+        PostInputEvent(hWnd, InputEvent::TYPE::LMOUSE_UP, wParam, lParam);
         break;
-    }
     case WM_MOUSEWHEEL:
-    {
-        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
-        pMyWindowData->pScene->OnMouseWheel(wParam, lParam);
+        PostInputEvent(hWnd, InputEvent::TYPE::MOUSE_WHEEL, wParam, lParam);
         break;
-    }
     case WM_DESTROY:
+    {
+        struct MyWindowData* pMyWindowData = (struct MyWindowData*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+        if (pMyWindowData->pRenderThread)
+        {
+            pMyWindowData->pRenderThread->Stop();
+        }
         PostQuitMessage(0);
         break;
+    }
     default:
         return DefWindowProc(hWnd, message, wParam, lParam);
     }
@@ -0,0 +1,367 @@
+#include "MeshFile.h"
+#include "BufferCodec.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MeshFileMagic[4] = { 'L', '5', 'M', 'S' };
+
+static_assert(sizeof(MeshFileHeader) == 184, "The header layout is part of the file format");
+static_assert(sizeof(MeshSubmesh) == 16 && sizeof(MeshLod) == 12, "The table layouts are part of the file format");
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + MeshFileAlignment - 1) / MeshFileAlignment * MeshFileAlignment;
+}
+
+#ifndef _WIN32
+static std::string GetNarrowPath(const std::wstring& path)
+{
+    std::vector<char> narrow(path.size() * MB_CUR_MAX + 1);
+    size_t length = wcstombs(narrow.data(), path.c_str(), narrow.size());
+    return length == static_cast<size_t>(-1) ? std::string() : std::string(narrow.data(), length);
+}
+#endif
+
+bool BuildMeshFile(const MeshData& mesh, const VertexFormat& format, const std::vector<MeshSubmesh>& submeshes,
+    const std::vector<MeshLod>& lods, std::vector<uint8_t>& file, MESH_FILE_COMPRESSION compression)
+{
+    size_t vertexCount = mesh.GetVertexCount();
+    size_t indexCount = mesh.GetIndexCount();
+    if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+    {
+        return false;
+    }
+
+    std::vector<MeshSubmesh> fileSubmeshes = submeshes;
+    if (fileSubmeshes.empty())
+    {
+        fileSubmeshes.push_back({ 0, static_cast<uint32_t>(indexCount), 0, 0 });
+    }
+    std::vector<MeshLod> fileLods = lods;
+    if (fileLods.empty())
+    {
+        fileLods.push_back({ 0, static_cast<uint32_t>(fileSubmeshes.size()), 0.0f });
+    }
+    for (const MeshSubmesh& submesh : fileSubmeshes)
+    {
+        if (uint64_t(submesh.indexOffset) + submesh.indexCount > indexCount || submesh.vertexOffset > vertexCount)
+        {
+            return false;
+        }
+    }
+    for (const MeshLod& lod : fileLods)
+    {
+        if (uint64_t(lod.firstSubmesh) + lod.submeshCount > fileSubmeshes.size())
+        {
+            return false;
+        }
+    }
+
+    EncodedVertices vertices;
+    EncodeVertices(mesh, format, vertices);
+    uint8_t indexSize = vertexCount <= 0x10000 ? 2 : 4;
+
+    // Sections as they go into the file, pointing at the uncompressed data unless compressing
+    const uint8_t* pVertexData = vertices.data.data();
+    uint64_t vertexBytes = vertices.GetSize();
+    std::vector<uint8_t> packedVertices;
+    std::vector<uint8_t> packedIndices;
+    if (compression == MESH_FILE_COMPRESSION::BUFFER_CODEC)
+    {
+        if (!EncodeVertexBuffer(vertices.data.data(), vertexCount, format.GetStride(), packedVertices) ||
+            !EncodeIndexBuffer(mesh.indices.data(), indexCount, packedIndices))
+        {
+            return false;
+        }
+        pVertexData = packedVertices.data();
+        vertexBytes = packedVertices.size();
+    }
+    uint64_t indexBytes = compression == MESH_FILE_COMPRESSION::NONE ? uint64_t(indexCount) * indexSize : packedIndices.size();
+
+    MeshFileHeader header = {};
+    memcpy(header.magic, MeshFileMagic, sizeof(MeshFileMagic));
+    header.version = MeshFileVersion;
+    header.vertexCount = static_cast<uint32_t>(vertexCount);
+    header.indexCount = static_cast<uint32_t>(indexCount);
+    header.submeshCount = static_cast<uint32_t>(fileSubmeshes.size());
+    header.lodCount = static_cast<uint32_t>(fileLods.size());
+    header.positionFormat = static_cast<uint8_t>(format.position);
+    header.normalFormat = static_cast<uint8_t>(format.normal);
+    header.uvFormat = static_cast<uint8_t>(format.uv);
+    header.indexSize = indexSize;
+    header.vertexStride = format.GetStride();
+    memcpy(header.boundsMin, mesh.bounds.min, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, mesh.bounds.max, sizeof(header.boundsMax));
+    memcpy(header.center, mesh.bounds.center, sizeof(header.center));
+    header.radius = mesh.bounds.radius;
+    header.decode = vertices.decode;
+    header.compression = static_cast<uint32_t>(compression);
+
+    header.vertices = { AlignOffset(sizeof(MeshFileHeader)), vertexBytes };
+    header.indices = { AlignOffset(header.vertices.offset + header.vertices.size), indexBytes };
+    header.submeshes = { AlignOffset(header.indices.offset + header.indices.size), fileSubmeshes.size() * sizeof(MeshSubmesh) };
+    header.lods = { AlignOffset(header.submeshes.offset + header.submeshes.size), fileLods.size() * sizeof(MeshLod) };
+    header.fileSize = header.lods.offset + header.lods.size;
+
+    // Padding between the sections stays zero
+    file.assign(static_cast<size_t>(header.fileSize), 0);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(&file[static_cast<size_t>(header.vertices.offset)], pVertexData, static_cast<size_t>(vertexBytes));
+    if (compression != MESH_FILE_COMPRESSION::NONE)
+    {
+        memcpy(&file[static_cast<size_t>(header.indices.offset)], packedIndices.data(), packedIndices.size());
+    }
+    else if (indexSize == 2)
+    {
+        uint16_t* pIndices = reinterpret_cast<uint16_t*>(&file[static_cast<size_t>(header.indices.offset)]);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            pIndices[i] = static_cast<uint16_t>(mesh.indices[i]);
+        }
+    }
+    else if (indexCount > 0)
+    {
+        memcpy(&file[static_cast<size_t>(header.indices.offset)], mesh.indices.data(), indexCount * sizeof(uint32_t));
+    }
+    memcpy(&file[static_cast<size_t>(header.submeshes.offset)], fileSubmeshes.data(), static_cast<size_t>(header.submeshes.size));
+    memcpy(&file[static_cast<size_t>(header.lods.offset)], fileLods.data(), static_cast<size_t>(header.lods.size));
+    return true;
+}
+
+bool WriteMeshFile(const std::wstring& path, const MeshData& mesh, const VertexFormat& format,
+    const std::vector<MeshSubmesh>& submeshes, const std::vector<MeshLod>& lods, MESH_FILE_COMPRESSION compression)
+{
+    std::vector<uint8_t> file;
+    if (!BuildMeshFile(mesh, format, submeshes, lods, file, compression))
+    {
+        return false;
+    }
+
+    FILE* pFile = nullptr;
+#ifdef _WIN32
+    _wfopen_s(&pFile, path.c_str(), L"wb");
+#else
+    pFile = fopen(GetNarrowPath(path).c_str(), "wb");
+#endif
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+    size_t written = fwrite(file.data(), 1, file.size(), pFile);
+    return fclose(pFile) == 0 && written == file.size();
+}
+
+MeshFile::~MeshFile()
+{
+    Close();
+}
+
+bool MeshFile::Open(const std::wstring& path)
+{
+    Close();
+
+    // The mapping keeps the file referenced, so both handles can go right away
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size = {};
+    HANDLE hMapping = NULL;
+    if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+    {
+        hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(hFile);
+    if (hMapping == NULL)
+    {
+        return false;
+    }
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(hMapping);
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(GetNarrowPath(path).c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat status = {};
+    void* pMapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        pMapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    m_pData = pMapping != MAP_FAILED ? static_cast<const uint8_t*>(pMapping) : nullptr;
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+
+    if (m_pData == nullptr)
+    {
+        m_size = 0;
+        return false;
+    }
+    m_isMapped = true;
+    if (!Validate())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::OpenMemory(const void* pData, size_t size)
+{
+    Close();
+    m_pData = static_cast<const uint8_t*>(pData);
+    m_size = size;
+    if (m_pData == nullptr || !Validate())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MeshFile::Close()
+{
+    if (m_isMapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_pData);
+#else
+        munmap(const_cast<uint8_t*>(m_pData), m_size);
+#endif
+    }
+    m_pData = nullptr;
+    m_size = 0;
+    m_isMapped = false;
+}
+
+VertexFormat MeshFile::GetVertexFormat() const
+{
+    const MeshFileHeader& header = GetHeader();
+    VertexFormat format;
+    format.position = static_cast<POSITION_FORMAT>(header.positionFormat);
+    format.normal = static_cast<NORMAL_FORMAT>(header.normalFormat);
+    format.uv = static_cast<UV_FORMAT>(header.uvFormat);
+    return format;
+}
+
+MeshBounds MeshFile::GetBounds() const
+{
+    const MeshFileHeader& header = GetHeader();
+    MeshBounds bounds;
+    memcpy(bounds.min, header.boundsMin, sizeof(bounds.min));
+    memcpy(bounds.max, header.boundsMax, sizeof(bounds.max));
+    memcpy(bounds.center, header.center, sizeof(bounds.center));
+    bounds.radius = header.radius;
+    return bounds;
+}
+
+bool MeshFile::DecodeVertices(void* pDestination) const
+{
+    const MeshFileHeader& header = GetHeader();
+    if (IsCompressed())
+    {
+        return DecodeVertexBuffer(pDestination, header.vertexCount, header.vertexStride, static_cast<const uint8_t*>(GetVertices()),
+            GetVertexBytes());
+    }
+    memcpy(pDestination, GetVertices(), GetVertexBytes());
+    return true;
+}
+
+bool MeshFile::DecodeIndices(void* pDestination) const
+{
+    const MeshFileHeader& header = GetHeader();
+    if (IsCompressed())
+    {
+        return DecodeIndexBuffer(pDestination, header.indexCount, header.indexSize, static_cast<const uint8_t*>(GetIndices()),
+            GetIndexBytes());
+    }
+    memcpy(pDestination, GetIndices(), GetIndexBytes());
+    return true;
+}
+
+bool MeshFile::Validate() const
+{
+    // Mappings start at a page boundary, views of memory have to provide the same alignment for the tables
+    if (m_size < sizeof(MeshFileHeader) || reinterpret_cast<uintptr_t>(m_pData) % alignof(MeshFileHeader) != 0)
+    {
+        return false;
+    }
+
+    const MeshFileHeader& header = GetHeader();
+    if (memcmp(header.magic, MeshFileMagic, sizeof(MeshFileMagic)) != 0 || header.version != MeshFileVersion ||
+        header.fileSize != m_size)
+    {
+        return false;
+    }
+    if (header.positionFormat > static_cast<uint8_t>(POSITION_FORMAT::HALF) ||
+        header.normalFormat > static_cast<uint8_t>(NORMAL_FORMAT::OCTAHEDRAL_SNORM16) ||
+        header.uvFormat > static_cast<uint8_t>(UV_FORMAT::HALF) ||
+        (header.indexSize != 2 && header.indexSize != 4) || header.vertexStride != GetVertexFormat().GetStride() ||
+        header.compression > static_cast<uint32_t>(MESH_FILE_COMPRESSION::BUFFER_CODEC))
+    {
+        return false;
+    }
+
+    const MeshFileSection* sections[] = { &header.vertices, &header.indices, &header.submeshes, &header.lods };
+    for (const MeshFileSection* pSection : sections)
+    {
+        if (pSection->offset % MeshFileAlignment != 0 || pSection->offset < sizeof(MeshFileHeader) ||
+            pSection->offset > m_size || pSection->size > m_size - pSection->offset)
+        {
+            return false;
+        }
+    }
+    // Compressed sections only have an upper bound, the decoders check that they end where the data does
+    bool isCompressed = IsCompressed();
+    if ((!isCompressed && header.vertices.size != uint64_t(header.vertexCount) * header.vertexStride) ||
+        (!isCompressed && header.indices.size != uint64_t(header.indexCount) * header.indexSize) ||
+        (isCompressed && header.vertices.size > GetVertexBufferEncodeBound(header.vertexCount, header.vertexStride)) ||
+        (isCompressed && header.indices.size > GetIndexBufferEncodeBound(header.indexCount)) ||
+        header.submeshes.size != uint64_t(header.submeshCount) * sizeof(MeshSubmesh) ||
+        header.lods.size != uint64_t(header.lodCount) * sizeof(MeshLod))
+    {
+        return false;
+    }
+
+    const MeshSubmesh* pSubmeshes = GetSubmeshes();
+    for (uint32_t i = 0; i < header.submeshCount; i++)
+    {
+        if (uint64_t(pSubmeshes[i].indexOffset) + pSubmeshes[i].indexCount > header.indexCount ||
+            pSubmeshes[i].vertexOffset > header.vertexCount)
+        {
+            return false;
+        }
+    }
+    const MeshLod* pLods = GetLods();
+    for (uint32_t i = 0; i < header.lodCount; i++)
+    {
+        if (uint64_t(pLods[i].firstSubmesh) + pLods[i].submeshCount > header.submeshCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "ProceduralMesh.h"
+#include "VertexFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary mesh container that is mapped and handed to the GPU as is, without parsing or per-vertex work.
+//
+// Layout: MeshFileHeader, then the vertex data, the index data, the submesh table and the LOD table, each
+// starting at a multiple of MeshFileAlignment. Vertices are interleaved in the encoded VertexFormat of the
+// header, indices are 16-bit when the vertex count allows it and 32-bit otherwise. Little endian throughout.
+// Compressed files store the vertex and index sections through BufferCodec.h and decode them on load.
+const uint32_t MeshFileVersion = 2;
+const uint32_t MeshFileAlignment = 64;
+
+enum class MESH_FILE_COMPRESSION
+{
+    NONE,
+    // EncodeVertexBuffer and EncodeIndexBuffer, triangles may come back rotated
+    BUFFER_CODEC
+};
+
+struct MeshFileSection
+{
+    // From the start of the file
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct MeshFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t submeshCount;
+    uint32_t lodCount;
+    // POSITION_FORMAT, NORMAL_FORMAT and UV_FORMAT values
+    uint8_t positionFormat;
+    uint8_t normalFormat;
+    uint8_t uvFormat;
+    // Bytes per index, 2 or 4
+    uint8_t indexSize;
+    uint32_t vertexStride;
+    float boundsMin[3];
+    float boundsMax[3];
+    float center[3];
+    float radius;
+    VertexDecode decode;
+    // MESH_FILE_COMPRESSION value
+    uint32_t compression;
+    uint32_t reserved;
+    MeshFileSection vertices;
+    MeshFileSection indices;
+    MeshFileSection submeshes;
+    MeshFileSection lods;
+};
+
+// Range of the index buffer drawn with one material
+struct MeshSubmesh
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    // Added to every index, as BaseVertexLocation of the draw
+    uint32_t vertexOffset;
+    uint32_t materialIndex;
+};
+
+// Level of detail as a range of the submesh table, the first one is the full mesh
+struct MeshLod
+{
+    uint32_t firstSubmesh;
+    uint32_t submeshCount;
+    // Deviation from the full mesh in mesh units, zero for the full mesh
+    float error;
+};
+
+// Encodes the mesh into a complete file image. Without submeshes a single one covers all indices, without
+// LODs a single one covers all submeshes. Tangents are not stored. Returns false if a range is out of bounds.
+// Compression works best on vertices numbered in first use order, as OptimizeVertexFetch leaves them.
+bool BuildMeshFile(const MeshData& mesh, const VertexFormat& format, const std::vector<MeshSubmesh>& submeshes,
+    const std::vector<MeshLod>& lods, std::vector<uint8_t>& file, MESH_FILE_COMPRESSION compression = MESH_FILE_COMPRESSION::NONE);
+bool WriteMeshFile(const std::wstring& path, const MeshData& mesh, const VertexFormat& format,
+    const std::vector<MeshSubmesh>& submeshes = std::vector<MeshSubmesh>(), const std::vector<MeshLod>& lods = std::vector<MeshLod>(),
+    MESH_FILE_COMPRESSION compression = MESH_FILE_COMPRESSION::NONE);
+
+// Read-only view of a mesh file mapped into memory. Opening checks the header and the tables, which is
+// independent of the mesh size; index values are not checked, the GPU reads out of range vertices as zero.
+// Compressed sections are checked while they are decoded. The pointers stay valid until Close.
+class MeshFile
+{
+    const uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+    bool m_isMapped = false;
+
+public:
+    MeshFile() = default;
+    ~MeshFile();
+
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator=(const MeshFile&) = delete;
+
+    bool Open(const std::wstring& path);
+    // Views a file image already in memory, which has to outlive the MeshFile
+    bool OpenMemory(const void* pData, size_t size);
+    void Close();
+    bool IsOpen() const { return m_pData != nullptr; }
+
+    const MeshFileHeader& GetHeader() const { return *reinterpret_cast<const MeshFileHeader*>(m_pData); }
+    VertexFormat GetVertexFormat() const;
+    MeshBounds GetBounds() const;
+
+    bool IsCompressed() const { return GetHeader().compression != static_cast<uint32_t>(MESH_FILE_COMPRESSION::NONE); }
+
+    // Sections as stored, usable as buffer data only when the file is not compressed
+    const void* GetVertices() const { return m_pData + GetHeader().vertices.offset; }
+    size_t GetVertexBytes() const { return static_cast<size_t>(GetHeader().vertices.size); }
+    const void* GetIndices() const { return m_pData + GetHeader().indices.offset; }
+    size_t GetIndexBytes() const { return static_cast<size_t>(GetHeader().indices.size); }
+
+    // Write vertexCount * vertexStride and indexCount * indexSize bytes to the destination, such as a mapped upload
+    // buffer, decoding compressed sections and copying the others. False if a compressed section is corrupt.
+    bool DecodeVertices(void* pDestination) const;
+    bool DecodeIndices(void* pDestination) const;
+    const MeshSubmesh* GetSubmeshes() const { return reinterpret_cast<const MeshSubmesh*>(m_pData + GetHeader().submeshes.offset); }
+    const MeshLod* GetLods() const { return reinterpret_cast<const MeshLod*>(m_pData + GetHeader().lods.offset); }
+
+private:
+    bool Validate() const;
+};
@@ -0,0 +1,1470 @@
+#include "MeshImport.h"
+#include "MeshOptimizer.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    const uint32_t MissingIndex = UINT32_MAX;
+    // Resolved OBJ indices that point outside the file, always past the element counts
+    const uint32_t InvalidIndex = UINT32_MAX - 1;
+    // Smaller chunks would not pay for their thread
+    const size_t MinChunkSize = 256 * 1024;
+    // glTF vertices are converted in ranges of this many, so a single large primitive still uses every thread
+    const size_t VertexRangeSize = 64 * 1024;
+
+    uint32_t GetThreadCount(const ImportOptions& options)
+    {
+        uint32_t count = options.threadCount != 0 ? options.threadCount : std::thread::hardware_concurrency();
+        return std::max(count, 1u);
+    }
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+        {
+            p++;
+        }
+        return p;
+    }
+
+    const char* SkipLine(const char* p, const char* end)
+    {
+        const char* pNewline = static_cast<const char*>(memchr(p, '\n', end - p));
+        return pNewline != nullptr ? pNewline + 1 : end;
+    }
+
+    // Decimal with an optional fraction and exponent. Keeps up to 18 significant digits and scales them by an
+    // exact power of ten, which stays within an ulp of strtof for the usual digit counts and is locale independent.
+    // Returns nullptr if there is no number.
+    const char* ParseFloat(const char* p, const char* end, float& value)
+    {
+        static const double PowersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        const uint64_t MaxMantissa = 100000000000000000ull;
+
+        p = SkipSpaces(p, end);
+        bool isNegative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            p++;
+        }
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        bool hasDigits = false;
+        for (; p < end && IsDigit(*p); p++)
+        {
+            hasDigits = true;
+            if (mantissa < MaxMantissa)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+            else
+            {
+                exponent++;
+            }
+        }
+        if (p < end && *p == '.')
+        {
+            for (p++; p < end && IsDigit(*p); p++)
+            {
+                hasDigits = true;
+                if (mantissa < MaxMantissa)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    exponent--;
+                }
+            }
+        }
+        if (!hasDigits)
+        {
+            return nullptr;
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            bool isExponentNegative = p < end && *p == '-';
+            if (p < end && (*p == '-' || *p == '+'))
+            {
+                p++;
+            }
+            int explicitExponent = 0;
+            for (; p < end && IsDigit(*p); p++)
+            {
+                explicitExponent = std::min(explicitExponent * 10 + (*p - '0'), 10000);
+            }
+            exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+        }
+
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0)
+        {
+            result = exponent >= -22 ? result / PowersOfTen[-exponent] : result * pow(10.0, exponent);
+        }
+        else if (exponent > 0)
+        {
+            result = exponent <= 22 ? result * PowersOfTen[exponent] : result * pow(10.0, exponent);
+        }
+        value = static_cast<float>(isNegative ? -result : result);
+        return p;
+    }
+
+    // Signed OBJ index, zero when there are no digits
+    const char* ParseIndex(const char* p, const char* end, int64_t& value)
+    {
+        bool isNegative = p < end && *p == '-';
+        if (isNegative)
+        {
+            p++;
+        }
+        int64_t result = 0;
+        for (; p < end && IsDigit(*p); p++)
+        {
+            result = std::min<int64_t>(result * 10 + (*p - '0'), INT64_C(1) << 40);
+        }
+        value = isNegative ? -result : result;
+        return p;
+    }
+
+    // One-based from the start of the file or negative from the elements defined so far
+    uint32_t ResolveIndex(int64_t index, size_t definedCount)
+    {
+        int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(definedCount) + index;
+        return resolved >= 0 && resolved < InvalidIndex ? static_cast<uint32_t>(resolved) : InvalidIndex;
+    }
+
+    enum class OBJ_LINE
+    {
+        POSITION,
+        UV,
+        NORMAL,
+        FACE,
+        OTHER
+    };
+
+    // Leaves p after the keyword
+    OBJ_LINE GetObjLineType(const char*& p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+        if (end - p >= 2 && p[0] == 'v' && IsSpace(p[1]))
+        {
+            p += 1;
+            return OBJ_LINE::POSITION;
+        }
+        if (end - p >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+        {
+            p += 2;
+            return OBJ_LINE::UV;
+        }
+        if (end - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+        {
+            p += 2;
+            return OBJ_LINE::NORMAL;
+        }
+        if (end - p >= 2 && p[0] == 'f' && IsSpace(p[1]))
+        {
+            p += 1;
+            return OBJ_LINE::FACE;
+        }
+        return OBJ_LINE::OTHER;
+    }
+
+    struct ObjCorner
+    {
+        uint32_t position;
+        uint32_t uv;
+        uint32_t normal;
+    };
+
+    // Part of the file between two line boundaries. Counted in a first pass, so the second one knows where the
+    // elements of the chunk go and how to resolve negative indices.
+    struct ObjChunk
+    {
+        const char* pBegin = nullptr;
+        const char* pEnd = nullptr;
+        size_t positionCount = 0;
+        size_t uvCount = 0;
+        size_t normalCount = 0;
+        size_t positionBase = 0;
+        size_t uvBase = 0;
+        size_t normalBase = 0;
+        // Three per triangle, already in clockwise order
+        std::vector<ObjCorner> corners;
+        bool isValid = true;
+    };
+
+    void CountObjChunk(ObjChunk& chunk)
+    {
+        const char* end = chunk.pEnd;
+        for (const char* p = chunk.pBegin; p < end; p = SkipLine(p, end))
+        {
+            switch (GetObjLineType(p, end))
+            {
+            case OBJ_LINE::POSITION:
+                chunk.positionCount++;
+                break;
+            case OBJ_LINE::UV:
+                chunk.uvCount++;
+                break;
+            case OBJ_LINE::NORMAL:
+                chunk.normalCount++;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    const char* ParseObjFace(const char* p, const char* end, ObjChunk& chunk, size_t positionCount, size_t uvCount, size_t normalCount)
+    {
+        ObjCorner first = {};
+        ObjCorner previous = {};
+        int cornerCount = 0;
+        for (;;)
+        {
+            p = SkipSpaces(p, end);
+            if (p >= end || *p == '\n' || *p == '#')
+            {
+                break;
+            }
+
+            int64_t position = 0;
+            int64_t uv = 0;
+            int64_t normal = 0;
+            p = ParseIndex(p, end, position);
+            if (p < end && *p == '/')
+            {
+                p = ParseIndex(p + 1, end, uv);
+                if (p < end && *p == '/')
+                {
+                    p = ParseIndex(p + 1, end, normal);
+                }
+            }
+            if (position == 0 || (p < end && !IsSpace(*p) && *p != '\n'))
+            {
+                chunk.isValid = false;
+                break;
+            }
+
+            ObjCorner corner = {
+                ResolveIndex(position, positionCount),
+                uv != 0 ? ResolveIndex(uv, uvCount) : MissingIndex,
+                normal != 0 ? ResolveIndex(normal, normalCount) : MissingIndex };
+            if (cornerCount == 0)
+            {
+                first = corner;
+            }
+            else if (cornerCount >= 2)
+            {
+                // Fan around the first corner, rewound for the mirrored result
+                chunk.corners.push_back(first);
+                chunk.corners.push_back(corner);
+                chunk.corners.push_back(previous);
+            }
+            previous = corner;
+            cornerCount++;
+        }
+        return p;
+    }
+
+    void ParseObjChunk(ObjChunk& chunk, float* pPositions, float* pUvs, float* pNormals)
+    {
+        size_t positionCount = chunk.positionBase;
+        size_t uvCount = chunk.uvBase;
+        size_t normalCount = chunk.normalBase;
+        const char* end = chunk.pEnd;
+        for (const char* p = chunk.pBegin; p < end && chunk.isValid; p = SkipLine(p, end))
+        {
+            float* pValues = nullptr;
+            int valueCount = 0;
+            switch (GetObjLineType(p, end))
+            {
+            case OBJ_LINE::POSITION:
+                pValues = &pPositions[positionCount++ * 3];
+                valueCount = 3;
+                break;
+            case OBJ_LINE::UV:
+                pValues = &pUvs[uvCount++ * 2];
+                valueCount = 2;
+                break;
+            case OBJ_LINE::NORMAL:
+                pValues = &pNormals[normalCount++ * 3];
+                valueCount = 3;
+                break;
+            case OBJ_LINE::FACE:
+                p = ParseObjFace(p, end, chunk, positionCount, uvCount, normalCount);
+                break;
+            default:
+                break;
+            }
+
+            // Extra values, like the w of positions or vertex colors, are skipped with the rest of the line
+            for (int i = 0; i < valueCount && p != nullptr; i++)
+            {
+                p = ParseFloat(p, end, pValues[i]);
+            }
+            if (p == nullptr)
+            {
+                chunk.isValid = false;
+                break;
+            }
+        }
+    }
+
+    uint64_t HashCorner(const ObjCorner& corner)
+    {
+        uint64_t hash = corner.position * 0x9E3779B97F4A7C15ull;
+        hash ^= corner.uv * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+        hash ^= corner.normal * 0x165667B19E3779F9ull + (hash >> 32);
+        return hash ^ (hash >> 31);
+    }
+
+    // Area weighted normals of the triangles from firstIndex on, shared by the vertices from firstVertex on
+    // that have the same position, so texture seams do not show up as creases
+    void GenerateNormals(MeshData& mesh, size_t firstVertex, size_t firstIndex)
+    {
+        struct PositionHash
+        {
+            size_t operator()(const std::pair<uint64_t, uint32_t>& key) const
+            {
+                return static_cast<size_t>((key.first * 0x9E3779B97F4A7C15ull) ^ (key.second * 0xC2B2AE3D27D4EB4Full));
+            }
+        };
+
+        size_t vertexCount = mesh.GetVertexCount();
+        mesh.normals.resize(vertexCount * 3);
+        std::vector<uint32_t> groups(vertexCount - firstVertex);
+        std::unordered_map<std::pair<uint64_t, uint32_t>, uint32_t, PositionHash> positionGroups;
+        positionGroups.reserve(groups.size());
+        for (size_t vertex = firstVertex; vertex < vertexCount; vertex++)
+        {
+            uint32_t bits[3];
+            memcpy(bits, &mesh.positions[vertex * 3], sizeof(bits));
+            std::pair<uint64_t, uint32_t> key(uint64_t(bits[0]) << 32 | bits[1], bits[2]);
+            groups[vertex - firstVertex] = positionGroups.emplace(key, static_cast<uint32_t>(positionGroups.size())).first->second;
+        }
+
+        std::vector<float> groupNormals(positionGroups.size() * 3, 0.0f);
+        for (size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3)
+        {
+            const float* a = &mesh.positions[mesh.indices[i] * 3];
+            const float* b = &mesh.positions[mesh.indices[i + 1] * 3];
+            const float* c = &mesh.positions[mesh.indices[i + 2] * 3];
+            float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+            for (int corner = 0; corner < 3; corner++)
+            {
+                float* pGroupNormal = &groupNormals[groups[mesh.indices[i + corner] - firstVertex] * 3];
+                pGroupNormal[0] += normal[0];
+                pGroupNormal[1] += normal[1];
+                pGroupNormal[2] += normal[2];
+            }
+        }
+
+        for (size_t vertex = firstVertex; vertex < vertexCount; vertex++)
+        {
+            const float* pGroupNormal = &groupNormals[groups[vertex - firstVertex] * 3];
+            float length = sqrtf(pGroupNormal[0] * pGroupNormal[0] + pGroupNormal[1] * pGroupNormal[1] + pGroupNormal[2] * pGroupNormal[2]);
+            float* pNormal = &mesh.normals[vertex * 3];
+            // Unreferenced and degenerate vertices point up
+            pNormal[0] = length > 0.0f ? pGroupNormal[0] / length : 0.0f;
+            pNormal[1] = length > 0.0f ? pGroupNormal[1] / length : 1.0f;
+            pNormal[2] = length > 0.0f ? pGroupNormal[2] / length : 0.0f;
+        }
+    }
+
+    void FinishImport(MeshData& mesh, const ImportOptions& options)
+    {
+        ComputeMeshBounds(mesh);
+        if (options.optimize)
+        {
+            OptimizeMesh(mesh);
+        }
+    }
+
+    // Just enough JSON for the glTF header: a tree of nodes in one array, children linked by index
+    enum class JSON_TYPE
+    {
+        NULL_VALUE,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    const uint32_t NoJsonNode = UINT32_MAX;
+
+    struct JsonNode
+    {
+        JSON_TYPE type = JSON_TYPE::NULL_VALUE;
+        double number = 0.0;
+        // String value, or true for booleans
+        std::string text;
+        // Member name within an object
+        std::string key;
+        uint32_t firstChild = NoJsonNode;
+        uint32_t nextSibling = NoJsonNode;
+    };
+
+    class JsonDocument
+    {
+        static const int MaxDepth = 64;
+
+        std::vector<JsonNode> m_nodes;
+        const char* m_pEnd = nullptr;
+
+    public:
+        bool Parse(const char* pText, size_t size)
+        {
+            m_nodes.clear();
+            m_pEnd = pText + size;
+            const char* p = ParseValue(pText, 0);
+            return p != nullptr && SkipWhitespace(p) == m_pEnd;
+        }
+
+        const JsonNode* GetRoot() const { return m_nodes.empty() ? nullptr : &m_nodes[0]; }
+
+        const JsonNode* Find(const JsonNode* pObject, const char* key) const
+        {
+            if (pObject == nullptr || pObject->type != JSON_TYPE::OBJECT)
+            {
+                return nullptr;
+            }
+            for (uint32_t child = pObject->firstChild; child != NoJsonNode; child = m_nodes[child].nextSibling)
+            {
+                if (m_nodes[child].key == key)
+                {
+                    return &m_nodes[child];
+                }
+            }
+            return nullptr;
+        }
+
+        const JsonNode* GetElement(const JsonNode* pArray, size_t index) const
+        {
+            if (pArray == nullptr || pArray->type != JSON_TYPE::ARRAY)
+            {
+                return nullptr;
+            }
+            uint32_t child = pArray->firstChild;
+            for (size_t i = 0; i < index && child != NoJsonNode; i++)
+            {
+                child = m_nodes[child].nextSibling;
+            }
+            return child != NoJsonNode ? &m_nodes[child] : nullptr;
+        }
+
+        size_t GetElementCount(const JsonNode* pArray) const
+        {
+            size_t count = 0;
+            if (pArray != nullptr && pArray->type == JSON_TYPE::ARRAY)
+            {
+                for (uint32_t child = pArray->firstChild; child != NoJsonNode; child = m_nodes[child].nextSibling)
+                {
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        double GetNumber(const JsonNode* pObject, const char* key, double defaultValue) const
+        {
+            const JsonNode* pNode = Find(pObject, key);
+            return pNode != nullptr && pNode->type == JSON_TYPE::NUMBER ? pNode->number : defaultValue;
+        }
+
+        // Non-negative integer member, or the default when it is missing or not an index
+        size_t GetIndex(const JsonNode* pObject, const char* key, size_t defaultValue) const
+        {
+            double value = GetNumber(pObject, key, -1.0);
+            return value >= 0.0 && value < 4294967295.0 && value == floor(value) ? static_cast<size_t>(value) : defaultValue;
+        }
+
+    private:
+        const char* SkipWhitespace(const char* p) const
+        {
+            while (p < m_pEnd && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            {
+                p++;
+            }
+            return p;
+        }
+
+        static void AppendUtf8(std::string& text, uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                text += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                text += static_cast<char>(0xC0 | (codePoint >> 6));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                text += static_cast<char>(0xE0 | (codePoint >> 12));
+                text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                text += static_cast<char>(0xF0 | (codePoint >> 18));
+                text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        const char* ParseHex4(const char* p, uint32_t& value) const
+        {
+            value = 0;
+            for (int i = 0; i < 4; i++, p++)
+            {
+                if (p >= m_pEnd)
+                {
+                    return nullptr;
+                }
+                char c = *p;
+                uint32_t digit = IsDigit(c) ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 16;
+                if (digit == 16)
+                {
+                    return nullptr;
+                }
+                value = value * 16 + digit;
+            }
+            return p;
+        }
+
+        const char* ParseString(const char* p, std::string& text) const
+        {
+            // p is past the opening quote
+            text.clear();
+            while (p < m_pEnd && *p != '"')
+            {
+                if (*p != '\\')
+                {
+                    text += *p++;
+                    continue;
+                }
+                if (++p >= m_pEnd)
+                {
+                    return nullptr;
+                }
+                char c = *p++;
+                switch (c)
+                {
+                case '"': text += '"'; break;
+                case '\\': text += '\\'; break;
+                case '/': text += '/'; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+                case 'u':
+                {
+                    uint32_t codePoint = 0;
+                    p = ParseHex4(p, codePoint);
+                    if (p == nullptr)
+                    {
+                        return nullptr;
+                    }
+                    uint32_t low = 0;
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && m_pEnd - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                        ParseHex4(p + 2, low) != nullptr && low >= 0xDC00 && low < 0xE000)
+                    {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                    AppendUtf8(text, codePoint);
+                    break;
+                }
+                default:
+                    return nullptr;
+                }
+            }
+            return p < m_pEnd ? p + 1 : nullptr;
+        }
+
+        const char* ParseValue(const char* p, int depth)
+        {
+            p = SkipWhitespace(p);
+            if (p >= m_pEnd || depth > MaxDepth)
+            {
+                return nullptr;
+            }
+
+            uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+            char c = *p;
+            if (c == '{' || c == '[')
+            {
+                bool isObject = c == '{';
+                m_nodes[nodeIndex].type = isObject ? JSON_TYPE::OBJECT : JSON_TYPE::ARRAY;
+                p = SkipWhitespace(p + 1);
+                if (p < m_pEnd && *p == (isObject ? '}' : ']'))
+                {
+                    return p + 1;
+                }
+
+                uint32_t previousChild = NoJsonNode;
+                for (;;)
+                {
+                    std::string key;
+                    if (isObject)
+                    {
+                        if (p >= m_pEnd || *p != '"' || (p = ParseString(p + 1, key)) == nullptr)
+                        {
+                            return nullptr;
+                        }
+                        p = SkipWhitespace(p);
+                        if (p >= m_pEnd || *p != ':')
+                        {
+                            return nullptr;
+                        }
+                        p++;
+                    }
+
+                    uint32_t childIndex = static_cast<uint32_t>(m_nodes.size());
+                    p = ParseValue(p, depth + 1);
+                    if (p == nullptr)
+                    {
+                        return nullptr;
+                    }
+                    m_nodes[childIndex].key = std::move(key);
+                    if (previousChild == NoJsonNode)
+                    {
+                        m_nodes[nodeIndex].firstChild = childIndex;
+                    }
+                    else
+                    {
+                        m_nodes[previousChild].nextSibling = childIndex;
+                    }
+                    previousChild = childIndex;
+
+                    p = SkipWhitespace(p);
+                    if (p < m_pEnd && *p == ',')
+                    {
+                        p = SkipWhitespace(p + 1);
+                        continue;
+                    }
+                    if (p < m_pEnd && *p == (isObject ? '}' : ']'))
+                    {
+                        return p + 1;
+                    }
+                    return nullptr;
+                }
+            }
+            if (c == '"')
+            {
+                m_nodes[nodeIndex].type = JSON_TYPE::STRING;
+                std::string text;
+                p = ParseString(p + 1, text);
+                m_nodes[nodeIndex].text = std::move(text);
+                return p;
+            }
+            if (m_pEnd - p >= 4 && memcmp(p, "true", 4) == 0)
+            {
+                m_nodes[nodeIndex].type = JSON_TYPE::BOOLEAN;
+                m_nodes[nodeIndex].text = "true";
+                return p + 4;
+            }
+            if (m_pEnd - p >= 5 && memcmp(p, "false", 5) == 0)
+            {
+                m_nodes[nodeIndex].type = JSON_TYPE::BOOLEAN;
+                return p + 5;
+            }
+            if (m_pEnd - p >= 4 && memcmp(p, "null", 4) == 0)
+            {
+                return p + 4;
+            }
+
+            // Number text is copied out, strtod needs it terminated
+            const char* pStart = p;
+            while (p < m_pEnd && (IsDigit(*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+            {
+                p++;
+            }
+            std::string number(pStart, p);
+            char* pNumberEnd = nullptr;
+            m_nodes[nodeIndex].type = JSON_TYPE::NUMBER;
+            m_nodes[nodeIndex].number = strtod(number.c_str(), &pNumberEnd);
+            return !number.empty() && pNumberEnd == number.c_str() + number.size() ? p : nullptr;
+        }
+    };
+
+    // Column-major 4x4, as glTF stores node matrices
+    struct Transform
+    {
+        float m[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+        Transform operator*(const Transform& other) const
+        {
+            Transform result;
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    float sum = 0.0f;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        sum += m[k * 4 + row] * other.m[column * 4 + k];
+                    }
+                    result.m[column * 4 + row] = sum;
+                }
+            }
+            return result;
+        }
+    };
+
+    struct GlbPrimitive
+    {
+        const JsonNode* pPrimitive;
+        Transform transform;
+    };
+
+    // Accessor data resolved against the binary chunk
+    struct GlbAccessor
+    {
+        const uint8_t* pData = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        uint32_t componentType = 0;
+        uint32_t componentCount = 0;
+        bool isNormalized = false;
+    };
+
+    const uint32_t GltfByte = 5120;
+    const uint32_t GltfUnsignedByte = 5121;
+    const uint32_t GltfShort = 5122;
+    const uint32_t GltfUnsignedShort = 5123;
+    const uint32_t GltfUnsignedInt = 5125;
+    const uint32_t GltfFloat = 5126;
+    const uint32_t GltfTriangles = 4;
+
+    uint32_t GetComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case GltfByte:
+        case GltfUnsignedByte:
+            return 1;
+        case GltfShort:
+        case GltfUnsignedShort:
+            return 2;
+        case GltfUnsignedInt:
+        case GltfFloat:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t GetComponentCount(const std::string& type)
+    {
+        return type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+    }
+
+    class GlbReader
+    {
+        JsonDocument m_json;
+        const uint8_t* m_pBinary = nullptr;
+        size_t m_binarySize = 0;
+
+    public:
+        bool Open(const void* pData, size_t size)
+        {
+            const uint32_t GlbMagic = 0x46546C67;
+            const uint32_t JsonChunk = 0x4E4F534A;
+            const uint32_t BinaryChunk = 0x004E4942;
+
+            const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+            uint32_t header[3];
+            if (size < sizeof(header) + 8)
+            {
+                return false;
+            }
+            memcpy(header, pBytes, sizeof(header));
+            if (header[0] != GlbMagic || header[1] != 2 || header[2] > size)
+            {
+                return false;
+            }
+
+            // JSON comes first, the optional binary chunk right after it
+            size_t end = header[2];
+            size_t offset = sizeof(header);
+            bool hasJson = false;
+            while (offset + 8 <= end)
+            {
+                uint32_t chunk[2];
+                memcpy(chunk, pBytes + offset, sizeof(chunk));
+                offset += sizeof(chunk);
+                if (chunk[0] > end - offset)
+                {
+                    return false;
+                }
+                if (!hasJson)
+                {
+                    if (chunk[1] != JsonChunk || !m_json.Parse(reinterpret_cast<const char*>(pBytes + offset), chunk[0]))
+                    {
+                        return false;
+                    }
+                    hasJson = true;
+                }
+                else if (chunk[1] == BinaryChunk && m_pBinary == nullptr)
+                {
+                    m_pBinary = pBytes + offset;
+                    m_binarySize = chunk[0];
+                }
+                offset += (chunk[0] + 3) & ~size_t(3);
+            }
+            return hasJson && m_json.GetRoot()->type == JSON_TYPE::OBJECT;
+        }
+
+        const JsonDocument& GetJson() const { return m_json; }
+
+        // Triangle primitives of the default scene with their world transforms, or of every mesh without a scene
+        bool GetPrimitives(std::vector<GlbPrimitive>& primitives) const
+        {
+            const JsonNode* pRoot = m_json.GetRoot();
+            const JsonNode* pScenes = m_json.Find(pRoot, "scenes");
+            const JsonNode* pScene = m_json.GetElement(pScenes, m_json.GetIndex(pRoot, "scene", 0));
+            if (pScene == nullptr)
+            {
+                const JsonNode* pMeshes = m_json.Find(pRoot, "meshes");
+                for (size_t mesh = 0; mesh < m_json.GetElementCount(pMeshes); mesh++)
+                {
+                    if (!AddMeshPrimitives(mesh, Transform(), primitives))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const JsonNode* pNodes = m_json.Find(pScene, "nodes");
+            for (size_t i = 0; i < m_json.GetElementCount(pNodes); i++)
+            {
+                const JsonNode* pNode = m_json.GetElement(pNodes, i);
+                if (pNode->type != JSON_TYPE::NUMBER || !AddNode(static_cast<size_t>(pNode->number), Transform(), 0, primitives))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool GetAccessor(size_t index, GlbAccessor& accessor) const
+        {
+            const JsonNode* pRoot = m_json.GetRoot();
+            const JsonNode* pAccessor = m_json.GetElement(m_json.Find(pRoot, "accessors"), index);
+            if (pAccessor == nullptr || m_json.Find(pAccessor, "sparse") != nullptr)
+            {
+                return false;
+            }
+            const JsonNode* pType = m_json.Find(pAccessor, "type");
+            const JsonNode* pNormalized = m_json.Find(pAccessor, "normalized");
+            accessor.componentType = static_cast<uint32_t>(m_json.GetIndex(pAccessor, "componentType", 0));
+            accessor.componentCount = pType != nullptr ? GetComponentCount(pType->text) : 0;
+            accessor.count = m_json.GetIndex(pAccessor, "count", SIZE_MAX);
+            accessor.isNormalized = pNormalized != nullptr && pNormalized->text == "true";
+            size_t elementSize = GetComponentSize(accessor.componentType) * accessor.componentCount;
+            const JsonNode* pView = m_json.GetElement(m_json.Find(pRoot, "bufferViews"), m_json.GetIndex(pAccessor, "bufferView", SIZE_MAX));
+            if (elementSize == 0 || accessor.count == SIZE_MAX || pView == nullptr || m_json.GetIndex(pView, "buffer", SIZE_MAX) != 0)
+            {
+                return false;
+            }
+
+            size_t viewOffset = m_json.GetIndex(pView, "byteOffset", 0);
+            size_t viewLength = m_json.GetIndex(pView, "byteLength", SIZE_MAX);
+            size_t accessorOffset = m_json.GetIndex(pAccessor, "byteOffset", 0);
+            accessor.stride = m_json.GetIndex(pView, "byteStride", elementSize);
+            if (viewLength > m_binarySize || viewOffset > m_binarySize - viewLength || accessor.stride < elementSize)
+            {
+                return false;
+            }
+            if (accessor.count > 0 && (accessorOffset > viewLength || accessor.count - 1 > (viewLength - accessorOffset - std::min(viewLength - accessorOffset, elementSize)) / accessor.stride ||
+                viewLength - accessorOffset < elementSize))
+            {
+                return false;
+            }
+            accessor.pData = m_pBinary + viewOffset + accessorOffset;
+            return true;
+        }
+
+    private:
+        bool AddMeshPrimitives(size_t meshIndex, const Transform& transform, std::vector<GlbPrimitive>& primitives) const
+        {
+            const JsonNode* pMesh = m_json.GetElement(m_json.Find(m_json.GetRoot(), "meshes"), meshIndex);
+            if (pMesh == nullptr)
+            {
+                return false;
+            }
+            const JsonNode* pPrimitives = m_json.Find(pMesh, "primitives");
+            for (size_t i = 0; i < m_json.GetElementCount(pPrimitives); i++)
+            {
+                const JsonNode* pPrimitive = m_json.GetElement(pPrimitives, i);
+                // Points and lines have nothing to draw here
+                if (m_json.GetIndex(pPrimitive, "mode", GltfTriangles) == GltfTriangles)
+                {
+                    primitives.push_back({ pPrimitive, transform });
+                }
+            }
+            return true;
+        }
+
+        bool AddNode(size_t nodeIndex, const Transform& parent, int depth, std::vector<GlbPrimitive>& primitives) const
+        {
+            const int MaxDepth = 64;
+            const JsonNode* pNode = m_json.GetElement(m_json.Find(m_json.GetRoot(), "nodes"), nodeIndex);
+            if (pNode == nullptr || depth > MaxDepth)
+            {
+                return false;
+            }
+
+            Transform local;
+            const JsonNode* pMatrix = m_json.Find(pNode, "matrix");
+            if (pMatrix != nullptr)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    const JsonNode* pValue = m_json.GetElement(pMatrix, i);
+                    local.m[i] = pValue != nullptr ? static_cast<float>(pValue->number) : local.m[i];
+                }
+            }
+            else
+            {
+                float t[3] = { 0.0f, 0.0f, 0.0f };
+                float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                float s[3] = { 1.0f, 1.0f, 1.0f };
+                GetFloats(m_json.Find(pNode, "translation"), t, 3);
+                GetFloats(m_json.Find(pNode, "rotation"), q, 4);
+                GetFloats(m_json.Find(pNode, "scale"), s, 3);
+                float rotation[9] = {
+                    1 - 2 * (q[1] * q[1] + q[2] * q[2]), 2 * (q[0] * q[1] + q[2] * q[3]), 2 * (q[0] * q[2] - q[1] * q[3]),
+                    2 * (q[0] * q[1] - q[2] * q[3]), 1 - 2 * (q[0] * q[0] + q[2] * q[2]), 2 * (q[1] * q[2] + q[0] * q[3]),
+                    2 * (q[0] * q[2] + q[1] * q[3]), 2 * (q[1] * q[2] - q[0] * q[3]), 1 - 2 * (q[0] * q[0] + q[1] * q[1]) };
+                for (int column = 0; column < 3; column++)
+                {
+                    for (int row = 0; row < 3; row++)
+                    {
+                        local.m[column * 4 + row] = rotation[column * 3 + row] * s[column];
+                    }
+                    local.m[12 + column] = t[column];
+                }
+            }
+
+            Transform world = parent * local;
+            size_t meshIndex = m_json.GetIndex(pNode, "mesh", SIZE_MAX);
+            if (meshIndex != SIZE_MAX && !AddMeshPrimitives(meshIndex, world, primitives))
+            {
+                return false;
+            }
+            const JsonNode* pChildren = m_json.Find(pNode, "children");
+            for (size_t i = 0; i < m_json.GetElementCount(pChildren); i++)
+            {
+                const JsonNode* pChild = m_json.GetElement(pChildren, i);
+                if (pChild->type != JSON_TYPE::NUMBER || !AddNode(static_cast<size_t>(pChild->number), world, depth + 1, primitives))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void GetFloats(const JsonNode* pArray, float* pValues, size_t count) const
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const JsonNode* pValue = m_json.GetElement(pArray, i);
+                if (pValue != nullptr && pValue->type == JSON_TYPE::NUMBER)
+                {
+                    pValues[i] = static_cast<float>(pValue->number);
+                }
+            }
+        }
+    };
+
+    // Float, or normalized integer components as glTF allows them for texture coordinates
+    float ReadComponent(const GlbAccessor& accessor, size_t element, uint32_t component)
+    {
+        const uint8_t* p = accessor.pData + element * accessor.stride;
+        switch (accessor.componentType)
+        {
+        case GltfFloat:
+        {
+            float value;
+            memcpy(&value, p + component * 4, sizeof(value));
+            return value;
+        }
+        case GltfUnsignedByte:
+            return p[component] / 255.0f;
+        case GltfUnsignedShort:
+        {
+            uint16_t value;
+            memcpy(&value, p + component * 2, sizeof(value));
+            return value / 65535.0f;
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    uint32_t ReadIndex(const GlbAccessor& accessor, size_t element)
+    {
+        const uint8_t* p = accessor.pData + element * accessor.stride;
+        switch (accessor.componentType)
+        {
+        case GltfUnsignedByte:
+            return *p;
+        case GltfUnsignedShort:
+        {
+            uint16_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        default:
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        }
+    }
+
+    // Where a primitive lands in the merged mesh
+    struct GlbInstance
+    {
+        GlbAccessor positions;
+        GlbAccessor normals;
+        GlbAccessor uvs;
+        GlbAccessor indices;
+        bool hasNormals = false;
+        bool hasUvs = false;
+        bool hasIndices = false;
+        Transform transform;
+        // Cofactors of the upper 3x3, normals transform with them; negative determinants flip the winding
+        float normalMatrix[9];
+        bool isMirrored = false;
+        size_t firstVertex = 0;
+        size_t firstIndex = 0;
+        size_t indexCount = 0;
+    };
+
+    bool IsValidAttribute(const GlbAccessor& accessor, uint32_t componentCount, bool allowNormalized)
+    {
+        return accessor.componentCount == componentCount && (accessor.componentType == GltfFloat ||
+            (allowNormalized && accessor.isNormalized && (accessor.componentType == GltfUnsignedByte || accessor.componentType == GltfUnsignedShort)));
+    }
+
+    bool ReadFile(const std::wstring& path, std::vector<char>& data)
+    {
+        FILE* pFile = nullptr;
+#ifdef _WIN32
+        _wfopen_s(&pFile, path.c_str(), L"rb");
+#else
+        std::vector<char> narrowPath(path.size() * MB_CUR_MAX + 1);
+        if (wcstombs(narrowPath.data(), path.c_str(), narrowPath.size()) != static_cast<size_t>(-1))
+        {
+            pFile = fopen(narrowPath.data(), "rb");
+        }
+#endif
+        if (pFile == nullptr)
+        {
+            return false;
+        }
+
+        bool result = fseek(pFile, 0, SEEK_END) == 0;
+        long size = result ? ftell(pFile) : -1;
+        result = size >= 0 && fseek(pFile, 0, SEEK_SET) == 0;
+        if (result)
+        {
+            data.resize(static_cast<size_t>(size));
+            result = fread(data.data(), 1, data.size(), pFile) == data.size();
+        }
+        fclose(pFile);
+        return result;
+    }
+}
+
+bool ImportObj(const char* pText, size_t size, const ImportOptions& options, MeshData& mesh, ImportStats* pStats)
+{
+    uint32_t threadCount = GetThreadCount(options);
+    size_t chunkCount = std::max<size_t>(std::min<size_t>(size / MinChunkSize, threadCount * 4), 1);
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* end = pText + size;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        chunks[i].pBegin = i == 0 ? pText : chunks[i - 1].pEnd;
+        chunks[i].pEnd = i + 1 == chunkCount ? end : std::max(chunks[i].pBegin, SkipLine(pText + size * (i + 1) / chunkCount, end));
+    }
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i) { CountObjChunk(chunks[i]); });
+
+    size_t positionCount = 0;
+    size_t uvCount = 0;
+    size_t normalCount = 0;
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.positionBase = positionCount;
+        chunk.uvBase = uvCount;
+        chunk.normalBase = normalCount;
+        positionCount += chunk.positionCount;
+        uvCount += chunk.uvCount;
+        normalCount += chunk.normalCount;
+    }
+    if (positionCount >= InvalidIndex || uvCount >= InvalidIndex || normalCount >= InvalidIndex)
+    {
+        return false;
+    }
+
+    std::vector<float> positions(positionCount * 3);
+    std::vector<float> uvs(uvCount * 2);
+    std::vector<float> normals(normalCount * 3);
+    ParallelFor(chunkCount, threadCount, [&](size_t i) { ParseObjChunk(chunks[i], positions.data(), uvs.data(), normals.data()); });
+
+    // File normals are used only if every corner has one, otherwise they are all generated
+    size_t cornerCount = 0;
+    bool hasNormals = true;
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (!chunk.isValid)
+        {
+            return false;
+        }
+        cornerCount += chunk.corners.size();
+        for (const ObjCorner& corner : chunk.corners)
+        {
+            if (corner.position >= positionCount || (corner.uv != MissingIndex && corner.uv >= uvCount) ||
+                (corner.normal != MissingIndex && corner.normal >= normalCount))
+            {
+                return false;
+            }
+            hasNormals = hasNormals && corner.normal != MissingIndex;
+        }
+    }
+
+    // Corners that share all three indices become one vertex, numbered in first use order
+    size_t tableSize = 16;
+    while (tableSize < cornerCount * 2)
+    {
+        tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, MissingIndex);
+    std::vector<ObjCorner> vertices;
+    vertices.reserve(cornerCount / 2);
+    mesh = MeshData();
+    mesh.indices.reserve(cornerCount);
+    for (const ObjChunk& chunk : chunks)
+    {
+        for (ObjCorner corner : chunk.corners)
+        {
+            corner.normal = hasNormals ? corner.normal : MissingIndex;
+            size_t slot = HashCorner(corner) & (tableSize - 1);
+            for (;; slot = (slot + 1) & (tableSize - 1))
+            {
+                uint32_t vertex = table[slot];
+                if (vertex == MissingIndex)
+                {
+                    vertex = static_cast<uint32_t>(vertices.size());
+                    table[slot] = vertex;
+                    vertices.push_back(corner);
+                    mesh.indices.push_back(vertex);
+                    break;
+                }
+                const ObjCorner& existing = vertices[vertex];
+                if (existing.position == corner.position && existing.uv == corner.uv && existing.normal == corner.normal)
+                {
+                    mesh.indices.push_back(vertex);
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t vertexCount = vertices.size();
+    mesh.positions.resize(vertexCount * 3);
+    mesh.uvs.resize(vertexCount * 2);
+    if (hasNormals)
+    {
+        mesh.normals.resize(vertexCount * 3);
+    }
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        const ObjCorner& corner = vertices[vertex];
+        const float* pPosition = &positions[corner.position * 3];
+        mesh.positions[vertex * 3] = pPosition[0];
+        mesh.positions[vertex * 3 + 1] = pPosition[1];
+        mesh.positions[vertex * 3 + 2] = -pPosition[2];
+        if (corner.uv != MissingIndex)
+        {
+            mesh.uvs[vertex * 2] = uvs[corner.uv * 2];
+            mesh.uvs[vertex * 2 + 1] = 1.0f - uvs[corner.uv * 2 + 1];
+        }
+        if (hasNormals)
+        {
+            const float* pNormal = &normals[corner.normal * 3];
+            mesh.normals[vertex * 3] = pNormal[0];
+            mesh.normals[vertex * 3 + 1] = pNormal[1];
+            mesh.normals[vertex * 3 + 2] = -pNormal[2];
+        }
+    }
+
+    bool generateNormals = !hasNormals && options.generateNormals && vertexCount > 0;
+    if (generateNormals)
+    {
+        GenerateNormals(mesh, 0, 0);
+    }
+    FinishImport(mesh, options);
+
+    if (pStats != nullptr)
+    {
+        pStats->bytes = size;
+        pStats->sourceVertices = cornerCount;
+        pStats->generatedNormals = generateNormals;
+    }
+    return true;
+}
+
+bool ImportGlb(const void* pData, size_t size, const ImportOptions& options, MeshData& mesh, ImportStats* pStats)
+{
+    GlbReader reader;
+    std::vector<GlbPrimitive> primitives;
+    if (!reader.Open(pData, size) || !reader.GetPrimitives(primitives))
+    {
+        return false;
+    }
+    const JsonDocument& json = reader.GetJson();
+
+    // Resolve every primitive and lay the merged mesh out before converting anything
+    std::vector<GlbInstance> instances(primitives.size());
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    bool isMissingNormals = false;
+    for (size_t i = 0; i < primitives.size(); i++)
+    {
+        GlbInstance& instance = instances[i];
+        const JsonNode* pAttributes = json.Find(primitives[i].pPrimitive, "attributes");
+        size_t indices = json.GetIndex(primitives[i].pPrimitive, "indices", SIZE_MAX);
+        size_t normals = json.GetIndex(pAttributes, "NORMAL", SIZE_MAX);
+        size_t uvs = json.GetIndex(pAttributes, "TEXCOORD_0", SIZE_MAX);
+        if (!reader.GetAccessor(json.GetIndex(pAttributes, "POSITION", SIZE_MAX), instance.positions) ||
+            !IsValidAttribute(instance.positions, 3, false))
+        {
+            return false;
+        }
+        instance.hasNormals = normals != SIZE_MAX;
+        instance.hasUvs = uvs != SIZE_MAX;
+        instance.hasIndices = indices != SIZE_MAX;
+        if ((instance.hasNormals && (!reader.GetAccessor(normals, instance.normals) || !IsValidAttribute(instance.normals, 3, false) ||
+                instance.normals.count != instance.positions.count)) ||
+            (instance.hasUvs && (!reader.GetAccessor(uvs, instance.uvs) || !IsValidAttribute(instance.uvs, 2, true) ||
+                instance.uvs.count != instance.positions.count)) ||
+            (instance.hasIndices && (!reader.GetAccessor(indices, instance.indices) || instance.indices.componentCount != 1 ||
+                (instance.indices.componentType != GltfUnsignedByte && instance.indices.componentType != GltfUnsignedShort &&
+                instance.indices.componentType != GltfUnsignedInt))))
+        {
+            return false;
+        }
+
+        instance.transform = primitives[i].transform;
+        const float* m = instance.transform.m;
+        // Rows of the cofactor matrix are cross products of the columns
+        const float* c0 = &m[0];
+        const float* c1 = &m[4];
+        const float* c2 = &m[8];
+        float cofactors[9] = {
+            c1[1] * c2[2] - c1[2] * c2[1], c1[2] * c2[0] - c1[0] * c2[2], c1[0] * c2[1] - c1[1] * c2[0],
+            c2[1] * c0[2] - c2[2] * c0[1], c2[2] * c0[0] - c2[0] * c0[2], c2[0] * c0[1] - c2[1] * c0[0],
+            c0[1] * c1[2] - c0[2] * c1[1], c0[2] * c1[0] - c0[0] * c1[2], c0[0] * c1[1] - c0[1] * c1[0] };
+        float determinant = c0[0] * cofactors[0] + c0[1] * cofactors[1] + c0[2] * cofactors[2];
+        instance.isMirrored = determinant < 0.0f;
+        for (int i = 0; i < 9; i++)
+        {
+            instance.normalMatrix[i] = instance.isMirrored ? -cofactors[i] : cofactors[i];
+        }
+
+        instance.indexCount = instance.hasIndices ? instance.indices.count : instance.positions.count;
+        instance.indexCount -= instance.indexCount % 3;
+        instance.firstVertex = vertexCount;
+        instance.firstIndex = indexCount;
+        vertexCount += instance.positions.count;
+        indexCount += instance.indexCount;
+        isMissingNormals = isMissingNormals || !instance.hasNormals;
+        if (vertexCount >= InvalidIndex)
+        {
+            return false;
+        }
+    }
+
+    mesh = MeshData();
+    mesh.positions.resize(vertexCount * 3);
+    mesh.uvs.resize(vertexCount * 2);
+    mesh.normals.resize(vertexCount * 3);
+    mesh.indices.resize(indexCount);
+
+    // Work items are vertex ranges of the instances followed by their index buffers
+    struct WorkItem
+    {
+        size_t instance;
+        size_t begin;
+        size_t end;
+        bool isIndices;
+    };
+    std::vector<WorkItem> items;
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        for (size_t begin = 0; begin < instances[i].positions.count; begin += VertexRangeSize)
+        {
+            items.push_back({ i, begin, std::min(begin + VertexRangeSize, instances[i].positions.count), false });
+        }
+        for (size_t begin = 0; begin < instances[i].indexCount; begin += VertexRangeSize * 3)
+        {
+            items.push_back({ i, begin, std::min(begin + VertexRangeSize * 3, instances[i].indexCount), true });
+        }
+    }
+
+    std::atomic<bool> isValid(true);
+    ParallelFor(items.size(), GetThreadCount(options), [&](size_t itemIndex)
+    {
+        const WorkItem& item = items[itemIndex];
+        const GlbInstance& instance = instances[item.instance];
+        if (item.isIndices)
+        {
+            size_t vertexLimit = instance.positions.count;
+            for (size_t i = item.begin; i < item.end; i += 3)
+            {
+                uint32_t triangle[3];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    triangle[corner] = instance.hasIndices ? ReadIndex(instance.indices, i + corner) : static_cast<uint32_t>(i + corner);
+                    if (triangle[corner] >= vertexLimit)
+                    {
+                        isValid = false;
+                        return;
+                    }
+                }
+                // Mirroring along z rewinds the triangle, a mirroring node transform rewinds it back
+                uint32_t* pTriangle = &mesh.indices[instance.firstIndex + i];
+                pTriangle[0] = static_cast<uint32_t>(instance.firstVertex + triangle[0]);
+                pTriangle[1] = static_cast<uint32_t>(instance.firstVertex + triangle[instance.isMirrored ? 1 : 2]);
+                pTriangle[2] = static_cast<uint32_t>(instance.firstVertex + triangle[instance.isMirrored ? 2 : 1]);
+            }
+            return;
+        }
+
+        const float* m = instance.transform.m;
+        const float* n = instance.normalMatrix;
+        for (size_t i = item.begin; i < item.end; i++)
+        {
+            size_t vertex = instance.firstVertex + i;
+            float p[3] = { ReadComponent(instance.positions, i, 0), ReadComponent(instance.positions, i, 1), ReadComponent(instance.positions, i, 2) };
+            mesh.positions[vertex * 3] = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+            mesh.positions[vertex * 3 + 1] = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+            mesh.positions[vertex * 3 + 2] = -(m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]);
+            if (instance.hasNormals)
+            {
+                float v[3] = { ReadComponent(instance.normals, i, 0), ReadComponent(instance.normals, i, 1), ReadComponent(instance.normals, i, 2) };
+                float normal[3] = {
+                    n[0] * v[0] + n[3] * v[1] + n[6] * v[2],
+                    n[1] * v[0] + n[4] * v[1] + n[7] * v[2],
+                    n[2] * v[0] + n[5] * v[1] + n[8] * v[2] };
+                float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                float scale = length > 0.0f ? 1.0f / length : 0.0f;
+                mesh.normals[vertex * 3] = normal[0] * scale;
+                mesh.normals[vertex * 3 + 1] = normal[1] * scale;
+                mesh.normals[vertex * 3 + 2] = -normal[2] * scale;
+            }
+            if (instance.hasUvs)
+            {
+                mesh.uvs[vertex * 2] = ReadComponent(instance.uvs, i, 0);
+                mesh.uvs[vertex * 2 + 1] = ReadComponent(instance.uvs, i, 1);
+            }
+        }
+    });
+    if (!isValid)
+    {
+        return false;
+    }
+
+    // Normals are generated per primitive, so they do not blend across primitives that have their own
+    bool generateNormals = isMissingNormals && options.generateNormals;
+    if (generateNormals)
+    {
+        MeshData primitive;
+        for (const GlbInstance& instance : instances)
+        {
+            if (instance.hasNormals)
+            {
+                continue;
+            }
+            size_t count = instance.positions.count;
+            primitive.positions.assign(mesh.positions.begin() + instance.firstVertex * 3, mesh.positions.begin() + (instance.firstVertex + count) * 3);
+            primitive.indices.resize(instance.indexCount);
+            for (size_t i = 0; i < instance.indexCount; i++)
+            {
+                primitive.indices[i] = static_cast<uint32_t>(mesh.indices[instance.firstIndex + i] - instance.firstVertex);
+            }
+            GenerateNormals(primitive, 0, 0);
+            std::copy(primitive.normals.begin(), primitive.normals.end(), mesh.normals.begin() + instance.firstVertex * 3);
+        }
+    }
+    else if (isMissingNormals)
+    {
+        mesh.normals.clear();
+    }
+    FinishImport(mesh, options);
+
+    if (pStats != nullptr)
+    {
+        pStats->bytes = size;
+        pStats->sourceVertices = vertexCount;
+        pStats->generatedNormals = generateNormals;
+    }
+    return true;
+}
+
+bool ImportMesh(const std::wstring& path, const ImportOptions& options, MeshData& mesh, ImportStats* pStats)
+{
+    size_t extension = path.find_last_of(L'.');
+    std::wstring type = extension != std::wstring::npos ? path.substr(extension) : std::wstring();
+    std::transform(type.begin(), type.end(), type.begin(), [](wchar_t c) { return c >= L'A' && c <= L'Z' ? wchar_t(c - L'A' + L'a') : c; });
+    bool isObj = type == L".obj";
+    if (!isObj && type != L".glb")
+    {
+        return false;
+    }
+
+    std::vector<char> data;
+    if (!ReadFile(path, data))
+    {
+        return false;
+    }
+    return isObj ? ImportObj(data.data(), data.size(), options, mesh, pStats) : ImportGlb(data.data(), data.size(), options, mesh, pStats);
+}
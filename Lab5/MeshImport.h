@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ProceduralMesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ImportOptions
+{
+    // Parsing threads, 0 uses one per hardware thread
+    uint32_t threadCount = 0;
+    // Smooth normals from the triangles for the parts of the file that have none
+    bool generateNormals = true;
+    // Vertex cache, overdraw and vertex fetch order through OptimizeMesh, files rarely come in a good one
+    bool optimize = true;
+};
+
+struct ImportStats
+{
+    size_t bytes = 0;
+    // Vertices as the file references them, before deduplication
+    size_t sourceVertices = 0;
+    bool generatedNormals = false;
+};
+
+// Both formats are right-handed with counterclockwise front faces. The result is mirrored along z and rewound,
+// so it matches the generated meshes: left-handed, clockwise front faces, texture origin at the top left.
+// Tangents are not imported. Returns false on malformed input, leaving the mesh in an unspecified state.
+
+// Wavefront OBJ: v, vt, vn and f lines with polygons fanned into triangles, split into chunks at line boundaries
+// and parsed in parallel. Corners are deduplicated by their position, texture and normal indices. Groups, objects
+// and materials are ignored.
+bool ImportObj(const char* pText, size_t size, const ImportOptions& options, MeshData& mesh, ImportStats* pStats = nullptr);
+// Binary glTF 2.0 with the geometry in the embedded buffer: triangle primitives of the default scene with the
+// node transforms applied, merged into one mesh. Sparse accessors and external buffers are not supported.
+bool ImportGlb(const void* pData, size_t size, const ImportOptions& options, MeshData& mesh, ImportStats* pStats = nullptr);
+// Reads the file and picks the importer from the extension, .obj or .glb
+bool ImportMesh(const std::wstring& path, const ImportOptions& options, MeshData& mesh, ImportStats* pStats = nullptr);
@@ -0,0 +1,75 @@
+#include "MeshMetrics.h"
+
+#include <vector>
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount == 0 || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    // A vertex is in the cache while fewer than cacheSize misses happened since it was loaded
+    std::vector<uint64_t> loadTime(vertexCount, 0);
+    uint64_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t vertex = pIndices[i];
+        if (loadTime[vertex] == 0 || misses - loadTime[vertex] >= cacheSize)
+        {
+            misses++;
+            loadTime[vertex] = misses;
+        }
+    }
+
+    stats.transformedVertices = misses;
+    stats.acmr = static_cast<double>(misses) / (indexCount / 3);
+    stats.atvr = static_cast<double>(misses) / vertexCount;
+    return stats;
+}
+
+VertexFetchStats AnalyzeVertexFetch(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+{
+    VertexFetchStats stats;
+    if (indexCount == 0 || vertexCount == 0 || vertexSize == 0)
+    {
+        return stats;
+    }
+
+    // Roughly the texture/vertex cache of a GPU shader core
+    const size_t LineSize = 64;
+    const size_t LineCount = 64;
+    uint64_t lines[LineCount];
+    for (uint64_t& line : lines)
+    {
+        line = UINT64_MAX;
+    }
+
+    std::vector<bool> referenced(vertexCount, false);
+    size_t referencedCount = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t vertex = pIndices[i];
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            referencedCount++;
+        }
+
+        uint64_t firstLine = uint64_t(vertex) * vertexSize / LineSize;
+        uint64_t lastLine = (uint64_t(vertex) * vertexSize + vertexSize - 1) / LineSize;
+        for (uint64_t line = firstLine; line <= lastLine; line++)
+        {
+            uint64_t& slot = lines[line % LineCount];
+            if (slot != line)
+            {
+                slot = line;
+                stats.bytesFetched += LineSize;
+            }
+        }
+    }
+
+    stats.overfetch = static_cast<double>(stats.bytesFetched) / (referencedCount * vertexSize);
+    return stats;
+}
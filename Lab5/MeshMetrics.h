@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Post-transform vertex cache behaviour of an index buffer, simulated as a FIFO of the given size
+struct VertexCacheStats
+{
+    // Transformed vertices per triangle, 0.5 is the limit for large regular grids and 3 means no reuse
+    double acmr = 0.0;
+    // Transformed vertices per unique vertex, 1 means every vertex is transformed once
+    double atvr = 0.0;
+    uint64_t transformedVertices = 0;
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+// Memory traffic of vertex fetch through a direct mapped cache of 64 byte lines
+struct VertexFetchStats
+{
+    // Bytes fetched per byte of vertices referenced, 1 means every line is read once
+    double overfetch = 0.0;
+    uint64_t bytesFetched = 0;
+};
+
+VertexFetchStats AnalyzeVertexFetch(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, size_t vertexSize);
@@ -0,0 +1,391 @@
+#include "MeshOptimizer.h"
+#include "MeshMetrics.h"
+#include "ProceduralMesh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Largest cache the scoring tables are built for
+    const uint32_t MaxCacheSize = 64;
+    const float CacheDecayPower = 1.5f;
+    const float LastTriangleScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+    const uint32_t ValenceTableSize = 32;
+
+    class VertexScorer
+    {
+    public:
+        explicit VertexScorer(uint32_t cacheSize)
+        {
+            for (uint32_t position = 0; position < MaxCacheSize + 3; position++)
+            {
+                if (position < 3)
+                {
+                    // Vertices of the last triangle get a fixed score, so the next one does not just reuse the same edge
+                    m_cacheScores[position] = LastTriangleScore;
+                }
+                else if (position < cacheSize)
+                {
+                    float scaler = 1.0f / (cacheSize - 3);
+                    m_cacheScores[position] = powf(1.0f - (position - 3) * scaler, CacheDecayPower);
+                }
+                else
+                {
+                    m_cacheScores[position] = 0.0f;
+                }
+            }
+            for (uint32_t valence = 0; valence < ValenceTableSize; valence++)
+            {
+                m_valenceScores[valence] = valence == 0 ? 0.0f : ValenceBoostScale * powf(float(valence), -ValenceBoostPower);
+            }
+        }
+
+        float GetScore(int cachePosition, uint32_t valence) const
+        {
+            if (valence == 0)
+            {
+                // Nothing left to draw with this vertex
+                return -1.0f;
+            }
+            float score = cachePosition < 0 ? 0.0f : m_cacheScores[cachePosition];
+            score += valence < ValenceTableSize ? m_valenceScores[valence] : ValenceBoostScale * powf(float(valence), -ValenceBoostPower);
+            return score;
+        }
+
+    private:
+        float m_cacheScores[MaxCacheSize + 3];
+        float m_valenceScores[ValenceTableSize];
+    };
+}
+
+void OptimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+    cacheSize = std::max(4u, std::min(cacheSize, MaxCacheSize));
+    VertexScorer scorer(cacheSize);
+
+    // Triangles of every vertex, compacted as they are emitted so the first valence entries are the live ones
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        assert(pIndices[i] < vertexCount);
+        valence[pIndices[i]]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + valence[vertex];
+    }
+    std::vector<uint32_t> adjacency(indexCount);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency[fill[pIndices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        vertexScores[vertex] = scorer.GetScore(-1, valence[vertex]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const uint32_t* pTriangle = pIndices + triangle * 3;
+        triangleScores[triangle] = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+    }
+
+    std::vector<uint32_t> result(indexCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t cache[MaxCacheSize + 3];
+    uint32_t newCache[MaxCacheSize + 3];
+    uint32_t cacheCount = 0;
+    size_t nextCandidate = 0;
+
+    uint32_t bestTriangle = 0;
+    for (size_t triangle = 1; triangle < triangleCount; triangle++)
+    {
+        if (triangleScores[triangle] > triangleScores[bestTriangle])
+        {
+            bestTriangle = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    for (size_t outputTriangle = 0; outputTriangle < triangleCount; outputTriangle++)
+    {
+        // Dead end: none of the cached vertices has triangles left, continue with the next unemitted one in input order
+        if (bestTriangle == UINT32_MAX)
+        {
+            while (emitted[nextCandidate])
+            {
+                nextCandidate++;
+            }
+            bestTriangle = static_cast<uint32_t>(nextCandidate);
+        }
+
+        const uint32_t* pTriangle = pIndices + size_t(bestTriangle) * 3;
+        memcpy(&result[outputTriangle * 3], pTriangle, 3 * sizeof(uint32_t));
+        emitted[bestTriangle] = true;
+
+        // The triangle's vertices move to the front, the rest keeps its order behind them
+        uint32_t newCacheCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            uint32_t vertex = pTriangle[i];
+            newCache[newCacheCount++] = vertex;
+
+            uint32_t* pBegin = &adjacency[adjacencyOffsets[vertex]];
+            uint32_t* pEnd = pBegin + valence[vertex];
+            uint32_t* pFound = std::find(pBegin, pEnd, bestTriangle);
+            assert(pFound != pEnd);
+            std::swap(*pFound, *(pEnd - 1));
+            valence[vertex]--;
+        }
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            uint32_t vertex = cache[i];
+            if (vertex != pTriangle[0] && vertex != pTriangle[1] && vertex != pTriangle[2])
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        // Rescore the cached and the evicted vertices and push the change to their live triangles
+        bestTriangle = UINT32_MAX;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < newCacheCount; i++)
+        {
+            uint32_t vertex = newCache[i];
+            int position = i < cacheSize ? static_cast<int>(i) : -1;
+            float score = scorer.GetScore(position, valence[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const uint32_t* pAdjacent = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < valence[vertex]; j++)
+            {
+                uint32_t triangle = pAdjacent[j];
+                triangleScores[triangle] += delta;
+                if (position >= 0 && triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCacheCount, cacheSize);
+        memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+
+    memcpy(pIndices, result.data(), indexCount * sizeof(uint32_t));
+}
+
+void OptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount,
+    uint32_t cacheSize, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Hard cluster boundaries where a triangle misses the cache with all three vertices
+    std::vector<uint8_t> triangleMisses(triangleCount, 0);
+    std::vector<uint64_t> loadTime(vertexCount, 0);
+    uint64_t misses = 0;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            uint32_t vertex = pIndices[triangle * 3 + i];
+            if (loadTime[vertex] == 0 || misses - loadTime[vertex] >= cacheSize)
+            {
+                misses++;
+                loadTime[vertex] = misses;
+                triangleMisses[triangle]++;
+            }
+        }
+    }
+
+    // Soft boundaries inside them, wherever the cluster so far, starting from a cold cache, is already about as
+    // cache efficient as the whole cluster: smaller clusters give the sort more to work with
+    std::vector<uint32_t> clusterStarts;
+    size_t hardStart = 0;
+    while (hardStart < triangleCount)
+    {
+        size_t hardEnd = hardStart + 1;
+        uint32_t hardMisses = triangleMisses[hardStart];
+        while (hardEnd < triangleCount && triangleMisses[hardEnd] != 3)
+        {
+            hardMisses += triangleMisses[hardEnd++];
+        }
+        float clusterThreshold = threshold * hardMisses / (hardEnd - hardStart);
+
+        clusterStarts.push_back(static_cast<uint32_t>(hardStart));
+        size_t softStart = hardStart;
+        uint64_t softMisses = 0;
+        // Advancing the clock by a cache size evicts everything
+        misses += cacheSize;
+        for (size_t triangle = hardStart; triangle + 1 < hardEnd; triangle++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t vertex = pIndices[triangle * 3 + i];
+                if (loadTime[vertex] == 0 || misses - loadTime[vertex] >= cacheSize)
+                {
+                    misses++;
+                    loadTime[vertex] = misses;
+                    softMisses++;
+                }
+            }
+            if (softMisses <= clusterThreshold * (triangle + 1 - softStart))
+            {
+                softStart = triangle + 1;
+                softMisses = 0;
+                misses += cacheSize;
+                clusterStarts.push_back(static_cast<uint32_t>(softStart));
+            }
+        }
+        hardStart = hardEnd;
+    }
+    if (clusterStarts.size() < 2)
+    {
+        return;
+    }
+
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            meshCenter[i] += pPositions[vertex * 3 + i];
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        meshCenter[i] /= vertexCount;
+    }
+
+    // Area weighted normal and centroid of every cluster, sorted by how far the cluster faces away from the center
+    struct Cluster
+    {
+        uint32_t start;
+        uint32_t end;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters(clusterStarts.size());
+    for (size_t clusterIdx = 0; clusterIdx < clusters.size(); clusterIdx++)
+    {
+        Cluster& cluster = clusters[clusterIdx];
+        cluster.start = clusterStarts[clusterIdx];
+        cluster.end = clusterIdx + 1 < clusterStarts.size() ? clusterStarts[clusterIdx + 1] : static_cast<uint32_t>(triangleCount);
+
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float centroid[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (uint32_t triangle = cluster.start; triangle < cluster.end; triangle++)
+        {
+            const float* a = pPositions + pIndices[triangle * 3] * 3;
+            const float* b = pPositions + pIndices[triangle * 3 + 1] * 3;
+            const float* c = pPositions + pIndices[triangle * 3 + 2] * 3;
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int i = 0; i < 3; i++)
+            {
+                normal[i] += n[i];
+                centroid[i] += (a[i] + b[i] + c[i]) * triangleArea / 3.0f;
+            }
+            area += triangleArea;
+        }
+        float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        cluster.sortKey = 0.0f;
+        if (area > 0.0f && normalLength > 0.0f)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                cluster.sortKey += (centroid[i] / area - meshCenter[i]) * normal[i] / normalLength;
+            }
+        }
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+        {
+            return a.sortKey > b.sortKey;
+        });
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for (const Cluster& cluster : clusters)
+    {
+        result.insert(result.end(), pIndices + cluster.start * 3, pIndices + cluster.end * 3);
+    }
+
+    double before = AnalyzeVertexCache(pIndices, indexCount, vertexCount, cacheSize).acmr;
+    double after = AnalyzeVertexCache(result.data(), indexCount, vertexCount, cacheSize).acmr;
+    if (after <= before * threshold)
+    {
+        memcpy(pIndices, result.data(), indexCount * sizeof(uint32_t));
+    }
+}
+
+void OptimizeVertexFetch(uint32_t* pIndices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap)
+{
+    remap.assign(vertexCount, UINT32_MAX);
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& mapped = remap[pIndices[i]];
+        if (mapped == UINT32_MAX)
+        {
+            mapped = nextVertex++;
+        }
+        pIndices[i] = mapped;
+    }
+    for (uint32_t& mapped : remap)
+    {
+        if (mapped == UINT32_MAX)
+        {
+            mapped = nextVertex++;
+        }
+    }
+}
+
+void RemapVertexStream(std::vector<float>& stream, size_t componentCount, const std::vector<uint32_t>& remap)
+{
+    if (stream.empty())
+    {
+        return;
+    }
+    assert(stream.size() == remap.size() * componentCount);
+    std::vector<float> remapped(stream.size());
+    for (size_t vertex = 0; vertex < remap.size(); vertex++)
+    {
+        memcpy(&remapped[remap[vertex] * componentCount], &stream[vertex * componentCount], componentCount * sizeof(float));
+    }
+    stream.swap(remapped);
+}
+
+void OptimizeMesh(MeshData& mesh, uint32_t cacheSize)
+{
+    size_t vertexCount = mesh.GetVertexCount();
+    OptimizeVertexCache(mesh.indices.data(), mesh.GetIndexCount(), vertexCount, cacheSize);
+    OptimizeOverdraw(mesh.indices.data(), mesh.GetIndexCount(), mesh.positions.data(), vertexCount, cacheSize);
+
+    std::vector<uint32_t> remap;
+    OptimizeVertexFetch(mesh.indices.data(), mesh.GetIndexCount(), vertexCount, remap);
+    RemapVertexStream(mesh.positions, 3, remap);
+    RemapVertexStream(mesh.normals, 3, remap);
+    RemapVertexStream(mesh.tangents, 4, remap);
+    RemapVertexStream(mesh.uvs, 2, remap);
+}
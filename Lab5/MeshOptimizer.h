@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshData;
+
+// Triangle orders are rewritten in place, index values are only changed by OptimizeVertexFetch.
+// The passes are meant to run in this order: cache, overdraw, fetch.
+
+// Forsyth's linear-speed vertex cache optimization: greedily emits the triangle whose vertices score best,
+// favouring vertices recently used and those with few triangles left
+void OptimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 32);
+
+// Splits a cache-optimized order into clusters where the cache starts over and orders the clusters from
+// those facing outwards to those facing the center, so convex parts are drawn before what they occlude.
+// Keeps the input when the cache efficiency would drop below the threshold (ACMR ratio).
+void OptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount,
+    uint32_t cacheSize = 32, float threshold = 1.05f);
+
+// Renumbers vertices in the order the index buffer first uses them, so vertex fetch walks memory forwards.
+// remap[old] is the new index, unused vertices are moved to the end.
+void OptimizeVertexFetch(uint32_t* pIndices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap);
+
+// Moves the vertices of a stream with componentCount floats per vertex to their remapped positions
+void RemapVertexStream(std::vector<float>& stream, size_t componentCount, const std::vector<uint32_t>& remap);
+
+// All three passes on a generated or loaded mesh, remapping every stream
+void OptimizeMesh(MeshData& mesh, uint32_t cacheSize = 32);
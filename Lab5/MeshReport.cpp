@@ -0,0 +1,439 @@
+#include "MeshReport.h"
+#include "ProceduralMesh.h"
+#include "MeshMetrics.h"
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+#include "MeshFile.h"
+#include "MeshImport.h"
+#include "MeshSimplifier.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct MeshPrimitive
+    {
+        const char* name;
+        void (*generate)(const MeshOptions& options, MeshData& mesh);
+    };
+
+    // Sizes in the range of what the scene would draw up close
+    const MeshPrimitive MeshPrimitives[] = {
+        { "uv_sphere_64x32", [](const MeshOptions& options, MeshData& mesh) { GenerateUvSphere(1.0f, 64, 32, options, mesh); } },
+        { "icosphere_4", [](const MeshOptions& options, MeshData& mesh) { GenerateIcosphere(1.0f, 4, options, mesh); } },
+        { "cube_16", [](const MeshOptions& options, MeshData& mesh) { GenerateCube(1.0f, 16, options, mesh); } },
+        { "plane_64x64", [](const MeshOptions& options, MeshData& mesh) { GeneratePlane(2.0f, 2.0f, 64, 64, options, mesh); } },
+        { "cylinder_64x8", [](const MeshOptions& options, MeshData& mesh) { GenerateCylinder(1.0f, 2.0f, 64, 8, options, mesh); } },
+        { "torus_64x32", [](const MeshOptions& options, MeshData& mesh) { GenerateTorus(1.0f, 0.25f, 64, 32, options, mesh); } },
+    };
+
+    const uint32_t CacheSizes[] = { 16, 32 };
+
+    enum class MESH_ORDER
+    {
+        // Row by row, as a plain generator would emit it
+        SCAN,
+        // Cache-aware strips of the generators
+        STRIPS,
+        // Scan order through the vertex cache, overdraw and vertex fetch optimizers
+        OPTIMIZED,
+        COUNT
+    };
+
+    // The compact precision of the renderer, with normals
+    VertexRequirements GetCompactRequirements(const MeshData& mesh)
+    {
+        VertexRequirements requirements;
+        requirements.normals = true;
+        requirements.maxPositionError = mesh.bounds.radius * CompactPositionTolerance;
+        requirements.maxNormalError = CompactNormalTolerance;
+        requirements.maxUvError = CompactUvTolerance;
+        return requirements;
+    }
+
+    const char* GetVertexFormatName(const VertexFormat& format)
+    {
+        static const char* PositionNames[] = { "f32", "sn16", "f16" };
+        static const char* NormalNames[] = { "-", "f32", "oct16" };
+        static const char* UvNames[] = { "-", "f32", "un16", "f16" };
+        static char name[32];
+        sprintf_s(name, "%s/%s/%s", PositionNames[static_cast<int>(format.position)],
+            NormalNames[static_cast<int>(format.normal)], UvNames[static_cast<int>(format.uv)]);
+        return name;
+    }
+
+    // atan2 keeps its precision for the tiny angles acos loses
+    float GetAngle(const float a[3], const float b[3])
+    {
+        double cross[3] = {
+            double(a[1]) * b[2] - double(a[2]) * b[1],
+            double(a[2]) * b[0] - double(a[0]) * b[2],
+            double(a[0]) * b[1] - double(a[1]) * b[0] };
+        double dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+        return static_cast<float>(atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot));
+    }
+
+    const wchar_t* GetMeshOrderName(MESH_ORDER order)
+    {
+        switch (order)
+        {
+        case MESH_ORDER::SCAN:
+            return L"scan";
+        case MESH_ORDER::STRIPS:
+            return L"strips";
+        case MESH_ORDER::OPTIMIZED:
+            return L"optimized";
+        default:
+            return L"unknown";
+        }
+    }
+
+    // One submesh per level with the indices of all levels after each other, as a mesh file stores them
+    void FlattenLodChain(const std::vector<LodLevel>& levels, std::vector<uint32_t>& indices,
+        std::vector<MeshSubmesh>& submeshes, std::vector<MeshLod>& lods)
+    {
+        indices.clear();
+        submeshes.clear();
+        lods.clear();
+        for (const LodLevel& level : levels)
+        {
+            MeshSubmesh submesh = { static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level.indices.size()), 0, 0 };
+            MeshLod lod = { static_cast<uint32_t>(submeshes.size()), 1, level.error };
+            indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+            submeshes.push_back(submesh);
+            lods.push_back(lod);
+        }
+    }
+}
+
+int RunMeshReport(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const int Repetitions = 5;
+
+    FILE* pReport = nullptr;
+    if (!options.reportPath.empty())
+    {
+        _wfopen_s(&pReport, options.reportPath.c_str(), L"w");
+        if (pReport == nullptr)
+        {
+            wprintf(L"Failed to open report file %s\n", options.reportPath.c_str());
+            return 1;
+        }
+        fprintf(pReport, "{\n  \"orders\": [\n");
+    }
+
+    wprintf(L"%-18s %8s %8s %10s %-10s %8s %8s %8s %8s %9s\n", L"mesh", L"verts", L"tris", L"ms", L"order",
+        L"acmr16", L"atvr16", L"acmr32", L"atvr32", L"overfetch");
+
+    bool first = true;
+    for (const MeshPrimitive& primitive : MeshPrimitives)
+    {
+        for (int order = 0; order < static_cast<int>(MESH_ORDER::COUNT); order++)
+        {
+            MeshOptions meshOptions;
+            meshOptions.tangents = true;
+            meshOptions.cacheSize = static_cast<MESH_ORDER>(order) == MESH_ORDER::STRIPS ? MeshOptions().cacheSize : 0;
+
+            // Best of a few runs into the same mesh, the way a streaming system would reuse its buffers.
+            // The optimized order includes the time of the optimizer.
+            MeshData mesh;
+            double best = 0.0;
+            for (int repetition = 0; repetition < Repetitions; repetition++)
+            {
+                Clock::time_point start = Clock::now();
+                primitive.generate(meshOptions, mesh);
+                if (static_cast<MESH_ORDER>(order) == MESH_ORDER::OPTIMIZED)
+                {
+                    OptimizeMesh(mesh);
+                }
+                double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                best = repetition == 0 ? elapsed : min(best, elapsed);
+            }
+
+            VertexCacheStats stats[2];
+            for (int cache = 0; cache < 2; cache++)
+            {
+                stats[cache] = AnalyzeVertexCache(mesh.indices.data(), mesh.GetIndexCount(), mesh.GetVertexCount(), CacheSizes[cache]);
+            }
+            // Position, normal, tangent and texture coordinates interleaved
+            VertexFetchStats fetch = AnalyzeVertexFetch(mesh.indices.data(), mesh.GetIndexCount(), mesh.GetVertexCount(), 12 * sizeof(float));
+
+            const wchar_t* orderName = GetMeshOrderName(static_cast<MESH_ORDER>(order));
+            wprintf(L"%-18S %8zu %8zu %10.3f %-10s %8.3f %8.3f %8.3f %8.3f %9.3f\n", primitive.name, mesh.GetVertexCount(),
+                mesh.GetIndexCount() / 3, best * 1000.0, orderName, stats[0].acmr, stats[0].atvr, stats[1].acmr, stats[1].atvr,
+                fetch.overfetch);
+            if (pReport != nullptr)
+            {
+                fprintf(pReport, "%s    { \"name\": \"%s\", \"order\": \"%S\", \"vertices\": %zu, \"triangles\": %zu, \"ms\": %.4f, "
+                    "\"acmr16\": %.4f, \"atvr16\": %.4f, \"acmr32\": %.4f, \"atvr32\": %.4f, \"overfetch\": %.4f }",
+                    first ? "" : ",\n", primitive.name, orderName, mesh.GetVertexCount(), mesh.GetIndexCount() / 3,
+                    best * 1000.0, stats[0].acmr, stats[0].atvr, stats[1].acmr, stats[1].atvr, fetch.overfetch);
+            }
+            first = false;
+        }
+    }
+
+    // Compact vertex formats as the renderer picks them, with the error measured on every vertex against its bound
+    if (pReport != nullptr)
+    {
+        fprintf(pReport, "\n  ],\n  \"vertexFormats\": [\n");
+    }
+    wprintf(L"\n%-18s %-16s %6s %10s %10s %10s %10s %10s %10s %10s\n", L"mesh", L"format", L"stride", L"bytes",
+        L"pos err", L"bound", L"normal err", L"bound", L"uv err", L"bound");
+
+    bool withinBounds = true;
+    first = true;
+    for (const MeshPrimitive& primitive : MeshPrimitives)
+    {
+        MeshData mesh;
+        primitive.generate(MeshOptions(), mesh);
+
+        VertexFormat format = ChooseVertexFormat(mesh, GetCompactRequirements(mesh));
+        EncodedVertices vertices;
+        EncodeVertices(mesh, format, vertices);
+
+        float maxAbsUv = 0.0f;
+        for (float uv : mesh.uvs)
+        {
+            maxAbsUv = max(maxAbsUv, fabsf(uv));
+        }
+        float positionBound = GetPositionErrorBound(format.position, mesh.bounds);
+        float normalBound = GetNormalErrorBound(format.normal);
+        float uvBound = GetUvErrorBound(format.uv, maxAbsUv);
+
+        float positionError = 0.0f;
+        float normalError = 0.0f;
+        float uvError = 0.0f;
+        for (size_t vertex = 0; vertex < mesh.GetVertexCount(); vertex++)
+        {
+            float position[3];
+            float normal[3];
+            float uv[2];
+            DecodeVertex(vertices, vertex, position, normal, uv);
+            const float* pPosition = &mesh.positions[vertex * 3];
+            float dx = position[0] - pPosition[0];
+            float dy = position[1] - pPosition[1];
+            float dz = position[2] - pPosition[2];
+            positionError = max(positionError, sqrtf(dx * dx + dy * dy + dz * dz));
+            normalError = max(normalError, GetAngle(normal, &mesh.normals[vertex * 3]));
+            uvError = max(uvError, max(fabsf(uv[0] - mesh.uvs[vertex * 2]), fabsf(uv[1] - mesh.uvs[vertex * 2 + 1])));
+        }
+        // Float normals come back bit exact, the angle between them is only the rounding of the measurement
+        bool isWithinBounds = positionError <= positionBound && uvError <= uvBound &&
+            (format.normal == NORMAL_FORMAT::FLOAT3 || normalError <= normalBound);
+        withinBounds = withinBounds && isWithinBounds;
+
+        const char* formatName = GetVertexFormatName(format);
+        wprintf(L"%-18S %-16S %6u %10zu %10.3g %10.3g %10.3g %10.3g %10.3g %10.3g%s\n", primitive.name, formatName,
+            format.GetStride(), vertices.GetSize(), positionError, positionBound, normalError, normalBound, uvError, uvBound,
+            isWithinBounds ? L"" : L"  EXCEEDS BOUND");
+        if (pReport != nullptr)
+        {
+            fprintf(pReport, "%s    { \"name\": \"%s\", \"format\": \"%s\", \"stride\": %u, \"bytes\": %zu, \"floatBytes\": %zu, "
+                "\"positionError\": %g, \"positionBound\": %g, \"normalError\": %g, \"normalBound\": %g, \"uvError\": %g, \"uvBound\": %g }",
+                first ? "" : ",\n", primitive.name, formatName, format.GetStride(), vertices.GetSize(),
+                mesh.GetVertexCount() * 8 * sizeof(float), positionError, positionBound, normalError, normalBound, uvError, uvBound);
+        }
+        first = false;
+    }
+
+    if (pReport != nullptr)
+    {
+        fprintf(pReport, "\n  ]\n}\n");
+        fclose(pReport);
+    }
+    // Like a failed test, so scripts running the report notice
+    return withinBounds ? 0 : 2;
+}
+
+int RunLodReport(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct LodSource
+    {
+        std::string name;
+        MeshData mesh;
+    };
+    std::vector<LodSource> sources;
+    for (const MeshPrimitive& primitive : MeshPrimitives)
+    {
+        sources.push_back(LodSource());
+        sources.back().name = primitive.name;
+        primitive.generate(MeshOptions(), sources.back().mesh);
+    }
+    if (!options.modelPath.empty())
+    {
+        sources.push_back(LodSource());
+        sources.back().name = "model";
+        if (!ImportMesh(options.modelPath, ImportOptions(), sources.back().mesh))
+        {
+            wprintf(L"Failed to import model %s\n", options.modelPath.c_str());
+            return 1;
+        }
+    }
+
+    FILE* pReport = nullptr;
+    if (!options.reportPath.empty())
+    {
+        _wfopen_s(&pReport, options.reportPath.c_str(), L"w");
+        if (pReport == nullptr)
+        {
+            wprintf(L"Failed to open report file %s\n", options.reportPath.c_str());
+            return 1;
+        }
+        fprintf(pReport, "{\n  \"threads\": %u,\n  \"meshes\": [\n", std::thread::hardware_concurrency());
+    }
+
+    // Levels are simplified from the full mesh one per thread, so the throughput counts the input of every level
+    wprintf(L"%-18s %8s %10s %8s %5s %8s %7s %10s %10s\n", L"mesh", L"tris", L"ms", L"Mtri/s", L"level", L"tris",
+        L"ratio", L"error", L"deviation");
+    for (size_t sourceIndex = 0; sourceIndex < sources.size(); sourceIndex++)
+    {
+        const LodSource& source = sources[sourceIndex];
+        const MeshData& mesh = source.mesh;
+        size_t triangleCount = mesh.GetIndexCount() / 3;
+
+        std::vector<LodLevel> levels;
+        LodChainOptions chainOptions;
+        Clock::time_point start = Clock::now();
+        BuildLodChain(mesh, chainOptions, levels);
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        double throughput = triangleCount * (chainOptions.maxLevels - 1) / elapsed * 1e-6;
+
+        if (pReport != nullptr)
+        {
+            fprintf(pReport, "%s    { \"name\": \"%s\", \"vertices\": %zu, \"triangles\": %zu, \"ms\": %.3f, "
+                "\"mtrisPerSecond\": %.3f, \"radius\": %g, \"levels\": [", sourceIndex == 0 ? "" : ",\n", source.name.c_str(),
+                mesh.GetVertexCount(), triangleCount, elapsed * 1000.0, throughput, mesh.bounds.radius);
+        }
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            const LodLevel& level = levels[i];
+            size_t levelTriangles = level.indices.size() / 3;
+            float ratio = triangleCount > 0 ? float(levelTriangles) / triangleCount : 0.0f;
+            if (i == 0)
+            {
+                wprintf(L"%-18S %8zu %10.2f %8.2f", source.name.c_str(), triangleCount, elapsed * 1000.0, throughput);
+            }
+            else
+            {
+                wprintf(L"%-18s %8s %10s %8s", L"", L"", L"", L"");
+            }
+            wprintf(L" %5zu %8zu %7.3f %10.3g %10.3g\n", i, levelTriangles, ratio, level.error, level.deviation);
+            if (pReport != nullptr)
+            {
+                fprintf(pReport, "%s\n      { \"triangles\": %zu, \"error\": %g, \"deviation\": %g }", i == 0 ? "" : ",",
+                    levelTriangles, level.error, level.deviation);
+            }
+        }
+        if (pReport != nullptr)
+        {
+            fprintf(pReport, " ] }");
+        }
+    }
+
+    if (pReport != nullptr)
+    {
+        fprintf(pReport, "\n  ]\n}\n");
+        fclose(pReport);
+    }
+    return 0;
+}
+
+int RunMeshExport(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const int Repetitions = 5;
+
+    wprintf(L"%-18s %-16s %5s %10s %10s %10s %10s %10s\n", L"mesh", L"format", L"lods", L"bytes", L"packed", L"open us",
+        L"decode us", L"MB/s");
+    for (const MeshPrimitive& primitive : MeshPrimitives)
+    {
+        MeshData mesh;
+        primitive.generate(MeshOptions(), mesh);
+        VertexFormat format = ChooseVertexFormat(mesh, GetCompactRequirements(mesh));
+
+        std::vector<LodLevel> levels;
+        BuildLodChain(mesh, LodChainOptions(), levels);
+        std::vector<MeshSubmesh> submeshes;
+        std::vector<MeshLod> lods;
+        FlattenLodChain(levels, mesh.indices, submeshes, lods);
+
+        // The index codec refers to vertices it has not seen yet by their first use order, all levels share the numbering
+        std::vector<uint32_t> remap;
+        OptimizeVertexFetch(mesh.indices.data(), mesh.GetIndexCount(), mesh.GetVertexCount(), remap);
+        RemapVertexStream(mesh.positions, 3, remap);
+        RemapVertexStream(mesh.normals, 3, remap);
+        RemapVertexStream(mesh.tangents, 4, remap);
+        RemapVertexStream(mesh.uvs, 2, remap);
+
+        std::vector<uint8_t> uncompressed;
+        std::wstring path = options.meshExportPath + L"/" + std::wstring(primitive.name, primitive.name + strlen(primitive.name)) + L".l5mesh";
+        if (!BuildMeshFile(mesh, format, submeshes, lods, uncompressed) ||
+            !WriteMeshFile(path, mesh, format, submeshes, lods, MESH_FILE_COMPRESSION::BUFFER_CODEC))
+        {
+            wprintf(L"Failed to write mesh file %s\n", path.c_str());
+            return 1;
+        }
+
+        // Read back what was written, the first open includes the page cache lookup of a fresh file
+        MeshFile file;
+        Clock::time_point start = Clock::now();
+        bool isOpen = file.Open(path);
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!isOpen || file.GetHeader().vertexCount != mesh.GetVertexCount() || file.GetHeader().indexCount != mesh.GetIndexCount() ||
+            file.GetHeader().lodCount != lods.size())
+        {
+            wprintf(L"Failed to load mesh file %s\n", path.c_str());
+            return 1;
+        }
+
+        // Round trip against the uncompressed image, triangles may start at another corner
+        MeshFile reference;
+        reference.OpenMemory(uncompressed.data(), uncompressed.size());
+        std::vector<uint8_t> vertices(reference.GetVertexBytes());
+        std::vector<uint8_t> indices(reference.GetIndexBytes());
+        double decodeTime = 0.0;
+        bool isDecoded = true;
+        for (int repetition = 0; repetition < Repetitions; repetition++)
+        {
+            Clock::time_point decodeStart = Clock::now();
+            isDecoded = file.DecodeVertices(vertices.data()) && file.DecodeIndices(indices.data()) && isDecoded;
+            double decodeElapsed = std::chrono::duration<double>(Clock::now() - decodeStart).count();
+            decodeTime = repetition == 0 ? decodeElapsed : min(decodeTime, decodeElapsed);
+        }
+        isDecoded = isDecoded && memcmp(vertices.data(), reference.GetVertices(), vertices.size()) == 0;
+        for (size_t i = 0; isDecoded && i < mesh.GetIndexCount(); i += 3)
+        {
+            uint32_t corners[3];
+            for (size_t c = 0; c < 3; c++)
+            {
+                corners[c] = file.GetHeader().indexSize == 2 ? reinterpret_cast<const uint16_t*>(indices.data())[i + c]
+                    : reinterpret_cast<const uint32_t*>(indices.data())[i + c];
+            }
+            const uint32_t* pExpected = &mesh.indices[i];
+            isDecoded = (corners[0] == pExpected[0] && corners[1] == pExpected[1] && corners[2] == pExpected[2]) ||
+                (corners[0] == pExpected[1] && corners[1] == pExpected[2] && corners[2] == pExpected[0]) ||
+                (corners[0] == pExpected[2] && corners[1] == pExpected[0] && corners[2] == pExpected[1]);
+        }
+        if (!isDecoded)
+        {
+            wprintf(L"Mesh file %s does not decode to the mesh\n", path.c_str());
+            return 1;
+        }
+
+        double decodedBytes = static_cast<double>(vertices.size() + indices.size());
+        wprintf(L"%-18S %-16S %5zu %10zu %10llu %10.1f %10.1f %10.0f\n", primitive.name, GetVertexFormatName(format), lods.size(),
+            uncompressed.size(), static_cast<unsigned long long>(file.GetHeader().fileSize), elapsed * 1e6, decodeTime * 1e6,
+            decodedBytes / decodeTime * 1e-6);
+    }
+    return 0;
+}
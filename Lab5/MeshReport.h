@@ -0,0 +1,16 @@
+#pragma once
+
+#include "CommandLine.h"
+
+// Generates every procedural primitive in scan order, in cache-aware strips and through the mesh optimizer
+// and prints its size, generation time and vertex cache and fetch efficiency, then encodes it in the compact
+// vertex formats and checks the decoded error against the bounds. Returns 2 if a bound is exceeded.
+int RunMeshReport(const AppOptions& options);
+
+// Builds the LOD chain of every primitive and of options.modelPath if set, printing the simplification time and the
+// triangles, collapse error and measured deviation of each level
+int RunLodReport(const AppOptions& options);
+
+// Writes every primitive of the report in its compact vertex format with its LOD chain as a mesh file into
+// options.meshExportPath and loads it back
+int RunMeshExport(const AppOptions& options);
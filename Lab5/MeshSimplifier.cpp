@@ -0,0 +1,997 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "ParallelFor.h"
+#include "ProceduralMesh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    // Position, normal and texture coordinates
+    const uint32_t MaxDimensions = 8;
+    const uint32_t QuadricSize = MaxDimensions * (MaxDimensions + 1) / 2;
+    const uint32_t NoVertex = UINT32_MAX;
+    // Planes through open edges weigh this much more than the triangles next to them
+    const float BorderWeight = 10.0f;
+    // Each pass takes collapses up to this much above the cost that would reach the target if every collapse went through
+    const float PassErrorScale = 1.5f;
+    const size_t MinPassShare = 16;
+    const float MinLevelReduction = 0.9f;
+
+    enum class VertexKind : uint8_t
+    {
+        MANIFOLD,
+        // On one open edge chain, slides along it
+        BORDER,
+        // One of two vertices at a position, slides along the seam together with its sibling
+        SEAM,
+        LOCKED
+    };
+
+    // v'Av + 2b'v + c, weighted by the area of the triangles that went in. Doubles, since the error of a small
+    // collapse is a tiny difference of terms around the squared distance to the origin.
+    struct Quadric
+    {
+        // Upper triangle of the symmetric A, row by row
+        double a[QuadricSize];
+        double b[MaxDimensions];
+        double c;
+        double weight;
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float error;
+    };
+
+    float Dot3(const float* a, const float* b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void Cross(const float* a, const float* b, float result[3])
+    {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // Not normalized, twice the area long
+    void GetTriangleNormal(const float* a, const float* b, const float* c, float normal[3])
+    {
+        float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        Cross(ab, ac, normal);
+    }
+
+    void AddQuadric(Quadric& q, const Quadric& other)
+    {
+        for (uint32_t i = 0; i < QuadricSize; i++)
+        {
+            q.a[i] += other.a[i];
+        }
+        for (uint32_t i = 0; i < MaxDimensions; i++)
+        {
+            q.b[i] += other.b[i];
+        }
+        q.c += other.c;
+        q.weight += other.weight;
+    }
+
+    double EvaluateQuadric(const Quadric& q, const float* v, uint32_t dimensions)
+    {
+        double result = q.c;
+        const double* pRow = q.a;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            double rowSum = pRow[0] * v[i];
+            for (uint32_t j = i + 1; j < dimensions; j++)
+            {
+                rowSum += 2.0 * pRow[j - i] * v[j];
+            }
+            result += v[i] * (rowSum + 2.0 * q.b[i]);
+            pRow += MaxDimensions - i;
+        }
+        return result;
+    }
+
+    // Squared distance to the plane of the triangle in all dimensions (Garland and Heckbert 1998), zero for
+    // degenerate triangles
+    void GetTriangleQuadric(const float* p, const float* q, const float* r, uint32_t dimensions, double weight, Quadric& result)
+    {
+        result = Quadric();
+        double e1[MaxDimensions];
+        double e2[MaxDimensions];
+        double lengthSquared = 0.0;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            e1[i] = double(q[i]) - p[i];
+            lengthSquared += e1[i] * e1[i];
+        }
+        if (lengthSquared <= 0.0)
+        {
+            return;
+        }
+        double scale = 1.0 / sqrt(lengthSquared);
+        double projection = 0.0;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            e1[i] *= scale;
+            projection += (double(r[i]) - p[i]) * e1[i];
+        }
+        lengthSquared = 0.0;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            e2[i] = double(r[i]) - p[i] - projection * e1[i];
+            lengthSquared += e2[i] * e2[i];
+        }
+        if (lengthSquared <= 0.0)
+        {
+            return;
+        }
+        scale = 1.0 / sqrt(lengthSquared);
+        double pe1 = 0.0;
+        double pe2 = 0.0;
+        double pp = 0.0;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            e2[i] *= scale;
+            pe1 += p[i] * e1[i];
+            pe2 += p[i] * e2[i];
+            pp += double(p[i]) * p[i];
+        }
+
+        double* pRow = result.a;
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            for (uint32_t j = i; j < dimensions; j++)
+            {
+                pRow[j - i] = weight * ((i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j]);
+            }
+            result.b[i] = weight * (pe1 * e1[i] + pe2 * e2[i] - p[i]);
+            pRow += MaxDimensions - i;
+        }
+        result.c = weight * (pp - pe1 * pe1 - pe2 * pe2);
+        result.weight = weight;
+    }
+
+    // Squared distance to the plane through an open edge, perpendicular to its triangle. Only the position
+    // dimensions take part, and it adds no weight so it stands out against the triangles.
+    void AddBorderQuadric(const float* a, const float* b, const float* triangleNormal, Quadric& result)
+    {
+        float edge[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float normal[3];
+        Cross(edge, triangleNormal, normal);
+        float length = sqrtf(Dot3(normal, normal));
+        if (length <= 0.0f)
+        {
+            return;
+        }
+        float scale = 1.0f / length;
+        normal[0] *= scale;
+        normal[1] *= scale;
+        normal[2] *= scale;
+        double weight = Dot3(edge, edge) * BorderWeight;
+        double distance = -Dot3(normal, a);
+
+        double* pRow = result.a;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            for (uint32_t j = i; j < 3; j++)
+            {
+                pRow[j - i] += weight * normal[i] * normal[j];
+            }
+            result.b[i] += weight * distance * normal[i];
+            pRow += MaxDimensions - i;
+        }
+        result.c += weight * distance * distance;
+    }
+
+    // Triangles around every vertex
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        void Build(const std::vector<uint32_t>& indices, size_t vertexCount)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : indices)
+            {
+                offsets[index + 1]++;
+            }
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                offsets[i + 1] += offsets[i];
+            }
+            triangles.resize(indices.size());
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                triangles[fill[indices[i]]++] = uint32_t(i / 3);
+            }
+        }
+
+        // Whether a triangle has the directed edge from a to b
+        bool HasEdge(const std::vector<uint32_t>& indices, uint32_t a, uint32_t b) const
+        {
+            for (uint32_t i = offsets[a]; i < offsets[a + 1]; i++)
+            {
+                const uint32_t* pTriangle = &indices[3 * triangles[i]];
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    if (pTriangle[k] == a && pTriangle[(k + 1) % 3] == b)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const MeshData& mesh, const SimplifyOptions& options)
+            : m_vertexCount(mesh.GetVertexCount())
+        {
+            const MeshBounds& bounds = mesh.bounds;
+            m_scale = bounds.radius > 0.0f ? bounds.radius : 1.0f;
+            bool hasNormals = !mesh.normals.empty() && options.normalWeight > 0.0f;
+            bool hasUvs = !mesh.uvs.empty() && options.uvWeight > 0.0f;
+            m_dimensions = 3 + (hasNormals ? 3 : 0) + (hasUvs ? 2 : 0);
+
+            // Positions in radii around the center, so the attribute weights mean the same for any mesh size
+            m_attributes.resize(m_vertexCount * MaxDimensions, 0.0f);
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                float* pVertex = &m_attributes[v * MaxDimensions];
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    pVertex[i] = (mesh.positions[3 * v + i] - bounds.center[i]) / m_scale;
+                }
+                uint32_t dimension = 3;
+                if (hasNormals)
+                {
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        pVertex[dimension++] = mesh.normals[3 * v + i] * options.normalWeight;
+                    }
+                }
+                if (hasUvs)
+                {
+                    for (uint32_t i = 0; i < 2; i++)
+                    {
+                        pVertex[dimension++] = mesh.uvs[2 * v + i] * options.uvWeight;
+                    }
+                }
+            }
+        }
+
+        float Simplify(const std::vector<uint32_t>& indices, const SimplifyOptions& options, std::vector<uint32_t>& result)
+        {
+            result.clear();
+            result.reserve(indices.size());
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                uint32_t a = indices[i];
+                uint32_t b = indices[i + 1];
+                uint32_t c = indices[i + 2];
+                assert(a < m_vertexCount && b < m_vertexCount && c < m_vertexCount);
+                if (a != b && b != c && c != a)
+                {
+                    result.push_back(a);
+                    result.push_back(b);
+                    result.push_back(c);
+                }
+            }
+
+            m_adjacency.Build(result, m_vertexCount);
+            ClassifyVertices(result);
+            BuildQuadrics(result);
+
+            size_t targetTriangles = options.targetIndexCount / 3;
+            float errorLimit = FLT_MAX;
+            if (options.targetError < FLT_MAX)
+            {
+                float error = options.targetError / m_scale;
+                errorLimit = error * error;
+            }
+            float maxError = 0.0f;
+            while (result.size() / 3 > targetTriangles)
+            {
+                if (!RunPass(result, result.size() / 3 - targetTriangles, errorLimit, maxError))
+                {
+                    break;
+                }
+                m_adjacency.Build(result, m_vertexCount);
+            }
+
+            return sqrtf(maxError) * m_scale;
+        }
+
+    private:
+        const float* GetAttributes(uint32_t v) const
+        {
+            return &m_attributes[size_t(v) * MaxDimensions];
+        }
+
+        bool IsSamePosition(uint32_t a, uint32_t b) const
+        {
+            if (a == NoVertex || b == NoVertex)
+            {
+                return false;
+            }
+            const float* pA = GetAttributes(a);
+            const float* pB = GetAttributes(b);
+            return pA[0] == pB[0] && pA[1] == pB[1] && pA[2] == pB[2];
+        }
+
+        void ClassifyVertices(const std::vector<uint32_t>& indices)
+        {
+            // Vertices sharing a position are linked in a ring
+            m_wedges.resize(m_vertexCount);
+            std::vector<uint32_t> order(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                order[v] = uint32_t(v);
+            }
+            std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+            {
+                const float* pA = GetAttributes(a);
+                const float* pB = GetAttributes(b);
+                return std::lexicographical_compare(pA, pA + 3, pB, pB + 3);
+            });
+            for (size_t begin = 0; begin < order.size();)
+            {
+                size_t end = begin + 1;
+                while (end < order.size() && IsSamePosition(order[begin], order[end]))
+                {
+                    end++;
+                }
+                for (size_t i = begin; i < end; i++)
+                {
+                    m_wedges[order[i]] = order[i + 1 < end ? i + 1 : begin];
+                }
+                begin = end;
+            }
+
+            // Directed edges without the reverse edge in another triangle
+            m_openNext.assign(m_vertexCount, NoVertex);
+            m_openPrevious.assign(m_vertexCount, NoVertex);
+            std::vector<uint8_t> openOutCount(m_vertexCount, 0);
+            std::vector<uint8_t> openInCount(m_vertexCount, 0);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                uint32_t a = indices[i];
+                uint32_t b = indices[i % 3 == 2 ? i - 2 : i + 1];
+                if (!m_adjacency.HasEdge(indices, b, a))
+                {
+                    m_openNext[a] = b;
+                    m_openPrevious[b] = a;
+                    openOutCount[a] = uint8_t(std::min(openOutCount[a] + 1, 2));
+                    openInCount[b] = uint8_t(std::min(openInCount[b] + 1, 2));
+                }
+            }
+
+            m_kinds.resize(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                uint32_t sibling = m_wedges[v];
+                bool isOnChain = openOutCount[v] == 1 && openInCount[v] == 1;
+                VertexKind kind = VertexKind::LOCKED;
+                if (sibling == v)
+                {
+                    if (openOutCount[v] == 0 && openInCount[v] == 0)
+                    {
+                        kind = VertexKind::MANIFOLD;
+                    }
+                    else if (isOnChain)
+                    {
+                        kind = VertexKind::BORDER;
+                    }
+                }
+                else if (m_wedges[sibling] == v && isOnChain && openOutCount[sibling] == 1 && openInCount[sibling] == 1)
+                {
+                    // The two sides of a seam run in opposite directions
+                    if (IsSamePosition(m_openNext[v], m_openPrevious[sibling]) &&
+                        IsSamePosition(m_openPrevious[v], m_openNext[sibling]))
+                    {
+                        kind = VertexKind::SEAM;
+                    }
+                }
+                m_kinds[v] = kind;
+            }
+        }
+
+        // Whether the open edge from a to b runs back from b to a on the other side of a seam
+        bool IsSeamEdge(uint32_t a, uint32_t b) const
+        {
+            for (uint32_t wedge = m_wedges[a]; wedge != a; wedge = m_wedges[wedge])
+            {
+                if (IsSamePosition(m_openPrevious[wedge], b))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void BuildQuadrics(const std::vector<uint32_t>& indices)
+        {
+            m_quadrics.assign(m_vertexCount, Quadric());
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const float* pA = GetAttributes(indices[i]);
+                const float* pB = GetAttributes(indices[i + 1]);
+                const float* pC = GetAttributes(indices[i + 2]);
+                float normal[3];
+                GetTriangleNormal(pA, pB, pC, normal);
+                float area = 0.5f * sqrtf(Dot3(normal, normal));
+
+                Quadric quadric;
+                GetTriangleQuadric(pA, pB, pC, m_dimensions, area, quadric);
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    AddQuadric(m_quadrics[indices[i + k]], quadric);
+                }
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    uint32_t a = indices[i + k];
+                    uint32_t b = indices[i + (k + 1) % 3];
+                    if (m_openNext[a] == b && !IsSeamEdge(a, b))
+                    {
+                        AddBorderQuadric(GetAttributes(a), GetAttributes(b), normal, m_quadrics[a]);
+                        AddBorderQuadric(GetAttributes(a), GetAttributes(b), normal, m_quadrics[b]);
+                    }
+                }
+            }
+        }
+
+        // The vertex at the other end of the seam edge for the sibling of from, NoVertex if the collapse is not allowed
+        uint32_t GetCollapseSibling(uint32_t from, uint32_t to) const
+        {
+            uint32_t sibling = m_wedges[from];
+            uint32_t result = to == m_openNext[from] ? m_openPrevious[sibling] : m_openNext[sibling];
+            return IsSamePosition(result, to) ? result : NoVertex;
+        }
+
+        bool CanCollapse(uint32_t from, uint32_t to) const
+        {
+            switch (m_kinds[from])
+            {
+            case VertexKind::MANIFOLD:
+                return true;
+            case VertexKind::BORDER:
+                return to == m_openNext[from] || to == m_openPrevious[from];
+            case VertexKind::SEAM:
+                return (to == m_openNext[from] || to == m_openPrevious[from]) && GetCollapseSibling(from, to) != NoVertex;
+            default:
+                return false;
+            }
+        }
+
+        float GetVertexError(uint32_t from, uint32_t to) const
+        {
+            const Quadric& a = m_quadrics[from];
+            const Quadric& b = m_quadrics[to];
+            const float* pTarget = GetAttributes(to);
+            double error = EvaluateQuadric(a, pTarget, m_dimensions) + EvaluateQuadric(b, pTarget, m_dimensions);
+            double weight = a.weight + b.weight;
+            return float(std::max(error, 0.0) / (weight > 0.0 ? weight : 1.0));
+        }
+
+        float GetCollapseError(uint32_t from, uint32_t to) const
+        {
+            float error = GetVertexError(from, to);
+            if (m_kinds[from] == VertexKind::SEAM)
+            {
+                error += GetVertexError(m_wedges[from], GetCollapseSibling(from, to));
+            }
+            return error;
+        }
+
+        // Whether moving from onto to turns a remaining triangle around, counting the triangles that collapse
+        bool HasTriangleFlip(const std::vector<uint32_t>& indices, uint32_t from, uint32_t to, size_t& removedTriangles) const
+        {
+            const float* pTarget = GetAttributes(to);
+            for (uint32_t i = m_adjacency.offsets[from]; i < m_adjacency.offsets[from + 1]; i++)
+            {
+                uint32_t corners[3];
+                uint32_t fromCorner = 0;
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    corners[k] = m_passRemap[indices[3 * m_adjacency.triangles[i] + k]];
+                    fromCorner = corners[k] == from ? k : fromCorner;
+                }
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                {
+                    removedTriangles++;
+                    continue;
+                }
+                const float* pB = GetAttributes(corners[(fromCorner + 1) % 3]);
+                const float* pC = GetAttributes(corners[(fromCorner + 2) % 3]);
+                float before[3];
+                float after[3];
+                GetTriangleNormal(GetAttributes(from), pB, pC, before);
+                GetTriangleNormal(pTarget, pB, pC, after);
+                if (Dot3(before, after) <= 0.0f)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Keeps the open edge chains linked past a vertex that collapses along them
+        void UnlinkOpenEdge(uint32_t from, uint32_t to)
+        {
+            if (to == m_openNext[from])
+            {
+                m_openPrevious[to] = m_openPrevious[from];
+                m_openNext[m_openPrevious[from]] = to;
+            }
+            else
+            {
+                m_openNext[to] = m_openNext[from];
+                m_openPrevious[m_openNext[from]] = to;
+            }
+        }
+
+        void ApplyCollapse(uint32_t from, uint32_t to)
+        {
+            AddQuadric(m_quadrics[to], m_quadrics[from]);
+            m_passRemap[from] = to;
+            if (m_kinds[from] != VertexKind::MANIFOLD)
+            {
+                UnlinkOpenEdge(from, to);
+            }
+        }
+
+        bool LockWedges(uint32_t v)
+        {
+            uint32_t wedge = v;
+            do
+            {
+                if (m_isLocked[wedge])
+                {
+                    return false;
+                }
+                wedge = m_wedges[wedge];
+            } while (wedge != v);
+            do
+            {
+                m_isLocked[wedge] = 1;
+                wedge = m_wedges[wedge];
+            } while (wedge != v);
+            return true;
+        }
+
+        // Collapses in order of cost as long as they touch no vertex collapsed before, returns how many went through
+        size_t PerformCollapses(const std::vector<uint32_t>& indices, size_t triangleGoal, float passLimit, float& maxError)
+        {
+            m_passRemap.resize(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                m_passRemap[v] = uint32_t(v);
+            }
+            m_isLocked.assign(m_vertexCount, 0);
+            size_t removedTriangles = 0;
+            size_t collapseCount = 0;
+            for (const Collapse& collapse : m_collapses)
+            {
+                if (collapse.error > passLimit || removedTriangles >= triangleGoal)
+                {
+                    break;
+                }
+                uint32_t from = collapse.from;
+                uint32_t to = collapse.to;
+                uint32_t sibling = NoVertex;
+                uint32_t siblingTo = NoVertex;
+                if (m_kinds[from] == VertexKind::SEAM)
+                {
+                    sibling = m_wedges[from];
+                    siblingTo = GetCollapseSibling(from, to);
+                }
+                if (m_isLocked[from] || m_isLocked[to])
+                {
+                    continue;
+                }
+                size_t removed = 0;
+                if (HasTriangleFlip(indices, from, to, removed) ||
+                    (sibling != NoVertex && HasTriangleFlip(indices, sibling, siblingTo, removed)))
+                {
+                    continue;
+                }
+                if (!LockWedges(from) || !LockWedges(to))
+                {
+                    continue;
+                }
+                ApplyCollapse(from, to);
+                if (sibling != NoVertex)
+                {
+                    ApplyCollapse(sibling, siblingTo);
+                }
+                removedTriangles += removed;
+                maxError = std::max(maxError, collapse.error);
+                collapseCount++;
+            }
+            return collapseCount;
+        }
+
+        // Collapses the cheapest edges that touch no vertex collapsed in this pass, then drops the degenerate
+        // triangles. Returns false when nothing could be collapsed.
+        bool RunPass(std::vector<uint32_t>& indices, size_t triangleGoal, float errorLimit, float& maxError)
+        {
+            m_collapses.clear();
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                uint32_t a = indices[i];
+                uint32_t b = indices[i % 3 == 2 ? i - 2 : i + 1];
+                // Inner edges come up in both of their triangles
+                if (a > b && m_adjacency.HasEdge(indices, b, a))
+                {
+                    continue;
+                }
+                Collapse collapse = { a, b, FLT_MAX };
+                if (CanCollapse(a, b))
+                {
+                    collapse.error = GetCollapseError(a, b);
+                }
+                if (CanCollapse(b, a))
+                {
+                    float error = GetCollapseError(b, a);
+                    if (error < collapse.error)
+                    {
+                        collapse = { b, a, error };
+                    }
+                }
+                if (collapse.error < FLT_MAX)
+                {
+                    m_collapses.push_back(collapse);
+                }
+            }
+            if (m_collapses.empty())
+            {
+                return false;
+            }
+            std::sort(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return a.error < b.error;
+            });
+
+            // An inner collapse removes two triangles. Near the target the few collapses left would each take a pass
+            // of their own, the triangle goal stops the pass anyway.
+            size_t goalIndex = std::max(triangleGoal / 2, m_collapses.size() / MinPassShare);
+            float passLimit = errorLimit;
+            if (goalIndex < m_collapses.size())
+            {
+                passLimit = std::min(passLimit, std::max(m_collapses[goalIndex].error * PassErrorScale, FLT_MIN));
+            }
+
+            size_t collapseCount = PerformCollapses(indices, triangleGoal, passLimit, maxError);
+            // The cheapest collapses can all be blocked by flips while costlier ones within the limit still go through
+            if (collapseCount == 0 && passLimit < errorLimit)
+            {
+                collapseCount = PerformCollapses(indices, triangleGoal, errorLimit, maxError);
+            }
+            if (collapseCount == 0)
+            {
+                return false;
+            }
+
+            size_t write = 0;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                uint32_t a = m_passRemap[indices[i]];
+                uint32_t b = m_passRemap[indices[i + 1]];
+                uint32_t c = m_passRemap[indices[i + 2]];
+                if (a != b && b != c && c != a)
+                {
+                    indices[write++] = a;
+                    indices[write++] = b;
+                    indices[write++] = c;
+                }
+            }
+            indices.resize(write);
+            return true;
+        }
+
+        size_t m_vertexCount;
+        uint32_t m_dimensions;
+        float m_scale;
+        std::vector<float> m_attributes;
+        std::vector<Quadric> m_quadrics;
+        std::vector<VertexKind> m_kinds;
+        // Next vertex at the same position, the vertex itself if it is alone
+        std::vector<uint32_t> m_wedges;
+        std::vector<uint32_t> m_openNext;
+        std::vector<uint32_t> m_openPrevious;
+        Adjacency m_adjacency;
+        std::vector<Collapse> m_collapses;
+        std::vector<uint32_t> m_passRemap;
+        std::vector<uint8_t> m_isLocked;
+    };
+
+    float GetSquaredDistance(const float* a, const float* b)
+    {
+        float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        return Dot3(d, d);
+    }
+
+    // Closest point on a triangle by its Voronoi regions (Ericson, Real-Time Collision Detection 5.1.5)
+    float GetSquaredDistanceToTriangle(const float* p, const float* a, const float* b, const float* c)
+    {
+        float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+        float d1 = Dot3(ab, ap);
+        float d2 = Dot3(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+        {
+            return GetSquaredDistance(p, a);
+        }
+        float bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+        float d3 = Dot3(ab, bp);
+        float d4 = Dot3(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+        {
+            return GetSquaredDistance(p, b);
+        }
+        float cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+        float d5 = Dot3(ab, cp);
+        float d6 = Dot3(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+        {
+            return GetSquaredDistance(p, c);
+        }
+
+        float closest[3];
+        float vc = d1 * d4 - d3 * d2;
+        float vb = d5 * d2 - d1 * d6;
+        float va = d3 * d6 - d5 * d4;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        {
+            float t = d1 / (d1 - d3);
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                closest[i] = a[i] + t * ab[i];
+            }
+        }
+        else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        {
+            float t = d2 / (d2 - d6);
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                closest[i] = a[i] + t * ac[i];
+            }
+        }
+        else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        {
+            float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                closest[i] = b[i] + t * (c[i] - b[i]);
+            }
+        }
+        else
+        {
+            float sum = va + vb + vc;
+            float v = sum != 0.0f ? vb / sum : 0.0f;
+            float w = sum != 0.0f ? vc / sum : 0.0f;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                closest[i] = a[i] + v * ab[i] + w * ac[i];
+            }
+        }
+        return GetSquaredDistance(p, closest);
+    }
+
+    // Triangles binned into the cells of a uniform grid their bounds overlap, for nearest triangle queries
+    class TriangleGrid
+    {
+    public:
+        TriangleGrid(const MeshData& mesh, const std::vector<uint32_t>& indices)
+            : m_positions(mesh.positions), m_indices(indices)
+        {
+            const MeshBounds& bounds = mesh.bounds;
+            size_t triangleCount = indices.size() / 3;
+            float extent = std::max(bounds.max[0] - bounds.min[0], std::max(bounds.max[1] - bounds.min[1], bounds.max[2] - bounds.min[2]));
+            // Surfaces fill about resolution^2 cells
+            float resolution = std::min(std::max(sqrtf(float(triangleCount)), 1.0f), float(MaxGridResolution));
+            m_cellSize = extent > 0.0f ? extent / resolution : 1.0f;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                m_origin[i] = bounds.min[i];
+                m_size[i] = std::max(int(ceilf((bounds.max[i] - bounds.min[i]) / m_cellSize)), 1);
+            }
+
+            std::vector<int> cellRanges(triangleCount * 6);
+            m_offsets.assign(size_t(m_size[0]) * m_size[1] * m_size[2] + 1, 0);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                int* pRange = &cellRanges[6 * t];
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    float low = FLT_MAX;
+                    float high = -FLT_MAX;
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        float value = m_positions[3 * indices[3 * t + k] + i];
+                        low = std::min(low, value);
+                        high = std::max(high, value);
+                    }
+                    pRange[i] = GetCell(low, i);
+                    pRange[3 + i] = GetCell(high, i);
+                }
+                ForEachCell(pRange, [this](size_t cell) { m_offsets[cell + 1]++; });
+            }
+            for (size_t i = 1; i < m_offsets.size(); i++)
+            {
+                m_offsets[i] += m_offsets[i - 1];
+            }
+            m_triangles.resize(m_offsets.back());
+            std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                ForEachCell(&cellRanges[6 * t], [&](size_t cell) { m_triangles[fill[cell]++] = uint32_t(t); });
+            }
+        }
+
+        // Visits rings of cells around the point until no closer triangle can be left outside them
+        float GetSquaredDistance(const float* p) const
+        {
+            int center[3] = { GetCell(p[0], 0), GetCell(p[1], 1), GetCell(p[2], 2) };
+            int maxRing = std::max(m_size[0], std::max(m_size[1], m_size[2]));
+            float closest = FLT_MAX;
+            for (int ring = 0; ring <= maxRing; ring++)
+            {
+                int range[6];
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    range[i] = std::max(center[i] - ring, 0);
+                    range[3 + i] = std::min(center[i] + ring, m_size[i] - 1);
+                }
+                for (int z = range[2]; z <= range[5]; z++)
+                {
+                    for (int y = range[1]; y <= range[4]; y++)
+                    {
+                        bool isShell = abs(z - center[2]) == ring || abs(y - center[1]) == ring;
+                        // Inside the shell only the first and last cell of a row are new
+                        int step = isShell ? 1 : std::max(2 * ring, 1);
+                        for (int x = center[0] - ring; x <= center[0] + ring; x += step)
+                        {
+                            if (x < 0 || x >= m_size[0])
+                            {
+                                continue;
+                            }
+                            size_t cell = (size_t(z) * m_size[1] + y) * m_size[0] + x;
+                            if (GetSquaredCellDistance(p, x, y, z) >= closest)
+                            {
+                                continue;
+                            }
+                            for (uint32_t i = m_offsets[cell]; i < m_offsets[cell + 1]; i++)
+                            {
+                                const uint32_t* pTriangle = &m_indices[3 * m_triangles[i]];
+                                closest = std::min(closest, GetSquaredDistanceToTriangle(p, &m_positions[3 * pTriangle[0]],
+                                    &m_positions[3 * pTriangle[1]], &m_positions[3 * pTriangle[2]]));
+                            }
+                        }
+                    }
+                }
+                float reach = ring * m_cellSize;
+                if (closest <= reach * reach)
+                {
+                    break;
+                }
+            }
+            return closest;
+        }
+
+    private:
+        static const int MaxGridResolution = 128;
+
+        int GetCell(float value, uint32_t axis) const
+        {
+            int cell = int((value - m_origin[axis]) / m_cellSize);
+            return std::min(std::max(cell, 0), m_size[axis] - 1);
+        }
+
+        float GetSquaredCellDistance(const float* p, int x, int y, int z) const
+        {
+            int cell[3] = { x, y, z };
+            float result = 0.0f;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                float low = m_origin[i] + cell[i] * m_cellSize;
+                float outside = std::max(std::max(low - p[i], p[i] - low - m_cellSize), 0.0f);
+                result += outside * outside;
+            }
+            return result;
+        }
+
+        template <typename Function>
+        void ForEachCell(const int* pRange, const Function& function) const
+        {
+            for (int z = pRange[2]; z <= pRange[5]; z++)
+            {
+                for (int y = pRange[1]; y <= pRange[4]; y++)
+                {
+                    for (int x = pRange[0]; x <= pRange[3]; x++)
+                    {
+                        function((size_t(z) * m_size[1] + y) * m_size[0] + x);
+                    }
+                }
+            }
+        }
+
+        const std::vector<float>& m_positions;
+        const std::vector<uint32_t>& m_indices;
+        float m_origin[3];
+        float m_cellSize;
+        int m_size[3];
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_triangles;
+    };
+
+    float MeasureDeviation(const MeshData& mesh, const std::vector<uint32_t>& indices)
+    {
+        if (indices.empty())
+        {
+            return 0.0f;
+        }
+        TriangleGrid grid(mesh, indices);
+        float result = 0.0f;
+        for (size_t v = 0; v < mesh.GetVertexCount(); v++)
+        {
+            result = std::max(result, grid.GetSquaredDistance(&mesh.positions[3 * v]));
+        }
+        return sqrtf(result);
+    }
+}
+
+float SimplifyMesh(const MeshData& mesh, const std::vector<uint32_t>& indices, const SimplifyOptions& options,
+    std::vector<uint32_t>& result)
+{
+    Simplifier simplifier(mesh, options);
+    return simplifier.Simplify(indices, options, result);
+}
+
+void BuildLodChain(const MeshData& mesh, const LodChainOptions& options, std::vector<LodLevel>& levels)
+{
+    uint32_t maxLevels = std::max(options.maxLevels, 1u);
+    std::vector<LodLevel> candidates(maxLevels);
+    candidates[0].indices = mesh.indices;
+
+    uint32_t threadCount = options.threadCount != 0 ? options.threadCount : std::thread::hardware_concurrency();
+    ParallelFor(maxLevels - 1, std::max(threadCount, 1u), [&](size_t item)
+    {
+        LodLevel& level = candidates[item + 1];
+        SimplifyOptions simplifyOptions;
+        simplifyOptions.targetIndexCount = size_t(mesh.indices.size() / 3 * powf(options.ratio, float(item + 1))) * 3;
+        simplifyOptions.targetError = options.maxError * mesh.bounds.radius;
+        simplifyOptions.normalWeight = options.normalWeight;
+        simplifyOptions.uvWeight = options.uvWeight;
+        level.error = SimplifyMesh(mesh, mesh.indices, simplifyOptions, level.indices);
+        OptimizeVertexCache(level.indices.data(), level.indices.size(), mesh.GetVertexCount());
+        level.deviation = MeasureDeviation(mesh, level.indices);
+    });
+
+    // Levels that stopped at the error limit can come out as large as the previous one
+    levels.clear();
+    levels.push_back(std::move(candidates[0]));
+    for (uint32_t i = 1; i < maxLevels; i++)
+    {
+        if (candidates[i].indices.empty() || candidates[i].indices.size() > levels.back().indices.size() * MinLevelReduction)
+        {
+            break;
+        }
+        levels.push_back(std::move(candidates[i]));
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshData;
+
+struct SimplifyOptions
+{
+    // Simplification stops at whichever is reached first, 0 and FLT_MAX leave the limit out
+    size_t targetIndexCount = 0;
+    // Largest collapse error in mesh units
+    float targetError = FLT_MAX;
+    // Scale of unit normal and texture coordinate differences against distances in mesh radii
+    float normalWeight = 0.5f;
+    float uvWeight = 0.5f;
+};
+
+// Quadric error edge collapse of the triangles in indices onto their own vertices, so the result shares the vertex
+// buffer of the mesh. Each quadric measures the distance to the planes of the triangles around a vertex in position,
+// normal and texture space. Vertices on open edges only slide along them, and seam vertices (two at one position with
+// different normals or texture coordinates) collapse together with their sibling so the seam stays closed. Vertices
+// where more than two seam or border edges meet never move.
+// Returns the error of the costliest collapse in mesh units.
+float SimplifyMesh(const MeshData& mesh, const std::vector<uint32_t>& indices, const SimplifyOptions& options,
+    std::vector<uint32_t>& result);
+
+struct LodChainOptions
+{
+    // Levels including the full mesh
+    uint32_t maxLevels = 6;
+    // Triangles of each level relative to the previous one
+    float ratio = 0.5f;
+    // Levels stop at this error relative to the mesh radius
+    float maxError = 0.1f;
+    float normalWeight = 0.5f;
+    float uvWeight = 0.5f;
+    // Levels are simplified in parallel, 0 uses one thread per hardware thread
+    uint32_t threadCount = 0;
+};
+
+struct LodLevel
+{
+    std::vector<uint32_t> indices;
+    // Collapse error reported by SimplifyMesh, in mesh units
+    float error = 0.0f;
+    // Measured largest distance from a vertex of the full mesh to the nearest triangle of the level, in mesh units
+    float deviation = 0.0f;
+};
+
+// Level 0 holds the mesh indices, every further level is simplified from the full mesh and reordered for the vertex
+// cache. A level that removes less than a tenth of the triangles of the previous one ends the chain.
+void BuildLodChain(const MeshData& mesh, const LodChainOptions& options, std::vector<LodLevel>& levels);
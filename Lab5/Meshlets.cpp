@@ -0,0 +1,414 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+    const uint8_t NotInMeshlet = 0xff;
+    const uint32_t NoTriangle = UINT32_MAX;
+
+    float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // Unit normal and twice the area, the normal is zero for degenerate triangles
+    float GetTriangleNormal(const float* a, const float* b, const float* c, float normal[3])
+    {
+        float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+        normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+        normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+        float length = sqrtf(Dot(normal, normal));
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        normal[0] *= scale;
+        normal[1] *= scale;
+        normal[2] *= scale;
+        return length;
+    }
+
+    struct TriangleShape
+    {
+        float centroid[3];
+        float normal[3];
+    };
+
+    // State of the meshlet being grown
+    struct MeshletState
+    {
+        Meshlet meshlet = {};
+        float centroidSum[3] = {};
+        float normalSum[3] = {};
+        float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    };
+
+    void ComputeMeshletBounds(const MeshletData& meshlets, const Meshlet& meshlet, const float* pPositions, MeshletBounds& bounds)
+    {
+        const uint32_t* pVertices = &meshlets.vertices[meshlet.vertexOffset];
+        const uint8_t* pTriangles = &meshlets.triangles[meshlet.triangleOffset * 3];
+
+        float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const float* p = &pPositions[pVertices[i] * 3];
+            for (int c = 0; c < 3; c++)
+            {
+                boxMin[c] = std::min(boxMin[c], p[c]);
+                boxMax[c] = std::max(boxMax[c], p[c]);
+            }
+        }
+        float radiusSquared = 0.0f;
+        for (int c = 0; c < 3; c++)
+        {
+            bounds.center[c] = 0.5f * (boxMin[c] + boxMax[c]);
+        }
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const float* p = &pPositions[pVertices[i] * 3];
+            float d[3] = { p[0] - bounds.center[0], p[1] - bounds.center[1], p[2] - bounds.center[2] };
+            radiusSquared = std::max(radiusSquared, Dot(d, d));
+        }
+        bounds.radius = sqrtf(radiusSquared);
+
+        float axis[3] = {};
+        for (uint32_t i = 0; i < meshlet.triangleCount; i++)
+        {
+            float normal[3];
+            GetTriangleNormal(&pPositions[pVertices[pTriangles[i * 3]] * 3], &pPositions[pVertices[pTriangles[i * 3 + 1]] * 3],
+                &pPositions[pVertices[pTriangles[i * 3 + 2]] * 3], normal);
+            axis[0] += normal[0];
+            axis[1] += normal[1];
+            axis[2] += normal[2];
+        }
+        float axisLength = sqrtf(Dot(axis, axis));
+        float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+        for (int c = 0; c < 3; c++)
+        {
+            axis[c] = axisLength > 0.0f ? axis[c] / axisLength : 0.0f;
+            bounds.coneAxis[c] = axis[c];
+            bounds.coneApex[c] = bounds.center[c];
+        }
+
+        // The apex goes back along the axis until it is behind every triangle plane, then a viewer inside the cone
+        // sees the back of all of them
+        float apexDistance = 0.0f;
+        for (uint32_t i = 0; i < meshlet.triangleCount && minDot > 0.0f; i++)
+        {
+            const float* a = &pPositions[pVertices[pTriangles[i * 3]] * 3];
+            float normal[3];
+            if (GetTriangleNormal(a, &pPositions[pVertices[pTriangles[i * 3 + 1]] * 3], &pPositions[pVertices[pTriangles[i * 3 + 2]] * 3], normal) == 0.0f)
+            {
+                continue;
+            }
+            float axisDot = Dot(normal, axis);
+            minDot = std::min(minDot, axisDot);
+            if (axisDot > 0.0f)
+            {
+                float toCenter[3] = { bounds.center[0] - a[0], bounds.center[1] - a[1], bounds.center[2] - a[2] };
+                apexDistance = std::max(apexDistance, Dot(toCenter, normal) / axisDot);
+            }
+        }
+
+        if (minDot <= 0.0f)
+        {
+            bounds.coneCutoff = 1.0f;
+            return;
+        }
+        bounds.coneCutoff = sqrtf(1.0f - minDot * minDot);
+        for (int c = 0; c < 3; c++)
+        {
+            bounds.coneApex[c] = bounds.center[c] - axis[c] * apexDistance;
+        }
+    }
+}
+
+void BuildMeshlets(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount,
+    MeshletData& meshlets, uint32_t maxVertices, uint32_t maxTriangles, float coneWeight)
+{
+    assert(maxVertices >= 3 && maxVertices <= 255 && maxTriangles > 0);
+    meshlets.meshlets.clear();
+    meshlets.bounds.clear();
+    meshlets.vertices.clear();
+    meshlets.triangles.clear();
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles of each vertex, the first liveCounts[v] of them are not in a meshlet yet
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        offsets[pIndices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> liveCounts(vertexCount, 0);
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        uint32_t vertex = pIndices[i];
+        adjacency[offsets[vertex] + liveCounts[vertex]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<TriangleShape> shapes(triangleCount);
+    double totalArea = 0.0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const float* a = &pPositions[pIndices[t * 3] * 3];
+        const float* b = &pPositions[pIndices[t * 3 + 1] * 3];
+        const float* c = &pPositions[pIndices[t * 3 + 2] * 3];
+        for (int i = 0; i < 3; i++)
+        {
+            shapes[t].centroid[i] = (a[i] + b[i] + c[i]) / 3.0f;
+        }
+        totalArea += 0.5 * GetTriangleNormal(a, b, c, shapes[t].normal);
+    }
+    // Radius of a flat disc with the area of a full meshlet, scales the distance term of the score
+    float expectedRadius = static_cast<float>(sqrt(totalArea / triangleCount * maxTriangles / Pi));
+    float distanceScale = expectedRadius > 0.0f ? (1.0f - coneWeight) / expectedRadius : 0.0f;
+
+    std::vector<uint8_t> isEmitted(triangleCount, 0);
+    std::vector<uint8_t> localIndices(vertexCount, NotInMeshlet);
+    meshlets.vertices.reserve(triangleCount);
+    meshlets.triangles.reserve(triangleCount * 3);
+
+    MeshletState state;
+    size_t scan = 0;
+    uint32_t seed = NoTriangle;
+    uint32_t lastTriangle = NoTriangle;
+    auto getLiveCount = [&](uint32_t triangle)
+    {
+        return liveCounts[pIndices[triangle * 3]] + liveCounts[pIndices[triangle * 3 + 1]] + liveCounts[pIndices[triangle * 3 + 2]];
+    };
+    auto finishMeshlet = [&]()
+    {
+        // The next meshlet starts next to this one, in the corner with the fewest triangles left, so the meshlets
+        // cover the surface as a front instead of leaving small islands between them
+        seed = NoTriangle;
+        uint32_t seedLiveCount = UINT32_MAX;
+        for (uint32_t i = 0; i < state.meshlet.vertexCount; i++)
+        {
+            uint32_t vertex = meshlets.vertices[state.meshlet.vertexOffset + i];
+            for (uint32_t j = offsets[vertex]; j < offsets[vertex] + liveCounts[vertex]; j++)
+            {
+                uint32_t liveCount = getLiveCount(adjacency[j]);
+                if (liveCount < seedLiveCount)
+                {
+                    seed = adjacency[j];
+                    seedLiveCount = liveCount;
+                }
+            }
+            localIndices[vertex] = NotInMeshlet;
+        }
+        meshlets.meshlets.push_back(state.meshlet);
+        state = MeshletState();
+        state.meshlet.vertexOffset = static_cast<uint32_t>(meshlets.vertices.size());
+        state.meshlet.triangleOffset = static_cast<uint32_t>(meshlets.triangles.size() / 3);
+    };
+    auto getNewVertexCount = [&](uint32_t triangle)
+    {
+        return uint32_t(localIndices[pIndices[triangle * 3]] == NotInMeshlet) +
+            uint32_t(localIndices[pIndices[triangle * 3 + 1]] == NotInMeshlet) +
+            uint32_t(localIndices[pIndices[triangle * 3 + 2]] == NotInMeshlet);
+    };
+
+    for (;;)
+    {
+        while (scan < triangleCount && isEmitted[scan])
+        {
+            scan++;
+        }
+        if (scan == triangleCount)
+        {
+            break;
+        }
+
+        uint32_t best = NoTriangle;
+        if (state.meshlet.triangleCount == 0)
+        {
+            best = seed != NoTriangle ? seed : static_cast<uint32_t>(scan);
+        }
+        else
+        {
+            float center[3];
+            float axis[3];
+            float axisLength = sqrtf(Dot(state.normalSum, state.normalSum));
+            for (int c = 0; c < 3; c++)
+            {
+                center[c] = state.centroidSum[c] / state.meshlet.triangleCount;
+                axis[c] = axisLength > 0.0f ? state.normalSum[c] / axisLength : 0.0f;
+            }
+
+            // Only triangles sharing a vertex with the meshlet are candidates. One that is the last triangle of a
+            // vertex goes first whatever it adds, otherwise it would be left behind on its own.
+            uint32_t bestPriority = 3;
+            float bestScore = FLT_MAX;
+            uint32_t vertexBudget = maxVertices - state.meshlet.vertexCount;
+            auto considerTriangles = [&](uint32_t vertex)
+            {
+                for (uint32_t j = offsets[vertex]; j < offsets[vertex] + liveCounts[vertex]; j++)
+                {
+                    uint32_t triangle = adjacency[j];
+                    uint32_t newVertices = getNewVertexCount(triangle);
+                    const uint32_t* pCorners = &pIndices[triangle * 3];
+                    bool isLast = liveCounts[pCorners[0]] == 1 || liveCounts[pCorners[1]] == 1 || liveCounts[pCorners[2]] == 1;
+                    uint32_t priority = isLast ? 0 : newVertices;
+                    if (newVertices > vertexBudget || priority > bestPriority)
+                    {
+                        continue;
+                    }
+                    const TriangleShape& shape = shapes[triangle];
+                    const float* pCentroid = shape.centroid;
+                    float d[3] = { pCentroid[0] - center[0], pCentroid[1] - center[1], pCentroid[2] - center[2] };
+                    float spread = std::max(1.0f - Dot(shape.normal, axis) * coneWeight, 1e-3f);
+                    float score = (1.0f + sqrtf(Dot(d, d)) * distanceScale) * spread;
+                    if (priority < bestPriority || score < bestScore)
+                    {
+                        best = triangle;
+                        bestPriority = priority;
+                        bestScore = score;
+                    }
+                }
+            };
+
+            // Around the last triangle first, the whole meshlet border only if that adds vertices
+            for (int corner = 0; corner < 3; corner++)
+            {
+                considerTriangles(pIndices[lastTriangle * 3 + corner]);
+            }
+            for (uint32_t i = 0; i < state.meshlet.vertexCount && bestPriority > 0; i++)
+            {
+                considerTriangles(meshlets.vertices[state.meshlet.vertexOffset + i]);
+            }
+
+            // Across a seam or a gap in the connectivity, as long as the triangle is within the meshlet box
+            if (best == NoTriangle && getNewVertexCount(static_cast<uint32_t>(scan)) <= vertexBudget)
+            {
+                const float* pCentroid = shapes[scan].centroid;
+                float radiusSquared = 0.0f;
+                float distanceSquared = 0.0f;
+                for (int c = 0; c < 3; c++)
+                {
+                    float halfExtent = 0.5f * (state.boxMax[c] - state.boxMin[c]);
+                    float d = pCentroid[c] - 0.5f * (state.boxMin[c] + state.boxMax[c]);
+                    radiusSquared += halfExtent * halfExtent;
+                    distanceSquared += d * d;
+                }
+                best = distanceSquared <= radiusSquared ? static_cast<uint32_t>(scan) : NoTriangle;
+            }
+            if (best == NoTriangle)
+            {
+                finishMeshlet();
+                continue;
+            }
+        }
+
+        for (int corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = pIndices[best * 3 + corner];
+            if (localIndices[vertex] == NotInMeshlet)
+            {
+                localIndices[vertex] = static_cast<uint8_t>(state.meshlet.vertexCount++);
+                meshlets.vertices.push_back(vertex);
+                const float* p = &pPositions[vertex * 3];
+                for (int c = 0; c < 3; c++)
+                {
+                    state.boxMin[c] = std::min(state.boxMin[c], p[c]);
+                    state.boxMax[c] = std::max(state.boxMax[c], p[c]);
+                }
+            }
+            meshlets.triangles.push_back(localIndices[vertex]);
+
+            // Swapped behind the live triangles of the vertex
+            uint32_t* pLive = &adjacency[offsets[vertex]];
+            uint32_t last = --liveCounts[vertex];
+            for (uint32_t j = 0; j <= last; j++)
+            {
+                if (pLive[j] == best)
+                {
+                    std::swap(pLive[j], pLive[last]);
+                    break;
+                }
+            }
+        }
+        isEmitted[best] = 1;
+        lastTriangle = best;
+        state.meshlet.triangleCount++;
+        for (int c = 0; c < 3; c++)
+        {
+            state.centroidSum[c] += shapes[best].centroid[c];
+            state.normalSum[c] += shapes[best].normal[c];
+        }
+
+        if (state.meshlet.triangleCount == maxTriangles)
+        {
+            finishMeshlet();
+        }
+    }
+    if (state.meshlet.triangleCount > 0)
+    {
+        finishMeshlet();
+    }
+
+    meshlets.bounds.resize(meshlets.meshlets.size());
+    for (size_t i = 0; i < meshlets.meshlets.size(); i++)
+    {
+        ComputeMeshletBounds(meshlets, meshlets.meshlets[i], pPositions, meshlets.bounds[i]);
+    }
+}
+
+void GetMeshletIndices(const MeshletData& meshlets, std::vector<uint32_t>& indices)
+{
+    indices.resize(meshlets.triangles.size());
+    for (const Meshlet& meshlet : meshlets.meshlets)
+    {
+        const uint32_t* pVertices = &meshlets.vertices[meshlet.vertexOffset];
+        for (size_t i = meshlet.triangleOffset * 3; i < (meshlet.triangleOffset + meshlet.triangleCount) * 3; i++)
+        {
+            indices[i] = pVertices[meshlets.triangles[i]];
+        }
+    }
+}
+
+bool IsMeshletVisible(const MeshletBounds& bounds, const MeshletCullView& view)
+{
+    for (const float* pPlane : view.planes)
+    {
+        if (Dot(pPlane, bounds.center) + pPlane[3] < -bounds.radius)
+        {
+            return false;
+        }
+    }
+
+    float toApex[3] = {
+        bounds.coneApex[0] - view.cameraPosition[0],
+        bounds.coneApex[1] - view.cameraPosition[1],
+        bounds.coneApex[2] - view.cameraPosition[2] };
+    return Dot(toApex, bounds.coneAxis) < bounds.coneCutoff * sqrtf(Dot(toApex, toApex));
+}
+
+size_t CullMeshlets(const MeshletData& meshlets, const MeshletCullView& view, std::vector<uint32_t>& visible)
+{
+    visible.clear();
+    size_t triangleCount = 0;
+    for (size_t i = 0; i < meshlets.meshlets.size(); i++)
+    {
+        if (IsMeshletVisible(meshlets.bounds[i], view))
+        {
+            visible.push_back(static_cast<uint32_t>(i));
+            triangleCount += meshlets.meshlets[i].triangleCount;
+        }
+    }
+    return triangleCount;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cluster limits of current mesh shader hardware, also a good granularity for culling on the CPU
+const uint32_t MaxMeshletVertices = 64;
+const uint32_t MaxMeshletTriangles = 124;
+
+struct Meshlet
+{
+    // Range of MeshletData::vertices
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    // Range of the triangles in MeshletData::triangles, three entries each
+    uint32_t triangleOffset;
+    uint32_t triangleCount;
+};
+
+// Sphere around the meshlet and the cone around the normals of its triangles
+struct MeshletBounds
+{
+    float center[3];
+    float radius;
+    // Every triangle faces away from a viewer at p if dot(apex - p, axis) >= cutoff * |apex - p|
+    float coneApex[3];
+    float coneAxis[3];
+    // Sine of the largest angle between the axis and a triangle normal, 1 if the normals span half a sphere or more
+    float coneCutoff;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    // Mesh vertices referenced by each meshlet
+    std::vector<uint32_t> vertices;
+    // Corners as indices into the vertices of the meshlet
+    std::vector<uint8_t> triangles;
+
+    size_t GetTriangleCount() const { return triangles.size() / 3; }
+};
+
+// Grows one meshlet at a time from a seed next to the previous one, adding the neighbouring triangle that needs the
+// fewest new vertices, then the one closest to the meshlet and facing its way. coneWeight trades compact spheres (0)
+// for narrow normal cones (1). When no neighbour is left the next triangle in index order continues the meshlet if it
+// lies within its box, so the input should be in a cache-optimized order. maxVertices is at most 255.
+void BuildMeshlets(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount,
+    MeshletData& meshlets, uint32_t maxVertices = MaxMeshletVertices, uint32_t maxTriangles = MaxMeshletTriangles,
+    float coneWeight = 0.25f);
+
+// Index buffer with the triangles meshlet by meshlet, meshlet i covers 3 * triangleOffset to 3 * (triangleOffset + triangleCount)
+void GetMeshletIndices(const MeshletData& meshlets, std::vector<uint32_t>& indices);
+
+// Culling pass in the space of the mesh. Planes face inwards as (x, y, z, w) with unit normals, a point p is inside
+// where dot(xyz, p) + w >= 0.
+struct MeshletCullView
+{
+    float planes[6][4];
+    float cameraPosition[3];
+};
+
+// False if the sphere is outside a plane or the cone faces away from the camera
+bool IsMeshletVisible(const MeshletBounds& bounds, const MeshletCullView& view);
+
+// Writes the indices of the visible meshlets in order and returns the number of triangles they hold
+size_t CullMeshlets(const MeshletData& meshlets, const MeshletCullView& view, std::vector<uint32_t>& visible);
@@ -0,0 +1,1465 @@
+#include "Microbench.h"
+#include "Camera.h"
+#include "ViewDepth.h"
+#include "TransparencySorter.h"
+#include "Scene.h"
+#include "WeightedBlendedOit.h"
+#include "ProceduralMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshMetrics.h"
+#include "MeshFile.h"
+#include "MeshImport.h"
+#include "RangeAllocator.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "BufferCodec.h"
+#include "Animation.h"
+#include "Skinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace
+{
+    struct Microbenchmark
+    {
+        const char* name;
+        // Performs count operations and returns a value depending on all of them, so nothing is optimized out
+        double (*run)(size_t count);
+        size_t count;
+        // Optional figure of merit of the state the runs left behind, reported next to the time
+        const char* metricName;
+        double (*metric)();
+    };
+
+    // Orbit camera poses along a path, as the scene produces them
+    void GetOrbitAngles(size_t i, float& xAngle, float& yAngle, float& zoom)
+    {
+        xAngle = i * 0.001f;
+        yAngle = 0.5f * sinf(i * 0.0007f);
+        zoom = 8.0f + (i % 64) * 0.01f;
+    }
+
+    // Per-view math as Scene::Update and Renderer::Render did it before the Camera class:
+    // a chain of matrix products, a general inverse and the projection rebuilt every time
+    double CameraLegacyMath(size_t count)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            float xAngle, yAngle, zoom;
+            GetOrbitAngles(i, xAngle, yAngle, zoom);
+
+            DirectX::XMMATRIX v = DirectX::XMMatrixIdentity();
+            v *= DirectX::XMMatrixTranslation(0, 0, -zoom);
+            v *= DirectX::XMMatrixRotationAxis({ 1, 0, 0 }, yAngle);
+            v *= DirectX::XMMatrixRotationAxis({ 0, 1, 0 }, xAngle);
+            v *= DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f);
+
+            DirectX::XMMATRIX vInv = DirectX::XMMatrixInverse(nullptr, v);
+            float f = 100.0f;
+            float n = 0.1f;
+            float fov = (float)M_PI / 2;
+            float aspectRatio = 720.0f / 1280.0f;
+            float width = n * tanf(fov / 2) * 2;
+            float height = aspectRatio * width;
+            float skyboxRad = sqrtf(powf(n, 2) + powf(width / 2, 2) + powf(height / 2, 2));
+            DirectX::XMMATRIX p = DirectX::XMMatrixPerspectiveLH(tanf(fov / 2) * 2 * f, tanf(fov / 2) * 2 * f * aspectRatio, f, n);
+            DirectX::XMMATRIX vp = DirectX::XMMatrixMultiply(vInv, p);
+
+            sum += DirectX::XMVectorGetX(vp.r[0]) + DirectX::XMVectorGetZ(v.r[3]) + skyboxRad;
+        }
+        return sum;
+    }
+
+    // Same views through Camera: quaternion orientation, rigid inverse and a cached projection
+    double CameraCached(size_t count)
+    {
+        Camera camera;
+        camera.SetPerspective((float)M_PI / 2, 720.0f / 1280.0f, 0.1f, 100.0f);
+
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            float xAngle, yAngle, zoom;
+            GetOrbitAngles(i, xAngle, yAngle, zoom);
+
+            DirectX::XMVECTOR orientation = DirectX::XMQuaternionMultiply(
+                DirectX::XMQuaternionRotationAxis({ 1, 0, 0 }, yAngle),
+                DirectX::XMQuaternionRotationAxis({ 0, 1, 0 }, xAngle));
+            DirectX::XMVECTOR position = DirectX::XMVector3Rotate(DirectX::XMVectorSet(0, 0, -zoom, 0), orientation);
+            camera.SetPose(position, orientation);
+
+            float n = camera.GetNearZ();
+            float tanX = camera.GetTanHalfFovX();
+            float tanY = camera.GetTanHalfFovY();
+            float skyboxRad = n * sqrtf(1.0f + tanX * tanX + tanY * tanY);
+            const DirectX::XMMATRIX& vp = camera.GetViewProjection();
+
+            sum += DirectX::XMVectorGetX(vp.r[0]) + DirectX::XMVectorGetZ(position) + skyboxRad;
+        }
+        return sum;
+    }
+
+    // Several passes or views querying the same camera within a frame only pay for the first query
+    double CameraCachedFourQueries(size_t count)
+    {
+        Camera camera;
+        camera.SetPerspective((float)M_PI / 2, 720.0f / 1280.0f, 0.1f, 100.0f);
+
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            float xAngle, yAngle, zoom;
+            GetOrbitAngles(i / 4, xAngle, yAngle, zoom);
+
+            DirectX::XMVECTOR orientation = DirectX::XMQuaternionMultiply(
+                DirectX::XMQuaternionRotationAxis({ 1, 0, 0 }, yAngle),
+                DirectX::XMQuaternionRotationAxis({ 0, 1, 0 }, xAngle));
+            camera.SetPose(DirectX::XMVector3Rotate(DirectX::XMVectorSet(0, 0, -zoom, 0), orientation), orientation);
+
+            sum += DirectX::XMVectorGetX(camera.GetViewProjection().r[0]) + DirectX::XMVectorGetW(camera.GetFrustum().planes[0]);
+        }
+        return sum;
+    }
+
+    // Transparent particles spread in front of a camera looking down +z, shared by the depth benchmarks
+    struct DepthFixture
+    {
+        static const size_t ObjectCount = 16384;
+
+        std::vector<DirectX::XMFLOAT3> positionsAoS;
+        PositionsSoA positions;
+        std::vector<float> depths;
+        DirectX::XMMATRIX view;
+        DirectX::XMFLOAT4 depthRow;
+
+        DepthFixture()
+        {
+            positionsAoS.reserve(ObjectCount);
+            positions.Reserve(ObjectCount);
+            for (size_t i = 0; i < ObjectCount; i++)
+            {
+                DirectX::XMFLOAT3 position = { (i % 32) * 2.5f - 40.0f, ((i / 32) % 32) * 2.5f, 10.0f + (i / 1024) * 2.5f };
+                positionsAoS.push_back(position);
+                positions.PushBack(position.x, position.y, position.z);
+            }
+            depths.resize(ObjectCount);
+
+            Camera camera;
+            camera.SetPose(DirectX::XMVectorSet(1.0f, 2.0f, -8.0f, 0.0f), DirectX::XMQuaternionRotationRollPitchYaw(0.1f, 0.3f, 0.0f));
+            view = camera.GetView();
+            depthRow = camera.GetViewDepthRow();
+        }
+
+        static DepthFixture& Get()
+        {
+            static DepthFixture fixture;
+            return fixture;
+        }
+    };
+
+    // What the transparent pass did per object before: a translation matrix and a full transform to read z
+    double ViewDepthMatrix(size_t count)
+    {
+        DepthFixture& fixture = DepthFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += DepthFixture::ObjectCount)
+        {
+            size_t batch = min(count - done, DepthFixture::ObjectCount);
+            for (size_t i = 0; i < batch; i++)
+            {
+                const DirectX::XMFLOAT3& p = fixture.positionsAoS[i];
+                DirectX::XMMATRIX model = DirectX::XMMatrixTranslation(p.x, p.y, p.z);
+                fixture.depths[i] = DirectX::XMVectorGetZ(DirectX::XMVector3Transform(model.r[3], fixture.view));
+            }
+            sum += fixture.depths[batch - 1];
+        }
+        return sum;
+    }
+
+    template <void (*Kernel)(const float*, const float*, const float*, size_t, const float*, float*)>
+    double ViewDepthBatched(size_t count)
+    {
+        DepthFixture& fixture = DepthFixture::Get();
+        const PositionsSoA& positions = fixture.positions;
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += DepthFixture::ObjectCount)
+        {
+            size_t batch = min(count - done, DepthFixture::ObjectCount);
+            Kernel(positions.x.data(), positions.y.data(), positions.z.data(), batch, &fixture.depthRow.x, fixture.depths.data());
+            sum += fixture.depths[batch - 1];
+        }
+        return sum;
+    }
+
+    double ViewDepthAvx(size_t count)
+    {
+        // Reports the SSE timing on CPUs without AVX rather than crashing
+        return IsAvxSupported() ? ViewDepthBatched<ComputeViewDepthsAvx>(count) : ViewDepthBatched<ComputeViewDepthsSse>(count);
+    }
+
+    // View depths of the scene's transparent grid along an orbit, one frame of a mouse drag at 60 Hz per step.
+    // Depths are computed up front, so only the sorting is timed.
+    template <size_t ObjectCount, size_t FrameCount>
+    struct SortFixture
+    {
+        std::vector<float> depths;
+
+        SortFixture()
+        {
+            std::unique_ptr<Scene> pScene(new Scene());
+            pScene->SetTransparentObjectCount(ObjectCount);
+            const PositionsSoA& positions = pScene->GetTransparentPositions();
+
+            Camera camera;
+            depths.resize(positions.GetCount() * FrameCount);
+            for (size_t frame = 0; frame < FrameCount; frame++)
+            {
+                float xAngle = frame * 0.01f;
+                float yAngle = 0.3f + 0.2f * sinf(frame * 0.007f);
+                DirectX::XMVECTOR orientation = DirectX::XMQuaternionMultiply(
+                    DirectX::XMQuaternionRotationAxis({ 1, 0, 0 }, yAngle),
+                    DirectX::XMQuaternionRotationAxis({ 0, 1, 0 }, xAngle));
+                DirectX::XMVECTOR target = DirectX::XMVectorSet(0.0f, 5.0f, 20.0f, 0.0f);
+                camera.SetPose(DirectX::XMVectorAdd(target, DirectX::XMVector3Rotate(DirectX::XMVectorSet(0, 0, -40.0f, 0), orientation)), orientation);
+
+                DirectX::XMFLOAT4 depthRow = camera.GetViewDepthRow();
+                ComputeViewDepths(positions, &depthRow.x, GetDepths(frame));
+            }
+        }
+
+        float* GetDepths(size_t frame) { return depths.data() + (depths.size() / FrameCount) * frame; }
+        size_t GetObjectCount() const { return depths.size() / FrameCount; }
+
+        static SortFixture& Get()
+        {
+            static SortFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Full comparison sort of every frame, as the transparent pass did before
+    template <size_t ObjectCount, size_t FrameCount>
+    double SortStd(size_t count)
+    {
+        SortFixture<ObjectCount, FrameCount>& fixture = SortFixture<ObjectCount, FrameCount>::Get();
+        std::vector<std::pair<int, float>> cameraDist(fixture.GetObjectCount());
+        double sum = 0.0;
+        for (size_t frame = 0; frame < count; frame++)
+        {
+            const float* pDepths = fixture.GetDepths(frame % FrameCount);
+            for (size_t i = 0; i < cameraDist.size(); i++)
+            {
+                cameraDist[i] = { static_cast<int>(i), pDepths[i] };
+            }
+            std::sort(cameraDist.begin(), cameraDist.end(), [](const std::pair<int, float>& a, const std::pair<int, float>& b)
+                {
+                    return a.second > b.second;
+                });
+            sum += cameraDist[0].first;
+        }
+        return sum;
+    }
+
+    // Radix sort from scratch every frame, the fallback path of the sorter
+    template <size_t ObjectCount, size_t FrameCount>
+    double SortRadix(size_t count)
+    {
+        SortFixture<ObjectCount, FrameCount>& fixture = SortFixture<ObjectCount, FrameCount>::Get();
+        TransparencySorter sorter;
+        double sum = 0.0;
+        for (size_t frame = 0; frame < count; frame++)
+        {
+            sorter.Reset();
+            sum += sorter.Sort(fixture.GetDepths(frame % FrameCount), fixture.GetObjectCount())[0].index;
+        }
+        return sum;
+    }
+
+    // Previous order repaired frame to frame along the path
+    template <size_t ObjectCount, size_t FrameCount>
+    double SortIncremental(size_t count)
+    {
+        SortFixture<ObjectCount, FrameCount>& fixture = SortFixture<ObjectCount, FrameCount>::Get();
+        TransparencySorter sorter;
+        double sum = 0.0;
+        for (size_t frame = 0; frame < count; frame++)
+        {
+            sum += sorter.Sort(fixture.GetDepths(frame % FrameCount), fixture.GetObjectCount())[0].index;
+        }
+        return sum;
+    }
+
+    // Pixels covered by eight layers of half transparent cubes at varying depths
+    void GetOitFragments(size_t pixel, OitFragment* pFragments, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t seed = pixel * 31 + i * 17;
+            OitFragment& fragment = pFragments[i];
+            fragment.color[0] = (seed % 3) == 0 ? 1.0f : 0.0f;
+            fragment.color[1] = (seed % 3) == 1 ? 1.0f : 0.0f;
+            fragment.color[2] = (seed % 3) == 2 ? 1.0f : 0.0f;
+            fragment.alpha = 0.5f;
+            fragment.viewDepth = 2.0f + (seed % 97) * 0.5f;
+        }
+    }
+
+    // Per pixel cost of the CPU reference composite, accumulation in submission order
+    double OitReferenceComposite(size_t count)
+    {
+        const size_t LayerCount = 8;
+        const float Background[3] = { 0.5f, 0.25f, 0.75f };
+        OitFragment fragments[LayerCount];
+        double sum = 0.0;
+        for (size_t pixel = 0; pixel < count; pixel++)
+        {
+            GetOitFragments(pixel, fragments, LayerCount);
+            OitPixel oit;
+            for (const OitFragment& fragment : fragments)
+            {
+                oit.AddFragment(fragment);
+            }
+            float result[3];
+            oit.Composite(Background, result);
+            sum += result[0];
+        }
+        return sum;
+    }
+
+    // Exact blend of the same pixels, sorting the fragments first
+    double OitSortedBlend(size_t count)
+    {
+        const size_t LayerCount = 8;
+        const float Background[3] = { 0.5f, 0.25f, 0.75f };
+        OitFragment fragments[LayerCount];
+        double sum = 0.0;
+        for (size_t pixel = 0; pixel < count; pixel++)
+        {
+            GetOitFragments(pixel, fragments, LayerCount);
+            float result[3];
+            BlendSortedFragments(fragments, LayerCount, Background, result);
+            sum += result[0];
+        }
+        return sum;
+    }
+
+    // Regenerates a mesh into the same storage, so after the warmup only the generation itself is timed
+    template <void (*Generate)(const MeshOptions&, MeshData&)>
+    double MeshGenerate(size_t count)
+    {
+        MeshOptions options;
+        options.tangents = true;
+        MeshData mesh;
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            Generate(options, mesh);
+            sum += mesh.indices[i % mesh.GetIndexCount()];
+        }
+        return sum;
+    }
+
+    void GenerateSkyboxSphere(const MeshOptions& options, MeshData& mesh) { GenerateUvSphere(1.2f, 20, 10, options, mesh); }
+    void GenerateUvSphere64(const MeshOptions& options, MeshData& mesh) { GenerateUvSphere(1.0f, 64, 32, options, mesh); }
+    void GenerateIcosphere4(const MeshOptions& options, MeshData& mesh) { GenerateIcosphere(1.0f, 4, options, mesh); }
+    void GenerateCube16(const MeshOptions& options, MeshData& mesh) { GenerateCube(1.0f, 16, options, mesh); }
+    void GenerateTorus64(const MeshOptions& options, MeshData& mesh) { GenerateTorus(1.0f, 0.25f, 64, 32, options, mesh); }
+
+    // A large torus with its triangles shuffled, as a mesh exported without any optimization would arrive
+    struct OptimizerFixture
+    {
+        static const uint32_t MajorSegments = 512;
+        static const uint32_t MinorSegments = 256;
+        static const size_t TriangleCount = MajorSegments * MinorSegments * 2;
+
+        MeshData mesh;
+        std::vector<uint32_t> shuffledIndices;
+        std::vector<uint32_t> cacheOptimizedIndices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> remap;
+
+        OptimizerFixture()
+        {
+            MeshOptions options;
+            options.normals = false;
+            options.cacheSize = 0;
+            GenerateTorus(1.0f, 0.25f, MajorSegments, MinorSegments, options, mesh);
+
+            size_t triangleCount = TriangleCount;
+            shuffledIndices.resize(mesh.GetIndexCount());
+            uint32_t seed = 1;
+            std::vector<uint32_t> order(triangleCount);
+            for (size_t i = 0; i < triangleCount; i++)
+            {
+                order[i] = static_cast<uint32_t>(i);
+            }
+            for (size_t i = triangleCount - 1; i > 0; i--)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                std::swap(order[i], order[seed % (i + 1)]);
+            }
+            for (size_t i = 0; i < triangleCount; i++)
+            {
+                memcpy(&shuffledIndices[i * 3], &mesh.indices[order[i] * 3], 3 * sizeof(uint32_t));
+            }
+
+            cacheOptimizedIndices = shuffledIndices;
+            OptimizeVertexCache(cacheOptimizedIndices.data(), cacheOptimizedIndices.size(), mesh.GetVertexCount());
+        }
+
+        static OptimizerFixture& Get()
+        {
+            static OptimizerFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Every pass runs on a fresh copy of its input, counted per triangle
+    double OptimizeCacheShuffled(size_t count)
+    {
+        OptimizerFixture& fixture = OptimizerFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += OptimizerFixture::TriangleCount)
+        {
+            fixture.indices = fixture.shuffledIndices;
+            OptimizeVertexCache(fixture.indices.data(), fixture.indices.size(), fixture.mesh.GetVertexCount());
+            sum += fixture.indices[0];
+        }
+        return sum;
+    }
+
+    double OptimizeOverdrawCacheOptimized(size_t count)
+    {
+        OptimizerFixture& fixture = OptimizerFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += OptimizerFixture::TriangleCount)
+        {
+            fixture.indices = fixture.cacheOptimizedIndices;
+            OptimizeOverdraw(fixture.indices.data(), fixture.indices.size(), fixture.mesh.positions.data(), fixture.mesh.GetVertexCount());
+            sum += fixture.indices[0];
+        }
+        return sum;
+    }
+
+    double OptimizeFetchCacheOptimized(size_t count)
+    {
+        OptimizerFixture& fixture = OptimizerFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += OptimizerFixture::TriangleCount)
+        {
+            fixture.indices = fixture.cacheOptimizedIndices;
+            OptimizeVertexFetch(fixture.indices.data(), fixture.indices.size(), fixture.mesh.GetVertexCount(), fixture.remap);
+            sum += fixture.remap[0];
+        }
+        return sum;
+    }
+
+    double AnalyzeCacheOptimized(size_t count)
+    {
+        OptimizerFixture& fixture = OptimizerFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += OptimizerFixture::TriangleCount)
+        {
+            sum += AnalyzeVertexCache(fixture.cacheOptimizedIndices.data(), fixture.cacheOptimizedIndices.size(), fixture.mesh.GetVertexCount(), 32).acmr;
+        }
+        return sum;
+    }
+
+    // The same torus with normals and texture coordinates as a mesh file with float attributes and as text with
+    // one vertex or triangle per line, written to the temp directory once
+    struct MeshFileFixture
+    {
+        static const uint32_t MajorSegments = 512;
+        static const uint32_t MinorSegments = 256;
+        static const size_t TriangleCount = MajorSegments * MinorSegments * 2;
+
+        std::wstring binaryPath;
+        std::wstring textPath;
+        std::vector<char> text;
+        MeshData mesh;
+        bool isValid = false;
+
+        MeshFileFixture()
+        {
+            MeshData source;
+            GenerateTorus(1.0f, 0.25f, MajorSegments, MinorSegments, MeshOptions(), source);
+
+            wchar_t tempPath[MAX_PATH] = {};
+            GetTempPathW(MAX_PATH, tempPath);
+            binaryPath = std::wstring(tempPath) + L"lab5_microbench.l5mesh";
+            textPath = std::wstring(tempPath) + L"lab5_microbench.txt";
+
+            VertexFormat format;
+            format.normal = NORMAL_FORMAT::FLOAT3;
+            isValid = WriteMeshFile(binaryPath, source, format);
+
+            FILE* pFile = nullptr;
+            _wfopen_s(&pFile, textPath.c_str(), L"w");
+            if (pFile != nullptr)
+            {
+                fprintf(pFile, "vertices %zu\nindices %zu\n", source.GetVertexCount(), source.GetIndexCount());
+                for (size_t i = 0; i < source.GetVertexCount(); i++)
+                {
+                    const float* p = &source.positions[i * 3];
+                    const float* n = &source.normals[i * 3];
+                    const float* uv = &source.uvs[i * 2];
+                    fprintf(pFile, "%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n", p[0], p[1], p[2], n[0], n[1], n[2], uv[0], uv[1]);
+                }
+                for (size_t i = 0; i < source.GetIndexCount(); i += 3)
+                {
+                    fprintf(pFile, "%u %u %u\n", source.indices[i], source.indices[i + 1], source.indices[i + 2]);
+                }
+                isValid = fclose(pFile) == 0 && isValid;
+            }
+            else
+            {
+                isValid = false;
+            }
+        }
+
+        ~MeshFileFixture()
+        {
+            DeleteFileW(binaryPath.c_str());
+            DeleteFileW(textPath.c_str());
+        }
+
+        // What loading the text takes: reading the file and converting every number
+        bool ParseText()
+        {
+            FILE* pFile = nullptr;
+            _wfopen_s(&pFile, textPath.c_str(), L"rb");
+            if (pFile == nullptr)
+            {
+                return false;
+            }
+            _fseeki64(pFile, 0, SEEK_END);
+            text.resize(static_cast<size_t>(_ftelli64(pFile)) + 1);
+            _fseeki64(pFile, 0, SEEK_SET);
+            size_t rd = fread(text.data(), 1, text.size() - 1, pFile);
+            fclose(pFile);
+            text[rd] = '\0';
+
+            char* pText = strstr(text.data(), "vertices");
+            size_t vertexCount = pText != nullptr ? strtoull(pText + strlen("vertices"), &pText, 10) : 0;
+            pText = pText != nullptr ? strstr(pText, "indices") : nullptr;
+            if (pText == nullptr)
+            {
+                return false;
+            }
+            size_t indexCount = strtoull(pText + strlen("indices"), &pText, 10);
+            mesh.positions.resize(vertexCount * 3);
+            mesh.normals.resize(vertexCount * 3);
+            mesh.uvs.resize(vertexCount * 2);
+            mesh.indices.resize(indexCount);
+
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    mesh.positions[i * 3 + c] = strtof(pText, &pText);
+                }
+                for (int c = 0; c < 3; c++)
+                {
+                    mesh.normals[i * 3 + c] = strtof(pText, &pText);
+                }
+                for (int c = 0; c < 2; c++)
+                {
+                    mesh.uvs[i * 2 + c] = strtof(pText, &pText);
+                }
+            }
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                mesh.indices[i] = static_cast<uint32_t>(strtoul(pText, &pText, 10));
+            }
+            return true;
+        }
+
+        static MeshFileFixture& Get()
+        {
+            static MeshFileFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Loads are counted per triangle of the mesh
+    double MeshFileParseText(size_t count)
+    {
+        MeshFileFixture& fixture = MeshFileFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += MeshFileFixture::TriangleCount)
+        {
+            sum += fixture.isValid && fixture.ParseText() ? fixture.mesh.positions[done % fixture.mesh.positions.size()] : -1.0;
+        }
+        return sum;
+    }
+
+    // Mapping and validating only, the pages are read later by whatever uses them
+    double MeshFileMap(size_t count)
+    {
+        MeshFileFixture& fixture = MeshFileFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += MeshFileFixture::TriangleCount)
+        {
+            MeshFile file;
+            sum += fixture.isValid && file.Open(fixture.binaryPath) ? file.GetHeader().vertexCount : -1.0;
+        }
+        return sum;
+    }
+
+    // Mapping plus a read of every page of the vertex and index data, the faults a GPU upload from the mapping would take
+    double MeshFileMapTouch(size_t count)
+    {
+        const size_t PageSize = 4096;
+        MeshFileFixture& fixture = MeshFileFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += MeshFileFixture::TriangleCount)
+        {
+            MeshFile file;
+            if (!fixture.isValid || !file.Open(fixture.binaryPath))
+            {
+                return -1.0;
+            }
+            const uint8_t* pVertices = static_cast<const uint8_t*>(file.GetVertices());
+            for (size_t offset = 0; offset < file.GetVertexBytes(); offset += PageSize)
+            {
+                sum += pVertices[offset];
+            }
+            const uint8_t* pIndices = static_cast<const uint8_t*>(file.GetIndices());
+            for (size_t offset = 0; offset < file.GetIndexBytes(); offset += PageSize)
+            {
+                sum += pIndices[offset];
+            }
+        }
+        return sum;
+    }
+
+    // The torus of the mesh file benchmarks as the files a content tool exports: right-handed, counterclockwise
+    // and with the texture origin at the bottom left, so the importers do all of their conversions
+    struct ImportFixture
+    {
+        static const uint32_t MajorSegments = 512;
+        static const uint32_t MinorSegments = 256;
+
+        std::string obj;
+        std::vector<uint8_t> glb;
+        MeshData mesh;
+
+        ImportFixture()
+        {
+            MeshData source;
+            GenerateTorus(1.0f, 0.25f, MajorSegments, MinorSegments, MeshOptions(), source);
+            size_t vertexCount = source.GetVertexCount();
+
+            char line[128];
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                const float* p = &source.positions[i * 3];
+                sprintf_s(line, "v %.6f %.6f %.6f\n", p[0], p[1], -p[2]);
+                obj += line;
+            }
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                sprintf_s(line, "vt %.6f %.6f\n", source.uvs[i * 2], 1.0f - source.uvs[i * 2 + 1]);
+                obj += line;
+            }
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                const float* n = &source.normals[i * 3];
+                sprintf_s(line, "vn %.6f %.6f %.6f\n", n[0], n[1], -n[2]);
+                obj += line;
+            }
+            for (size_t i = 0; i < source.GetIndexCount(); i += 3)
+            {
+                uint32_t a = source.indices[i] + 1;
+                uint32_t b = source.indices[i + 2] + 1;
+                uint32_t c = source.indices[i + 1] + 1;
+                sprintf_s(line, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+                obj += line;
+            }
+
+            // One buffer with the three attribute streams and 32-bit indices, viewed by one accessor each
+            std::vector<uint8_t> binary;
+            auto append = [&binary](const void* pData, size_t size)
+            {
+                const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+                binary.insert(binary.end(), pBytes, pBytes + size);
+            };
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                float p[3] = { source.positions[i * 3], source.positions[i * 3 + 1], -source.positions[i * 3 + 2] };
+                append(p, sizeof(p));
+            }
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                float n[3] = { source.normals[i * 3], source.normals[i * 3 + 1], -source.normals[i * 3 + 2] };
+                append(n, sizeof(n));
+            }
+            append(source.uvs.data(), source.uvs.size() * sizeof(float));
+            for (size_t i = 0; i < source.GetIndexCount(); i += 3)
+            {
+                uint32_t triangle[3] = { source.indices[i], source.indices[i + 2], source.indices[i + 1] };
+                append(triangle, sizeof(triangle));
+            }
+
+            size_t positionBytes = vertexCount * 12;
+            size_t uvOffset = positionBytes * 2;
+            size_t indexOffset = uvOffset + vertexCount * 8;
+            char json[2048];
+            sprintf_s(json,
+                "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+                "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}],"
+                "\"buffers\":[{\"byteLength\":%zu}],\"bufferViews\":["
+                "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+                "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+                "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+                "{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+                "{\"bufferView\":2,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+                "{\"bufferView\":3,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+                binary.size(), positionBytes, positionBytes, positionBytes, uvOffset, vertexCount * 8, indexOffset, binary.size() - indexOffset,
+                vertexCount, vertexCount, vertexCount, source.GetIndexCount());
+
+            // Chunks are padded to four bytes, the JSON with spaces
+            std::string header = json;
+            header.resize((header.size() + 3) & ~size_t(3), ' ');
+            uint32_t fileHeader[5] = { 0x46546C67, 2, static_cast<uint32_t>(28 + header.size() + binary.size()),
+                static_cast<uint32_t>(header.size()), 0x4E4F534A };
+            uint32_t binaryHeader[2] = { static_cast<uint32_t>(binary.size()), 0x004E4942 };
+            glb.resize(sizeof(fileHeader) + header.size() + sizeof(binaryHeader) + binary.size());
+            uint8_t* pFile = glb.data();
+            memcpy(pFile, fileHeader, sizeof(fileHeader));
+            memcpy(pFile += sizeof(fileHeader), header.data(), header.size());
+            memcpy(pFile += header.size(), binaryHeader, sizeof(binaryHeader));
+            memcpy(pFile + sizeof(binaryHeader), binary.data(), binary.size());
+        }
+
+        static ImportFixture& Get()
+        {
+            static ImportFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Imports are counted per byte of the file, 1000 / (ns/op) is the throughput in MB/s
+    template <uint32_t ThreadCount>
+    double ImportObjFile(size_t count)
+    {
+        ImportFixture& fixture = ImportFixture::Get();
+        ImportOptions options;
+        options.threadCount = ThreadCount;
+        options.optimize = false;
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.obj.size())
+        {
+            sum += ImportObj(fixture.obj.data(), fixture.obj.size(), options, fixture.mesh) ? fixture.mesh.GetVertexCount() : -1.0;
+        }
+        return sum;
+    }
+
+    double ImportGlbFile(size_t count)
+    {
+        ImportFixture& fixture = ImportFixture::Get();
+        ImportOptions options;
+        options.optimize = false;
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.glb.size())
+        {
+            sum += ImportGlb(fixture.glb.data(), fixture.glb.size(), options, fixture.mesh) ? fixture.mesh.GetVertexCount() : -1.0;
+        }
+        return sum;
+    }
+
+    // A 64 MB pool page churned by mesh sized requests: log-uniform from 1 KB to 1 MB and aligned to the vertex
+    // strides of the renderer. Requests are allocated while less than 3/4 of the page is in use, otherwise a random
+    // live allocation is freed.
+    struct AllocatorFixture
+    {
+        static const uint32_t Capacity = 64 << 20;
+        static const size_t RequestCount = 1 << 16;
+
+        struct Request
+        {
+            uint32_t size;
+            uint32_t alignment;
+            uint32_t victim;
+        };
+
+        std::vector<Request> requests;
+
+        AllocatorFixture()
+        {
+            const uint32_t Strides[] = { 8, 12, 16, 20, 24, 32 };
+            requests.resize(RequestCount);
+            uint32_t seed = 1;
+            for (Request& request : requests)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                request.size = static_cast<uint32_t>(1024.0 * pow(1024.0, (seed >> 8) / 16777216.0));
+                seed = seed * 1664525u + 1013904223u;
+                request.alignment = Strides[(seed >> 8) % (sizeof(Strides) / sizeof(Strides[0]))];
+                seed = seed * 1664525u + 1013904223u;
+                request.victim = seed >> 8;
+            }
+        }
+
+        static AllocatorFixture& Get()
+        {
+            static AllocatorFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Baseline for the segregated fit: a single address ordered free list searched first fit
+    class FirstFitAllocator
+    {
+        // Offset to size of the free blocks
+        std::map<uint32_t, uint32_t> m_freeBlocks;
+        std::vector<std::pair<uint32_t, uint32_t>> m_allocations;
+        std::vector<uint32_t> m_unusedHandles;
+
+    public:
+        explicit FirstFitAllocator(uint32_t capacity)
+        {
+            m_freeBlocks[0] = capacity;
+        }
+
+        RangeAllocation Allocate(uint32_t size, uint32_t alignment)
+        {
+            RangeAllocation allocation;
+            for (auto block = m_freeBlocks.begin(); block != m_freeBlocks.end(); ++block)
+            {
+                uint32_t padding = (alignment - block->first % alignment) % alignment;
+                if (block->second < padding + size)
+                {
+                    continue;
+                }
+                uint32_t blockOffset = block->first;
+                uint32_t blockEnd = block->first + block->second;
+                allocation.offset = blockOffset + padding;
+                m_freeBlocks.erase(block);
+                if (padding > 0)
+                {
+                    m_freeBlocks[blockOffset] = padding;
+                }
+                if (allocation.offset + size < blockEnd)
+                {
+                    m_freeBlocks[allocation.offset + size] = blockEnd - allocation.offset - size;
+                }
+
+                if (m_unusedHandles.empty())
+                {
+                    m_unusedHandles.push_back(static_cast<uint32_t>(m_allocations.size()));
+                    m_allocations.emplace_back();
+                }
+                allocation.handle = m_unusedHandles.back();
+                m_unusedHandles.pop_back();
+                m_allocations[allocation.handle] = { allocation.offset, size };
+                break;
+            }
+            return allocation;
+        }
+
+        void Free(uint32_t handle)
+        {
+            uint32_t offset = m_allocations[handle].first;
+            uint32_t size = m_allocations[handle].second;
+            m_unusedHandles.push_back(handle);
+
+            auto next = m_freeBlocks.lower_bound(offset);
+            if (next != m_freeBlocks.end() && next->first == offset + size)
+            {
+                size += next->second;
+                next = m_freeBlocks.erase(next);
+            }
+            if (next != m_freeBlocks.begin())
+            {
+                auto previous = std::prev(next);
+                if (previous->first + previous->second == offset)
+                {
+                    previous->second += size;
+                    return;
+                }
+            }
+            m_freeBlocks.emplace_hint(next, offset, size);
+        }
+
+        double GetFragmentation() const
+        {
+            uint64_t freeSize = 0;
+            uint32_t largest = 0;
+            for (const auto& block : m_freeBlocks)
+            {
+                freeSize += block.second;
+                largest = max(largest, block.second);
+            }
+            return freeSize > 0 ? 1.0 - double(largest) / freeSize : 0.0;
+        }
+    };
+
+    // State carries over between runs, so the fragmentation metric describes the steady state of the churn
+    template <typename Allocator>
+    struct AllocatorChurn
+    {
+        Allocator allocator;
+        std::vector<RangeAllocation> live;
+        std::vector<uint32_t> liveSizes;
+        uint64_t liveBytes = 0;
+        size_t next = 0;
+
+        AllocatorChurn() : allocator(AllocatorFixture::Capacity) {}
+
+        static AllocatorChurn& Get()
+        {
+            static AllocatorChurn churn;
+            return churn;
+        }
+    };
+
+    // Counted per allocation or free
+    template <typename Allocator>
+    double AllocatorChurnRun(size_t count)
+    {
+        AllocatorFixture& fixture = AllocatorFixture::Get();
+        AllocatorChurn<Allocator>& churn = AllocatorChurn<Allocator>::Get();
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const AllocatorFixture::Request& request = fixture.requests[churn.next++ % AllocatorFixture::RequestCount];
+            if (churn.live.empty() || churn.liveBytes < AllocatorFixture::Capacity / 4 * 3)
+            {
+                RangeAllocation allocation = churn.allocator.Allocate(request.size, request.alignment);
+                if (allocation.IsValid())
+                {
+                    churn.live.push_back(allocation);
+                    churn.liveSizes.push_back(request.size);
+                    churn.liveBytes += request.size;
+                    sum += allocation.offset;
+                }
+            }
+            else
+            {
+                size_t victim = request.victim % churn.live.size();
+                churn.allocator.Free(churn.live[victim].handle);
+                churn.liveBytes -= churn.liveSizes[victim];
+                churn.live[victim] = churn.live.back();
+                churn.liveSizes[victim] = churn.liveSizes.back();
+                churn.live.pop_back();
+                churn.liveSizes.pop_back();
+            }
+        }
+        return sum;
+    }
+
+    template <typename Allocator>
+    double AllocatorFragmentation()
+    {
+        return AllocatorChurn<Allocator>::Get().allocator.GetFragmentation();
+    }
+
+    // Meshlets of the cache-optimized torus of the optimizer benchmarks, kept for the metric
+    struct MeshletBuildFixture
+    {
+        MeshletData meshlets;
+
+        static MeshletBuildFixture& Get()
+        {
+            static MeshletBuildFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Counted per triangle
+    double MeshletBuild(size_t count)
+    {
+        OptimizerFixture& source = OptimizerFixture::Get();
+        MeshletData& meshlets = MeshletBuildFixture::Get().meshlets;
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += OptimizerFixture::TriangleCount)
+        {
+            BuildMeshlets(source.cacheOptimizedIndices.data(), source.cacheOptimizedIndices.size(), source.mesh.positions.data(),
+                source.mesh.GetVertexCount(), meshlets);
+            sum += meshlets.meshlets.size();
+        }
+        return sum;
+    }
+
+    double MeshletTrianglesPerMeshlet()
+    {
+        const MeshletData& meshlets = MeshletBuildFixture::Get().meshlets;
+        return meshlets.meshlets.empty() ? 0.0 : double(meshlets.GetTriangleCount()) / meshlets.meshlets.size();
+    }
+
+    void GenerateTorus512(const MeshOptions& options, MeshData& mesh) { GenerateTorus(1.0f, 0.25f, 512, 256, options, mesh); }
+    void GenerateIcosphere6(const MeshOptions& options, MeshData& mesh) { GenerateIcosphere(1.0f, 6, options, mesh); }
+    void GenerateCube64(const MeshOptions& options, MeshData& mesh) { GenerateCube(1.0f, 64, options, mesh); }
+
+    // A mesh in meshlets seen from cameras orbiting it at varying heights, every other one close enough for the
+    // frustum to cut off part of it
+    template <void (*Generate)(const MeshOptions&, MeshData&)>
+    struct MeshletCullFixture
+    {
+        static const size_t ViewCount = 64;
+
+        MeshletData meshlets;
+        MeshletCullView views[ViewCount];
+        std::vector<uint32_t> visible;
+
+        MeshletCullFixture()
+        {
+            MeshData mesh;
+            Generate(MeshOptions(), mesh);
+            BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.GetVertexCount(), meshlets);
+
+            Camera camera;
+            camera.SetPerspective((float)M_PI / 2, 720.0f / 1280.0f, 0.1f, 100.0f);
+            for (size_t i = 0; i < ViewCount; i++)
+            {
+                float xAngle = i * 0.7f;
+                float yAngle = 0.8f * sinf(i * 0.3f);
+                float distance = i % 2 == 0 ? 3.0f : 1.5f;
+                DirectX::XMVECTOR orientation = DirectX::XMQuaternionMultiply(
+                    DirectX::XMQuaternionRotationAxis({ 1, 0, 0 }, yAngle),
+                    DirectX::XMQuaternionRotationAxis({ 0, 1, 0 }, xAngle));
+                DirectX::XMVECTOR position = DirectX::XMVector3Rotate(DirectX::XMVectorSet(0, 0, -distance, 0), orientation);
+                camera.SetPose(position, orientation);
+
+                const Frustum& frustum = camera.GetFrustum();
+                for (int plane = 0; plane < Frustum::PLANE_COUNT; plane++)
+                {
+                    DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(views[i].planes[plane]), frustum.planes[plane]);
+                }
+                DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(views[i].cameraPosition), position);
+            }
+        }
+
+        static MeshletCullFixture& Get()
+        {
+            static MeshletCullFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Counted per meshlet tested
+    template <void (*Generate)(const MeshOptions&, MeshData&)>
+    double MeshletCull(size_t count)
+    {
+        MeshletCullFixture<Generate>& fixture = MeshletCullFixture<Generate>::Get();
+        double sum = 0.0;
+        size_t view = 0;
+        for (size_t done = 0; done < count; done += fixture.meshlets.meshlets.size())
+        {
+            sum += CullMeshlets(fixture.meshlets, fixture.views[view++ % MeshletCullFixture<Generate>::ViewCount], fixture.visible);
+        }
+        return sum;
+    }
+
+    // Share of the triangles skipped over all views
+    template <void (*Generate)(const MeshOptions&, MeshData&)>
+    double MeshletCulledTriangles()
+    {
+        MeshletCullFixture<Generate>& fixture = MeshletCullFixture<Generate>::Get();
+        size_t visibleTriangles = 0;
+        for (const MeshletCullView& view : fixture.views)
+        {
+            visibleTriangles += CullMeshlets(fixture.meshlets, view, fixture.visible);
+        }
+        return 1.0 - double(visibleTriangles) / (double(fixture.meshlets.GetTriangleCount()) * MeshletCullFixture<Generate>::ViewCount);
+    }
+
+    // The large torus with normals and texture coordinates, simplified from scratch every run
+    struct SimplifyFixture
+    {
+        static const size_t TriangleCount = 512 * 256 * 2;
+
+        MeshData mesh;
+        std::vector<uint32_t> indices;
+        float error = 0.0f;
+
+        SimplifyFixture()
+        {
+            GenerateTorus512(MeshOptions(), mesh);
+        }
+
+        static SimplifyFixture& Get()
+        {
+            static SimplifyFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Counted per input triangle
+    template <size_t TargetTriangles>
+    double MeshSimplify(size_t count)
+    {
+        SimplifyFixture& fixture = SimplifyFixture::Get();
+        SimplifyOptions options;
+        options.targetIndexCount = TargetTriangles * 3;
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += SimplifyFixture::TriangleCount)
+        {
+            fixture.error = SimplifyMesh(fixture.mesh, fixture.mesh.indices, options, fixture.indices);
+            sum += fixture.indices.size();
+        }
+        return sum;
+    }
+
+    // Collapse error of the last run relative to the torus radius
+    double MeshSimplifyError()
+    {
+        SimplifyFixture& fixture = SimplifyFixture::Get();
+        return fixture.error / fixture.mesh.bounds.radius;
+    }
+
+    // The large torus through OptimizeMesh, so its vertices are numbered in first use order like those of an exported
+    // mesh file, in the compact vertex format of the renderer
+    struct BufferCodecFixture
+    {
+        MeshData mesh;
+        EncodedVertices vertices;
+        std::vector<uint8_t> packedVertices;
+        std::vector<uint8_t> packedIndices;
+        std::vector<uint8_t> decodedVertices;
+        std::vector<uint32_t> decodedIndices;
+
+        BufferCodecFixture()
+        {
+            GenerateTorus512(MeshOptions(), mesh);
+            OptimizeMesh(mesh);
+            VertexRequirements requirements;
+            requirements.normals = true;
+            requirements.maxPositionError = mesh.bounds.radius * CompactPositionTolerance;
+            requirements.maxNormalError = CompactNormalTolerance;
+            requirements.maxUvError = CompactUvTolerance;
+            EncodeVertices(mesh, ChooseVertexFormat(mesh, requirements), vertices);
+            EncodeVertexBuffer(vertices.data.data(), vertices.vertexCount, vertices.format.GetStride(), packedVertices);
+            EncodeIndexBuffer(mesh.indices.data(), mesh.GetIndexCount(), packedIndices);
+            decodedVertices.resize(vertices.GetSize());
+            decodedIndices.resize(mesh.GetIndexCount());
+        }
+
+        size_t GetIndexBytes() const { return mesh.GetIndexCount() * sizeof(uint32_t); }
+
+        static BufferCodecFixture& Get()
+        {
+            static BufferCodecFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Counted per byte of the uncompressed buffer, 1000 / (ns/op) is the throughput in MB/s
+    double CodecEncodeVertices(size_t count)
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.vertices.GetSize())
+        {
+            sum += EncodeVertexBuffer(fixture.vertices.data.data(), fixture.vertices.vertexCount, fixture.vertices.format.GetStride(),
+                fixture.packedVertices) ? fixture.packedVertices.size() : -1.0;
+        }
+        return sum;
+    }
+
+    template <bool (*Decode)(void*, size_t, size_t, const uint8_t*, size_t)>
+    double CodecDecodeVertices(size_t count)
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.vertices.GetSize())
+        {
+            bool isDecoded = Decode(fixture.decodedVertices.data(), fixture.vertices.vertexCount, fixture.vertices.format.GetStride(),
+                fixture.packedVertices.data(), fixture.packedVertices.size());
+            sum += isDecoded ? fixture.decodedVertices[done % fixture.decodedVertices.size()] : -1.0;
+        }
+        return sum;
+    }
+
+    double CodecEncodeIndices(size_t count)
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.GetIndexBytes())
+        {
+            sum += EncodeIndexBuffer(fixture.mesh.indices.data(), fixture.mesh.GetIndexCount(), fixture.packedIndices) ?
+                fixture.packedIndices.size() : -1.0;
+        }
+        return sum;
+    }
+
+    // Into 32-bit indices, as the torus has more than 64k vertices
+    double CodecDecodeIndices(size_t count)
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += fixture.GetIndexBytes())
+        {
+            bool isDecoded = DecodeIndexBuffer(fixture.decodedIndices.data(), fixture.decodedIndices.size(), sizeof(uint32_t),
+                fixture.packedIndices.data(), fixture.packedIndices.size());
+            sum += isDecoded ? fixture.decodedIndices[done % fixture.decodedIndices.size()] : -1.0;
+        }
+        return sum;
+    }
+
+    // Compressed size against the vertex buffer
+    double CodecVertexRatio()
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        return double(fixture.packedVertices.size()) / fixture.vertices.GetSize();
+    }
+
+    double CodecBytesPerTriangle()
+    {
+        BufferCodecFixture& fixture = BufferCodecFixture::Get();
+        return double(fixture.packedIndices.size()) / (fixture.mesh.GetIndexCount() / 3);
+    }
+
+    // 64 joints in a random hierarchy with a clip keyed at 30 fps, and 64k vertices each weighted to four random joints
+    struct SkinningFixture
+    {
+        static const size_t JointCount = 64;
+        static const size_t VertexCount = 65536;
+
+        Skeleton skeleton;
+        AnimationClip clip;
+        std::vector<JointPose> poses;
+        std::vector<JointMatrix> globals;
+        std::vector<JointMatrix> palette;
+        std::vector<SkinVertex> vertices;
+        std::vector<SkinnedVertex> skinned;
+
+        SkinningFixture()
+        {
+            const float KeyRate = 30.0f;
+            uint32_t seed = 1;
+            auto next = [&seed]()
+            {
+                seed = seed * 1664525u + 1013904223u;
+                return (seed >> 8) / 16777216.0f;
+            };
+
+            for (size_t joint = 0; joint < JointCount; joint++)
+            {
+                JointPose pose;
+                for (int k = 0; k < 3; k++)
+                {
+                    pose.translation[k] = next() - 0.5f;
+                }
+                skeleton.parents.push_back(joint == 0 ? -1 : int32_t(next() * joint));
+                skeleton.bindPose.push_back(pose);
+            }
+            skeleton.Finalize();
+
+            clip.duration = 2.0f;
+            clip.tracks.resize(JointCount);
+            size_t keyCount = size_t(clip.duration * KeyRate) + 1;
+            for (size_t joint = 0; joint < JointCount; joint++)
+            {
+                for (size_t key = 0; key < keyCount; key++)
+                {
+                    JointPose pose = skeleton.bindPose[joint];
+                    float angle = next() - 0.5f;
+                    pose.rotation[joint % 3] = sinf(angle);
+                    pose.rotation[3] = cosf(angle);
+                    clip.tracks[joint].times.push_back(key / KeyRate);
+                    clip.tracks[joint].poses.push_back(pose);
+                }
+            }
+
+            poses.resize(JointCount);
+            globals.resize(JointCount);
+            palette.resize(JointCount);
+            SampleClip(skeleton, clip, 0.5f, poses.data());
+            ComputeSkinningPalette(skeleton, poses.data(), globals.data(), palette.data());
+
+            vertices.resize(VertexCount);
+            skinned.resize(VertexCount);
+            for (SkinVertex& vertex : vertices)
+            {
+                float weightSum = 0.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    vertex.joints[k] = uint16_t(next() * JointCount);
+                    vertex.weights[k] = next();
+                    weightSum += vertex.weights[k];
+                }
+                for (int k = 0; k < 4; k++)
+                {
+                    vertex.weights[k] /= weightSum;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    vertex.position[k] = next() - 0.5f;
+                    vertex.normal[k] = next() - 0.5f;
+                }
+            }
+        }
+
+        static SkinningFixture& Get()
+        {
+            static SkinningFixture fixture;
+            return fixture;
+        }
+    };
+
+    // Sampling the clip at 60 Hz and building the palette from it, counted per joint
+    double SkinningAnimate(size_t count)
+    {
+        SkinningFixture& fixture = SkinningFixture::Get();
+        double sum = 0.0;
+        float time = 0.0f;
+        for (size_t done = 0; done < count; done += SkinningFixture::JointCount)
+        {
+            SampleClip(fixture.skeleton, fixture.clip, time, fixture.poses.data());
+            ComputeSkinningPalette(fixture.skeleton, fixture.poses.data(), fixture.globals.data(), fixture.palette.data());
+            sum += fixture.palette[done % SkinningFixture::JointCount].columns[3][0];
+            time += 1.0f / 60;
+        }
+        return sum;
+    }
+
+    // Counted per vertex
+    template <void (*Skin)(const JointMatrix*, const SkinVertex*, size_t, SkinnedVertex*)>
+    double SkinningSkinVertices(size_t count)
+    {
+        SkinningFixture& fixture = SkinningFixture::Get();
+        double sum = 0.0;
+        for (size_t done = 0; done < count; done += SkinningFixture::VertexCount)
+        {
+            Skin(fixture.palette.data(), fixture.vertices.data(), SkinningFixture::VertexCount, fixture.skinned.data());
+            sum += fixture.skinned[done % SkinningFixture::VertexCount].position[0];
+        }
+        return sum;
+    }
+
+    const Microbenchmark Microbenchmarks[] = {
+        { "camera/legacy_matrices", CameraLegacyMath, 1000000 },
+        { "camera/cached", CameraCached, 1000000 },
+        { "camera/cached_4_queries_per_pose", CameraCachedFourQueries, 1000000 },
+        { "view_depth/matrix_per_object", ViewDepthMatrix, 16 * DepthFixture::ObjectCount },
+        { "view_depth/soa_scalar", ViewDepthBatched<ComputeViewDepthsScalar>, 64 * DepthFixture::ObjectCount },
+        { "view_depth/soa_sse", ViewDepthBatched<ComputeViewDepthsSse>, 64 * DepthFixture::ObjectCount },
+        { "view_depth/soa_avx", ViewDepthAvx, 64 * DepthFixture::ObjectCount },
+        { "transparency_sort/std_sort_1k", SortStd<1000, 400>, 400 },
+        { "transparency_sort/radix_1k", SortRadix<1000, 400>, 400 },
+        { "transparency_sort/incremental_1k", SortIncremental<1000, 400>, 400 },
+        { "transparency_sort/std_sort_10k", SortStd<10000, 100>, 100 },
+        { "transparency_sort/radix_10k", SortRadix<10000, 100>, 100 },
+        { "transparency_sort/incremental_10k", SortIncremental<10000, 100>, 100 },
+        { "transparency_sort/std_sort_100k", SortStd<100000, 20>, 20 },
+        { "transparency_sort/radix_100k", SortRadix<100000, 20>, 20 },
+        { "transparency_sort/incremental_100k", SortIncremental<100000, 20>, 20 },
+        { "transparency_sort/std_sort_1m", SortStd<1000000, 4>, 4 },
+        { "transparency_sort/radix_1m", SortRadix<1000000, 4>, 4 },
+        { "transparency_sort/incremental_1m", SortIncremental<1000000, 4>, 4 },
+        { "oit/reference_composite_8_layers", OitReferenceComposite, 1000000 },
+        { "oit/sorted_blend_8_layers", OitSortedBlend, 1000000 },
+        { "mesh_gen/uv_sphere_20x10", MeshGenerate<GenerateSkyboxSphere>, 10000 },
+        { "mesh_gen/uv_sphere_64x32", MeshGenerate<GenerateUvSphere64>, 1000 },
+        { "mesh_gen/icosphere_4", MeshGenerate<GenerateIcosphere4>, 200 },
+        { "mesh_gen/cube_16", MeshGenerate<GenerateCube16>, 1000 },
+        { "mesh_gen/torus_64x32", MeshGenerate<GenerateTorus64>, 1000 },
+        { "mesh_opt/vertex_cache_256k_tris", OptimizeCacheShuffled, 4 * OptimizerFixture::TriangleCount },
+        { "mesh_opt/overdraw_256k_tris", OptimizeOverdrawCacheOptimized, 4 * OptimizerFixture::TriangleCount },
+        { "mesh_opt/vertex_fetch_256k_tris", OptimizeFetchCacheOptimized, 4 * OptimizerFixture::TriangleCount },
+        { "mesh_opt/analyze_vertex_cache_256k_tris", AnalyzeCacheOptimized, 4 * OptimizerFixture::TriangleCount },
+        { "mesh_file/parse_text_256k_tris", MeshFileParseText, 2 * MeshFileFixture::TriangleCount },
+        { "mesh_file/map_binary_256k_tris", MeshFileMap, 256 * MeshFileFixture::TriangleCount },
+        { "mesh_file/map_binary_touch_256k_tris", MeshFileMapTouch, 64 * MeshFileFixture::TriangleCount },
+        { "mesh_import/obj_256k_tris", ImportObjFile<0>, 256 << 20 },
+        { "mesh_import/obj_256k_tris_1_thread", ImportObjFile<1>, 128 << 20 },
+        { "mesh_import/glb_256k_tris", ImportGlbFile, 1024 << 20 },
+        { "range_alloc/segregated_fit_churn", AllocatorChurnRun<RangeAllocator>, 4000000, "fragmentation", AllocatorFragmentation<RangeAllocator> },
+        { "range_alloc/first_fit_churn", AllocatorChurnRun<FirstFitAllocator>, 400000, "fragmentation", AllocatorFragmentation<FirstFitAllocator> },
+        { "meshlet/build_256k_tris", MeshletBuild, 4 * OptimizerFixture::TriangleCount, "triangles_per_meshlet", MeshletTrianglesPerMeshlet },
+        { "meshlet/cull_torus_256k_tris", MeshletCull<GenerateTorus512>, 1000000, "culled_triangles", MeshletCulledTriangles<GenerateTorus512> },
+        { "meshlet/cull_icosphere_80k_tris", MeshletCull<GenerateIcosphere6>, 1000000, "culled_triangles", MeshletCulledTriangles<GenerateIcosphere6> },
+        { "meshlet/cull_cube_48k_tris", MeshletCull<GenerateCube64>, 1000000, "culled_triangles", MeshletCulledTriangles<GenerateCube64> },
+        { "mesh_simplify/torus_256k_tris_to_64k", MeshSimplify<65536>, 2 * SimplifyFixture::TriangleCount, "relative_error", MeshSimplifyError },
+        { "mesh_simplify/torus_256k_tris_to_4k", MeshSimplify<4096>, 2 * SimplifyFixture::TriangleCount, "relative_error", MeshSimplifyError },
+        { "buffer_codec/encode_vertices", CodecEncodeVertices, 32 << 20, "size_ratio", CodecVertexRatio },
+        { "buffer_codec/decode_vertices_scalar", CodecDecodeVertices<DecodeVertexBufferScalar>, 128 << 20, "size_ratio", CodecVertexRatio },
+        { "buffer_codec/decode_vertices", CodecDecodeVertices<DecodeVertexBuffer>, 512 << 20, "size_ratio", CodecVertexRatio },
+        { "buffer_codec/encode_indices", CodecEncodeIndices, 64 << 20, "bytes_per_triangle", CodecBytesPerTriangle },
+        { "buffer_codec/decode_indices", CodecDecodeIndices, 512 << 20, "bytes_per_triangle", CodecBytesPerTriangle },
+        { "skinning/animate_64_joints", SkinningAnimate, 4000000 },
+        { "skinning/skin_vertices_scalar", SkinningSkinVertices<SkinVerticesScalar>, 4 << 20 },
+        { "skinning/skin_vertices_sse", SkinningSkinVertices<SkinVerticesSse>, 16 << 20 },
+    };
+
+    bool MatchesFilter(const char* name, const std::wstring& filter)
+    {
+        std::wstring wideName(name, name + strlen(name));
+        return filter.empty() || wideName.find(filter) != std::wstring::npos;
+    }
+}
+
+int RunMicrobenchmarks(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const int Repetitions = 5;
+
+    FILE* pReport = nullptr;
+    if (!options.reportPath.empty())
+    {
+        _wfopen_s(&pReport, options.reportPath.c_str(), L"w");
+        if (pReport == nullptr)
+        {
+            wprintf(L"Failed to open report file %s\n", options.reportPath.c_str());
+            return 1;
+        }
+        fprintf(pReport, "[\n");
+    }
+
+    bool first = true;
+    for (const Microbenchmark& benchmark : Microbenchmarks)
+    {
+        if (!MatchesFilter(benchmark.name, options.microbenchFilter))
+        {
+            continue;
+        }
+
+        // Warm up caches and clocks, then keep the best repetition to filter out preemption
+        double checksum = benchmark.run(benchmark.count / 10 + 1);
+        double best = 0.0;
+        for (int repetition = 0; repetition < Repetitions; repetition++)
+        {
+            Clock::time_point start = Clock::now();
+            checksum += benchmark.run(benchmark.count);
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            best = repetition == 0 ? elapsed : min(best, elapsed);
+        }
+        double nsPerOp = best * 1e9 / benchmark.count;
+
+        double metric = benchmark.metric != nullptr ? benchmark.metric() : 0.0;
+        wprintf(L"%-40S %10.2f ns/op  (checksum %g)", benchmark.name, nsPerOp, checksum);
+        if (benchmark.metric != nullptr)
+        {
+            wprintf(L"  %S %.4f", benchmark.metricName, metric);
+        }
+        wprintf(L"\n");
+        if (pReport != nullptr)
+        {
+            fprintf(pReport, "%s  { \"name\": \"%s\", \"nsPerOp\": %.3f, \"count\": %zu", first ? "" : ",\n", benchmark.name, nsPerOp, benchmark.count);
+            if (benchmark.metric != nullptr)
+            {
+                fprintf(pReport, ", \"%s\": %.6f", benchmark.metricName, metric);
+            }
+            fprintf(pReport, " }");
+        }
+        first = false;
+    }
+
+    if (pReport != nullptr)
+    {
+        fprintf(pReport, "\n]\n");
+        fclose(pReport);
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "CommandLine.h"
+
+// Times hot path building blocks against the code they replaced and prints nanoseconds per operation
+int RunMicrobenchmarks(const AppOptions& options);
@@ -0,0 +1,27 @@
+Texture2D accumTexture : register (t0);
+Texture2D revealageTexture : register (t1);
+
+struct VSOutput
+{
+    float4 pos : SV_Position;
+};
+
+// Blended with src * (1 - alpha) + dst * alpha, alpha carries the revealage
+float4 ps(VSOutput pixel) : SV_Target0
+{
+    int3 coord = int3(pixel.pos.xy, 0);
+    float revealage = revealageTexture.Load(coord).r;
+    if (revealage == 1.0)
+    {
+        // Nothing transparent covers the pixel
+        discard;
+    }
+
+    float4 accum = accumTexture.Load(coord);
+    // Half floats can still overflow under many heavily weighted layers
+    if (isinf(max(max(abs(accum.r), abs(accum.g)), abs(accum.b))))
+    {
+        accum.rgb = accum.aaa;
+    }
+    return float4(accum.rgb / max(accum.a, 1e-5), revealage);
+}
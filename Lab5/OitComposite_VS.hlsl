@@ -0,0 +1,15 @@
+struct VSOutput
+{
+    float4 pos : SV_Position;
+};
+
+// Single triangle covering the screen, no vertex buffer
+VSOutput vs(uint vertexId : SV_VertexID)
+{
+    VSOutput result;
+
+    float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    result.pos = float4(uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+
+    return result;
+}
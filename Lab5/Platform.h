@@ -0,0 +1,50 @@
+#pragma once
+
+// The scene and camera only need DirectXMath and a few window message helpers, so besides the application they
+// build on other platforms too, e.g. for the headless replay and benchmark on Linux (see HeadlessMain.cpp).
+#ifdef _WIN32
+
+#include "framework.h"
+
+#else
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+// Header only, e.g. the Inc directory of github.com/microsoft/DirectXMath together with a sal.h stub
+#include <DirectXMath.h>
+
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+
+struct POINT
+{
+    int32_t x;
+    int32_t y;
+};
+
+#define VK_SPACE 0x20
+#define MK_LBUTTON 0x0001
+#define WHEEL_DELTA 120
+#define MAPVK_VK_TO_CHAR 2
+
+#define GET_X_LPARAM(lp) ((int)(short)((uintptr_t)(lp) & 0xFFFF))
+#define GET_Y_LPARAM(lp) ((int)(short)(((uintptr_t)(lp) >> 16) & 0xFFFF))
+#define GET_WHEEL_DELTA_WPARAM(wp) ((short)(((uintptr_t)(wp) >> 16) & 0xFFFF))
+
+// Virtual key codes of digits and letters are their upper case characters, the only keys recordings contain
+inline unsigned MapVirtualKey(WPARAM code, unsigned mapType)
+{
+    assert(mapType == MAPVK_VK_TO_CHAR);
+    bool isDigit = code >= '0' && code <= '9';
+    bool isLetter = code >= 'A' && code <= 'Z';
+    return isDigit || isLetter ? static_cast<unsigned>(code) : 0;
+}
+
+#endif
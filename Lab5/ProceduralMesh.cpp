@@ -0,0 +1,457 @@
+#include "ProceduralMesh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    void Cross(const float a[3], const float b[3], float result[3])
+    {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    void Normalize(float v[3])
+    {
+        float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    // Fills the preallocated streams of a mesh front to back
+    class MeshWriter
+    {
+    public:
+        MeshWriter(MeshData& mesh, size_t vertexCount, size_t indexCount, const MeshOptions& options)
+            : m_mesh(mesh)
+            , m_options(options)
+        {
+            mesh.positions.resize(vertexCount * 3);
+            mesh.normals.resize(options.normals ? vertexCount * 3 : 0);
+            mesh.tangents.resize(options.tangents ? vertexCount * 4 : 0);
+            mesh.uvs.resize(vertexCount * 2);
+            mesh.indices.resize(indexCount);
+        }
+
+        uint32_t GetVertexCount() const { return m_vertexCount; }
+
+        uint32_t AddVertex(const float position[3], const float normal[3], const float tangent[3], float u, float v)
+        {
+            float sign = m_options.insideOut ? -1.0f : 1.0f;
+            memcpy(&m_mesh.positions[m_vertexCount * 3], position, 3 * sizeof(float));
+            if (m_options.normals)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    m_mesh.normals[m_vertexCount * 3 + i] = normal[i] * sign;
+                }
+            }
+            if (m_options.tangents)
+            {
+                // Flipping the normal mirrors the tangent frame
+                memcpy(&m_mesh.tangents[m_vertexCount * 4], tangent, 3 * sizeof(float));
+                m_mesh.tangents[m_vertexCount * 4 + 3] = sign;
+            }
+            m_mesh.uvs[m_vertexCount * 2] = u;
+            m_mesh.uvs[m_vertexCount * 2 + 1] = v;
+            return m_vertexCount++;
+        }
+
+        void AddTriangle(uint32_t a, uint32_t b, uint32_t c)
+        {
+            uint32_t* pIndices = &m_mesh.indices[m_indexCount];
+            pIndices[0] = a;
+            pIndices[1] = m_options.insideOut ? c : b;
+            pIndices[2] = m_options.insideOut ? b : c;
+            m_indexCount += 3;
+        }
+
+        // Quads of a row-major grid of (rows + 1) x (columns + 1) vertices starting at base. Columns run to the
+        // right and rows downwards as seen from the front. Degenerate triangles touching a pole row can be skipped.
+        void AddGrid(uint32_t base, uint32_t columns, uint32_t rows, bool skipFirstRowTop, bool skipLastRowBottom)
+        {
+            // Vertical strips narrow enough that the row above is still in the cache when the next row is drawn
+            uint32_t stripWidth = m_options.cacheSize >= 4 ? m_options.cacheSize / 2 - 1 : columns;
+            uint32_t stride = columns + 1;
+            for (uint32_t stripStart = 0; stripStart < columns; stripStart += stripWidth)
+            {
+                uint32_t stripEnd = std::min(columns, stripStart + stripWidth);
+                for (uint32_t row = 0; row < rows; row++)
+                {
+                    for (uint32_t column = stripStart; column < stripEnd; column++)
+                    {
+                        uint32_t topLeft = base + row * stride + column;
+                        uint32_t bottomLeft = topLeft + stride;
+                        if (!skipFirstRowTop || row != 0)
+                        {
+                            AddTriangle(topLeft, topLeft + 1, bottomLeft + 1);
+                        }
+                        if (!skipLastRowBottom || row + 1 != rows)
+                        {
+                            AddTriangle(topLeft, bottomLeft + 1, bottomLeft);
+                        }
+                    }
+                }
+            }
+        }
+
+        void Finish()
+        {
+            assert(m_vertexCount * 3 == m_mesh.positions.size());
+            assert(m_indexCount == m_mesh.indices.size());
+
+            ComputeMeshBounds(m_mesh);
+        }
+
+    private:
+        MeshData& m_mesh;
+        const MeshOptions& m_options;
+        uint32_t m_vertexCount = 0;
+        size_t m_indexCount = 0;
+    };
+
+    uint32_t GetIcosphereVertexCount(uint32_t subdivisions)
+    {
+        return 10 * (1u << (2 * subdivisions)) + 2;
+    }
+
+    // Recursive subdivision emits the triangles of each base face depth first, so neighbours stay close
+    // in the index buffer and new vertices are created in the order they are first used
+    class IcosphereBuilder
+    {
+    public:
+        IcosphereBuilder(MeshWriter& writer, float radius, uint32_t subdivisions)
+            : m_writer(writer)
+            , m_radius(radius)
+        {
+            m_midpoints.reserve(30 * (size_t(1) << (2 * subdivisions)));
+        }
+
+        uint32_t AddVertex(const float direction[3])
+        {
+            float normal[3] = { direction[0], direction[1], direction[2] };
+            Normalize(normal);
+            float position[3] = { normal[0] * m_radius, normal[1] * m_radius, normal[2] * m_radius };
+            // Spherical texture coordinates, they wrap across the seam instead of duplicating vertices
+            float u = 0.5f + atan2f(normal[2], normal[0]) / (2.0f * Pi);
+            float v = acosf(std::max(-1.0f, std::min(1.0f, normal[1]))) / Pi;
+            float tangent[3] = { -normal[2], 0.0f, normal[0] };
+            if (tangent[0] == 0.0f && tangent[2] == 0.0f)
+            {
+                tangent[0] = 1.0f;
+            }
+            Normalize(tangent);
+            uint32_t index = m_writer.AddVertex(position, normal, tangent, u, v);
+            m_directions.push_back({ normal[0], normal[1], normal[2] });
+            return index;
+        }
+
+        void Subdivide(uint32_t a, uint32_t b, uint32_t c, uint32_t level)
+        {
+            if (level == 0)
+            {
+                m_writer.AddTriangle(a, b, c);
+                return;
+            }
+            uint32_t ab = GetMidpoint(a, b);
+            uint32_t bc = GetMidpoint(b, c);
+            uint32_t ca = GetMidpoint(c, a);
+            Subdivide(a, ab, ca, level - 1);
+            Subdivide(ab, bc, ca, level - 1);
+            Subdivide(ab, b, bc, level - 1);
+            Subdivide(ca, bc, c, level - 1);
+        }
+
+    private:
+        struct Direction
+        {
+            float x, y, z;
+        };
+
+        uint32_t GetMidpoint(uint32_t a, uint32_t b)
+        {
+            uint64_t key = a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+            auto it = m_midpoints.find(key);
+            if (it != m_midpoints.end())
+            {
+                return it->second;
+            }
+            const Direction& da = m_directions[a];
+            const Direction& db = m_directions[b];
+            float direction[3] = { da.x + db.x, da.y + db.y, da.z + db.z };
+            uint32_t index = AddVertex(direction);
+            m_midpoints.emplace(key, index);
+            return index;
+        }
+
+        MeshWriter& m_writer;
+        float m_radius;
+        std::vector<Direction> m_directions;
+        std::unordered_map<uint64_t, uint32_t> m_midpoints;
+    };
+}
+
+size_t GetUvSphereIndexCount(uint32_t slices, uint32_t stacks)
+{
+    slices = std::max(slices, 3u);
+    stacks = std::max(stacks, 2u);
+    // Triangles next to the poles would be degenerate
+    return size_t(slices) * (stacks - 1) * 6;
+}
+
+void GenerateUvSphere(float radius, uint32_t slices, uint32_t stacks, const MeshOptions& options, MeshData& mesh)
+{
+    slices = std::max(slices, 3u);
+    stacks = std::max(stacks, 2u);
+    MeshWriter writer(mesh, size_t(slices + 1) * (stacks + 1), GetUvSphereIndexCount(slices, stacks), options);
+
+    for (uint32_t stack = 0; stack <= stacks; stack++)
+    {
+        float beta = Pi * stack / stacks;
+        for (uint32_t slice = 0; slice <= slices; slice++)
+        {
+            float alpha = 2.0f * Pi * slice / slices;
+            float normal[3] = { sinf(beta) * cosf(alpha), cosf(beta), sinf(beta) * sinf(alpha) };
+            float position[3] = { normal[0] * radius, normal[1] * radius, normal[2] * radius };
+            float tangent[3] = { -sinf(alpha), 0.0f, cosf(alpha) };
+            writer.AddVertex(position, normal, tangent, float(slice) / slices, float(stack) / stacks);
+        }
+    }
+    writer.AddGrid(0, slices, stacks, true, true);
+    writer.Finish();
+}
+
+size_t GetIcosphereIndexCount(uint32_t subdivisions)
+{
+    return 60 * (size_t(1) << (2 * subdivisions));
+}
+
+void GenerateIcosphere(float radius, uint32_t subdivisions, const MeshOptions& options, MeshData& mesh)
+{
+    // Each level quadruples the triangles, beyond this the vertex count no longer fits 32 bits comfortably
+    subdivisions = std::min(subdivisions, 12u);
+    MeshWriter writer(mesh, GetIcosphereVertexCount(subdivisions), GetIcosphereIndexCount(subdivisions), options);
+    IcosphereBuilder builder(writer, radius, subdivisions);
+
+    const float T = (1.0f + sqrtf(5.0f)) / 2.0f;
+    const float BaseVertices[12][3] = {
+        { -1.0f, T, 0.0f }, { 1.0f, T, 0.0f }, { -1.0f, -T, 0.0f }, { 1.0f, -T, 0.0f },
+        { 0.0f, -1.0f, T }, { 0.0f, 1.0f, T }, { 0.0f, -1.0f, -T }, { 0.0f, 1.0f, -T },
+        { T, 0.0f, -1.0f }, { T, 0.0f, 1.0f }, { -T, 0.0f, -1.0f }, { -T, 0.0f, 1.0f },
+    };
+    // Clockwise seen from outside, neighbouring faces follow each other
+    const uint32_t BaseFaces[20][3] = {
+        { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+        { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+    };
+    for (const float* pVertex : BaseVertices)
+    {
+        builder.AddVertex(pVertex);
+    }
+    for (const uint32_t* pFace : BaseFaces)
+    {
+        builder.Subdivide(pFace[0], pFace[1], pFace[2], subdivisions);
+    }
+    writer.Finish();
+}
+
+size_t GetCubeIndexCount(uint32_t segments)
+{
+    segments = std::max(segments, 1u);
+    return 6 * size_t(segments) * segments * 6;
+}
+
+void GenerateCube(float halfExtent, uint32_t segments, const MeshOptions& options, MeshData& mesh)
+{
+    segments = std::max(segments, 1u);
+    MeshWriter writer(mesh, 6 * size_t(segments + 1) * (segments + 1), GetCubeIndexCount(segments), options);
+
+    // Texture v runs down each face as seen from outside, the right axis follows from the winding
+    const float Normals[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    const float Downs[6][3] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+    for (int face = 0; face < 6; face++)
+    {
+        const float* normal = Normals[face];
+        const float* down = Downs[face];
+        float right[3];
+        Cross(down, normal, right);
+
+        uint32_t base = writer.GetVertexCount();
+        for (uint32_t row = 0; row <= segments; row++)
+        {
+            float y = -1.0f + 2.0f * row / segments;
+            for (uint32_t column = 0; column <= segments; column++)
+            {
+                float x = -1.0f + 2.0f * column / segments;
+                float position[3];
+                for (int i = 0; i < 3; i++)
+                {
+                    position[i] = (normal[i] + right[i] * x + down[i] * y) * halfExtent;
+                }
+                writer.AddVertex(position, normal, right, float(column) / segments, float(row) / segments);
+            }
+        }
+        writer.AddGrid(base, segments, segments, false, false);
+    }
+    writer.Finish();
+}
+
+size_t GetPlaneIndexCount(uint32_t xSegments, uint32_t zSegments)
+{
+    return size_t(std::max(xSegments, 1u)) * std::max(zSegments, 1u) * 6;
+}
+
+void GeneratePlane(float width, float depth, uint32_t xSegments, uint32_t zSegments, const MeshOptions& options, MeshData& mesh)
+{
+    xSegments = std::max(xSegments, 1u);
+    zSegments = std::max(zSegments, 1u);
+    MeshWriter writer(mesh, size_t(xSegments + 1) * (zSegments + 1), GetPlaneIndexCount(xSegments, zSegments), options);
+
+    // Seen from above, rows run towards -z
+    const float Normal[3] = { 0.0f, 1.0f, 0.0f };
+    const float Tangent[3] = { 1.0f, 0.0f, 0.0f };
+    for (uint32_t row = 0; row <= zSegments; row++)
+    {
+        float v = float(row) / zSegments;
+        for (uint32_t column = 0; column <= xSegments; column++)
+        {
+            float u = float(column) / xSegments;
+            float position[3] = { (u - 0.5f) * width, 0.0f, (0.5f - v) * depth };
+            writer.AddVertex(position, Normal, Tangent, u, v);
+        }
+    }
+    writer.AddGrid(0, xSegments, zSegments, false, false);
+    writer.Finish();
+}
+
+size_t GetCylinderIndexCount(uint32_t slices, uint32_t stacks)
+{
+    slices = std::max(slices, 3u);
+    stacks = std::max(stacks, 1u);
+    return size_t(slices) * stacks * 6 + 2 * size_t(slices) * 3;
+}
+
+void GenerateCylinder(float radius, float height, uint32_t slices, uint32_t stacks, const MeshOptions& options, MeshData& mesh)
+{
+    slices = std::max(slices, 3u);
+    stacks = std::max(stacks, 1u);
+    size_t sideVertexCount = size_t(slices + 1) * (stacks + 1);
+    size_t capVertexCount = 1 + slices + 1;
+    MeshWriter writer(mesh, sideVertexCount + 2 * capVertexCount, GetCylinderIndexCount(slices, stacks), options);
+
+    for (uint32_t stack = 0; stack <= stacks; stack++)
+    {
+        float y = height * (0.5f - float(stack) / stacks);
+        for (uint32_t slice = 0; slice <= slices; slice++)
+        {
+            float alpha = 2.0f * Pi * slice / slices;
+            float normal[3] = { cosf(alpha), 0.0f, sinf(alpha) };
+            float position[3] = { normal[0] * radius, y, normal[2] * radius };
+            float tangent[3] = { -sinf(alpha), 0.0f, cosf(alpha) };
+            writer.AddVertex(position, normal, tangent, float(slice) / slices, float(stack) / stacks);
+        }
+    }
+    writer.AddGrid(0, slices, stacks, false, false);
+
+    // Fans around a center vertex, with their own normals for a hard edge
+    for (int cap = 0; cap < 2; cap++)
+    {
+        float direction = cap == 0 ? 1.0f : -1.0f;
+        float normal[3] = { 0.0f, direction, 0.0f };
+        float tangent[3] = { 1.0f, 0.0f, 0.0f };
+        float center[3] = { 0.0f, height * 0.5f * direction, 0.0f };
+        uint32_t centerIndex = writer.AddVertex(center, normal, tangent, 0.5f, 0.5f);
+        for (uint32_t slice = 0; slice <= slices; slice++)
+        {
+            float alpha = 2.0f * Pi * slice / slices;
+            float position[3] = { cosf(alpha) * radius, center[1], sinf(alpha) * radius };
+            writer.AddVertex(position, normal, tangent, 0.5f + 0.5f * cosf(alpha), 0.5f - 0.5f * direction * sinf(alpha));
+        }
+        for (uint32_t slice = 0; slice < slices; slice++)
+        {
+            uint32_t ring = centerIndex + 1 + slice;
+            if (cap == 0)
+            {
+                writer.AddTriangle(centerIndex, ring + 1, ring);
+            }
+            else
+            {
+                writer.AddTriangle(centerIndex, ring, ring + 1);
+            }
+        }
+    }
+    writer.Finish();
+}
+
+size_t GetTorusIndexCount(uint32_t majorSegments, uint32_t minorSegments)
+{
+    return size_t(std::max(majorSegments, 3u)) * std::max(minorSegments, 3u) * 6;
+}
+
+void GenerateTorus(float majorRadius, float minorRadius, uint32_t majorSegments, uint32_t minorSegments, const MeshOptions& options, MeshData& mesh)
+{
+    majorSegments = std::max(majorSegments, 3u);
+    minorSegments = std::max(minorSegments, 3u);
+    MeshWriter writer(mesh, size_t(majorSegments + 1) * (minorSegments + 1), GetTorusIndexCount(majorSegments, minorSegments), options);
+
+    // Rows go around the tube starting at the top, columns around the y axis
+    for (uint32_t minor = 0; minor <= minorSegments; minor++)
+    {
+        float phi = 2.0f * Pi * minor / minorSegments;
+        for (uint32_t major = 0; major <= majorSegments; major++)
+        {
+            float theta = 2.0f * Pi * major / majorSegments;
+            float normal[3] = { sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta) };
+            float position[3] = {
+                majorRadius * cosf(theta) + minorRadius * normal[0],
+                minorRadius * normal[1],
+                majorRadius * sinf(theta) + minorRadius * normal[2] };
+            float tangent[3] = { -sinf(theta), 0.0f, cosf(theta) };
+            writer.AddVertex(position, normal, tangent, float(major) / majorSegments, float(minor) / minorSegments);
+        }
+    }
+    writer.AddGrid(0, majorSegments, minorSegments, false, false);
+    writer.Finish();
+}
+
+void ComputeMeshBounds(MeshData& mesh)
+{
+    MeshBounds& bounds = mesh.bounds;
+    bounds = MeshBounds();
+    const float* pPositions = mesh.positions.data();
+    size_t vertexCount = mesh.GetVertexCount();
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            float value = pPositions[vertex * 3 + i];
+            bounds.min[i] = vertex == 0 ? value : std::min(bounds.min[i], value);
+            bounds.max[i] = vertex == 0 ? value : std::max(bounds.max[i], value);
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        bounds.center[i] = (bounds.min[i] + bounds.max[i]) * 0.5f;
+    }
+    float radiusSq = 0.0f;
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        float dx = pPositions[vertex * 3] - bounds.center[0];
+        float dy = pPositions[vertex * 3 + 1] - bounds.center[1];
+        float dz = pPositions[vertex * 3 + 2] - bounds.center[2];
+        radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+    }
+    bounds.radius = sqrtf(radiusSq);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshOptions
+{
+    bool normals = true;
+    // xyz along increasing u, w is the sign of the bitangent
+    bool tangents = false;
+    // Winding and normals face inwards, for meshes seen from inside like the skybox
+    bool insideOut = false;
+    // Post-transform cache size the triangle order is laid out for, 0 keeps plain scan order
+    uint32_t cacheSize = 16;
+};
+
+struct MeshBounds
+{
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+    // Sphere around the center of the box
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+};
+
+// Vertex attributes in separate streams, so a renderer uploads only what its layout uses.
+// Front faces are clockwise, as with the default D3D rasterizer state.
+struct MeshData
+{
+    // xyz
+    std::vector<float> positions;
+    // xyz, empty unless requested
+    std::vector<float> normals;
+    // xyzw, empty unless requested
+    std::vector<float> tangents;
+    // uv
+    std::vector<float> uvs;
+    std::vector<uint32_t> indices;
+    MeshBounds bounds;
+
+    size_t GetVertexCount() const { return positions.size() / 3; }
+    size_t GetIndexCount() const { return indices.size(); }
+};
+
+// All generators size the streams once from the exact counts and fill them in place.
+// Poles of the UV sphere are a vertex per slice, so the seams can carry distinct texture coordinates.
+void GenerateUvSphere(float radius, uint32_t slices, uint32_t stacks, const MeshOptions& options, MeshData& mesh);
+// Subdivided icosahedron, every level splits each triangle into four
+void GenerateIcosphere(float radius, uint32_t subdivisions, const MeshOptions& options, MeshData& mesh);
+// Axis aligned cube centered at the origin, every face split into segments x segments quads
+void GenerateCube(float halfExtent, uint32_t segments, const MeshOptions& options, MeshData& mesh);
+// Plane in xz facing +y
+void GeneratePlane(float width, float depth, uint32_t xSegments, uint32_t zSegments, const MeshOptions& options, MeshData& mesh);
+// Cylinder along y centered at the origin, closed with caps
+void GenerateCylinder(float radius, float height, uint32_t slices, uint32_t stacks, const MeshOptions& options, MeshData& mesh);
+// Torus around y
+void GenerateTorus(float majorRadius, float minorRadius, uint32_t majorSegments, uint32_t minorSegments, const MeshOptions& options, MeshData& mesh);
+
+// Index counts the generators produce, e.g. for draw calls without keeping the mesh around
+size_t GetUvSphereIndexCount(uint32_t slices, uint32_t stacks);
+size_t GetIcosphereIndexCount(uint32_t subdivisions);
+size_t GetCubeIndexCount(uint32_t segments);
+size_t GetPlaneIndexCount(uint32_t xSegments, uint32_t zSegments);
+size_t GetCylinderIndexCount(uint32_t slices, uint32_t stacks);
+size_t GetTorusIndexCount(uint32_t majorSegments, uint32_t minorSegments);
+
+// Box and sphere around the positions, the generators call it themselves
+void ComputeMeshBounds(MeshData& mesh);
@@ -0,0 +1,256 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    const size_t ChunkSize = 4096;
+    const size_t MaxChunks = 1024;
+}
+
+// Single writer buffer of a thread or virtual track. Chunks are never moved or freed during a capture,
+// so the exporter can read everything below the published count.
+struct Profiler::Track
+{
+    // Thread id of the track in the trace
+    uint32_t id = 0;
+    std::string name;
+    std::unique_ptr<Profiler::Zone[]> chunks[MaxChunks];
+    std::atomic<size_t> count;
+    std::atomic<size_t> dropped;
+
+    Track() : count(0), dropped(0) { }
+
+    void Push(const Profiler::Zone& zone)
+    {
+        size_t idx = count.load(std::memory_order_relaxed);
+        size_t chunkIdx = idx / ChunkSize;
+        if (chunkIdx >= MaxChunks)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!chunks[chunkIdx])
+        {
+            chunks[chunkIdx].reset(new Profiler::Zone[ChunkSize]);
+        }
+        chunks[chunkIdx][idx % ChunkSize] = zone;
+        count.store(idx + 1, std::memory_order_release);
+    }
+};
+
+namespace
+{
+    typedef Profiler::Track ZoneBuffer;
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ZoneBuffer>> buffers;
+        std::atomic<uint32_t> nextTrack;
+        std::atomic<bool> isCapturing;
+        std::atomic<uint64_t> captureStart;
+
+        Registry() : nextTrack(1), isCapturing(false), captureStart(0) { }
+
+        std::shared_ptr<ZoneBuffer> CreateBuffer(const char* name)
+        {
+            std::shared_ptr<ZoneBuffer> pBuffer = std::make_shared<ZoneBuffer>();
+            pBuffer->id = nextTrack.fetch_add(1);
+            pBuffer->name = name;
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(pBuffer);
+            return pBuffer;
+        }
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    struct ThreadBuffer
+    {
+        std::shared_ptr<ZoneBuffer> pRegistered;
+        // The registered buffer, except while MeasureZoneOverhead records to its own
+        ZoneBuffer* pCurrent;
+
+        ThreadBuffer() : pRegistered(GetRegistry().CreateBuffer("Thread")), pCurrent(pRegistered.get()) { }
+    };
+
+    // Registration takes the lock once per thread, recording never does
+    ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    void WriteEscaped(FILE* pFile, const char* str)
+    {
+        for (; *str != '\0'; str++)
+        {
+            if (*str == '"' || *str == '\\')
+            {
+                fputc('\\', pFile);
+            }
+            fputc(*str, pFile);
+        }
+    }
+}
+
+uint64_t Profiler::Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::BeginCapture()
+{
+    Registry& registry = GetRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (std::shared_ptr<ZoneBuffer>& pBuffer : registry.buffers)
+        {
+            pBuffer->count.store(0, std::memory_order_relaxed);
+            pBuffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    registry.captureStart = Now();
+    registry.isCapturing.store(true, std::memory_order_release);
+}
+
+void Profiler::EndCapture()
+{
+    GetRegistry().isCapturing.store(false, std::memory_order_release);
+}
+
+bool Profiler::IsCapturing()
+{
+    return GetRegistry().isCapturing.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ZoneBuffer& buffer = *GetThreadBuffer().pRegistered;
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    buffer.name = name;
+}
+
+void Profiler::RecordZone(const char* name, uint64_t start, uint64_t end)
+{
+    Zone zone = { name, start, end };
+    GetThreadBuffer().pCurrent->Push(zone);
+}
+
+Profiler::Track* Profiler::CreateTrack(const char* name)
+{
+    // The registry keeps the track alive
+    return GetRegistry().CreateBuffer(name).get();
+}
+
+void Profiler::RecordTrackZone(Track* pTrack, const char* name, uint64_t start, uint64_t end)
+{
+    Zone zone = { name, start, end };
+    pTrack->Push(zone);
+}
+
+bool Profiler::WriteChromeTrace(const std::wstring& path)
+{
+    FILE* pFile = nullptr;
+#ifdef _WIN32
+    _wfopen_s(&pFile, path.c_str(), L"w");
+#else
+    std::string mbPath(path.begin(), path.end());
+    pFile = fopen(mbPath.c_str(), "w");
+#endif
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    Registry& registry = GetRegistry();
+    std::vector<std::shared_ptr<ZoneBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffers = registry.buffers;
+    }
+    uint64_t origin = registry.captureStart;
+
+    fprintf(pFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const std::shared_ptr<ZoneBuffer>& pBuffer : buffers)
+    {
+        fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", pBuffer->id);
+        WriteEscaped(pFile, pBuffer->name.c_str());
+        fprintf(pFile, "\"}}");
+        first = false;
+
+        size_t count = pBuffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            const Zone& zone = pBuffer->chunks[i / ChunkSize][i % ChunkSize];
+            if (zone.start < origin)
+            {
+                continue;
+            }
+            fprintf(pFile, ",\n{\"name\":\"");
+            WriteEscaped(pFile, zone.name);
+            fprintf(pFile, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", pBuffer->id,
+                (zone.start - origin) / 1000.0, (zone.end - zone.start) / 1000.0);
+        }
+    }
+    fprintf(pFile, "\n]}\n");
+
+    bool result = ferror(pFile) == 0;
+    fclose(pFile);
+    return result;
+}
+
+double Profiler::MeasureZoneOverhead(size_t iterations)
+{
+    if (iterations == 0)
+    {
+        return 0.0;
+    }
+
+    // Rewound after every chunk, so a single chunk is ever allocated and it is freed on return
+    std::unique_ptr<ZoneBuffer> pBuffer(new ZoneBuffer());
+    ThreadBuffer& threadBuffer = GetThreadBuffer();
+    threadBuffer.pCurrent = pBuffer.get();
+
+    // The first chunk warms up the buffer so chunk allocation is not part of the measurement
+    uint64_t elapsed = 0;
+    size_t remaining = iterations;
+    bool isWarmUp = true;
+    while (remaining > 0)
+    {
+        size_t count = isWarmUp ? ChunkSize : std::min(remaining, ChunkSize);
+        pBuffer->count.store(0, std::memory_order_relaxed);
+
+        // What a ScopedZone does while capturing
+        uint64_t start = Now();
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t zoneStart = Now();
+            RecordZone("Overhead", zoneStart, Now());
+        }
+        uint64_t end = Now();
+
+        if (!isWarmUp)
+        {
+            elapsed += end - start;
+            remaining -= count;
+        }
+        isWarmUp = false;
+    }
+
+    threadBuffer.pCurrent = threadBuffer.pRegistered.get();
+    return static_cast<double>(elapsed) / iterations;
+}
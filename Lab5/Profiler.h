@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Define ENABLE_PROFILER to 0 to compile all zones out
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+// Low overhead CPU profiler. Every thread appends zones to its own buffer without locking,
+// buffers are merged only when the capture is exported as a Chrome trace / Perfetto JSON file.
+class Profiler
+{
+public:
+    struct Zone
+    {
+        // Zone names must be string literals or otherwise outlive the capture
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // Nanoseconds on the steady clock
+    static uint64_t Now();
+
+    static void BeginCapture();
+    static void EndCapture();
+    static bool IsCapturing();
+
+    // Name shown for the calling thread in the trace
+    static void SetThreadName(const char* name);
+
+    static void RecordZone(const char* name, uint64_t start, uint64_t end);
+
+    // Virtual track for zones that are not timed by the thread recording them, e.g. GPU timings resolved later.
+    // A track lives until the process exits and, like a thread buffer, must only be recorded to by one thread.
+    struct Track;
+    static Track* CreateTrack(const char* name);
+    static void RecordTrackZone(Track* pTrack, const char* name, uint64_t start, uint64_t end);
+
+    static bool WriteChromeTrace(const std::wstring& path);
+
+    // Average cost of one recorded zone in nanoseconds, measured on the calling thread. The zones go to a private
+    // buffer, so this works whether or not a capture is running and leaves no trace in it.
+    static double MeasureZoneOverhead(size_t iterations);
+
+    class ScopedZone
+    {
+        const char* m_name;
+        uint64_t m_start;
+
+    public:
+        explicit ScopedZone(const char* name) : m_name(name), m_start(IsCapturing() ? Now() : 0) { }
+        ~ScopedZone()
+        {
+            if (m_start != 0)
+            {
+                RecordZone(m_name, m_start, Now());
+            }
+        }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+    };
+};
+
+#if ENABLE_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) Profiler::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
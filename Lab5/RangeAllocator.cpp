@@ -0,0 +1,316 @@
+#include "RangeAllocator.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // Index of the lowest set bit, value must not be zero
+    uint32_t FindFirstSet(uint32_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return index;
+#else
+        return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+    }
+
+    // Index of the highest set bit, value must not be zero
+    uint32_t FindLastSet(uint32_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, value);
+        return index;
+#else
+        return 31 - static_cast<uint32_t>(__builtin_clz(value));
+#endif
+    }
+}
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+{
+    Reset(capacity);
+}
+
+void RangeAllocator::Reset(uint32_t capacity)
+{
+    m_blocks.clear();
+    m_firstUnused = NoBlock;
+    m_capacity = capacity;
+    m_freeSize = 0;
+    m_freeBlockCount = 0;
+    m_classBitmap = 0;
+    for (uint32_t sizeClass = 0; sizeClass < ClassCount; sizeClass++)
+    {
+        m_subclassBitmaps[sizeClass] = 0;
+        for (uint32_t subclass = 0; subclass < SubclassCount; subclass++)
+        {
+            m_freeLists[sizeClass][subclass] = NoBlock;
+        }
+    }
+
+    if (capacity > 0)
+    {
+        uint32_t index = CreateBlock();
+        m_blocks[index].size = capacity;
+        InsertFree(index);
+    }
+}
+
+RangeAllocation RangeAllocator::Allocate(uint32_t size, uint32_t alignment)
+{
+    RangeAllocation allocation;
+    alignment = alignment > 0 ? alignment : 1;
+    uint64_t paddedSize = uint64_t(size > 0 ? size : 1) + alignment - 1;
+    if (paddedSize > m_freeSize)
+    {
+        return allocation;
+    }
+    uint32_t index = FindFree(static_cast<uint32_t>(paddedSize));
+    if (index == NoBlock)
+    {
+        return allocation;
+    }
+    RemoveFree(index);
+
+    // The previous block is in use, free neighbours are always merged, so the padding becomes a block of its own
+    uint32_t padding = (alignment - m_blocks[index].offset % alignment) % alignment;
+    if (padding > 0)
+    {
+        uint32_t front = CreateBlock();
+        Block& block = m_blocks[index];
+        Block& frontBlock = m_blocks[front];
+        frontBlock.offset = block.offset;
+        frontBlock.size = padding;
+        frontBlock.previous = block.previous;
+        frontBlock.next = index;
+        if (block.previous != NoBlock)
+        {
+            m_blocks[block.previous].next = front;
+        }
+        block.previous = front;
+        block.offset += padding;
+        block.size -= padding;
+        InsertFree(front);
+    }
+
+    // So is the next one, the rest goes back as a free block
+    uint32_t blockSize = size > 0 ? size : 1;
+    if (m_blocks[index].size > blockSize)
+    {
+        uint32_t back = CreateBlock();
+        Block& block = m_blocks[index];
+        Block& backBlock = m_blocks[back];
+        backBlock.offset = block.offset + blockSize;
+        backBlock.size = block.size - blockSize;
+        backBlock.previous = index;
+        backBlock.next = block.next;
+        if (block.next != NoBlock)
+        {
+            m_blocks[block.next].previous = back;
+        }
+        block.next = back;
+        block.size = blockSize;
+        InsertFree(back);
+    }
+
+    allocation.offset = m_blocks[index].offset;
+    allocation.handle = index;
+    return allocation;
+}
+
+void RangeAllocator::Free(uint32_t handle)
+{
+    assert(handle < m_blocks.size() && !m_blocks[handle].isFree);
+    uint32_t index = handle;
+
+    uint32_t previous = m_blocks[index].previous;
+    if (previous != NoBlock && m_blocks[previous].isFree)
+    {
+        RemoveFree(previous);
+        Block& block = m_blocks[index];
+        block.offset = m_blocks[previous].offset;
+        block.size += m_blocks[previous].size;
+        block.previous = m_blocks[previous].previous;
+        if (block.previous != NoBlock)
+        {
+            m_blocks[block.previous].next = index;
+        }
+        ReleaseBlock(previous);
+    }
+
+    uint32_t next = m_blocks[index].next;
+    if (next != NoBlock && m_blocks[next].isFree)
+    {
+        RemoveFree(next);
+        Block& block = m_blocks[index];
+        block.size += m_blocks[next].size;
+        block.next = m_blocks[next].next;
+        if (block.next != NoBlock)
+        {
+            m_blocks[block.next].previous = index;
+        }
+        ReleaseBlock(next);
+    }
+
+    InsertFree(index);
+}
+
+uint32_t RangeAllocator::GetLargestFreeBlock() const
+{
+    if (m_classBitmap == 0)
+    {
+        return 0;
+    }
+    uint32_t sizeClass = FindLastSet(m_classBitmap);
+    uint32_t subclass = FindLastSet(m_subclassBitmaps[sizeClass]);
+    uint32_t largest = 0;
+    for (uint32_t index = m_freeLists[sizeClass][subclass]; index != NoBlock; index = m_blocks[index].nextFree)
+    {
+        largest = m_blocks[index].size > largest ? m_blocks[index].size : largest;
+    }
+    return largest;
+}
+
+double RangeAllocator::GetFragmentation() const
+{
+    return m_freeSize > 0 ? 1.0 - double(GetLargestFreeBlock()) / m_freeSize : 0.0;
+}
+
+void RangeAllocator::GetClass(uint32_t size, uint32_t& sizeClass, uint32_t& subclass)
+{
+    if (size < SmallSize)
+    {
+        sizeClass = 0;
+        subclass = size;
+        return;
+    }
+    uint32_t highBit = FindLastSet(size);
+    sizeClass = highBit - SubclassBits + 1;
+    subclass = (size >> (highBit - SubclassBits)) ^ SubclassCount;
+}
+
+uint32_t RangeAllocator::CreateBlock()
+{
+    uint32_t index = m_firstUnused;
+    if (index != NoBlock)
+    {
+        m_firstUnused = m_blocks[index].nextFree;
+        m_blocks[index] = Block();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_blocks.size());
+        m_blocks.emplace_back();
+    }
+    return index;
+}
+
+void RangeAllocator::ReleaseBlock(uint32_t index)
+{
+    m_blocks[index].isFree = false;
+    m_blocks[index].nextFree = m_firstUnused;
+    m_firstUnused = index;
+}
+
+void RangeAllocator::InsertFree(uint32_t index)
+{
+    Block& block = m_blocks[index];
+    uint32_t sizeClass;
+    uint32_t subclass;
+    GetClass(block.size, sizeClass, subclass);
+
+    uint32_t& head = m_freeLists[sizeClass][subclass];
+    block.isFree = true;
+    block.previousFree = NoBlock;
+    block.nextFree = head;
+    if (head != NoBlock)
+    {
+        m_blocks[head].previousFree = index;
+    }
+    head = index;
+    m_classBitmap |= 1u << sizeClass;
+    m_subclassBitmaps[sizeClass] |= 1u << subclass;
+    m_freeSize += block.size;
+    m_freeBlockCount++;
+}
+
+void RangeAllocator::RemoveFree(uint32_t index)
+{
+    Block& block = m_blocks[index];
+    uint32_t sizeClass;
+    uint32_t subclass;
+    GetClass(block.size, sizeClass, subclass);
+
+    if (block.previousFree != NoBlock)
+    {
+        m_blocks[block.previousFree].nextFree = block.nextFree;
+    }
+    else
+    {
+        m_freeLists[sizeClass][subclass] = block.nextFree;
+        if (block.nextFree == NoBlock)
+        {
+            m_subclassBitmaps[sizeClass] &= ~(1u << subclass);
+            if (m_subclassBitmaps[sizeClass] == 0)
+            {
+                m_classBitmap &= ~(1u << sizeClass);
+            }
+        }
+    }
+    if (block.nextFree != NoBlock)
+    {
+        m_blocks[block.nextFree].previousFree = block.previousFree;
+    }
+    block.isFree = false;
+    block.previousFree = NoBlock;
+    block.nextFree = NoBlock;
+    m_freeSize -= block.size;
+    m_freeBlockCount--;
+}
+
+uint32_t RangeAllocator::FindFree(uint32_t size) const
+{
+    // Rounded up to the next subclass boundary, so every block of the class found is large enough
+    uint32_t roundedSize = size;
+    if (size >= SmallSize)
+    {
+        uint64_t rounded = uint64_t(size) + (1u << (FindLastSet(size) - SubclassBits)) - 1;
+        roundedSize = rounded <= UINT32_MAX ? static_cast<uint32_t>(rounded) : UINT32_MAX;
+    }
+    uint32_t sizeClass;
+    uint32_t subclass;
+    GetClass(roundedSize, sizeClass, subclass);
+
+    uint32_t subclassBits = m_subclassBitmaps[sizeClass] & (~0u << subclass);
+    if (subclassBits == 0)
+    {
+        uint32_t classBits = sizeClass + 1 < ClassCount ? m_classBitmap & (~0u << (sizeClass + 1)) : 0;
+        if (classBits != 0)
+        {
+            sizeClass = FindFirstSet(classBits);
+            subclassBits = m_subclassBitmaps[sizeClass];
+        }
+    }
+    if (subclassBits != 0)
+    {
+        return m_freeLists[sizeClass][FindFirstSet(subclassBits)];
+    }
+
+    // Near full, the subclass of the size itself may still hold a block that fits
+    GetClass(size, sizeClass, subclass);
+    for (uint32_t index = m_freeLists[sizeClass][subclass]; index != NoBlock; index = m_blocks[index].nextFree)
+    {
+        if (m_blocks[index].size >= size)
+        {
+            return index;
+        }
+    }
+    return NoBlock;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RangeAllocation
+{
+    static const uint32_t InvalidHandle = UINT32_MAX;
+
+    uint32_t offset = 0;
+    // Passed back to Free, InvalidHandle if the allocation failed
+    uint32_t handle = InvalidHandle;
+
+    bool IsValid() const { return handle != InvalidHandle; }
+};
+
+// Hands out ranges of a fixed size address space, like the vertices of a large buffer, without touching the memory
+// itself. Two-level segregated fit: free blocks are kept in lists by size class, the first level a power of two and
+// the second splitting it into SubclassCount steps, with a bitmap of the non-empty lists at both levels. Allocation
+// and freeing take a constant number of steps, neighbouring free blocks are always merged, and a request is served
+// from a class whose smallest block fits, so it never walks a list. Units are up to the caller.
+class RangeAllocator
+{
+public:
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    // Forgets every allocation, the handles become invalid
+    void Reset(uint32_t capacity);
+
+    // Offset is a multiple of the alignment, which does not have to be a power of two, so vertex ranges can be
+    // aligned to their stride. Fails if no free block has room for the size plus alignment padding.
+    RangeAllocation Allocate(uint32_t size, uint32_t alignment = 1);
+    void Free(uint32_t handle);
+
+    uint32_t GetCapacity() const { return m_capacity; }
+    uint32_t GetFreeSize() const { return m_freeSize; }
+    uint32_t GetFreeBlockCount() const { return m_freeBlockCount; }
+    // Walks the largest non-empty size class, not for hot paths
+    uint32_t GetLargestFreeBlock() const;
+    // 1 - largest free block / free size: how much of the free space is unusable for one large allocation
+    double GetFragmentation() const;
+
+private:
+    static const uint32_t SubclassBits = 4;
+    static const uint32_t SubclassCount = 1 << SubclassBits;
+    // Sizes below this all land in the first class, one unit per subclass
+    static const uint32_t SmallSize = SubclassCount;
+    static const uint32_t ClassCount = 32 - SubclassBits + 1;
+    static const uint32_t NoBlock = UINT32_MAX;
+
+    struct Block
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        // Neighbours in the address space
+        uint32_t previous = NoBlock;
+        uint32_t next = NoBlock;
+        // Neighbours in the free list of the size class, or the next unused record
+        uint32_t previousFree = NoBlock;
+        uint32_t nextFree = NoBlock;
+        bool isFree = false;
+    };
+
+    static void GetClass(uint32_t size, uint32_t& sizeClass, uint32_t& subclass);
+    uint32_t CreateBlock();
+    void ReleaseBlock(uint32_t index);
+    void InsertFree(uint32_t index);
+    void RemoveFree(uint32_t index);
+    uint32_t FindFree(uint32_t size) const;
+
+    std::vector<Block> m_blocks;
+    uint32_t m_firstUnused = NoBlock;
+    uint32_t m_capacity = 0;
+    uint32_t m_freeSize = 0;
+    uint32_t m_freeBlockCount = 0;
+
+    uint32_t m_classBitmap = 0;
+    uint32_t m_subclassBitmaps[ClassCount] = {};
+    uint32_t m_freeLists[ClassCount][SubclassCount];
+};
@@ -0,0 +1,127 @@
+#include "RenderStats.h"
+
+#include <cassert>
+
+PassStats& PassStats::operator+=(const PassStats& other)
+{
+    drawCalls += other.drawCalls;
+    primitives += other.primitives;
+    bufferUpdates += other.bufferUpdates;
+    bytesUploaded += other.bytesUploaded;
+    shaderBinds += other.shaderBinds;
+    stateBinds += other.stateBinds;
+    resourceBinds += other.resourceBinds;
+    culledObjects += other.culledObjects;
+    cpuTime += other.cpuTime;
+    return *this;
+}
+
+PassStats RenderStats::GetTotal() const
+{
+    PassStats total = frame;
+    for (const PassStats& pass : passes)
+    {
+        total += pass;
+    }
+    return total;
+}
+
+void RenderStatsHistory::Push(const RenderStats& stats)
+{
+    m_frames[m_count % HistorySize] = stats;
+    m_count++;
+}
+
+void RenderStatsHistory::Clear()
+{
+    m_count = 0;
+}
+
+const RenderStats& RenderStatsHistory::GetFrame(size_t age) const
+{
+    assert(age < GetCount());
+    return m_frames[(m_count - 1 - age) % HistorySize];
+}
+
+namespace
+{
+    // Divides the accumulated counters, rounding to the nearest value
+    void DividePassStats(PassStats& stats, size_t count)
+    {
+        uint64_t half = count / 2;
+        stats.drawCalls = static_cast<uint32_t>((stats.drawCalls + half) / count);
+        stats.primitives = (stats.primitives + half) / count;
+        stats.bufferUpdates = static_cast<uint32_t>((stats.bufferUpdates + half) / count);
+        stats.bytesUploaded = (stats.bytesUploaded + half) / count;
+        stats.shaderBinds = static_cast<uint32_t>((stats.shaderBinds + half) / count);
+        stats.stateBinds = static_cast<uint32_t>((stats.stateBinds + half) / count);
+        stats.resourceBinds = static_cast<uint32_t>((stats.resourceBinds + half) / count);
+        stats.culledObjects = static_cast<uint32_t>((stats.culledObjects + half) / count);
+        stats.cpuTime /= count;
+    }
+
+    void WritePassStatsJson(FILE* pFile, const PassStats& stats)
+    {
+        fprintf(pFile, "{ \"drawCalls\": %u, \"primitives\": %llu, \"bufferUpdates\": %u, \"bytesUploaded\": %llu, "
+            "\"shaderBinds\": %u, \"stateBinds\": %u, \"resourceBinds\": %u, \"culledObjects\": %u, \"cpuTimeMs\": %.4f }",
+            stats.drawCalls, static_cast<unsigned long long>(stats.primitives), stats.bufferUpdates,
+            static_cast<unsigned long long>(stats.bytesUploaded), stats.shaderBinds, stats.stateBinds,
+            stats.resourceBinds, stats.culledObjects, stats.cpuTime * 1000.0);
+    }
+}
+
+RenderStats RenderStatsHistory::GetAverage() const
+{
+    RenderStats average;
+    size_t count = GetCount();
+    if (count == 0)
+    {
+        return average;
+    }
+
+    // Sums of a few hundred frames fit the 32-bit counters of a single frame comfortably
+    for (size_t age = 0; age < count; age++)
+    {
+        const RenderStats& stats = GetFrame(age);
+        average.frame += stats.frame;
+        for (size_t passIdx = 0; passIdx < RenderStats::PassCount; passIdx++)
+        {
+            average.passes[passIdx] += stats.passes[passIdx];
+        }
+    }
+
+    DividePassStats(average.frame, count);
+    for (PassStats& pass : average.passes)
+    {
+        DividePassStats(pass, count);
+    }
+    return average;
+}
+
+bool RenderStatsHistory::WriteJson(FILE* pFile) const
+{
+    size_t count = GetCount();
+    fprintf(pFile, "[\n");
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(pFile, "  ");
+        WriteRenderStatsJson(pFile, GetFrame(count - 1 - i), "  ");
+        fprintf(pFile, "%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(pFile, "]\n");
+    return ferror(pFile) == 0;
+}
+
+void WriteRenderStatsJson(FILE* pFile, const RenderStats& stats, const char* indent)
+{
+    fprintf(pFile, "{\n%s  \"frame\": ", indent);
+    WritePassStatsJson(pFile, stats.frame);
+    fprintf(pFile, ",\n%s  \"total\": ", indent);
+    WritePassStatsJson(pFile, stats.GetTotal());
+    for (size_t passIdx = 0; passIdx < RenderStats::PassCount; passIdx++)
+    {
+        fprintf(pFile, ",\n%s  \"%s\": ", indent, GetRenderPassName(static_cast<RENDER_PASS>(passIdx)));
+        WritePassStatsJson(pFile, stats.passes[passIdx]);
+    }
+    fprintf(pFile, "\n%s}", indent);
+}
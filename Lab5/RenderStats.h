@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+enum class RENDER_PASS
+{
+    OPAQUE_OBJECTS,
+    SKYBOX,
+    TRANSPARENT_OBJECTS,
+    COUNT
+};
+
+inline const char* GetRenderPassName(RENDER_PASS pass)
+{
+    switch (pass)
+    {
+    case RENDER_PASS::OPAQUE_OBJECTS:
+        return "opaque";
+    case RENDER_PASS::SKYBOX:
+        return "skybox";
+    case RENDER_PASS::TRANSPARENT_OBJECTS:
+        return "transparent";
+    default:
+        return "unknown";
+    }
+}
+
+// Counters are plain increments next to the API calls they describe, cheap enough to stay on in release builds
+struct PassStats
+{
+    uint32_t drawCalls = 0;
+    uint64_t primitives = 0;
+    // UpdateSubresource and Map calls and the bytes written through them
+    uint32_t bufferUpdates = 0;
+    uint64_t bytesUploaded = 0;
+    uint32_t shaderBinds = 0;
+    // Depth, blend, rasterizer states, input layouts and topology
+    uint32_t stateBinds = 0;
+    // Textures, samplers, vertex, index and constant buffers
+    uint32_t resourceBinds = 0;
+    // Objects, and meshlets of the model, skipped by frustum or cone culling
+    uint32_t culledObjects = 0;
+    // Seconds of CPU time spent recording the pass
+    double cpuTime = 0.0;
+
+    void CountDraw(uint32_t indexCount)
+    {
+        drawCalls++;
+        primitives += indexCount / 3;
+    }
+
+    void CountUpload(size_t bytes)
+    {
+        bufferUpdates++;
+        bytesUploaded += bytes;
+    }
+
+    PassStats& operator+=(const PassStats& other);
+};
+
+struct RenderStats
+{
+    static const size_t PassCount = static_cast<size_t>(RENDER_PASS::COUNT);
+
+    PassStats passes[PassCount];
+    // Uploads and work done outside of any pass (per-view constants, present)
+    PassStats frame;
+
+    void Reset()
+    {
+        *this = RenderStats();
+    }
+
+    PassStats& operator[](RENDER_PASS pass) { return passes[static_cast<size_t>(pass)]; }
+    const PassStats& operator[](RENDER_PASS pass) const { return passes[static_cast<size_t>(pass)]; }
+
+    // Sum of all passes and the frame level work
+    PassStats GetTotal() const;
+};
+
+// Keeps the stats of the most recent frames for the overlay and dumps
+class RenderStatsHistory
+{
+public:
+    static const size_t HistorySize = 240;
+
+    void Push(const RenderStats& stats);
+    void Clear();
+
+    size_t GetCount() const { return m_count < HistorySize ? m_count : HistorySize; }
+    // Zero is the most recent frame
+    const RenderStats& GetFrame(size_t age) const;
+    // Per-frame average over the history
+    RenderStats GetAverage() const;
+
+    // Frames from the oldest to the most recent as a JSON array
+    bool WriteJson(FILE* pFile) const;
+
+private:
+    RenderStats m_frames[HistorySize];
+    size_t m_count = 0;
+};
+
+// Writes a single frame as a JSON object, passes are keyed by GetRenderPassName
+void WriteRenderStatsJson(FILE* pFile, const RenderStats& stats, const char* indent);
@@ -0,0 +1,176 @@
+#include "RenderThread.h"
+#include "Profiler.h"
+
+namespace
+{
+    const uint64_t PendingResizeBit = 1ull << 63;
+}
+
+RenderThread::RenderThread(Renderer* pRenderer, HWND hWnd)
+    : m_pRenderer(pRenderer)
+    , m_hWnd(hWnd)
+    , m_isRunning(false)
+    , m_stopRequested(false)
+    , m_pendingResize(0)
+    , m_framesPerSecond(0.0f)
+    , m_p50FrameTime(0.0f)
+    , m_p99FrameTime(0.0f)
+    , m_renderedFrames(0)
+{
+    m_hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    assert(m_hWakeEvent != NULL);
+}
+
+RenderThread::~RenderThread()
+{
+    Stop();
+    CloseHandle(m_hWakeEvent);
+}
+
+bool RenderThread::Start()
+{
+    if (m_isRunning || !m_pRenderer->IsRunning())
+    {
+        return false;
+    }
+
+    m_stopRequested = false;
+    m_isRunning = true;
+    m_thread = std::thread(&RenderThread::Run, this);
+    return true;
+}
+
+void RenderThread::Stop()
+{
+    m_stopRequested = true;
+    SetEvent(m_hWakeEvent);
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    m_isRunning = false;
+}
+
+bool RenderThread::PostCommand(const RenderCommand& command)
+{
+    bool result = true;
+    if (command.type == RenderCommand::TYPE::RESIZE)
+    {
+        m_pendingResize = PendingResizeBit | static_cast<uint64_t>(command.width) << 32 | command.height;
+    }
+    else
+    {
+        result = m_commands.Push(command);
+    }
+    SetEvent(m_hWakeEvent);
+    return result;
+}
+
+void RenderThread::PublishSnapshot()
+{
+    m_snapshots.Publish();
+    SetEvent(m_hWakeEvent);
+}
+
+void RenderThread::GetFrameStats(FrameStats& stats) const
+{
+    stats.framesPerSecond = m_framesPerSecond;
+    stats.p50FrameTime = m_p50FrameTime;
+    stats.p99FrameTime = m_p99FrameTime;
+}
+
+bool RenderThread::ProcessCommands()
+{
+    uint64_t resize = m_pendingResize.exchange(0);
+    if (resize != 0)
+    {
+        if (!m_pRenderer->Resize(static_cast<UINT>(resize >> 32 & 0x7FFFFFFF), static_cast<UINT>(resize & 0xFFFFFFFF)))
+        {
+            return false;
+        }
+        m_forceRender = true;
+    }
+
+    RenderCommand command;
+    while (m_commands.Pop(command))
+    {
+        switch (command.type)
+        {
+        case RenderCommand::TYPE::TOGGLE_STATS_OVERLAY:
+            m_pRenderer->SetStatsOverlayVisible(!m_pRenderer->IsStatsOverlayVisible());
+            m_forceRender = true;
+            break;
+        case RenderCommand::TYPE::TOGGLE_TRANSPARENCY_MODE:
+            m_pRenderer->SetTransparencyMode(m_pRenderer->GetTransparencyMode() == TRANSPARENCY_MODE::SORTED ?
+                TRANSPARENCY_MODE::WEIGHTED_BLENDED : TRANSPARENCY_MODE::SORTED);
+            m_forceRender = true;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+void RenderThread::Run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    PROFILE_THREAD_NAME("Render");
+
+    SceneState state;
+    bool hasSnapshot = false;
+    Clock::time_point lastStatsTime = Clock::now();
+
+    while (!m_stopRequested)
+    {
+        if (!ProcessCommands())
+        {
+            break;
+        }
+
+        hasSnapshot |= m_snapshots.Acquire();
+        if (!hasSnapshot || !m_snapshots.GetReadBuffer().NeedsRender(m_renderedVersion, m_forceRender))
+        {
+            // The frame would be identical to the one on screen, sleep until a snapshot or command arrives
+            PROFILE_SCOPE("Idle");
+            WaitForSingleObject(m_hWakeEvent, INFINITE);
+            m_pacer.Resume();
+            continue;
+        }
+
+        {
+            PROFILE_SCOPE("WaitForNextFrame");
+            m_pacer.WaitForNextFrame();
+        }
+
+        // A newer snapshot may have arrived while waiting
+        m_snapshots.Acquire();
+        const SceneSnapshot& snapshot = m_snapshots.GetReadBuffer();
+        snapshot.Interpolate(Clock::now(), state);
+
+        if (!m_pRenderer->Render(state))
+        {
+            break;
+        }
+        m_renderedVersion = snapshot.version;
+        m_forceRender = false;
+        m_renderedFrames++;
+
+        if (Clock::now() - lastStatsTime >= std::chrono::seconds(1))
+        {
+            double average = m_pacer.GetAverageFrameTime();
+            m_framesPerSecond = average > 0.0 ? static_cast<float>(1.0 / average) : 0.0f;
+            m_p50FrameTime = static_cast<float>(m_pacer.GetFrameTimePercentile(0.5));
+            m_p99FrameTime = static_cast<float>(m_pacer.GetFrameTimePercentile(0.99));
+            lastStatsTime = Clock::now();
+        }
+    }
+
+    if (!m_stopRequested)
+    {
+        // Rendering failed, let the window thread shut the application down
+        PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+    }
+    m_isRunning = false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "framework.h"
+#include "Renderer.h"
+#include "FramePacer.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+
+struct RenderCommand
+{
+    enum class TYPE
+    {
+        RESIZE,
+        TOGGLE_STATS_OVERLAY,
+        TOGGLE_TRANSPARENCY_MODE
+    };
+
+    TYPE type = TYPE::RESIZE;
+    UINT width = 0;
+    UINT height = 0;
+};
+
+struct FrameStats
+{
+    float framesPerSecond = 0.0f;
+    float p50FrameTime = 0.0f;
+    float p99FrameTime = 0.0f;
+};
+
+// Owns the thread that renders scene snapshots, so the window message pump and the simulation
+// never stall frames and vice versa. The renderer is only touched from this thread while it runs.
+class RenderThread
+{
+    Renderer* m_pRenderer = nullptr;
+    HWND m_hWnd = NULL;
+
+    std::thread m_thread;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_stopRequested;
+    // Wakes the thread up while it waits for something to change
+    HANDLE m_hWakeEvent = NULL;
+    bool m_forceRender = true;
+    uint64_t m_renderedVersion = 0;
+
+    FramePacer m_pacer;
+    SpscQueue<RenderCommand, 64> m_commands;
+    // Resizes skip the queue so a burst of them can neither fill it nor be lost to it, only the latest size counts.
+    // Holds PendingResizeBit | width << 32 | height, zero when there is none.
+    std::atomic<uint64_t> m_pendingResize;
+    TripleBuffer<SceneSnapshot> m_snapshots;
+
+    std::atomic<float> m_framesPerSecond;
+    std::atomic<float> m_p50FrameTime;
+    std::atomic<float> m_p99FrameTime;
+    std::atomic<uint64_t> m_renderedFrames;
+
+public:
+    RenderThread(Renderer* pRenderer, HWND hWnd);
+    ~RenderThread();
+
+    // Pacing has to be configured before the thread is started
+    FramePacer& GetPacer() { return m_pacer; }
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return m_isRunning; }
+
+    // Called from the window thread. Resizes always succeed and replace any resize the thread has not applied yet,
+    // other commands return false if the queue is full.
+    bool PostCommand(const RenderCommand& command);
+
+    // Called from the simulation thread
+    SceneSnapshot& BeginSnapshot() { return m_snapshots.GetWriteBuffer(); }
+    void PublishSnapshot();
+
+    void GetFrameStats(FrameStats& stats) const;
+    // Frames skipped because they would be identical to the previous one are not counted
+    uint64_t GetRenderedFrameCount() const { return m_renderedFrames; }
+
+private:
+    void Run();
+    bool ProcessCommands();
+};
@@ -1,6 +1,12 @@
 #include "Renderer.h"
 #include "utils.h"
 #include "LoadDDS.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "TransparentPass.h"
+#include "ProceduralMesh.h"
+#include "MeshImport.h"
+#include "MeshSimplifier.h"
 
 #include <algorithm>
 
@@ -21,11 +27,6 @@ struct TextureVertex
     float u, v;
 };
 
-struct Vertex
-{
-    float x, y, z;
-};
-
 
 struct SceneTransformsBuffer
 {
@@ -39,8 +40,67 @@ struct ViewTransformsBuffer
     DirectX::XMVECTOR cameraPos;
 };
 
-bool Renderer::Init(HWND hWnd)
+static const UINT MaxVertexInputElements = 3;
+
+// Per-vertex elements of the first slot for an interleaved vertex format
+static UINT GetVertexInputElements(const VertexFormat& format, D3D11_INPUT_ELEMENT_DESC* pElements)
+{
+    UINT count = 0;
+    DXGI_FORMAT positionFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+    if (format.position == POSITION_FORMAT::SNORM16)
+    {
+        positionFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+    }
+    else if (format.position == POSITION_FORMAT::HALF)
+    {
+        positionFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    }
+    pElements[count++] = { "POSITION", 0, positionFormat, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+    if (format.normal != NORMAL_FORMAT::NONE)
+    {
+        DXGI_FORMAT normalFormat = format.normal == NORMAL_FORMAT::FLOAT3 ? DXGI_FORMAT_R32G32B32_FLOAT : DXGI_FORMAT_R16G16_SNORM;
+        pElements[count++] = { "NORMAL", 0, normalFormat, 0, format.GetNormalOffset(), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+
+    if (format.uv != UV_FORMAT::NONE)
+    {
+        DXGI_FORMAT uvFormat = DXGI_FORMAT_R32G32_FLOAT;
+        if (format.uv == UV_FORMAT::UNORM16)
+        {
+            uvFormat = DXGI_FORMAT_R16G16_UNORM;
+        }
+        else if (format.uv == UV_FORMAT::HALF)
+        {
+            uvFormat = DXGI_FORMAT_R16G16_FLOAT;
+        }
+        pElements[count++] = { "TEXCOORD", 0, uvFormat, 0, format.GetUvOffset(), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+    return count;
+}
+
+static const float FieldOfView = (float)M_PI / 2;
+static const float NearZ = 0.1f;
+static const float FarZ = 100.0f;
+// A level of detail is drawn once its error covers at most this many pixels on screen
+static const float MaxLodPixelError = 1.0f;
+
+bool Renderer::InitHeadless(UINT width, UINT height, RENDER_BACKEND backend)
+{
+    if (m_isRunning)
+    {
+        return false;
+    }
+
+    m_width = max(width, 8);
+    m_height = max(height, 8);
+    return Init(NULL, backend);
+}
+
+bool Renderer::Init(HWND hWnd, RENDER_BACKEND backend)
 {
+    PROFILE_SCOPE("Renderer::Init");
+
     if (m_isRunning)
     {
         return false;
@@ -54,7 +114,7 @@ bool Renderer::Init(HWND hWnd)
 
     // Select hardware adapter
     IDXGIAdapter* pSelectedAdapter = NULL;
-    if (SUCCEEDED(result))
+    if (SUCCEEDED(result) && backend == RENDER_BACKEND::HARDWARE)
     {
         IDXGIAdapter* pAdapter = NULL;
         for (UINT adapterIdx = 0; SUCCEEDED(pFactory->EnumAdapters(adapterIdx, &pAdapter)); adapterIdx++)
@@ -71,25 +131,35 @@ bool Renderer::Init(HWND hWnd)
             pAdapter->Release();
         }
     }
-    assert(pSelectedAdapter != NULL);
+    assert(pSelectedAdapter != NULL || backend != RENDER_BACKEND::HARDWARE);
 
     // Create DirectX 11 device
     D3D_FEATURE_LEVEL level;
     D3D_FEATURE_LEVEL levels[] = { D3D_FEATURE_LEVEL_11_0 };
     if (SUCCEEDED(result))
     {
-        UINT flags = 0;
+        // Direct2D stats overlay draws into the swap chain
+        UINT flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
 #ifdef _DEBUG
         flags |= D3D11_CREATE_DEVICE_DEBUG;
 #endif // _DEBUG
-        result = D3D11CreateDevice(pSelectedAdapter, D3D_DRIVER_TYPE_UNKNOWN, NULL,
+        D3D_DRIVER_TYPE driverType = D3D_DRIVER_TYPE_UNKNOWN;
+        if (backend == RENDER_BACKEND::WARP)
+        {
+            driverType = D3D_DRIVER_TYPE_WARP;
+        }
+        else if (backend == RENDER_BACKEND::NULL_DEVICE)
+        {
+            driverType = D3D_DRIVER_TYPE_NULL;
+        }
+        result = D3D11CreateDevice(pSelectedAdapter, driverType, NULL,
             flags, levels, 1, D3D11_SDK_VERSION, &m_pDevice, &level, &m_pDeviceContext);
         assert(level == D3D_FEATURE_LEVEL_11_0);
         assert(SUCCEEDED(result));
     }
 
     // Create swapchain
-    if (SUCCEEDED(result))
+    if (SUCCEEDED(result) && hWnd != NULL)
     {
         DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
         swapChainDesc.BufferCount = 2;
@@ -162,10 +232,84 @@ bool Renderer::Init(HWND hWnd)
             result = SetResourceName(m_pTransBlendState, "TransBlendState");
         }
     }
+    if (SUCCEEDED(result))
+    {
+        // Weighted colors add up, revealage is multiplied by (1 - alpha) of every fragment
+        D3D11_BLEND_DESC desc = {};
+        desc.AlphaToCoverageEnable = FALSE;
+        desc.IndependentBlendEnable = TRUE;
+        desc.RenderTarget[0].BlendEnable = TRUE;
+        desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+        desc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+        desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+        desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+        desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+        desc.RenderTarget[1].BlendEnable = TRUE;
+        desc.RenderTarget[1].BlendOp = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[1].SrcBlend = D3D11_BLEND_ZERO;
+        desc.RenderTarget[1].DestBlend = D3D11_BLEND_INV_SRC_COLOR;
+        desc.RenderTarget[1].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[1].SrcBlendAlpha = D3D11_BLEND_ZERO;
+        desc.RenderTarget[1].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+        desc.RenderTarget[1].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_RED;
+        result = m_pDevice->CreateBlendState(&desc, &m_pOitAccumBlendState);
+
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(m_pOitAccumBlendState, "OitAccumBlendState");
+        }
+    }
+    if (SUCCEEDED(result))
+    {
+        // The composite outputs the average color and the revealage as alpha
+        D3D11_BLEND_DESC desc = {};
+        desc.AlphaToCoverageEnable = FALSE;
+        desc.IndependentBlendEnable = FALSE;
+        desc.RenderTarget[0].BlendEnable = TRUE;
+        desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[0].SrcBlend = D3D11_BLEND_INV_SRC_ALPHA;
+        desc.RenderTarget[0].DestBlend = D3D11_BLEND_SRC_ALPHA;
+        desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_RED | D3D11_COLOR_WRITE_ENABLE_GREEN | D3D11_COLOR_WRITE_ENABLE_BLUE;
+        desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+        desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+        result = m_pDevice->CreateBlendState(&desc, &m_pOitCompositeBlendState);
+
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(m_pOitCompositeBlendState, "OitCompositeBlendState");
+        }
+    }
+
+    for (UINT i = 0; i < MaxFramesInFlight && SUCCEEDED(result) && hWnd == NULL; i++)
+    {
+        D3D11_QUERY_DESC desc = {};
+        desc.Query = D3D11_QUERY_EVENT;
+        result = m_pDevice->CreateQuery(&desc, &m_pFrameQueries[i]);
+        assert(SUCCEEDED(result));
+    }
+
+    if (SUCCEEDED(result) && hWnd != NULL)
+    {
+        result = m_statsOverlay.Init();
+    }
+
+    // The null device does not execute anything to time
+    if (SUCCEEDED(result) && backend != RENDER_BACKEND::NULL_DEVICE)
+    {
+        m_pGpuQueries = new D3D11GpuQueries(m_pDevice, m_pDeviceContext);
+        if (!m_gpuProfiler.Init(m_pGpuQueries))
+        {
+            result = E_FAIL;
+        }
+    }
 
     if (SUCCEEDED(result))
     {
         result = SetupBackBuffer();
+        m_camera.SetPerspective(FieldOfView, (float)m_height / m_width, NearZ, FarZ);
     }
 
     if (SUCCEEDED(result))
@@ -173,6 +317,11 @@ bool Renderer::Init(HWND hWnd)
         result = SetupDepthBuffer();
     }
 
+    if (SUCCEEDED(result))
+    {
+        result = SetupOitTargets();
+    }
+
     if (SUCCEEDED(result))
     {
         result = InitSceneResources();
@@ -191,47 +340,14 @@ bool Renderer::Init(HWND hWnd)
 
 HRESULT Renderer::InitSceneResources()
 {
-    std::vector<Vertex> sphereVertices;
-    std::vector<USHORT> sphereIndices;
-    int hRes = 20;
-    int wRes = 10;
-    float rad = 1.2f;
-
-    for (int w = 0; w <= wRes; w++)
-    {
-        for (int h = 0; h <= hRes; h++)
-        {
-            float alpha = float(M_PI) * 2.0f * h / hRes;
-            float beta = float(M_PI) * 1.0f * w / wRes;
-            float x = rad * sinf(beta) * cosf(alpha);
-            float z = rad * sinf(beta) * sinf(alpha);
-            float y = rad * cosf(beta);
-            sphereVertices.push_back({ x, y, z });
-        }
-    }
-
-    for (int w = 0; w < wRes; w++)
-    {
-        for (int h = 0; h < hRes; h++)
-        {
-            int i = w * (hRes + 1) + h;
-            int iNext = i + (hRes + 1);
-            if (w != 0)
-            {
-                sphereIndices.push_back(iNext + 1);
-                sphereIndices.push_back(i + 1);
-                sphereIndices.push_back(i);
-            }
-            if (w + 1 != wRes)
-            {
-                sphereIndices.push_back(i);
-                sphereIndices.push_back(iNext);
-                sphereIndices.push_back(iNext + 1);
-            }
-
-        }
-    }
+    PROFILE_SCOPE("Renderer::InitSceneResources");
 
+    // Seen from inside, only the positions are used for the cubemap lookup
+    MeshOptions sphereOptions;
+    sphereOptions.normals = false;
+    sphereOptions.insideOut = true;
+    MeshData sphereMesh;
+    GenerateUvSphere(1.2f, 20, 10, sphereOptions, sphereMesh);
 
     static const TextureVertex Vertices[] = {
         {-1.0f, -1.0f, -1.0f, 0.0f, 1.0f},
@@ -287,99 +403,51 @@ HRESULT Renderer::InitSceneResources()
     };
 
 
-    HRESULT result = S_OK;
-
-    if (SUCCEEDED(result))
+    // The cube keeps its hand-authored layout, its streams are only gathered for the encoder
+    MeshData cubeMesh;
+    for (const TextureVertex& vertex : Vertices)
     {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(Vertex) * sphereVertices.size();
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
-
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = sphereVertices.data();
-        data.SysMemPitch = sizeof(Vertex) * sphereVertices.size();
-        data.SysMemSlicePitch = 0;
-
-        result = m_pDevice->CreateBuffer(&desc, &data, &m_pSphereVertexBuffer);
-        if (SUCCEEDED(result))
-        {
-            result = SetResourceName(m_pSphereVertexBuffer, "SphereVertexBuffer");
-        }
+        cubeMesh.positions.insert(cubeMesh.positions.end(), { vertex.x, vertex.y, vertex.z });
+        cubeMesh.uvs.insert(cubeMesh.uvs.end(), { vertex.u, vertex.v });
     }
-
-    if (SUCCEEDED(result))
+    cubeMesh.indices.assign(std::begin(Indices), std::end(Indices));
+    cubeMesh.bounds.radius = CubeBoundingRadius;
+    for (int i = 0; i < 3; i++)
     {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(USHORT) * sphereIndices.size();
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-        desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
-
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = sphereIndices.data();
-        data.SysMemPitch = sizeof(USHORT) * sphereIndices.size();
-        data.SysMemSlicePitch = 0;
+        cubeMesh.bounds.min[i] = -1.0f;
+        cubeMesh.bounds.max[i] = 1.0f;
+    }
 
-        result = m_pDevice->CreateBuffer(&desc, &data, &m_pSphereIndexBuffer);
-        if (SUCCEEDED(result))
-        {
-            result = SetResourceName(m_pSphereIndexBuffer, "SphereIndexBuffer");
-        }
+    VertexRequirements sphereRequirements;
+    sphereRequirements.uvs = false;
+    VertexRequirements cubeRequirements;
+    if (m_vertexPrecision == VERTEX_PRECISION::COMPACT)
+    {
+        sphereRequirements.maxPositionError = sphereMesh.bounds.radius * CompactPositionTolerance;
+        cubeRequirements.maxPositionError = cubeMesh.bounds.radius * CompactPositionTolerance;
+        cubeRequirements.maxUvError = CompactUvTolerance;
     }
 
+    m_vertexBufferBytes = 0;
+    HRESULT result = m_geometryPool.Init(m_pDevice, m_pDeviceContext);
     if (SUCCEEDED(result))
     {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(Vertices);
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
-
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = &Vertices;
-        data.SysMemPitch = sizeof(Vertices);
-        data.SysMemSlicePitch = 0;
-
-        result = m_pDevice->CreateBuffer(&desc, &data, &m_pCubeVertexBuffer);
-        if (SUCCEEDED(result))
-        {
-            result = SetResourceName(m_pCubeVertexBuffer, "CubeVertexBuffer");
-        }
+        result = CreateMeshBuffers(sphereMesh, sphereRequirements, "Sphere", m_sphereVertexFormat, m_sphereMesh, &m_pSphereDecodeBuffer);
     }
-
     if (SUCCEEDED(result))
     {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(Indices);
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-        desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
-
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = &Indices;
-        data.SysMemPitch = sizeof(Indices);
-        data.SysMemSlicePitch = 0;
+        result = CreateMeshBuffers(cubeMesh, cubeRequirements, "Cube", m_cubeVertexFormat, m_cubeMesh, &m_pCubeDecodeBuffer);
+    }
 
-        result = m_pDevice->CreateBuffer(&desc, &data, &m_pCubeIndexBuffer);
-        if (SUCCEEDED(result))
-        {
-            result = SetResourceName(m_pCubeIndexBuffer, "CubeIndexBuffer");
-        }
+    if (SUCCEEDED(result) && !m_modelPath.empty())
+    {
+        result = LoadModel();
     }
 
     TextureDesc textureDesc;
     if (SUCCEEDED(result))
     {
+        PROFILE_SCOPE("LoadKittyTexture");
         const std::wstring TextureName = L"Kitty.dds";
         bool ddsRes = LoadDDS(TextureName.c_str(), textureDesc);
         D3D11_TEXTURE2D_DESC desc = {};
@@ -453,6 +521,7 @@ HRESULT Renderer::InitSceneResources()
 
     DXGI_FORMAT textureFmt;
     if (SUCCEEDED(result)) {
+        PROFILE_SCOPE("LoadCubemapTexture");
         const std::wstring TextureNames[6] = {
             L"cubemap/posx.DDS", L"cubemap/negx.DDS",
             L"cubemap/posy.DDS", L"cubemap/negy.DDS",
@@ -550,10 +619,9 @@ HRESULT Renderer::InitSceneResources()
     ID3DBlob* pVertexShaderCode = NULL;
 
 
-    static const D3D11_INPUT_ELEMENT_DESC SimpleTextureInputDesc[] = {
-    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
+    // Layouts follow the formats chosen for the meshes above
+    D3D11_INPUT_ELEMENT_DESC cubeInputDesc[MaxVertexInputElements + 2];
+    UINT cubeInputCount = GetVertexInputElements(m_cubeVertexFormat, cubeInputDesc);
 
     if (SUCCEEDED(result))
     {
@@ -566,18 +634,24 @@ HRESULT Renderer::InitSceneResources()
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(SimpleTextureInputDesc, 2, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleTextureInputLayout);
+        result = m_pDevice->CreateInputLayout(cubeInputDesc, cubeInputCount, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleTextureInputLayout);
         if (SUCCEEDED(result))
         {
             result = SetResourceName(m_pSimpleTextureInputLayout, "SimpleTextureInputLayout");
         }
     }
+    if (SUCCEEDED(result) && m_modelMesh.IsValid())
+    {
+        D3D11_INPUT_ELEMENT_DESC modelInputDesc[MaxVertexInputElements];
+        UINT modelInputCount = GetVertexInputElements(m_modelVertexFormat, modelInputDesc);
+        result = m_pDevice->CreateInputLayout(modelInputDesc, modelInputCount, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pModelInputLayout);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(m_pModelInputLayout, "ModelInputLayout");
+        }
+    }
     SAFE_RELEASE(pVertexShaderCode);
 
-    static const D3D11_INPUT_ELEMENT_DESC SimpleTransTextureInputDesc[] = {
-    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
     if (SUCCEEDED(result))
     {
         result = CompileAndCreateShader(L"SimpleTransTexture_VS.hlsl", SHADER_TYPE::VERTEX_SHADER, (ID3D11DeviceChild**)&m_pSimpleTransTextureVertexShader, &pVertexShaderCode);
@@ -589,7 +663,7 @@ HRESULT Renderer::InitSceneResources()
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(SimpleTransTextureInputDesc, 2, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleTransTextureInputLayout);
+        result = m_pDevice->CreateInputLayout(cubeInputDesc, cubeInputCount, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleTransTextureInputLayout);
         if (SUCCEEDED(result))
         {
             result = SetResourceName(m_pSimpleTransTextureInputLayout, "SimpleTransTextureInputLayout");
@@ -598,9 +672,42 @@ HRESULT Renderer::InitSceneResources()
     SAFE_RELEASE(pVertexShaderCode);
 
 
-    static const D3D11_INPUT_ELEMENT_DESC SimpleSkyboxInputDesc[] = {
-    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
+    // Second slot holds SceneObject instances
+    static_assert(sizeof(SceneObject) == 28, "Instance layout does not match SceneObject");
+    D3D11_INPUT_ELEMENT_DESC* pInstanceInputDesc = cubeInputDesc + cubeInputCount;
+    pInstanceInputDesc[0] = { "INSTANCEPOS", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+    pInstanceInputDesc[1] = { "INSTANCECOLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 12, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+    if (SUCCEEDED(result))
+    {
+        result = CompileAndCreateShader(L"WeightedBlendedOit_VS.hlsl", SHADER_TYPE::VERTEX_SHADER, (ID3D11DeviceChild**)&m_pWeightedBlendedOitVertexShader, &pVertexShaderCode);
+    }
+    if (SUCCEEDED(result))
+    {
+        result = CompileAndCreateShader(L"WeightedBlendedOit_PS.hlsl", SHADER_TYPE::PIXEL_SHADER, (ID3D11DeviceChild**)&m_pWeightedBlendedOitPixelShader);
+    }
+
+    if (SUCCEEDED(result))
+    {
+        result = m_pDevice->CreateInputLayout(cubeInputDesc, cubeInputCount + 2, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pWeightedBlendedOitInputLayout);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(m_pWeightedBlendedOitInputLayout, "WeightedBlendedOitInputLayout");
+        }
+    }
+    SAFE_RELEASE(pVertexShaderCode);
+
+    if (SUCCEEDED(result))
+    {
+        result = CompileAndCreateShader(L"OitComposite_VS.hlsl", SHADER_TYPE::VERTEX_SHADER, (ID3D11DeviceChild**)&m_pOitCompositeVertexShader);
+    }
+    if (SUCCEEDED(result))
+    {
+        result = CompileAndCreateShader(L"OitComposite_PS.hlsl", SHADER_TYPE::PIXEL_SHADER, (ID3D11DeviceChild**)&m_pOitCompositePixelShader);
+    }
+
+
+    D3D11_INPUT_ELEMENT_DESC sphereInputDesc[MaxVertexInputElements];
+    UINT sphereInputCount = GetVertexInputElements(m_sphereVertexFormat, sphereInputDesc);
 
     if (SUCCEEDED(result))
     {
@@ -613,7 +720,7 @@ HRESULT Renderer::InitSceneResources()
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(SimpleSkyboxInputDesc, 1, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleSkyboxInputLayout);
+        result = m_pDevice->CreateInputLayout(sphereInputDesc, sphereInputCount, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pSimpleSkyboxInputLayout);
         if (SUCCEEDED(result))
         {
             result = SetResourceName(m_pSimpleSkyboxInputLayout, "SimpleSkyboxInputLayout");
@@ -624,8 +731,61 @@ HRESULT Renderer::InitSceneResources()
     return result;
 }
 
+HRESULT Renderer::CreateMeshBuffers(const MeshData& mesh, const VertexRequirements& requirements, const std::string& name,
+    VertexFormat& format, PooledMesh& pooledMesh, ID3D11Buffer** ppDecodeBuffer)
+{
+    format = ChooseVertexFormat(mesh, requirements);
+    EncodedVertices vertices;
+    EncodeVertices(mesh, format, vertices);
+
+    // 32-bit indices only where the vertex count needs them
+    HRESULT result;
+    if (mesh.GetVertexCount() <= 0x10000)
+    {
+        std::vector<USHORT> indices(mesh.indices.begin(), mesh.indices.end());
+        result = m_geometryPool.Add(vertices.data.data(), static_cast<UINT>(mesh.GetVertexCount()), format.GetStride(),
+            indices.data(), static_cast<UINT>(indices.size()), DXGI_FORMAT_R16_UINT, pooledMesh);
+    }
+    else
+    {
+        result = m_geometryPool.Add(vertices.data.data(), static_cast<UINT>(mesh.GetVertexCount()), format.GetStride(),
+            mesh.indices.data(), static_cast<UINT>(mesh.indices.size()), DXGI_FORMAT_R32_UINT, pooledMesh);
+    }
+    if (SUCCEEDED(result))
+    {
+        m_vertexBufferBytes += vertices.GetSize();
+    }
+
+    if (SUCCEEDED(result))
+    {
+        static_assert(sizeof(VertexDecode) % 16 == 0, "Constant buffers are made of float4 registers");
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = sizeof(VertexDecode);
+        desc.Usage = D3D11_USAGE_IMMUTABLE;
+        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        desc.CPUAccessFlags = 0;
+        desc.MiscFlags = 0;
+        desc.StructureByteStride = 0;
+
+        D3D11_SUBRESOURCE_DATA data;
+        data.pSysMem = &vertices.decode;
+        data.SysMemPitch = sizeof(VertexDecode);
+        data.SysMemSlicePitch = 0;
+
+        result = m_pDevice->CreateBuffer(&desc, &data, ppDecodeBuffer);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(*ppDecodeBuffer, name + "DecodeBuffer");
+        }
+    }
+
+    return result;
+}
+
 HRESULT Renderer::CompileAndCreateShader(const std::wstring& path, SHADER_TYPE type, ID3D11DeviceChild** ppShader, ID3DBlob** ppCode)
 {
+    PROFILE_SCOPE("Renderer::CompileAndCreateShader");
+
     FILE* pFile = nullptr;
     _wfopen_s(&pFile, path.c_str(), L"rb");
     assert(pFile != nullptr);
@@ -699,6 +859,60 @@ HRESULT Renderer::CompileAndCreateShader(const std::wstring& path, SHADER_TYPE t
     return result;
 }
 
+HRESULT Renderer::LoadModel()
+{
+    PROFILE_SCOPE("Renderer::LoadModel");
+
+    MeshData mesh;
+    if (!ImportMesh(m_modelPath, ImportOptions(), mesh))
+    {
+        return E_FAIL;
+    }
+    if (mesh.GetVertexCount() == 0)
+    {
+        return E_FAIL;
+    }
+
+    // Centered and scaled so the largest extent spans the cube it replaces
+    float center[3];
+    float extent = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        center[i] = 0.5f * (mesh.bounds.min[i] + mesh.bounds.max[i]);
+        extent = max(extent, 0.5f * (mesh.bounds.max[i] - mesh.bounds.min[i]));
+    }
+    float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (size_t i = 0; i < mesh.positions.size(); i++)
+    {
+        mesh.positions[i] = (mesh.positions[i] - center[i % 3]) * scale;
+    }
+    ComputeMeshBounds(mesh);
+    m_modelBounds = mesh.bounds;
+
+    std::vector<LodLevel> levels;
+    BuildLodChain(mesh, LodChainOptions(), levels);
+
+    // The importer leaves the triangles in cache order, which the meshlets keep as far as they can
+    BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.GetVertexCount(), m_modelMeshlets);
+    GetMeshletIndices(m_modelMeshlets, mesh.indices);
+
+    m_modelLods.clear();
+    m_modelLods.push_back({ 0, static_cast<UINT>(mesh.indices.size()), 0.0f });
+    for (size_t i = 1; i < levels.size(); i++)
+    {
+        m_modelLods.push_back({ static_cast<UINT>(mesh.indices.size()), static_cast<UINT>(levels[i].indices.size()), levels[i].error });
+        mesh.indices.insert(mesh.indices.end(), levels[i].indices.begin(), levels[i].indices.end());
+    }
+
+    VertexRequirements requirements;
+    if (m_vertexPrecision == VERTEX_PRECISION::COMPACT)
+    {
+        requirements.maxPositionError = mesh.bounds.radius * CompactPositionTolerance;
+        requirements.maxUvError = CompactUvTolerance;
+    }
+    return CreateMeshBuffers(mesh, requirements, "Model", m_modelVertexFormat, m_modelMesh, &m_pModelDecodeBuffer);
+}
+
 void Renderer::ReleaseSceneResources()
 {
     SAFE_RELEASE(m_pSampleTextureSampler);
@@ -721,22 +935,50 @@ void Renderer::ReleaseSceneResources()
     SAFE_RELEASE(m_pSimpleTransTexturePixelShader);
     SAFE_RELEASE(m_pSimpleTransTextureVertexShader);
 
+    SAFE_RELEASE(m_pWeightedBlendedOitInputLayout);
+    SAFE_RELEASE(m_pWeightedBlendedOitPixelShader);
+    SAFE_RELEASE(m_pWeightedBlendedOitVertexShader);
+    SAFE_RELEASE(m_pOitCompositePixelShader);
+    SAFE_RELEASE(m_pOitCompositeVertexShader);
+
+    SAFE_RELEASE(m_pTransparentInstanceBuffer);
+    m_transparentInstanceCapacity = 0;
+
     SAFE_RELEASE(m_pDepthBuffer);
     SAFE_RELEASE(m_pDepthBufferDSV);
 
     SAFE_RELEASE(m_pViewTransformsBuffer);
     SAFE_RELEASE(m_pSceneTransformsBuffer);
 
-    SAFE_RELEASE(m_pSphereIndexBuffer);
-    SAFE_RELEASE(m_pSphereVertexBuffer);
-    SAFE_RELEASE(m_pCubeIndexBuffer);
-    SAFE_RELEASE(m_pCubeVertexBuffer);
+    SAFE_RELEASE(m_pSphereDecodeBuffer);
+    SAFE_RELEASE(m_pCubeDecodeBuffer);
+    SAFE_RELEASE(m_pModelInputLayout);
+    SAFE_RELEASE(m_pModelDecodeBuffer);
+    m_sphereMesh = PooledMesh();
+    m_cubeMesh = PooledMesh();
+    m_modelMesh = PooledMesh();
+    m_modelMeshlets = MeshletData();
+    m_modelLods.clear();
+    m_geometryPool.Term();
+    m_vertexBufferBytes = 0;
 }
 
 void Renderer::Term()
 {
     ReleaseSceneResources();
 
+    for (UINT i = 0; i < MaxFramesInFlight; i++)
+    {
+        SAFE_RELEASE(m_pFrameQueries[i]);
+    }
+    m_statsOverlay.Term();
+    m_gpuProfiler.Term();
+    delete m_pGpuQueries;
+    m_pGpuQueries = NULL;
+    SAFE_RELEASE(m_pOffscreenBuffer);
+    ReleaseOitTargets();
+    SAFE_RELEASE(m_pOitCompositeBlendState);
+    SAFE_RELEASE(m_pOitAccumBlendState);
     SAFE_RELEASE(m_pTransBlendState);
     SAFE_RELEASE(m_pDepthStateRead);
     SAFE_RELEASE(m_pDepthStateReadWrite);
@@ -764,34 +1006,37 @@ void Renderer::Term()
     m_isRunning = false;
 }
 
-bool Renderer::Render(Scene* pScene)
+bool Renderer::Render(const SceneState& state)
 {
     if (!m_isRunning)
     {
         return false;
     }
 
+    PROFILE_SCOPE("Renderer::Render");
+
+    using Clock = std::chrono::steady_clock;
+    m_stats.Reset();
+    Clock::time_point frameStart = Clock::now();
 
     m_pDeviceContext->ClearState();
+    m_geometryPool.InvalidateBindings();
 
+    m_gpuProfiler.SetEnabled(Profiler::IsCapturing());
+    m_gpuProfiler.BeginFrame();
 
 
-    DirectX::XMMATRIX v = pScene->GetCameraTransform();
-    DirectX::XMMATRIX vInv = DirectX::XMMatrixInverse(nullptr, v);
-    float f = 100.0f;
-    float n = 0.1f;
-    float fov = (float)M_PI / 2;
-    float c = 1.0f / tanf(fov / 2);
-    float aspectRatio = (float)m_height / m_width;
+    // Projection only changes on resize, the view is recomputed when the pose differs from the last frame
+    m_camera.SetPose(state.camera.GetPosition(), state.camera.GetOrientation());
 
-    float width = n * tanf(fov / 2) * 2;
-    float height = aspectRatio * width;
-    float skyboxRad = sqrtf(powf(n, 2) + powf(width / 2, 2) + powf(height / 2, 2)) * 1.0f;
+    // Skybox sphere has to enclose the corners of the near plane
+    float n = m_camera.GetNearZ();
+    float tanX = m_camera.GetTanHalfFovX();
+    float tanY = m_camera.GetTanHalfFovY();
+    float skyboxRad = n * sqrtf(1.0f + tanX * tanX + tanY * tanY);
 
     DirectX::XMMATRIX skyboxScale = DirectX::XMMatrixScaling(skyboxRad, skyboxRad, skyboxRad);
 
-    DirectX::XMMATRIX p = DirectX::XMMatrixPerspectiveLH(tanf(fov / 2) * 2 * f, tanf(fov / 2) * 2 * f * aspectRatio, f, n);
-
 
     D3D11_MAPPED_SUBRESOURCE subresource;
     HRESULT result = m_pDeviceContext->Map(m_pViewTransformsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
@@ -800,15 +1045,17 @@ bool Renderer::Render(Scene* pScene)
     {
         ViewTransformsBuffer& sceneBuffer = *reinterpret_cast<ViewTransformsBuffer*>(subresource.pData);
 
-        sceneBuffer.vp = DirectX::XMMatrixMultiply(vInv, p);
-        sceneBuffer.cameraPos = v.r[3];
+        sceneBuffer.vp = m_camera.GetViewProjection();
+        sceneBuffer.cameraPos = DirectX::XMVectorSetW(m_camera.GetPosition(), 1.0f);
 
         m_pDeviceContext->Unmap(m_pViewTransformsBuffer, 0);
+        m_stats.frame.CountUpload(sizeof(ViewTransformsBuffer));
     }
 
 
     ID3D11RenderTargetView* views[] = { m_pBackBufferRTV };
     m_pDeviceContext->OMSetRenderTargets(1, views, m_pDepthBufferDSV);
+    m_stats.frame.resourceBinds++;
 
     static const FLOAT BackColor[4] = { 0.5f, 0.25f, 0.75f, 1.0f };
     m_pDeviceContext->ClearRenderTargetView(m_pBackBufferRTV, BackColor);
@@ -830,93 +1077,313 @@ bool Renderer::Render(Scene* pScene)
     rect.right = m_width;
     rect.bottom = m_height;
     m_pDeviceContext->RSSetScissorRects(1, &rect);
+    m_stats.frame.stateBinds += 2;
 
     {
-        PrepareSimpleTextureRender();
+        PROFILE_SCOPE("OpaquePass");
+        PassStats& passStats = m_stats[RENDER_PASS::OPAQUE_OBJECTS];
+        Clock::time_point passStart = Clock::now();
+        uint32_t gpuZone = m_gpuProfiler.BeginZone("OpaquePass");
+
+        PrepareSimpleTextureRender(passStats);
 
-        std::vector<SceneTransformsBuffer> sceneTransformsBuffer;
-        sceneTransformsBuffer.push_back({ pScene->GetModelTransform() });
+        FrameVector<SceneTransformsBuffer> sceneTransformsBuffer;
+        sceneTransformsBuffer.reserve(2);
+        sceneTransformsBuffer.push_back({ state.modelTransform });
         sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(0.5f, 0.0f, 0.5f) });
 
 
+        bool isModel = m_modelMesh.IsValid();
+        const PooledMesh& mesh = isModel ? m_modelMesh : m_cubeMesh;
+        if (isModel)
+        {
+            m_pDeviceContext->IASetInputLayout(m_pModelInputLayout);
+            passStats.stateBinds++;
+        }
+
         ID3D11ShaderResourceView* resources[] = { m_pKittyTextureView };
         m_pDeviceContext->PSSetShaderResources(0, 1, resources);
-        m_pDeviceContext->IASetIndexBuffer(m_pCubeIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-        ID3D11Buffer* vertexBuffers[] = { m_pCubeVertexBuffer };
-        UINT strides[] = { sizeof(TextureVertex) };
-        UINT offsets[] = { 0 };
-        m_pDeviceContext->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+        m_pDeviceContext->VSSetConstantBuffers(2, 1, isModel ? &m_pModelDecodeBuffer : &m_pCubeDecodeBuffer);
+        passStats.resourceBinds += 2 + m_geometryPool.Bind(mesh);
 
-        m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer[0], 0, 0);
-        m_pDeviceContext->DrawIndexed(36, 0, 0);
+        for (size_t i = 0; i < sceneTransformsBuffer.size(); i++)
+        {
+            m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer[i], 0, 0);
+            passStats.CountUpload(sizeof(SceneTransformsBuffer));
+            size_t lod = isModel ? SelectModelLod(sceneTransformsBuffer[i].model) : 0;
+            if (isModel && lod == 0)
+            {
+                DrawVisibleMeshlets(sceneTransformsBuffer[i].model, mesh, m_modelMeshlets, passStats);
+            }
+            else if (isModel)
+            {
+                const MeshLodRange& range = m_modelLods[lod];
+                m_pDeviceContext->DrawIndexed(range.indexCount, mesh.startIndex + range.firstIndex, mesh.baseVertex);
+                passStats.CountDraw(range.indexCount);
+            }
+            else
+            {
+                m_pDeviceContext->DrawIndexed(mesh.indexCount, mesh.startIndex, mesh.baseVertex);
+                passStats.CountDraw(mesh.indexCount);
+            }
+        }
 
-        m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer[1], 0, 0);
-        m_pDeviceContext->DrawIndexed(36, 0, 0);
+        m_gpuProfiler.EndZone(gpuZone);
+        passStats.cpuTime = std::chrono::duration<double>(Clock::now() - passStart).count();
     }
     {
-        PrepareSimpleSkyboxRender();
+        PROFILE_SCOPE("SkyboxPass");
+        PassStats& passStats = m_stats[RENDER_PASS::SKYBOX];
+        Clock::time_point passStart = Clock::now();
+        uint32_t gpuZone = m_gpuProfiler.BeginZone("SkyboxPass");
+
+        PrepareSimpleSkyboxRender(passStats);
 
         SceneTransformsBuffer sceneTransformsBuffer = { skyboxScale };
 
         ID3D11ShaderResourceView* resources[] = { m_pCubemapTextureView };
         m_pDeviceContext->PSSetShaderResources(0, 1, resources);
 
-        m_pDeviceContext->IASetIndexBuffer(m_pSphereIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-        ID3D11Buffer* vertexBuffers[] = { m_pSphereVertexBuffer };
-        UINT strides[] = { sizeof(Vertex) };
-        UINT offsets[] = { 0 };
-        m_pDeviceContext->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+        m_pDeviceContext->VSSetConstantBuffers(2, 1, &m_pSphereDecodeBuffer);
+        passStats.resourceBinds += 2 + m_geometryPool.Bind(m_sphereMesh);
 
         m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer, 0, 0);
-        m_pDeviceContext->DrawIndexed(20 * 9 * 6, 0, 0);
+        m_pDeviceContext->DrawIndexed(m_sphereMesh.indexCount, m_sphereMesh.startIndex, m_sphereMesh.baseVertex);
+        passStats.CountUpload(sizeof(SceneTransformsBuffer));
+        passStats.CountDraw(m_sphereMesh.indexCount);
+
+        m_gpuProfiler.EndZone(gpuZone);
+        passStats.cpuTime = std::chrono::duration<double>(Clock::now() - passStart).count();
     }
     {
-        PrepareSimpleTransTextureRender();
+        PROFILE_SCOPE("TransparentPass");
+        PassStats& passStats = m_stats[RENDER_PASS::TRANSPARENT_OBJECTS];
+        Clock::time_point passStart = Clock::now();
+        uint32_t gpuZone = m_gpuProfiler.BeginZone("TransparentPass");
 
-        std::vector<SceneTransformsBuffer> sceneTransformsBuffer;
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-2.25f, 0.0f, -0.5f), {1.0f, 0.0f, 0.0f, 0.5f} });
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-4.5f, 0.0f, 0.5f), { 0.0f, 1.0f, 0.0f, 0.5f } });
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-4.5f, 3.0f, 0.5f), { 0.0f, 0.0f, 1.0f, 0.5f } });
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-7.25f, 0.0f, -0.5f), {1.0f, 0.0f, 0.0f, 0.5f} });
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-4.5f, 0.0f, 3.5f), { 0.0f, 1.0f, 0.0f, 0.5f } });
-        sceneTransformsBuffer.push_back({ DirectX::XMMatrixTranslation(-0.5f, 3.0f, 5.5f), { 0.0f, 0.0f, 1.0f, 0.5f } });
+        if (m_transparencyMode == TRANSPARENCY_MODE::WEIGHTED_BLENDED)
+        {
+            RenderWeightedBlendedTransparent(state, passStats);
+        }
+        else
+        {
+            RenderSortedTransparent(state, passStats);
+        }
 
+        m_gpuProfiler.EndZone(gpuZone);
+        passStats.cpuTime = std::chrono::duration<double>(Clock::now() - passStart).count();
+    }
+
+    m_gpuProfiler.EndFrame();
+
+    if (m_pSwapChain != NULL && m_isStatsOverlayVisible)
+    {
+        PROFILE_SCOPE("StatsOverlay");
+        // Shows the history up to the previous frame, the current one is still being counted
+        m_statsOverlay.Draw(m_statsHistory);
+    }
 
-        std::vector<std::pair<int, float>> cameraDist;
-        for (int i = 0; i < sceneTransformsBuffer.size(); i++)
+    Clock::time_point presentStart = Clock::now();
+    if (m_pSwapChain != NULL)
+    {
+        PROFILE_SCOPE("Present");
+        result = m_pSwapChain->Present(0, 0);
+        assert(SUCCEEDED(result));
+    }
+    else
+    {
+        PROFILE_SCOPE("WaitForFrameInFlight");
+        WaitForFrameInFlight();
+    }
+    m_stats.frame.cpuTime = std::chrono::duration<double>(Clock::now() - presentStart).count();
+    m_statsHistory.Push(m_stats);
+
+    // Everything allocated from the arena during the frame is out of scope by now
+    FrameArena::GetThreadArena().Reset();
+
+    return SUCCEEDED(result);
+}
+
+bool Renderer::WriteStatsHistory(const std::wstring& path) const
+{
+    FILE* pFile = nullptr;
+    _wfopen_s(&pFile, path.c_str(), L"w");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+    bool result = m_statsHistory.WriteJson(pFile);
+    fclose(pFile);
+    return result;
+}
+
+void Renderer::WaitForFrameInFlight()
+{
+    // Keeps the GPU at most MaxFramesInFlight frames behind, which Present does for windowed rendering
+    ID3D11Query* pQuery = m_pFrameQueries[m_frameIndex % MaxFramesInFlight];
+    if (m_frameIndex >= MaxFramesInFlight)
+    {
+        BOOL done = FALSE;
+        while (m_pDeviceContext->GetData(pQuery, &done, sizeof(done), 0) == S_FALSE)
         {
-            float dist = DirectX::XMVectorGetZ((sceneTransformsBuffer[i].model * vInv).r[3]);
-            cameraDist.push_back({ i, dist });
+            std::this_thread::yield();
         }
+    }
+    m_pDeviceContext->End(pQuery);
+    m_pDeviceContext->Flush();
+    m_frameIndex++;
+}
 
-        std::sort(cameraDist.begin(), cameraDist.end(), [](const std::pair<int, float>& a, const std::pair<int, float>& b)
-            {
-                return a.second > b.second;
-            });
+size_t Renderer::SelectModelLod(const DirectX::XMMATRIX& model) const
+{
+    // Projected at the point of the bounding sphere closest to the camera, the scene transforms keep its radius
+    DirectX::XMFLOAT3 center;
+    DirectX::XMStoreFloat3(&center, DirectX::XMVector3TransformCoord(
+        DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(m_modelBounds.center)), model));
+    DirectX::XMFLOAT4 depthRow = m_camera.GetViewDepthRow();
+    float depth = depthRow.x * center.x + depthRow.y * center.y + depthRow.z * center.z + depthRow.w - m_modelBounds.radius;
+    if (depth <= NearZ)
+    {
+        return 0;
+    }
+    float pixelsPerUnit = DirectX::XMVectorGetY(m_camera.GetProjection().r[1]) * 0.5f * m_height / depth;
+    for (size_t lod = m_modelLods.size() - 1; lod > 0; lod--)
+    {
+        if (m_modelLods[lod].error * pixelsPerUnit <= MaxLodPixelError)
+        {
+            return lod;
+        }
+    }
+    return 0;
+}
 
+void Renderer::DrawVisibleMeshlets(const DirectX::XMMATRIX& model, const PooledMesh& mesh, const MeshletData& meshlets, PassStats& passStats)
+{
+    // Culled in model space: planes go through the transposed model matrix, which keeps them normalized for the
+    // rigid transforms of the scene, and the camera through its inverse
+    MeshletCullView view;
+    const Frustum& frustum = m_camera.GetFrustum();
+    DirectX::XMMATRIX planeTransform = DirectX::XMMatrixTranspose(model);
+    for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+    {
+        DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(view.planes[i]), DirectX::XMPlaneTransform(frustum.planes[i], planeTransform));
+    }
+    DirectX::XMVECTOR cameraPosition = DirectX::XMVector3TransformCoord(m_camera.GetPosition(), DirectX::XMMatrixInverse(nullptr, model));
+    DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(view.cameraPosition), cameraPosition);
 
-        ID3D11ShaderResourceView* resources[] = { m_pKittyTextureView };
-        m_pDeviceContext->PSSetShaderResources(0, 1, resources);
-        m_pDeviceContext->IASetIndexBuffer(m_pCubeIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-        ID3D11Buffer* vertexBuffers[] = { m_pCubeVertexBuffer };
-        UINT strides[] = { sizeof(TextureVertex) };
-        UINT offsets[] = { 0 };
-        m_pDeviceContext->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+    CullMeshlets(meshlets, view, m_visibleMeshlets);
+    passStats.culledObjects += static_cast<uint32_t>(meshlets.meshlets.size() - m_visibleMeshlets.size());
 
-        for (int i = 0; i < cameraDist.size(); i++)
+    // Meshlets next to each other in the list are next to each other in the index buffer, a run of them is one draw
+    for (size_t i = 0; i < m_visibleMeshlets.size();)
+    {
+        const Meshlet& first = meshlets.meshlets[m_visibleMeshlets[i]];
+        UINT indexCount = first.triangleCount * 3;
+        size_t next = i + 1;
+        for (; next < m_visibleMeshlets.size() && m_visibleMeshlets[next] == m_visibleMeshlets[next - 1] + 1; next++)
         {
-            m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer[cameraDist[i].first], 0, 0);
-            m_pDeviceContext->DrawIndexed(36, 0, 0);
+            indexCount += meshlets.meshlets[m_visibleMeshlets[next]].triangleCount * 3;
         }
+        m_pDeviceContext->DrawIndexed(indexCount, mesh.startIndex + first.triangleOffset * 3, mesh.baseVertex);
+        passStats.CountDraw(indexCount);
+        i = next;
+    }
+}
+
+void Renderer::RenderSortedTransparent(const SceneState& state, PassStats& passStats)
+{
+    PrepareSimpleTransTextureRender(passStats);
+
+    FrameVector<const SceneObject*> visible;
+    CollectSortedTransparent(state, m_camera, m_transparencySorter, visible, passStats);
+
+    ID3D11ShaderResourceView* resources[] = { m_pKittyTextureView };
+    m_pDeviceContext->PSSetShaderResources(0, 1, resources);
+    m_pDeviceContext->VSSetConstantBuffers(2, 1, &m_pCubeDecodeBuffer);
+    passStats.resourceBinds += 2 + m_geometryPool.Bind(m_cubeMesh);
+
+    for (const SceneObject* pObject : visible)
+    {
+        SceneTransformsBuffer sceneTransformsBuffer = { DirectX::XMMatrixTranslation(pObject->position.x, pObject->position.y, pObject->position.z), DirectX::XMLoadFloat4(&pObject->color) };
+        m_pDeviceContext->UpdateSubresource(m_pSceneTransformsBuffer, 0, nullptr, &sceneTransformsBuffer, 0, 0);
+        m_pDeviceContext->DrawIndexed(m_cubeMesh.indexCount, m_cubeMesh.startIndex, m_cubeMesh.baseVertex);
+        passStats.CountUpload(sizeof(SceneTransformsBuffer));
+        passStats.CountDraw(m_cubeMesh.indexCount);
+    }
+}
+
+void Renderer::RenderWeightedBlendedTransparent(const SceneState& state, PassStats& passStats)
+{
+    const std::vector<SceneObject>& objects = *state.pTransparentObjects;
+    if (objects.empty() || FAILED(EnsureTransparentInstanceCapacity(objects.size())))
+    {
+        return;
     }
 
-    result = m_pSwapChain->Present(0, 0);
+    // Visible objects go straight into the instance buffer, their order does not matter
+    UINT instanceCount = 0;
+    D3D11_MAPPED_SUBRESOURCE subresource;
+    HRESULT result = m_pDeviceContext->Map(m_pTransparentInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
     assert(SUCCEEDED(result));
+    if (SUCCEEDED(result))
+    {
+        SceneObject* pInstances = reinterpret_cast<SceneObject*>(subresource.pData);
+        for (const SceneObject& object : objects)
+        {
+            if (!m_camera.GetFrustum().IsSphereVisible(DirectX::XMLoadFloat3(&object.position), CubeBoundingRadius))
+            {
+                passStats.culledObjects++;
+                continue;
+            }
+            pInstances[instanceCount++] = object;
+        }
+        m_pDeviceContext->Unmap(m_pTransparentInstanceBuffer, 0);
+        passStats.CountUpload(instanceCount * sizeof(SceneObject));
+    }
+    if (instanceCount == 0)
+    {
+        return;
+    }
 
-    return SUCCEEDED(result);
+    static const FLOAT AccumClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    static const FLOAT RevealageClearColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    m_pDeviceContext->ClearRenderTargetView(m_pOitAccumRTV, AccumClearColor);
+    m_pDeviceContext->ClearRenderTargetView(m_pOitRevealageRTV, RevealageClearColor);
+
+    // Depth is tested against the opaque objects but not written
+    ID3D11RenderTargetView* oitViews[] = { m_pOitAccumRTV, m_pOitRevealageRTV };
+    m_pDeviceContext->OMSetRenderTargets(2, oitViews, m_pDepthBufferDSV);
+    passStats.resourceBinds++;
+
+    PrepareWeightedBlendedOitRender(passStats);
+
+    ID3D11ShaderResourceView* resources[] = { m_pKittyTextureView };
+    m_pDeviceContext->PSSetShaderResources(0, 1, resources);
+    // Instances come from the second slot, the cube from the pool in the first
+    UINT instanceStride = sizeof(SceneObject);
+    UINT instanceOffset = 0;
+    m_pDeviceContext->IASetVertexBuffers(1, 1, &m_pTransparentInstanceBuffer, &instanceStride, &instanceOffset);
+    m_pDeviceContext->VSSetConstantBuffers(2, 1, &m_pCubeDecodeBuffer);
+    passStats.resourceBinds += 3 + m_geometryPool.Bind(m_cubeMesh);
+
+    m_pDeviceContext->DrawIndexedInstanced(m_cubeMesh.indexCount, instanceCount, m_cubeMesh.startIndex, m_cubeMesh.baseVertex, 0);
+    passStats.CountDraw(m_cubeMesh.indexCount * instanceCount);
+
+    // Every fragment has been depth tested already, the composite covers the screen without a depth buffer
+    ID3D11RenderTargetView* views[] = { m_pBackBufferRTV };
+    m_pDeviceContext->OMSetRenderTargets(1, views, nullptr);
+    passStats.resourceBinds++;
+
+    PrepareOitCompositeRender(passStats);
+    m_pDeviceContext->Draw(3, 0);
+    passStats.CountDraw(3);
+
+    // The targets are written again next frame
+    ID3D11ShaderResourceView* nullResources[] = { nullptr, nullptr };
+    m_pDeviceContext->PSSetShaderResources(0, 2, nullResources);
 }
 
-bool Renderer::PrepareSimpleTextureRender()
+bool Renderer::PrepareSimpleTextureRender(PassStats& stats)
 {
     m_pDeviceContext->OMSetDepthStencilState(m_pDepthStateReadWrite, 0);
     m_pDeviceContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
@@ -930,10 +1397,14 @@ bool Renderer::PrepareSimpleTextureRender()
 
     ID3D11SamplerState* samplers[] = { m_pSampleTextureSampler };
     m_pDeviceContext->PSSetSamplers(0, 1, samplers);
+
+    stats.stateBinds += 4;
+    stats.shaderBinds += 2;
+    stats.resourceBinds += 3;
     return true;
 }
 
-bool Renderer::PrepareSimpleSkyboxRender()
+bool Renderer::PrepareSimpleSkyboxRender(PassStats& stats)
 {
     m_pDeviceContext->OMSetDepthStencilState(m_pDepthStateRead, 0);
     m_pDeviceContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
@@ -947,10 +1418,14 @@ bool Renderer::PrepareSimpleSkyboxRender()
 
     ID3D11SamplerState* samplers[] = { m_pSampleTextureSampler };
     m_pDeviceContext->PSSetSamplers(0, 1, samplers);
+
+    stats.stateBinds += 4;
+    stats.shaderBinds += 2;
+    stats.resourceBinds += 3;
     return true;
 }
 
-bool Renderer::PrepareSimpleTransTextureRender()
+bool Renderer::PrepareSimpleTransTextureRender(PassStats& stats)
 {
     m_pDeviceContext->OMSetDepthStencilState(m_pDepthStateRead, 0);
     m_pDeviceContext->OMSetBlendState(m_pTransBlendState, nullptr, 0xFFFFFFFF);
@@ -965,6 +1440,47 @@ bool Renderer::PrepareSimpleTransTextureRender()
 
     ID3D11SamplerState* samplers[] = { m_pSampleTextureSampler };
     m_pDeviceContext->PSSetSamplers(0, 1, samplers);
+
+    stats.stateBinds += 4;
+    stats.shaderBinds += 2;
+    stats.resourceBinds += 4;
+    return true;
+}
+
+bool Renderer::PrepareWeightedBlendedOitRender(PassStats& stats)
+{
+    m_pDeviceContext->OMSetDepthStencilState(m_pDepthStateRead, 0);
+    m_pDeviceContext->OMSetBlendState(m_pOitAccumBlendState, nullptr, 0xFFFFFFFF);
+    m_pDeviceContext->IASetInputLayout(m_pWeightedBlendedOitInputLayout);
+    m_pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_pDeviceContext->VSSetShader(m_pWeightedBlendedOitVertexShader, nullptr, 0);
+    m_pDeviceContext->PSSetShader(m_pWeightedBlendedOitPixelShader, nullptr, 0);
+
+    m_pDeviceContext->VSSetConstantBuffers(0, 1, &m_pViewTransformsBuffer);
+
+    ID3D11SamplerState* samplers[] = { m_pSampleTextureSampler };
+    m_pDeviceContext->PSSetSamplers(0, 1, samplers);
+
+    stats.stateBinds += 4;
+    stats.shaderBinds += 2;
+    stats.resourceBinds += 2;
+    return true;
+}
+
+bool Renderer::PrepareOitCompositeRender(PassStats& stats)
+{
+    m_pDeviceContext->OMSetBlendState(m_pOitCompositeBlendState, nullptr, 0xFFFFFFFF);
+    m_pDeviceContext->IASetInputLayout(nullptr);
+    m_pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_pDeviceContext->VSSetShader(m_pOitCompositeVertexShader, nullptr, 0);
+    m_pDeviceContext->PSSetShader(m_pOitCompositePixelShader, nullptr, 0);
+
+    ID3D11ShaderResourceView* resources[] = { m_pOitAccumSRV, m_pOitRevealageSRV };
+    m_pDeviceContext->PSSetShaderResources(0, 2, resources);
+
+    stats.stateBinds += 3;
+    stats.shaderBinds += 2;
+    stats.resourceBinds += 2;
     return true;
 }
 
@@ -983,13 +1499,20 @@ bool Renderer::Resize(UINT width, UINT height)
         SAFE_RELEASE(m_pBackBufferRTV);
         SAFE_RELEASE(m_pDepthBufferDSV);
         SAFE_RELEASE(m_pDepthBuffer);
+        ReleaseOitTargets();
+        m_statsOverlay.ReleaseTarget();
 
-        HRESULT result = m_pSwapChain->ResizeBuffers(2, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
+        HRESULT result = S_OK;
+        if (m_pSwapChain != NULL)
+        {
+            result = m_pSwapChain->ResizeBuffers(2, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
+        }
         assert(SUCCEEDED(result));
         if (SUCCEEDED(result))
         {
             m_width = width;
             m_height = height;
+            m_camera.SetPerspective(FieldOfView, (float)m_height / m_width, NearZ, FarZ);
 
             result = SetupBackBuffer();
         }
@@ -997,6 +1520,10 @@ bool Renderer::Resize(UINT width, UINT height)
         {
             result = SetupDepthBuffer();
         }
+        if (SUCCEEDED(result))
+        {
+            result = SetupOitTargets();
+        }
 
         return SUCCEEDED(result);
     }
@@ -1008,13 +1535,43 @@ HRESULT Renderer::SetupBackBuffer()
 {
     SAFE_RELEASE(m_pBackBufferRTV);
     ID3D11Texture2D* pBackBuffer = NULL;
-    HRESULT result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&pBackBuffer);
+    HRESULT result = S_OK;
+    if (m_pSwapChain != NULL)
+    {
+        result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&pBackBuffer);
+    }
+    else
+    {
+        SAFE_RELEASE(m_pOffscreenBuffer);
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.ArraySize = 1;
+        desc.MipLevels = 1;
+        desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Width = m_width;
+        desc.Height = m_height;
+        result = m_pDevice->CreateTexture2D(&desc, nullptr, &m_pOffscreenBuffer);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(m_pOffscreenBuffer, "OffscreenBuffer");
+            pBackBuffer = m_pOffscreenBuffer;
+            pBackBuffer->AddRef();
+        }
+    }
     assert(SUCCEEDED(result));
     if (SUCCEEDED(result))
     {
         result = m_pDevice->CreateRenderTargetView(pBackBuffer, NULL, &m_pBackBufferRTV);
         assert(SUCCEEDED(result));
 
+        if (SUCCEEDED(result) && m_pSwapChain != NULL)
+        {
+            result = m_statsOverlay.SetTarget(pBackBuffer);
+        }
+
         SAFE_RELEASE(pBackBuffer);
     }
     return result;
@@ -1057,3 +1614,103 @@ HRESULT Renderer::SetupDepthBuffer()
     }
     return result;
 }
+
+HRESULT Renderer::SetupOitTargets()
+{
+    ReleaseOitTargets();
+
+    struct TargetDesc
+    {
+        DXGI_FORMAT format;
+        const char* name;
+        ID3D11Texture2D** ppTexture;
+        ID3D11RenderTargetView** ppRTV;
+        ID3D11ShaderResourceView** ppSRV;
+    };
+    // Half floats hold the weighted sums, revealage is a product of values in [0, 1]
+    const TargetDesc Targets[] = {
+        { DXGI_FORMAT_R16G16B16A16_FLOAT, "OitAccum", &m_pOitAccumTexture, &m_pOitAccumRTV, &m_pOitAccumSRV },
+        { DXGI_FORMAT_R8_UNORM, "OitRevealage", &m_pOitRevealageTexture, &m_pOitRevealageRTV, &m_pOitRevealageSRV },
+    };
+
+    HRESULT result = S_OK;
+    for (const TargetDesc& target : Targets)
+    {
+        if (SUCCEEDED(result))
+        {
+            D3D11_TEXTURE2D_DESC desc = {};
+            desc.Format = target.format;
+            desc.ArraySize = 1;
+            desc.MipLevels = 1;
+            desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.SampleDesc.Count = 1;
+            desc.SampleDesc.Quality = 0;
+            desc.Width = m_width;
+            desc.Height = m_height;
+            result = m_pDevice->CreateTexture2D(&desc, nullptr, target.ppTexture);
+            assert(SUCCEEDED(result));
+            if (SUCCEEDED(result))
+            {
+                result = SetResourceName(*target.ppTexture, std::string(target.name) + "Texture");
+            }
+        }
+        if (SUCCEEDED(result))
+        {
+            result = m_pDevice->CreateRenderTargetView(*target.ppTexture, nullptr, target.ppRTV);
+            assert(SUCCEEDED(result));
+            if (SUCCEEDED(result))
+            {
+                result = SetResourceName(*target.ppRTV, std::string(target.name) + "RTV");
+            }
+        }
+        if (SUCCEEDED(result))
+        {
+            result = m_pDevice->CreateShaderResourceView(*target.ppTexture, nullptr, target.ppSRV);
+            assert(SUCCEEDED(result));
+            if (SUCCEEDED(result))
+            {
+                result = SetResourceName(*target.ppSRV, std::string(target.name) + "SRV");
+            }
+        }
+    }
+    return result;
+}
+
+void Renderer::ReleaseOitTargets()
+{
+    SAFE_RELEASE(m_pOitAccumSRV);
+    SAFE_RELEASE(m_pOitAccumRTV);
+    SAFE_RELEASE(m_pOitAccumTexture);
+    SAFE_RELEASE(m_pOitRevealageSRV);
+    SAFE_RELEASE(m_pOitRevealageRTV);
+    SAFE_RELEASE(m_pOitRevealageTexture);
+}
+
+HRESULT Renderer::EnsureTransparentInstanceCapacity(size_t count)
+{
+    if (count <= m_transparentInstanceCapacity)
+    {
+        return S_OK;
+    }
+
+    // The object count only changes between runs, so the buffer is sized exactly
+    SAFE_RELEASE(m_pTransparentInstanceBuffer);
+    m_transparentInstanceCapacity = 0;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = static_cast<UINT>(sizeof(SceneObject) * count);
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = 0;
+    desc.StructureByteStride = 0;
+    HRESULT result = m_pDevice->CreateBuffer(&desc, nullptr, &m_pTransparentInstanceBuffer);
+    assert(SUCCEEDED(result));
+    if (SUCCEEDED(result))
+    {
+        m_transparentInstanceCapacity = static_cast<UINT>(count);
+        result = SetResourceName(m_pTransparentInstanceBuffer, "TransparentInstanceBuffer");
+    }
+    return result;
+}
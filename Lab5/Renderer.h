@@ -2,6 +2,48 @@
 
 #include "framework.h"
 #include "Scene.h"
+#include "RenderStats.h"
+#include "StatsOverlay.h"
+#include "GpuProfiler.h"
+#include "D3D11GpuQueries.h"
+#include "Camera.h"
+#include "TransparencySorter.h"
+#include "VertexFormat.h"
+#include "ProceduralMesh.h"
+#include "GeometryPool.h"
+#include "Meshlets.h"
+
+enum class RENDER_BACKEND
+{
+    HARDWARE,
+    WARP,
+    NULL_DEVICE
+};
+
+enum class TRANSPARENCY_MODE
+{
+    // Sorted back to front on the CPU and blended over, one draw per object
+    SORTED,
+    // Weighted blended order-independent transparency, unsorted and instanced
+    WEIGHTED_BLENDED
+};
+
+enum class VERTEX_PRECISION
+{
+    // 32-bit floats for every attribute
+    FULL,
+    // Quantized formats picked per mesh within fixed error tolerances
+    COMPACT
+};
+
+// Index range of one level of detail within a pooled mesh
+struct MeshLodRange
+{
+    UINT firstIndex;
+    UINT indexCount;
+    // Collapse error of the simplification in mesh units
+    float error;
+};
 
 class Renderer
 {
@@ -12,11 +54,40 @@ class Renderer
     IDXGISwapChain* m_pSwapChain = NULL;
     ID3D11RenderTargetView* m_pBackBufferRTV = NULL;
 
-    ID3D11Buffer* m_pSphereVertexBuffer = NULL;
-    ID3D11Buffer* m_pSphereIndexBuffer = NULL;
+    // Headless rendering targets an offscreen texture and throttles on queries instead of Present
+    ID3D11Texture2D* m_pOffscreenBuffer = NULL;
+    static const UINT MaxFramesInFlight = 2;
+    ID3D11Query* m_pFrameQueries[MaxFramesInFlight] = {};
+    UINT m_frameIndex = 0;
+
+    // Vertex formats are chosen per mesh when the scene resources are created, the decode
+    // buffers hold what the vertex shaders need to map stored positions back to mesh space
+    VERTEX_PRECISION m_vertexPrecision = VERTEX_PRECISION::COMPACT;
+    size_t m_vertexBufferBytes = 0;
+
+    // Vertices and indices of every mesh live in the pool, draws pick them by base vertex and start index
+    GeometryPool m_geometryPool;
 
-    ID3D11Buffer* m_pCubeVertexBuffer = NULL;
-    ID3D11Buffer* m_pCubeIndexBuffer = NULL;
+    PooledMesh m_sphereMesh;
+    ID3D11Buffer* m_pSphereDecodeBuffer = NULL;
+    VertexFormat m_sphereVertexFormat;
+
+    PooledMesh m_cubeMesh;
+    ID3D11Buffer* m_pCubeDecodeBuffer = NULL;
+    VertexFormat m_cubeVertexFormat;
+
+    // Imported model drawn in place of the opaque cubes, fitted into their [-1, 1] box
+    std::wstring m_modelPath;
+    PooledMesh m_modelMesh;
+    // Clusters of the model in index buffer order, culled on the CPU before every draw of it
+    MeshletData m_modelMeshlets;
+    std::vector<uint32_t> m_visibleMeshlets;
+    // Full detail in meshlet order, then the simplified levels, all in the index range of the model
+    std::vector<MeshLodRange> m_modelLods;
+    MeshBounds m_modelBounds;
+    ID3D11Buffer* m_pModelDecodeBuffer = NULL;
+    ID3D11InputLayout* m_pModelInputLayout = NULL;
+    VertexFormat m_modelVertexFormat;
 
     ID3D11Buffer* m_pSceneTransformsBuffer = NULL;
     ID3D11Buffer* m_pViewTransformsBuffer = NULL;
@@ -46,23 +117,91 @@ class Renderer
     ID3D11Texture2D* m_pCubemapTexture = NULL;
     ID3D11ShaderResourceView* m_pCubemapTextureView = NULL;
 
+    // Weighted blended transparency: accumulation and revealage targets of the back buffer size
+    TRANSPARENCY_MODE m_transparencyMode = TRANSPARENCY_MODE::SORTED;
+    ID3D11Texture2D* m_pOitAccumTexture = NULL;
+    ID3D11RenderTargetView* m_pOitAccumRTV = NULL;
+    ID3D11ShaderResourceView* m_pOitAccumSRV = NULL;
+    ID3D11Texture2D* m_pOitRevealageTexture = NULL;
+    ID3D11RenderTargetView* m_pOitRevealageRTV = NULL;
+    ID3D11ShaderResourceView* m_pOitRevealageSRV = NULL;
+    ID3D11BlendState* m_pOitAccumBlendState = NULL;
+    ID3D11BlendState* m_pOitCompositeBlendState = NULL;
+
+    ID3D11PixelShader* m_pWeightedBlendedOitPixelShader = NULL;
+    ID3D11VertexShader* m_pWeightedBlendedOitVertexShader = NULL;
+    ID3D11InputLayout* m_pWeightedBlendedOitInputLayout = NULL;
+    ID3D11PixelShader* m_pOitCompositePixelShader = NULL;
+    ID3D11VertexShader* m_pOitCompositeVertexShader = NULL;
+
+    // Per-instance position and color of the visible transparent objects, grows with the object count
+    ID3D11Buffer* m_pTransparentInstanceBuffer = NULL;
+    UINT m_transparentInstanceCapacity = 0;
+
     bool m_isRunning = false;
 
+    // Pose comes from the scene every frame, the projection follows the back buffer size
+    Camera m_camera;
+    // Back to front order of the transparent objects, repaired from the previous frame
+    TransparencySorter m_transparencySorter;
+
+    RenderStats m_stats;
+    RenderStatsHistory m_statsHistory;
+    StatsOverlay m_statsOverlay;
+    bool m_isStatsOverlayVisible = false;
+
+    // Pass timings on the GPU, recorded while a profiler capture is running
+    D3D11GpuQueries* m_pGpuQueries = NULL;
+    GpuProfiler m_gpuProfiler;
+
 public:
-    bool Init(HWND hWnd);
+    bool Init(HWND hWnd, RENDER_BACKEND backend = RENDER_BACKEND::HARDWARE);
+    // Renders into an offscreen target of the given size instead of a window
+    bool InitHeadless(UINT width, UINT height, RENDER_BACKEND backend);
     void Term();
-    bool Render(Scene* pScene);
-    bool PrepareSimpleTextureRender();
-    bool PrepareSimpleSkyboxRender();
-    bool PrepareSimpleTransTextureRender();
+    bool Render(const SceneState& state);
+    bool PrepareSimpleTextureRender(PassStats& stats);
+    bool PrepareSimpleSkyboxRender(PassStats& stats);
+    bool PrepareSimpleTransTextureRender(PassStats& stats);
+    bool PrepareWeightedBlendedOitRender(PassStats& stats);
+    bool PrepareOitCompositeRender(PassStats& stats);
     bool Resize(UINT width, UINT height);
     bool IsRunning() { return m_isRunning; }
+    // Counters of the last rendered frame
+    const RenderStats& GetStats() const { return m_stats; }
+    const RenderStatsHistory& GetStatsHistory() const { return m_statsHistory; }
+    void SetStatsOverlayVisible(bool visible) { m_isStatsOverlayVisible = visible; }
+    bool IsStatsOverlayVisible() const { return m_isStatsOverlayVisible; }
+    // Takes effect with the next frame, may be called before Init
+    void SetTransparencyMode(TRANSPARENCY_MODE mode) { m_transparencyMode = mode; }
+    TRANSPARENCY_MODE GetTransparencyMode() const { return m_transparencyMode; }
+    // Applies to the scene resources, so it must be set before Init
+    void SetVertexPrecision(VERTEX_PRECISION precision) { m_vertexPrecision = precision; }
+    VERTEX_PRECISION GetVertexPrecision() const { return m_vertexPrecision; }
+    // OBJ or glTF binary file, loaded with the scene resources, so it must be set before Init
+    void SetModelPath(const std::wstring& path) { m_modelPath = path; }
+    // Size of all mesh vertices, the pool pages around them are larger
+    size_t GetVertexBufferBytes() const { return m_vertexBufferBytes; }
+    // Machine-readable dump of the stats history as a JSON array of frames
+    bool WriteStatsHistory(const std::wstring& path) const;
 
 private:
     HRESULT SetupBackBuffer();
     HRESULT SetupDepthBuffer();
+    HRESULT SetupOitTargets();
+    void ReleaseOitTargets();
+    HRESULT EnsureTransparentInstanceCapacity(size_t count);
+    void RenderSortedTransparent(const SceneState& state, PassStats& passStats);
+    void RenderWeightedBlendedTransparent(const SceneState& state, PassStats& passStats);
+    // Coarsest level of the model whose error projects to at most MaxLodPixelError pixels
+    size_t SelectModelLod(const DirectX::XMMATRIX& model) const;
+    void DrawVisibleMeshlets(const DirectX::XMMATRIX& model, const PooledMesh& mesh, const MeshletData& meshlets, PassStats& passStats);
+    void WaitForFrameInFlight();
     void ReleaseSceneResources();
     HRESULT InitSceneResources();
+    HRESULT LoadModel();
+    HRESULT CreateMeshBuffers(const MeshData& mesh, const VertexRequirements& requirements, const std::string& name,
+        VertexFormat& format, PooledMesh& pooledMesh, ID3D11Buffer** ppDecodeBuffer);
 
     enum class SHADER_TYPE
     {
@@ -1,24 +1,55 @@
 #include "Scene.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+static DirectX::XMMATRIX InterpolateTransform(const DirectX::XMMATRIX& a, const DirectX::XMMATRIX& b, float t)
+{
+    DirectX::XMVECTOR scaleA, rotationA, translationA;
+    DirectX::XMVECTOR scaleB, rotationB, translationB;
+    if (!DirectX::XMMatrixDecompose(&scaleA, &rotationA, &translationA, a) ||
+        !DirectX::XMMatrixDecompose(&scaleB, &rotationB, &translationB, b))
+    {
+        return b;
+    }
+    return DirectX::XMMatrixAffineTransformation(
+        DirectX::XMVectorLerp(scaleA, scaleB, t),
+        DirectX::XMVectorZero(),
+        DirectX::XMQuaternionSlerp(rotationA, rotationB, t),
+        DirectX::XMVectorLerp(translationA, translationB, t));
+}
 
 Scene::Scene()
 {
+    SetTransparentObjectCount(0);
     Update(0.0);
+    m_prevState = m_state;
+    m_prevVersion = m_version;
 }
 
 void Scene::Update(double deltaTime)
 {
-    if (m_playAnimation)
+    PROFILE_SCOPE("Scene::Update");
+
+    m_prevState = m_state;
+    m_prevVersion = m_version;
+
+    if (m_pRecorder != nullptr)
     {
-        m_animationTime += deltaTime * 2 * M_PI * 0.25;
+        m_pRecorder->BeginFrame(deltaTime);
+    }
+    ProcessInput();
+    if (m_pRecorder != nullptr)
+    {
+        m_pRecorder->EndFrame();
     }
-    m_modelTransform = DirectX::XMMatrixRotationAxis({ 0, 1, 0 }, -static_cast<float>(m_animationTime));
-    m_modelTransform *= DirectX::XMMatrixTranslation(0.0f, (1.0f + sinf(-static_cast<float>(m_animationTime))) / 4, 0.0f);
 
-    m_cameraTransform = DirectX::XMMatrixIdentity();
-    if (!m_isFirstPerson)
+    if (m_playAnimation)
     {
-        m_cameraTransform *= DirectX::XMMatrixTranslation(0, 0, -m_zoom);
+        m_animationTime += deltaTime * 2 * M_PI * 0.25;
     }
+    m_state.modelTransform = DirectX::XMMatrixRotationAxis(DirectX::XMVectorSet(0, 1, 0, 0), -static_cast<float>(m_animationTime));
+    m_state.modelTransform *= DirectX::XMMatrixTranslation(0.0f, (1.0f + sinf(-static_cast<float>(m_animationTime))) / 4, 0.0f);
 
     float yAngle = m_cameraYRotationAngle;
     float xAngle = m_cameraXRotationAngle;
@@ -27,10 +58,12 @@ void Scene::Update(double deltaTime)
         yAngle += (m_grabLast.y - m_grabStart.y) / 200.f;
         xAngle += (m_grabLast.x - m_grabStart.x) / 200.f;
     }
-    yAngle = max(-M_PI / 2, yAngle);
-    yAngle = min(M_PI / 2, yAngle);
-    m_cameraTransform *= DirectX::XMMatrixRotationAxis({ 1, 0, 0 }, yAngle);
-    m_cameraTransform *= DirectX::XMMatrixRotationAxis({ 0, 1, 0 }, xAngle);
+    yAngle = (std::max)(static_cast<float>(-M_PI / 2), yAngle);
+    yAngle = (std::min)(static_cast<float>(M_PI / 2), yAngle);
+    // Pitch followed by yaw
+    DirectX::XMVECTOR orientation = DirectX::XMQuaternionMultiply(
+        DirectX::XMQuaternionRotationAxis(DirectX::XMVectorSet(1, 0, 0, 0), yAngle),
+        DirectX::XMQuaternionRotationAxis(DirectX::XMVectorSet(0, 1, 0, 0), xAngle));
 
     float moveSpeed = 10.0f;
 
@@ -60,17 +93,153 @@ void Scene::Update(double deltaTime)
         z = m_zoom / 4.0f;
     }
    
-    m_cameraTransform *= DirectX::XMMatrixTranslation(m_cameraOriginXTranslation, z, m_cameraOriginZTranslation);
+    // Orbit camera sits zoom units behind the origin it rotates around
+    DirectX::XMVECTOR position = DirectX::XMVectorSet(m_cameraOriginXTranslation, z, m_cameraOriginZTranslation, 0.0f);
+    if (!m_isFirstPerson)
+    {
+        position = DirectX::XMVectorAdd(position, DirectX::XMVector3Rotate(DirectX::XMVectorSet(0, 0, -m_zoom, 0), orientation));
+    }
+    m_state.camera.SetPose(position, orientation);
+
+    if (memcmp(&m_state.modelTransform, &m_prevState.modelTransform, sizeof(DirectX::XMMATRIX)) != 0 ||
+        !m_state.camera.HasSamePose(m_prevState.camera))
+    {
+        m_version++;
+    }
+}
+
+bool Scene::IsIdle() const
+{
+    bool isMoving = m_isWDown || m_isADown || m_isSDown || m_isDDown;
+    return !m_playAnimation && !isMoving && m_version == m_prevVersion && m_inputQueue.Empty();
+}
+
+void Scene::SetTransparentObjectCount(size_t count)
+{
+    static const SceneObject DefaultObjects[] = {
+        { { -2.25f, 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f, 0.5f } },
+        { { -4.5f, 0.0f, 0.5f }, { 0.0f, 1.0f, 0.0f, 0.5f } },
+        { { -4.5f, 3.0f, 0.5f }, { 0.0f, 0.0f, 1.0f, 0.5f } },
+        { { -7.25f, 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f, 0.5f } },
+        { { -4.5f, 0.0f, 3.5f }, { 0.0f, 1.0f, 0.0f, 0.5f } },
+        { { -0.5f, 3.0f, 5.5f }, { 0.0f, 0.0f, 1.0f, 0.5f } },
+    };
+    const size_t DefaultCount = sizeof(DefaultObjects) / sizeof(DefaultObjects[0]);
+
+    count = (std::max)(count, DefaultCount);
+    m_transparentObjects.assign(DefaultObjects, DefaultObjects + DefaultCount);
+    m_transparentObjects.reserve(count);
+
+    // Extra objects fill a cube shaped grid behind the default ones
+    size_t extraCount = count - DefaultCount;
+    size_t side = 1;
+    while (side * side * side < extraCount)
+    {
+        side++;
+    }
+    const float Spacing = 2.5f;
+    for (size_t i = 0; i < extraCount; i++)
+    {
+        float x = static_cast<float>(i % side);
+        float y = static_cast<float>((i / side) % side);
+        float z = static_cast<float>(i / (side * side));
+        SceneObject object;
+        object.position = { (x - side / 2.0f) * Spacing, y * Spacing, 10.0f + z * Spacing };
+        object.color = { i % 3 == 0 ? 1.0f : 0.0f, i % 3 == 1 ? 1.0f : 0.0f, i % 3 == 2 ? 1.0f : 0.0f, 0.5f };
+        m_transparentObjects.push_back(object);
+    }
+
+    m_transparentPositions.Clear();
+    m_transparentPositions.Reserve(m_transparentObjects.size());
+    for (const SceneObject& object : m_transparentObjects)
+    {
+        m_transparentPositions.PushBack(object.position.x, object.position.y, object.position.z);
+    }
+
+    m_state.pTransparentObjects = &m_transparentObjects;
+    m_prevState.pTransparentObjects = &m_transparentObjects;
+    m_state.pTransparentPositions = &m_transparentPositions;
+    m_prevState.pTransparentPositions = &m_transparentPositions;
+    m_version++;
+}
+
+void SceneSnapshot::Interpolate(std::chrono::steady_clock::time_point time, SceneState& result) const
+{
+    double alpha = step > 0.0 ? std::chrono::duration<double>(time - stateTime).count() / step : 1.0;
+    float t = static_cast<float>((std::max)(0.0, (std::min)(1.0, alpha)));
+    result.modelTransform = InterpolateTransform(prevState.modelTransform, state.modelTransform, t);
+    result.camera = Camera::Interpolate(prevState.camera, state.camera, t);
+    result.pTransparentObjects = state.pTransparentObjects;
+    result.pTransparentPositions = state.pTransparentPositions;
+}
+
+bool SceneSnapshot::NeedsRender(uint64_t renderedVersion, bool forceRender) const
+{
+    // Interpolation between two different steps changes the picture every frame
+    return forceRender || !IsStatic() || version != renderedVersion;
+}
+
+void Scene::GetSnapshot(SceneSnapshot& snapshot) const
+{
+    snapshot.prevState = m_prevState;
+    snapshot.state = m_state;
+    snapshot.prevVersion = m_prevVersion;
+    snapshot.version = m_version;
 }
 
 const DirectX::XMMATRIX& Scene::GetModelTransform()
 {
-    return m_modelTransform;
+    return m_state.modelTransform;
+}
+
+
+bool Scene::PostInput(const InputEvent& event)
+{
+    return m_inputQueue.Push(event);
+}
+
+void Scene::ProcessInput()
+{
+    PROFILE_SCOPE("Scene::ProcessInput");
+
+    InputEvent event;
+    while (m_inputQueue.Pop(event))
+    {
+        if (m_pRecorder != nullptr)
+        {
+            m_pRecorder->RecordEvent(event);
+        }
+        HandleInput(event);
+    }
 }
 
-const DirectX::XMMATRIX& Scene::GetCameraTransform()
+void Scene::HandleInput(const InputEvent& event)
 {
-    return m_cameraTransform;
+    WPARAM wParam = static_cast<WPARAM>(event.wParam);
+    LPARAM lParam = static_cast<LPARAM>(static_cast<int32_t>(event.lParam));
+    switch (event.type)
+    {
+    case InputEvent::TYPE::KEY_DOWN:
+        OnKeyDown(wParam, lParam);
+        break;
+    case InputEvent::TYPE::KEY_UP:
+        OnKeyUp(wParam, lParam);
+        break;
+    case InputEvent::TYPE::MOUSE_MOVE:
+        OnMouseMove(wParam, lParam);
+        break;
+    case InputEvent::TYPE::LMOUSE_DOWN:
+        OnLMouseDown(wParam, lParam);
+        break;
+    case InputEvent::TYPE::LMOUSE_UP:
+        OnLMouseUp(wParam, lParam);
+        break;
+    case InputEvent::TYPE::MOUSE_WHEEL:
+        OnMouseWheel(wParam, lParam);
+        break;
+    default:
+        break;
+    }
 }
 
 void Scene::OnKeyDown(WPARAM wParam, LPARAM lParam)
@@ -178,12 +347,12 @@ void Scene::OnLMouseUp(WPARAM wParam, LPARAM lParam)
     m_cameraXRotationAngle += (m_grabLast.x - m_grabStart.x) / 200.f;
     m_cameraYRotationAngle += (m_grabLast.y - m_grabStart.y) / 200.f;
 
-    m_cameraYRotationAngle = max(-M_PI / 2, m_cameraYRotationAngle);
-    m_cameraYRotationAngle = min(M_PI / 2, m_cameraYRotationAngle);
+    m_cameraYRotationAngle = (std::max)(static_cast<float>(-M_PI / 2), m_cameraYRotationAngle);
+    m_cameraYRotationAngle = (std::min)(static_cast<float>(M_PI / 2), m_cameraYRotationAngle);
 }
 
 void Scene::OnMouseWheel(WPARAM wParam, LPARAM lParam)
 {
     m_zoom -= GET_WHEEL_DELTA_WPARAM(wParam) / 120.0f / 5.0f;
-    m_zoom = max(m_zoom, 0.0f);
+    m_zoom = (std::max)(m_zoom, 0.0f);
 }
\ No newline at end of file
@@ -1,11 +1,57 @@
 #pragma once
 
-#include "framework.h"
+#include "Platform.h"
+#include "InputEvent.h"
+#include "InputQueue.h"
+#include "InputRecording.h"
+#include "Camera.h"
+#include "ViewDepth.h"
+
+struct SceneObject
+{
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT4 color;
+};
+
+struct SceneState
+{
+    DirectX::XMMATRIX modelTransform;
+    // Only the pose is set by the scene, the renderer owns the projection
+    Camera camera;
+    // Owned by the scene and never modified while rendering
+    const std::vector<SceneObject>* pTransparentObjects = nullptr;
+    // Positions of the same objects in the same order, for batched depth computation
+    const PositionsSoA* pTransparentPositions = nullptr;
+};
+
+// Immutable copy of the last two simulation steps handed over to the render thread
+struct SceneSnapshot
+{
+    SceneState prevState;
+    SceneState state;
+    std::chrono::steady_clock::time_point stateTime;
+    double step = 0.0;
+    // Scene versions of the two steps, equal when the last step changed nothing
+    uint64_t prevVersion = 0;
+    uint64_t version = 0;
+
+    bool IsStatic() const { return prevVersion == version; }
+
+    // Whether the snapshot changes the picture rendered from renderedVersion, the rule behind idle rendering.
+    // forceRender is set when nothing has been rendered yet or a command changed the output.
+    bool NeedsRender(uint64_t renderedVersion, bool forceRender) const;
+
+    // Interpolates between the two steps for the given moment of wall clock time
+    void Interpolate(std::chrono::steady_clock::time_point time, SceneState& result) const;
+};
 
 class Scene
 {
-    DirectX::XMMATRIX m_modelTransform;
-    DirectX::XMMATRIX m_cameraTransform;
+    // Simulation runs with a fixed step, render state is interpolated between the last two steps
+    SceneState m_prevState;
+    SceneState m_state;
+    uint64_t m_prevVersion = 0;
+    uint64_t m_version = 0;
 
     float m_cameraXRotationAngle = 0.0f;
     float m_cameraYRotationAngle = 0.0f;
@@ -27,11 +73,40 @@ class Scene
     bool m_isDDown = false;
     bool m_isFirstPerson = false;
 
+    std::vector<SceneObject> m_transparentObjects;
+    PositionsSoA m_transparentPositions;
+
+    // Filled by the window thread, drained in batch at the start of Update
+    InputQueue m_inputQueue;
+    InputRecorder* m_pRecorder = nullptr;
+
 public:
     Scene();
     void Update(double deltaTime);
+    void GetSnapshot(SceneSnapshot& snapshot) const;
     const DirectX::XMMATRIX& GetModelTransform();
-    const DirectX::XMMATRIX& GetCameraTransform();
+    const Camera& GetCamera() const { return m_state.camera; }
+    const std::vector<SceneObject>& GetTransparentObjects() const { return m_transparentObjects; }
+    const PositionsSoA& GetTransparentPositions() const { return m_transparentPositions; }
+
+    // Incremented by every update that changes the rendered state
+    uint64_t GetVersion() const { return m_version; }
+    // Further updates change nothing until new input arrives: the animation is paused,
+    // no movement keys are held and the last update did not change the state
+    bool IsIdle() const;
+
+    // Adds a grid of extra transparent cubes after the default ones, must not be called while rendering
+    void SetTransparentObjectCount(size_t count);
+
+    // Called from the window thread, returns false if the queue was full and the event was dropped
+    bool PostInput(const InputEvent& event);
+    uint64_t GetDroppedInputCount() const { return m_inputQueue.GetDroppedCount(); }
+    // Every following update and the input it consumes is written to the recorder
+    void SetRecorder(InputRecorder* pRecorder) { m_pRecorder = pRecorder; }
+
+private:
+    void ProcessInput();
+    void HandleInput(const InputEvent& event);
 
     void OnKeyDown(WPARAM wParam, LPARAM lParam);
     void OnKeyUp(WPARAM wParam, LPARAM lParam);
@@ -0,0 +1,685 @@
+#include "SelfTest.h"
+#include "FramePacer.h"
+#include "GpuProfiler.h"
+#include "InputQueue.h"
+#include "InputRecording.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct SelfTest
+    {
+        const char* name;
+        // Returns false on failure, details are printed next to the result either way
+        bool (*run)(std::string& details);
+    };
+
+    void AppendDetails(std::string& details, const char* format, ...)
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        details += details.empty() ? "" : ", ";
+        details += buffer;
+    }
+
+    double Percentile(std::vector<double>& values, double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(percentile * (values.size() - 1) + 0.5)];
+    }
+
+    double NanosecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // The producer pushes a counting sequence through a small queue so it wraps and fills up constantly, the consumer
+    // checks that every value arrives exactly once and in order, through both Front and Pop
+    bool TestSpscQueueStress(std::string& details)
+    {
+        const uint32_t ItemCount = 1000000;
+        SpscQueue<uint32_t, 64> queue;
+
+        std::thread producer([&]()
+        {
+            for (uint32_t value = 0; value < ItemCount; value++)
+            {
+                while (!queue.Push(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        uint32_t expected = 0;
+        size_t errorCount = 0;
+        while (expected < ItemCount)
+        {
+            const uint32_t* pFront = queue.Front();
+            if (pFront == nullptr)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t front = *pFront;
+            uint32_t value = 0;
+            if (!queue.Pop(value) || value != front || value != expected)
+            {
+                errorCount++;
+            }
+            expected = value + 1;
+        }
+        producer.join();
+
+        AppendDetails(details, "%u items, %zu out of order", ItemCount, errorCount);
+        return errorCount == 0 && queue.Empty();
+    }
+
+    struct StressSnapshot
+    {
+        static const size_t ValueCount = 32;
+
+        uint64_t sequence = 0;
+        uint64_t values[ValueCount] = {};
+    };
+
+    // Every published snapshot is written in full from its sequence number, so a torn read or a slot shared by both
+    // sides shows up as values that disagree with the sequence. Sequences only ever move forward for the consumer.
+    bool TestTripleBufferStress(std::string& details)
+    {
+        const uint64_t PublishCount = 200000;
+        TripleBuffer<StressSnapshot> buffer;
+
+        std::thread producer([&]()
+        {
+            for (uint64_t sequence = 1; sequence <= PublishCount; sequence++)
+            {
+                StressSnapshot& snapshot = buffer.GetWriteBuffer();
+                snapshot.sequence = sequence;
+                for (size_t i = 0; i < StressSnapshot::ValueCount; i++)
+                {
+                    snapshot.values[i] = sequence * StressSnapshot::ValueCount + i;
+                }
+                buffer.Publish();
+                // Lets the consumer in now and then where both threads share a core
+                if (sequence % 16 == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        uint64_t lastSequence = 0;
+        size_t acquireCount = 0;
+        size_t tornCount = 0;
+        size_t staleCount = 0;
+        while (lastSequence < PublishCount)
+        {
+            if (!buffer.Acquire())
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            acquireCount++;
+            const StressSnapshot& snapshot = buffer.GetReadBuffer();
+            for (size_t i = 0; i < StressSnapshot::ValueCount; i++)
+            {
+                if (snapshot.values[i] != snapshot.sequence * StressSnapshot::ValueCount + i)
+                {
+                    tornCount++;
+                    break;
+                }
+            }
+            staleCount += snapshot.sequence <= lastSequence ? 1 : 0;
+            lastSequence = std::max(lastSequence, snapshot.sequence);
+        }
+        producer.join();
+
+        AppendDetails(details, "%zu of %llu snapshots seen, %zu torn, %zu stale", acquireCount,
+            static_cast<unsigned long long>(PublishCount), tornCount, staleCount);
+        return tornCount == 0 && staleCount == 0 && !buffer.Acquire();
+    }
+
+    // Time from Publish on one thread until Acquire returns it on another, the way the simulation hands snapshots to
+    // the render thread. The producer waits for each to be seen so the consumer never skips one. Both sides poll and
+    // yield, so on a machine with fewer idle cores than threads this mostly measures the scheduler.
+    bool TestTripleBufferLatency(std::string& details)
+    {
+        const size_t HandoffCount = 20000;
+        TripleBuffer<std::chrono::steady_clock::time_point> buffer;
+        std::atomic<size_t> seenCount(0);
+
+        std::thread producer([&]()
+        {
+            for (size_t i = 0; i < HandoffCount; i++)
+            {
+                buffer.GetWriteBuffer() = std::chrono::steady_clock::now();
+                buffer.Publish();
+                while (seenCount.load(std::memory_order_acquire) == i)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        std::vector<double> latencies;
+        latencies.reserve(HandoffCount);
+        while (latencies.size() < HandoffCount)
+        {
+            if (!buffer.Acquire())
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            latencies.push_back(NanosecondsSince(buffer.GetReadBuffer()));
+            seenCount.store(latencies.size(), std::memory_order_release);
+        }
+        producer.join();
+
+        AppendDetails(details, "handoff p50 %.0f ns, p99 %.0f ns", Percentile(latencies, 0.5),
+            Percentile(latencies, 0.99));
+        return true;
+    }
+
+    // Round trips of a value through a pair of queues, half of each is the latency of one Push to Pop
+    bool TestSpscQueueLatency(std::string& details)
+    {
+        const uint32_t RoundTripCount = 20000;
+        SpscQueue<uint32_t, 64> requests;
+        SpscQueue<uint32_t, 64> responses;
+
+        std::thread echo([&]()
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < RoundTripCount; i++)
+            {
+                while (!requests.Pop(value))
+                {
+                    std::this_thread::yield();
+                }
+                responses.Push(value);
+            }
+        });
+
+        std::vector<double> latencies;
+        latencies.reserve(RoundTripCount);
+        size_t errorCount = 0;
+        for (uint32_t i = 0; i < RoundTripCount; i++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            requests.Push(i);
+            uint32_t value = 0;
+            while (!responses.Pop(value))
+            {
+                std::this_thread::yield();
+            }
+            latencies.push_back(NanosecondsSince(start) / 2.0);
+            errorCount += value != i ? 1 : 0;
+        }
+        echo.join();
+
+        AppendDetails(details, "one way p50 %.0f ns, p99 %.0f ns", Percentile(latencies, 0.5),
+            Percentile(latencies, 0.99));
+        return errorCount == 0;
+    }
+
+    InputEvent MakeInputEvent(InputEvent::TYPE type, uint32_t wParam, uint32_t lParam)
+    {
+        InputEvent event;
+        event.type = type;
+        event.wParam = wParam;
+        event.lParam = lParam;
+        return event;
+    }
+
+    // Fills the queue to the brim: releases that no longer fit must still come out, after everything queued before
+    // them, while other events are dropped and counted until the queue has drained
+    bool TestInputQueueOverflow(std::string& details)
+    {
+        const uint32_t KeyW = 'W';
+        const uint32_t KeyA = 'A';
+        InputQueue queue;
+
+        bool pushed = queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_DOWN, KeyW, 0));
+        pushed &= queue.Push(MakeInputEvent(InputEvent::TYPE::LMOUSE_DOWN, 0, 0));
+        for (uint32_t i = 2; i < InputQueue::Capacity; i++)
+        {
+            pushed &= queue.Push(MakeInputEvent(InputEvent::TYPE::MOUSE_MOVE, 0, i));
+        }
+        pushed &= queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_UP, KeyW, 0));
+        pushed &= queue.Push(MakeInputEvent(InputEvent::TYPE::LMOUSE_UP, 0, 77));
+        bool wheelDropped = !queue.Push(MakeInputEvent(InputEvent::TYPE::MOUSE_WHEEL, 120, 0));
+        bool keyDownDropped = !queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_DOWN, KeyA, 0));
+
+        const InputEvent::TYPE ExpectedTypes[] = { InputEvent::TYPE::KEY_DOWN, InputEvent::TYPE::LMOUSE_DOWN,
+            InputEvent::TYPE::MOUSE_MOVE, InputEvent::TYPE::KEY_UP, InputEvent::TYPE::LMOUSE_UP };
+        std::vector<InputEvent> events;
+        InputEvent event;
+        while (queue.Pop(event))
+        {
+            events.push_back(event);
+        }
+
+        bool inOrder = events.size() == sizeof(ExpectedTypes) / sizeof(ExpectedTypes[0]);
+        for (size_t i = 0; inOrder && i < events.size(); i++)
+        {
+            inOrder = events[i].type == ExpectedTypes[i];
+        }
+        bool valuesKept = inOrder && events[2].lParam == InputQueue::Capacity - 1 && events[3].wParam == KeyW &&
+            events[4].lParam == 77;
+        bool recovered = queue.Empty() && queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_DOWN, KeyA, 0)) &&
+            queue.Pop(event) && event.wParam == KeyA;
+
+        AppendDetails(details, "%zu events out, %llu dropped", events.size(),
+            static_cast<unsigned long long>(queue.GetDroppedCount()));
+        return pushed && wheelDropped && keyDownDropped && inOrder && valuesKept && recovered &&
+            queue.GetDroppedCount() == 2;
+    }
+
+    // A window thread that presses and releases keys between bursts of mouse moves as fast as it can, against a
+    // scene thread that drains in batches. Events that fall out of the queue are reported, but however many there
+    // are, every key has to end up released.
+    bool TestInputQueueThroughput(std::string& details)
+    {
+        const uint32_t PressCount = 200000;
+        const uint32_t MovesPerPress = 4;
+        const uint32_t KeyCount = 8;
+        InputQueue queue;
+        std::atomic<bool> producerDone(false);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::thread producer([&]()
+        {
+            for (uint32_t i = 0; i < PressCount; i++)
+            {
+                uint32_t key = 'A' + i % KeyCount;
+                queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_DOWN, key, 0));
+                for (uint32_t move = 0; move < MovesPerPress; move++)
+                {
+                    queue.Push(MakeInputEvent(InputEvent::TYPE::MOUSE_MOVE, 0, i * MovesPerPress + move));
+                }
+                queue.Push(MakeInputEvent(InputEvent::TYPE::KEY_UP, key, 0));
+                // Lets the consumer in now and then where both threads share a core
+                if (i % 64 == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            producerDone.store(true, std::memory_order_release);
+        });
+
+        bool isKeyDown[KeyCount] = {};
+        size_t poppedCount = 0;
+        for (;;)
+        {
+            bool isDone = producerDone.load(std::memory_order_acquire);
+            InputEvent event;
+            while (queue.Pop(event))
+            {
+                poppedCount++;
+                if (event.type == InputEvent::TYPE::KEY_DOWN || event.type == InputEvent::TYPE::KEY_UP)
+                {
+                    isKeyDown[(event.wParam - 'A') % KeyCount] = event.type == InputEvent::TYPE::KEY_DOWN;
+                }
+            }
+            if (isDone)
+            {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        producer.join();
+        double seconds = NanosecondsSince(start) / 1e9;
+
+        size_t stuckCount = 0;
+        for (bool isDown : isKeyDown)
+        {
+            stuckCount += isDown ? 1 : 0;
+        }
+        uint64_t pushedCount = static_cast<uint64_t>(PressCount) * (MovesPerPress + 2);
+        AppendDetails(details, "%.1f M events/s, %zu of %llu popped, %llu dropped, %zu keys stuck",
+            pushedCount / seconds / 1e6, poppedCount, static_cast<unsigned long long>(pushedCount), static_cast<unsigned long long>(queue.GetDroppedCount()),
+            stuckCount);
+        return stuckCount == 0 && queue.Empty();
+    }
+
+    // Frames written by the recorder, with up to three events each and some without any, must come back from the replay
+    // as they went in. Event times are stored as float seconds relative to the first event.
+    bool TestInputRecordingRoundTrip(std::string& details)
+    {
+        const char* const Path = "selftest_recording.l5ir";
+        const size_t FrameCount = 240;
+        // Frame 0 has no events, the first one is recorded in frame 1
+        const double StartTime = 1000.0;
+        const double FirstEventTime = StartTime + 1.0 / 60.0;
+
+        std::vector<std::vector<InputEvent>> recorded(FrameCount);
+        InputRecorder recorder;
+        if (!recorder.Open(std::wstring(Path, Path + strlen(Path))))
+        {
+            AppendDetails(details, "cannot create %s", Path);
+            return false;
+        }
+        for (size_t frame = 0; frame < FrameCount; frame++)
+        {
+            recorder.BeginFrame(1.0 / 60.0 + frame * 1e-6);
+            for (size_t i = 0; i < frame % 4; i++)
+            {
+                InputEvent event = MakeInputEvent(static_cast<InputEvent::TYPE>((frame + i) % 6),
+                    static_cast<uint32_t>(frame * 7 + i), static_cast<uint32_t>(frame << 16 | i));
+                event.time = StartTime + frame / 60.0 + i * 0.001;
+                recorder.RecordEvent(event);
+                recorded[frame].push_back(event);
+            }
+            recorder.EndFrame();
+        }
+        recorder.Close();
+
+        InputReplay replay;
+        bool isOpen = replay.Open(std::wstring(Path, Path + strlen(Path)));
+        remove(Path);
+        if (!isOpen)
+        {
+            AppendDetails(details, "cannot read %s back", Path);
+            return false;
+        }
+
+        size_t frameCount = 0;
+        size_t mismatchCount = 0;
+        double deltaTime = 0.0;
+        std::vector<InputEvent> events;
+        while (replay.NextFrame(deltaTime, events))
+        {
+            const std::vector<InputEvent>& expected = recorded[frameCount % FrameCount];
+            bool matches = deltaTime == 1.0 / 60.0 + frameCount * 1e-6 && events.size() == expected.size();
+            for (size_t i = 0; matches && i < events.size(); i++)
+            {
+                matches = events[i].type == expected[i].type && events[i].wParam == expected[i].wParam &&
+                    events[i].lParam == expected[i].lParam &&
+                    std::abs(events[i].time - (expected[i].time - FirstEventTime)) < 1e-4;
+            }
+            mismatchCount += matches ? 0 : 1;
+            frameCount++;
+        }
+
+        AppendDetails(details, "%zu of %zu frames read back, %zu differ", frameCount, FrameCount, mismatchCount);
+        return frameCount == FrameCount && replay.GetFrameCount() == FrameCount && mismatchCount == 0;
+    }
+
+    // Stands in for the GPU: a timestamp is the CPU clock when it is written, plus a lag for how long the GPU takes to
+    // get to it, on a 10 MHz clock with its own epoch. Slots begun while the GPU is stalled only become readable once
+    // it catches up.
+    class FakeQueryBackend : public GpuQueryBackend
+    {
+    public:
+        static const uint64_t Frequency = 10000000;
+        // CPU minus GPU time in nanoseconds, the offset the profiler has to find
+        static const int64_t ClockOffset = -123456789012345;
+
+        bool isStalled = false;
+        bool isNextFrameDisjoint = false;
+        uint64_t lag = 0;
+
+        bool CreateQueries(uint32_t slotCount, uint32_t timestampsPerSlot) override
+        {
+            m_slots.assign(slotCount, Slot());
+            for (Slot& slot : m_slots)
+            {
+                slot.timestamps.assign(timestampsPerSlot, 0);
+            }
+            return true;
+        }
+
+        void ReleaseQueries() override
+        {
+            m_slots.clear();
+        }
+
+        void BeginDisjoint(uint32_t slot) override
+        {
+            m_slots[slot].isReady = false;
+            m_slots[slot].isDisjoint = isNextFrameDisjoint;
+        }
+
+        void EndDisjoint(uint32_t slot) override
+        {
+            m_slots[slot].isReady = !isStalled;
+        }
+
+        void WriteTimestamp(uint32_t slot, uint32_t index) override
+        {
+            m_slots[slot].timestamps[index] = (Profiler::Now() + lag - ClockOffset) / (1000000000 / Frequency);
+        }
+
+        bool ReadResults(uint32_t slot, uint32_t count, uint64_t* pTimestamps, uint64_t& frequency,
+            bool& isDisjoint) override
+        {
+            if (!m_slots[slot].isReady)
+            {
+                return false;
+            }
+            std::copy(m_slots[slot].timestamps.begin(), m_slots[slot].timestamps.begin() + count, pTimestamps);
+            frequency = Frequency;
+            isDisjoint = m_slots[slot].isDisjoint;
+            return true;
+        }
+
+        // Every slot that has been ended becomes readable
+        void CatchUp()
+        {
+            isStalled = false;
+            for (Slot& slot : m_slots)
+            {
+                slot.isReady = true;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            std::vector<uint64_t> timestamps;
+            bool isReady = false;
+            bool isDisjoint = false;
+        };
+
+        std::vector<Slot> m_slots;
+    };
+
+    void RecordGpuFrame(GpuProfiler& profiler)
+    {
+        profiler.BeginFrame();
+        uint32_t zone = profiler.BeginZone("Pass");
+        profiler.EndZone(zone);
+        profiler.EndFrame();
+    }
+
+    // A frame the GPU has not finished must stay pending without blocking, then resolve once it has
+    bool TestGpuProfilerNotReady(std::string& details)
+    {
+        FakeQueryBackend backend;
+        GpuProfiler profiler;
+        profiler.Init(&backend);
+        profiler.SetEnabled(true);
+
+        backend.isStalled = true;
+        RecordGpuFrame(profiler);
+        RecordGpuFrame(profiler);
+        size_t pendingCount = profiler.GetResolvedZoneCount();
+
+        backend.CatchUp();
+        profiler.BeginFrame();
+        size_t resolvedCount = profiler.GetResolvedZoneCount();
+        uint64_t latency = profiler.GetResolveLatency();
+        profiler.EndFrame();
+        profiler.Term();
+
+        AppendDetails(details, "%zu zones while pending, %zu once ready, latency %llu frames", pendingCount,
+            resolvedCount, static_cast<unsigned long long>(latency));
+        return pendingCount == 0 && resolvedCount == 2 && latency == 1 && profiler.GetDroppedFrameCount() == 0;
+    }
+
+    // With every slot of the ring in flight the next frame is skipped rather than waited for, and recording goes on
+    // once the GPU catches up
+    bool TestGpuProfilerRingFull(std::string& details)
+    {
+        FakeQueryBackend backend;
+        GpuProfiler profiler;
+        profiler.Init(&backend);
+        profiler.SetEnabled(true);
+
+        backend.isStalled = true;
+        for (uint32_t frame = 0; frame <= GpuProfiler::SlotCount; frame++)
+        {
+            RecordGpuFrame(profiler);
+        }
+        uint64_t droppedWhileStalled = profiler.GetDroppedFrameCount();
+
+        backend.CatchUp();
+        RecordGpuFrame(profiler);
+        RecordGpuFrame(profiler);
+        uint64_t droppedAfter = profiler.GetDroppedFrameCount();
+        bool hasResolved = profiler.GetResolvedZoneCount() == 2;
+        profiler.Term();
+
+        AppendDetails(details, "%llu dropped while stalled, %llu after catching up",
+            static_cast<unsigned long long>(droppedWhileStalled), static_cast<unsigned long long>(droppedAfter));
+        return droppedWhileStalled == 1 && droppedAfter == 1 && hasResolved;
+    }
+
+    // The timestamps of a disjoint frame are meaningless, it must be counted and its zones discarded
+    bool TestGpuProfilerDisjoint(std::string& details)
+    {
+        FakeQueryBackend backend;
+        GpuProfiler profiler;
+        profiler.Init(&backend);
+        profiler.SetEnabled(true);
+
+        backend.isNextFrameDisjoint = true;
+        RecordGpuFrame(profiler);
+        backend.isNextFrameDisjoint = false;
+        profiler.BeginFrame();
+        size_t resolvedCount = profiler.GetResolvedZoneCount();
+        uint64_t disjointCount = profiler.GetDisjointFrameCount();
+        profiler.EndFrame();
+        profiler.Term();
+
+        AppendDetails(details, "%llu disjoint, %zu zones resolved", static_cast<unsigned long long>(disjointCount),
+            resolvedCount);
+        return disjointCount == 1 && resolvedCount == 0;
+    }
+
+    // A frame the GPU runs right away pins the offset between the clocks: its resolved start has to land between the
+    // CPU times around BeginFrame. A later frame the GPU only gets to after a lag must keep that offset, so the lag
+    // shows up in its resolved start instead of being absorbed into the calibration.
+    bool TestGpuProfilerClockOffset(std::string& details)
+    {
+        const uint64_t Lag = 5000000;
+        const uint64_t Tick = 1000000000 / FakeQueryBackend::Frequency;
+        FakeQueryBackend backend;
+        GpuProfiler profiler;
+        profiler.Init(&backend);
+        profiler.SetEnabled(true);
+
+        uint64_t before = Profiler::Now();
+        RecordGpuFrame(profiler);
+        uint64_t after = Profiler::Now();
+        profiler.BeginFrame();
+        uint64_t start = profiler.GetResolvedZoneCount() != 0 ? profiler.GetResolvedZone(0).start : 0;
+        profiler.EndFrame();
+
+        backend.lag = Lag;
+        uint64_t lagBefore = Profiler::Now();
+        RecordGpuFrame(profiler);
+        uint64_t lagAfter = Profiler::Now();
+        profiler.BeginFrame();
+        uint64_t lagStart = profiler.GetResolvedZoneCount() != 0 ? profiler.GetResolvedZone(0).start : 0;
+        profiler.EndFrame();
+        profiler.Term();
+
+        AppendDetails(details, "frame start %+.1f us after BeginFrame, lagged %+.1f us",
+            (static_cast<double>(start) - static_cast<double>(before)) / 1000.0,
+            (static_cast<double>(lagStart) - static_cast<double>(lagBefore)) / 1000.0);
+        return start + Tick >= before && start <= after + Tick && lagStart + Tick >= lagBefore + Lag &&
+            lagStart <= lagAfter + Lag + Tick;
+    }
+
+    // Two seconds at 120 Hz through the sleep and spin path of the render thread. The spin has to hide the timer
+    // granularity for the typical frame; preemption on a busy machine may still delay a few by up to half a frame.
+    bool TestFramePacerDeadlines(std::string& details)
+    {
+        const double FrameRate = 120.0;
+        const double SpinTime = 0.001;
+        const double MaxMedianLateness = 0.0002;
+        const double MaxP99Lateness = 0.5 / FrameRate;
+        const size_t FrameCount = 240;
+
+        PacingAccuracy accuracy;
+        MeasurePacingAccuracy(FrameRate, SpinTime, FrameCount, accuracy);
+        AppendDetails(details, "lateness p50 %.1f us, p99 %.1f us, max %.1f us, %zu missed", accuracy.p50Lateness * 1e6,
+            accuracy.p99Lateness * 1e6, accuracy.maxLateness * 1e6, accuracy.missedDeadlines);
+        return accuracy.p50Lateness <= MaxMedianLateness && accuracy.p99Lateness <= MaxP99Lateness &&
+            accuracy.missedDeadlines <= FrameCount / 100;
+    }
+
+    const SelfTest SelfTests[] = {
+        { "spsc_queue/stress", TestSpscQueueStress },
+        { "spsc_queue/latency", TestSpscQueueLatency },
+        { "triple_buffer/stress", TestTripleBufferStress },
+        { "triple_buffer/latency", TestTripleBufferLatency },
+        { "input_queue/overflow", TestInputQueueOverflow },
+        { "input_queue/throughput", TestInputQueueThroughput },
+        { "input_recording/round_trip", TestInputRecordingRoundTrip },
+        { "gpu_profiler/not_ready", TestGpuProfilerNotReady },
+        { "gpu_profiler/ring_full", TestGpuProfilerRingFull },
+        { "gpu_profiler/disjoint", TestGpuProfilerDisjoint },
+        { "gpu_profiler/clock_offset", TestGpuProfilerClockOffset },
+        { "frame_pacer/deadlines_120hz", TestFramePacerDeadlines },
+    };
+
+    bool MatchesFilter(const char* name, const std::wstring& filter)
+    {
+        std::wstring wideName(name, name + strlen(name));
+        return filter.empty() || wideName.find(filter) != std::wstring::npos;
+    }
+}
+
+int RunSelfTests(const std::wstring& filter)
+{
+    size_t runCount = 0;
+    size_t failedCount = 0;
+    for (const SelfTest& test : SelfTests)
+    {
+        if (!MatchesFilter(test.name, filter))
+        {
+            continue;
+        }
+
+        std::string details;
+        bool passed = test.run(details);
+        printf("%-36s %-4s %s\n", test.name, passed ? "ok" : "FAIL", details.c_str());
+        fflush(stdout);
+        runCount++;
+        failedCount += passed ? 0 : 1;
+    }
+    printf("%zu of %zu tests passed\n", runCount - failedCount, runCount);
+    return failedCount == 0 ? 0 : 2;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+// Correctness and stress tests of the portable building blocks. They only use the standard library, so besides
+// the --self-test mode of the application SelfTestMain.cpp builds them on their own, e.g. with ThreadSanitizer.
+// Runs the tests whose name contains filter, prints a line per test and returns 2 if any of them failed.
+int RunSelfTests(const std::wstring& filter);
@@ -0,0 +1,15 @@
+// Entry point of the self tests outside the application, it is not part of the Visual Studio project. On Linux,
+// with the tested sources after the two of the tests themselves:
+//   g++ -std=c++14 -O1 -g -fsanitize=thread -pthread -o selftest SelfTestMain.cpp SelfTest.cpp
+//       FramePacer.cpp InputQueue.cpp InputRecording.cpp GpuProfiler.cpp Profiler.cpp
+//   ./selftest [filter]
+
+#include "SelfTest.h"
+
+#include <string>
+
+int main(int argc, char** argv)
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    return RunSelfTests(std::wstring(filter.begin(), filter.end()));
+}
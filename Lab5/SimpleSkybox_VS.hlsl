@@ -9,6 +9,12 @@ cbuffer SceneTransformsBuffer : register (b1)
     float4x4 model;
 };
 
+cbuffer MeshDecodeBuffer : register (b2)
+{
+    float4 positionScale;
+    float4 positionOffset;
+};
+
 struct VSInput
 {
     float3 pos : POSITION;
@@ -23,9 +29,10 @@ struct VSOutput
 VSOutput vs(VSInput vertex)
 {
     VSOutput result;
-    float4 pos = mul(model, float4(vertex.pos, 1.0)) + float4(cameraPos.xyz, 0.0);
+    float3 localPos = vertex.pos * positionScale.xyz + positionOffset.xyz;
+    float4 pos = mul(model, float4(localPos, 1.0)) + float4(cameraPos.xyz, 0.0);
     result.pos = mul(vp, pos);
     result.pos.z = 0.0;
-    result.localPos = vertex.pos;
+    result.localPos = localPos;
     return result;
 }
@@ -8,6 +8,12 @@ cbuffer SceneTransformsBuffer : register (b1)
     float4x4 model;
 };
 
+cbuffer MeshDecodeBuffer : register (b2)
+{
+    float4 positionScale;
+    float4 positionOffset;
+};
+
 
 struct VSInput
 {
@@ -25,7 +31,8 @@ VSOutput vs(VSInput vertex)
 {
     VSOutput result;
 
-    result.pos = mul(vp, mul(model, float4(vertex.pos, 1.0)));
+    float3 pos = vertex.pos * positionScale.xyz + positionOffset.xyz;
+    result.pos = mul(vp, mul(model, float4(pos, 1.0)));
     result.uv = vertex.uv;
 
     return result;
@@ -9,6 +9,12 @@ cbuffer SceneTransformsBuffer : register (b1)
     float4 color;
 };
 
+cbuffer MeshDecodeBuffer : register (b2)
+{
+    float4 positionScale;
+    float4 positionOffset;
+};
+
 
 struct VSInput
 {
@@ -26,7 +32,8 @@ VSOutput vs(VSInput vertex)
 {
     VSOutput result;
 
-    result.pos = mul(vp, mul(model, float4(vertex.pos, 1.0)));
+    float3 pos = vertex.pos * positionScale.xyz + positionOffset.xyz;
+    result.pos = mul(vp, mul(model, float4(pos, 1.0)));
     result.uv = vertex.uv;
 
     return result;
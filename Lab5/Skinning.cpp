@@ -0,0 +1,85 @@
+#include "Skinning.h"
+
+#include <immintrin.h>
+
+void SkinVerticesScalar(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count,
+    SkinnedVertex* pDestination)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const SkinVertex& vertex = pSource[i];
+        const JointMatrix& m0 = pPalette[vertex.joints[0]];
+        const JointMatrix& m1 = pPalette[vertex.joints[1]];
+        const JointMatrix& m2 = pPalette[vertex.joints[2]];
+        const JointMatrix& m3 = pPalette[vertex.joints[3]];
+
+        // Same order of operations as the vector version, so both agree bit for bit
+        float blended[4][3];
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                blended[column][row] = m0.columns[column][row] * vertex.weights[0] +
+                    m1.columns[column][row] * vertex.weights[1] + m2.columns[column][row] * vertex.weights[2] +
+                    m3.columns[column][row] * vertex.weights[3];
+            }
+        }
+
+        SkinnedVertex& result = pDestination[i];
+        for (int row = 0; row < 3; row++)
+        {
+            result.position[row] = blended[0][row] * vertex.position[0] + blended[1][row] * vertex.position[1] +
+                blended[2][row] * vertex.position[2] + blended[3][row];
+            result.normal[row] = blended[0][row] * vertex.normal[0] + blended[1][row] * vertex.normal[1] +
+                blended[2][row] * vertex.normal[2];
+        }
+    }
+}
+
+void SkinVerticesSse(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count, SkinnedVertex* pDestination)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const SkinVertex& vertex = pSource[i];
+        const float* m0 = pPalette[vertex.joints[0]].columns[0];
+        const float* m1 = pPalette[vertex.joints[1]].columns[0];
+        const float* m2 = pPalette[vertex.joints[2]].columns[0];
+        const float* m3 = pPalette[vertex.joints[3]].columns[0];
+
+        __m128 weights = _mm_loadu_ps(vertex.weights);
+        __m128 w0 = _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 w1 = _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 w2 = _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 w3 = _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m128 columns[4];
+        for (int column = 0; column < 4; column++)
+        {
+            __m128 blended = _mm_mul_ps(_mm_load_ps(m0 + column * 4), w0);
+            blended = _mm_add_ps(blended, _mm_mul_ps(_mm_load_ps(m1 + column * 4), w1));
+            blended = _mm_add_ps(blended, _mm_mul_ps(_mm_load_ps(m2 + column * 4), w2));
+            columns[column] = _mm_add_ps(blended, _mm_mul_ps(_mm_load_ps(m3 + column * 4), w3));
+        }
+
+        __m128 position = _mm_mul_ps(columns[0], _mm_set1_ps(vertex.position[0]));
+        position = _mm_add_ps(position, _mm_mul_ps(columns[1], _mm_set1_ps(vertex.position[1])));
+        position = _mm_add_ps(position, _mm_mul_ps(columns[2], _mm_set1_ps(vertex.position[2])));
+        position = _mm_add_ps(position, columns[3]);
+
+        __m128 normal = _mm_mul_ps(columns[0], _mm_set1_ps(vertex.normal[0]));
+        normal = _mm_add_ps(normal, _mm_mul_ps(columns[1], _mm_set1_ps(vertex.normal[1])));
+        normal = _mm_add_ps(normal, _mm_mul_ps(columns[2], _mm_set1_ps(vertex.normal[2])));
+
+        // The fourth lane of the position lands on normal x and is overwritten right after; the normal is stored as
+        // two plus one floats so the last vertex never writes past the end of the destination
+        float* pResult = pDestination[i].position;
+        _mm_storeu_ps(pResult, position);
+        _mm_storel_pi(reinterpret_cast<__m64*>(pResult + 3), normal);
+        _mm_store_ss(pResult + 5, _mm_movehl_ps(normal, normal));
+    }
+}
+
+void SkinVertices(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count, SkinnedVertex* pDestination)
+{
+    SkinVerticesSse(pPalette, pSource, count, pDestination);
+}
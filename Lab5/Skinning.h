@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Animation.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Bind pose vertex with up to four joint influences. Unused influences have a weight of zero, weights sum to one and
+// every joint index must be inside the palette.
+struct SkinVertex
+{
+    float position[3];
+    float normal[3];
+    float weights[4];
+    uint16_t joints[4];
+};
+
+// Same layout as a float position and normal vertex, so the output can be copied into a vertex buffer as is
+struct SkinnedVertex
+{
+    float position[3];
+    float normal[3];
+};
+
+// Blends the palette matrices of each vertex by its weights and transforms the position and normal with the result.
+// Normals are not renormalized, their length drifts slightly where joints with different rotations blend.
+void SkinVertices(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count, SkinnedVertex* pDestination);
+
+// Fixed instruction set variants, exposed for validation and benchmarks. SSE2 is always there on x64 and is what
+// SkinVertices runs; a matrix column is one register, so each vertex blends four columns of four joints.
+void SkinVerticesScalar(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count,
+    SkinnedVertex* pDestination);
+void SkinVerticesSse(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count, SkinnedVertex* pDestination);
@@ -0,0 +1,337 @@
+#include "SkinningBenchmark.h"
+#include "Animation.h"
+#include "Skinning.h"
+#include "JobPool.h"
+#include "ProceduralMesh.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    typedef void (*SkinFunction)(const JointMatrix* pPalette, const SkinVertex* pSource, size_t count,
+        SkinnedVertex* pDestination);
+
+    struct SkinningVariant
+    {
+        const char* name;
+        SkinFunction skin;
+        bool jobs;
+    };
+
+    const SkinningVariant SkinningVariants[] =
+    {
+        { "scalar", SkinVerticesScalar, false },
+        { "sse", SkinVerticesSse, false },
+        { "sse_jobs", SkinVerticesSse, true },
+    };
+
+    struct Character
+    {
+        float timeOffset = 0.0f;
+        std::vector<JointPose> poses;
+        std::vector<JointMatrix> globals;
+        std::vector<JointMatrix> palette;
+        std::vector<SkinnedVertex> vertices;
+    };
+
+    // Skinning work of a frame, split so jobs are about the same size however few characters there are
+    struct SkinningChunk
+    {
+        size_t character;
+        size_t firstVertex;
+        size_t vertexCount;
+    };
+
+    // Joints stacked along y from the bottom of the cylinder, each one segment above its parent
+    void BuildBoneChain(uint32_t boneCount, float height, Skeleton& skeleton)
+    {
+        float segment = height / boneCount;
+        for (uint32_t i = 0; i < boneCount; i++)
+        {
+            JointPose pose;
+            pose.translation[1] = i == 0 ? -0.5f * height : segment;
+            skeleton.parents.push_back(int32_t(i) - 1);
+            skeleton.bindPose.push_back(pose);
+        }
+    }
+
+    // Every vertex takes the four joints around its height, weighted by distance so all four influences are in use
+    void BuildSkinVertices(const MeshData& mesh, uint32_t boneCount, float height, std::vector<SkinVertex>& vertices)
+    {
+        float segment = height / boneCount;
+        vertices.resize(mesh.GetVertexCount());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            SkinVertex& vertex = vertices[i];
+            for (int k = 0; k < 3; k++)
+            {
+                vertex.position[k] = mesh.positions[i * 3 + k];
+                vertex.normal[k] = mesh.normals[i * 3 + k];
+            }
+
+            float bone = (vertex.position[1] + 0.5f * height) / segment - 0.5f;
+            int32_t first = int32_t(floorf(bone)) - 1;
+            float weightSum = 0.0f;
+            for (int k = 0; k < 4; k++)
+            {
+                int32_t joint = first + k;
+                bool inside = joint >= 0 && joint < int32_t(boneCount);
+                vertex.joints[k] = inside ? uint16_t(joint) : 0;
+                vertex.weights[k] = inside ? max(0.0f, 1.0f - 0.5f * fabsf(bone - joint)) : 0.0f;
+                weightSum += vertex.weights[k];
+            }
+            for (int k = 0; k < 4; k++)
+            {
+                vertex.weights[k] /= weightSum;
+            }
+        }
+    }
+
+    // Every joint swings around z with a phase shifted along the chain, keyed at frameRate
+    void BuildBendClip(const Skeleton& skeleton, float duration, float frameRate, AnimationClip& clip)
+    {
+        size_t jointCount = skeleton.GetJointCount();
+        size_t keyCount = size_t(duration * frameRate) + 1;
+        float amplitude = 2.0f / jointCount;
+        clip.duration = duration;
+        clip.tracks.resize(jointCount);
+        for (size_t joint = 0; joint < jointCount; joint++)
+        {
+            AnimationTrack& track = clip.tracks[joint];
+            for (size_t key = 0; key < keyCount; key++)
+            {
+                float angle = amplitude * sinf(2.0f * Pi * key / (keyCount - 1) + 0.5f * joint);
+                JointPose pose = skeleton.bindPose[joint];
+                pose.rotation[2] = sinf(0.5f * angle);
+                pose.rotation[3] = cosf(0.5f * angle);
+                track.times.push_back(duration * key / (keyCount - 1));
+                track.poses.push_back(pose);
+            }
+        }
+    }
+
+    double Percentile(std::vector<double> values, double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        size_t idx = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return values[idx];
+    }
+
+    double Mean(const std::vector<double>& values)
+    {
+        double sum = 0.0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        return values.empty() ? 0.0 : sum / values.size();
+    }
+}
+
+int RunSkinningBenchmark(const AppOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const float Height = 1.8f;
+    const float ClipDuration = 2.0f;
+    const float KeyRate = 30.0f;
+    const float SimulationStep = 1.0f / 60;
+    const size_t WarmupFrames = 10;
+    const size_t ChunkVertices = 1024;
+
+    if (options.characterCount == 0 || options.boneCount == 0 || options.boneCount > 65536)
+    {
+        wprintf(L"Skinning needs at least one character and 1 to 65536 bones\n");
+        return 1;
+    }
+    uint32_t boneCount = static_cast<uint32_t>(options.boneCount);
+
+    // All characters share the bind mesh, skeleton and clip like a crowd would; each has its own time and output
+    MeshData mesh;
+    GenerateCylinder(0.15f, Height, 24, 64, MeshOptions(), mesh);
+    Skeleton skeleton;
+    BuildBoneChain(boneCount, Height, skeleton);
+    if (!skeleton.Finalize())
+    {
+        wprintf(L"Invalid skeleton\n");
+        return 1;
+    }
+    std::vector<SkinVertex> bindVertices;
+    BuildSkinVertices(mesh, boneCount, Height, bindVertices);
+    AnimationClip clip;
+    BuildBendClip(skeleton, ClipDuration, KeyRate, clip);
+    size_t vertexCount = bindVertices.size();
+
+    std::vector<Character> characters(options.characterCount);
+    std::vector<SkinningChunk> chunks;
+    for (size_t i = 0; i < characters.size(); i++)
+    {
+        Character& character = characters[i];
+        character.timeOffset = 0.37f * i;
+        character.poses.resize(boneCount);
+        character.globals.resize(boneCount);
+        character.palette.resize(boneCount);
+        character.vertices.resize(vertexCount);
+        for (size_t first = 0; first < vertexCount; first += ChunkVertices)
+        {
+            chunks.push_back({ i, first, min(ChunkVertices, vertexCount - first) });
+        }
+    }
+
+    JobPool pool(max(1u, std::thread::hardware_concurrency()));
+    std::vector<SkinnedVertex> reference;
+    size_t frameCount = options.benchmarkFrames;
+
+    FILE* pReport = nullptr;
+    if (!options.reportPath.empty())
+    {
+        _wfopen_s(&pReport, options.reportPath.c_str(), L"w");
+        if (pReport == nullptr)
+        {
+            wprintf(L"Failed to open report file %s\n", options.reportPath.c_str());
+            return 1;
+        }
+        fprintf(pReport, "{\n  \"characters\": %zu,\n  \"bones\": %u,\n  \"verticesPerCharacter\": %zu,\n  \"frames\": %zu,\n"
+            "  \"variants\": [\n", characters.size(), boneCount, vertexCount, frameCount);
+    }
+
+    wprintf(L"%zu characters, %u bones, %zu vertices each, %zu frames\n", characters.size(), boneCount, vertexCount,
+        frameCount);
+    wprintf(L"%-10s %7s %10s %10s %10s %10s %10s\n", L"variant", L"threads", L"animate ms", L"skin ms", L"p50 ms",
+        L"p99 ms", L"Mvert/s");
+    int result = 0;
+    for (size_t variantIndex = 0; variantIndex < sizeof(SkinningVariants) / sizeof(SkinningVariants[0]); variantIndex++)
+    {
+        const SkinningVariant& variant = SkinningVariants[variantIndex];
+        uint32_t threadCount = variant.jobs ? pool.GetThreadCount() : 1;
+        for (Character& character : characters)
+        {
+            std::fill(character.vertices.begin(), character.vertices.end(), SkinnedVertex());
+        }
+
+        auto animate = [&](size_t index, float time)
+        {
+            Character& character = characters[index];
+            SampleClip(skeleton, clip, time + character.timeOffset, character.poses.data());
+            ComputeSkinningPalette(skeleton, character.poses.data(), character.globals.data(), character.palette.data());
+        };
+        auto skin = [&](const SkinningChunk& chunk)
+        {
+            Character& character = characters[chunk.character];
+            variant.skin(character.palette.data(), bindVertices.data() + chunk.firstVertex, chunk.vertexCount,
+                character.vertices.data() + chunk.firstVertex);
+        };
+
+        std::vector<double> animateTimes;
+        std::vector<double> skinTimes;
+        std::vector<double> frameTimes;
+        animateTimes.reserve(frameCount);
+        skinTimes.reserve(frameCount);
+        frameTimes.reserve(frameCount);
+        size_t allocatingFrames = 0;
+        for (size_t frame = 0; frame < WarmupFrames + frameCount; frame++)
+        {
+            float time = frame * SimulationStep;
+            uint64_t allocationsBefore = GetHeapAllocationCount();
+            Clock::time_point start = Clock::now();
+            if (variant.jobs)
+            {
+                pool.Run(characters.size(), [&](size_t index) { animate(index, time); });
+            }
+            else
+            {
+                for (size_t index = 0; index < characters.size(); index++)
+                {
+                    animate(index, time);
+                }
+            }
+            Clock::time_point animated = Clock::now();
+            if (variant.jobs)
+            {
+                pool.Run(chunks.size(), [&](size_t index) { skin(chunks[index]); });
+            }
+            else
+            {
+                for (const SkinningChunk& chunk : chunks)
+                {
+                    skin(chunk);
+                }
+            }
+            Clock::time_point skinned = Clock::now();
+            uint64_t allocationsAfter = GetHeapAllocationCount();
+
+            if (frame >= WarmupFrames)
+            {
+                animateTimes.push_back(std::chrono::duration<double, std::milli>(animated - start).count());
+                skinTimes.push_back(std::chrono::duration<double, std::milli>(skinned - animated).count());
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(skinned - start).count());
+                allocatingFrames += allocationsAfter != allocationsBefore ? 1 : 0;
+            }
+        }
+
+        // Every variant ends on the same frame, the first one is the reference for the others
+        float maxError = 0.0f;
+        for (size_t i = 0; i < characters.size(); i++)
+        {
+            const std::vector<SkinnedVertex>& vertices = characters[i].vertices;
+            if (variantIndex == 0)
+            {
+                reference.insert(reference.end(), vertices.begin(), vertices.end());
+                continue;
+            }
+            const float* pActual = vertices[0].position;
+            const float* pExpected = reference[i * vertexCount].position;
+            for (size_t k = 0; k < vertexCount * 6; k++)
+            {
+                maxError = max(maxError, fabsf(pActual[k] - pExpected[k]));
+            }
+        }
+
+        double skinMean = Mean(skinTimes);
+        double throughput = skinMean > 0.0 ? characters.size() * vertexCount / (skinMean * 1000.0) : 0.0;
+        wprintf(L"%-10S %7u %10.3f %10.3f %10.3f %10.3f %10.1f\n", variant.name, threadCount, Mean(animateTimes),
+            skinMean, Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.99), throughput);
+        if (pReport != nullptr)
+        {
+            fprintf(pReport, "%s    { \"name\": \"%s\", \"threads\": %u, \"animateMs\": %.4f, \"skinMs\": %.4f, "
+                "\"frameMs\": { \"p50\": %.4f, \"p99\": %.4f }, \"mverticesPerSecond\": %.3f, \"maxError\": %g, "
+                "\"allocatingFrames\": %zu }", variantIndex == 0 ? "" : ",\n", variant.name, threadCount,
+                Mean(animateTimes), skinMean, Percentile(frameTimes, 0.5), Percentile(frameTimes, 0.99), throughput,
+                maxError, allocatingFrames);
+        }
+
+        if (maxError > 1e-4f)
+        {
+            wprintf(L"FAILED: %S differs from the scalar variant by %g\n", variant.name, maxError);
+            result = 2;
+        }
+        if (allocatingFrames != 0)
+        {
+            wprintf(L"FAILED: %zu of %zu %S frames performed heap allocations\n", allocatingFrames, frameCount,
+                variant.name);
+            result = 2;
+        }
+    }
+
+#if !ENABLE_ALLOCATION_COUNTER
+    wprintf(L"Heap allocations per frame were not checked, use the Benchmark configuration or ENABLE_ALLOCATION_COUNTER=1 to check them\n");
+#endif
+
+    if (pReport != nullptr)
+    {
+        fprintf(pReport, "\n  ]\n}\n");
+        fclose(pReport);
+    }
+    return result;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "CommandLine.h"
+
+// Animates options.characterCount cylinders bent by a chain of options.boneCount joints for options.benchmarkFrames
+// frames without rendering, once per skinning variant: scalar and SSE on the calling thread and SSE split into jobs.
+// Prints the sampling and palette time, the skinning time and throughput of each. Returns 2 if a variant disagrees
+// with the scalar one or a frame allocates.
+int RunSkinningBenchmark(const AppOptions& options);
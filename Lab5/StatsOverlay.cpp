@@ -0,0 +1,108 @@
+#include "StatsOverlay.h"
+#include "utils.h"
+
+HRESULT StatsOverlay::Init()
+{
+    HRESULT result = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pFactory);
+    if (SUCCEEDED(result))
+    {
+        result = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), (IUnknown**)&m_pWriteFactory);
+    }
+    if (SUCCEEDED(result))
+    {
+        result = m_pWriteFactory->CreateTextFormat(L"Consolas", NULL, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL, 13.0f, L"en-us", &m_pTextFormat);
+    }
+    assert(SUCCEEDED(result));
+    return result;
+}
+
+void StatsOverlay::Term()
+{
+    ReleaseTarget();
+    SAFE_RELEASE(m_pTextFormat);
+    SAFE_RELEASE(m_pWriteFactory);
+    SAFE_RELEASE(m_pFactory);
+}
+
+HRESULT StatsOverlay::SetTarget(ID3D11Texture2D* pBackBuffer)
+{
+    ReleaseTarget();
+    if (m_pFactory == NULL)
+    {
+        return E_FAIL;
+    }
+
+    IDXGISurface* pSurface = NULL;
+    HRESULT result = pBackBuffer->QueryInterface(__uuidof(IDXGISurface), (void**)&pSurface);
+    if (SUCCEEDED(result))
+    {
+        D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_DEFAULT,
+            D2D1::PixelFormat(DXGI_FORMAT_UNKNOWN, D2D1_ALPHA_MODE_PREMULTIPLIED));
+        result = m_pFactory->CreateDxgiSurfaceRenderTarget(pSurface, &props, &m_pRenderTarget);
+    }
+    if (SUCCEEDED(result))
+    {
+        result = m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_pTextBrush);
+    }
+    if (SUCCEEDED(result))
+    {
+        result = m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.6f), &m_pBackgroundBrush);
+    }
+    SAFE_RELEASE(pSurface);
+    assert(SUCCEEDED(result));
+    return result;
+}
+
+void StatsOverlay::ReleaseTarget()
+{
+    SAFE_RELEASE(m_pBackgroundBrush);
+    SAFE_RELEASE(m_pTextBrush);
+    SAFE_RELEASE(m_pRenderTarget);
+}
+
+HRESULT StatsOverlay::Draw(const RenderStatsHistory& history)
+{
+    if (m_pRenderTarget == NULL)
+    {
+        return E_FAIL;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (m_text.empty() || now - m_lastUpdate >= std::chrono::milliseconds(250))
+    {
+        UpdateText(history);
+        m_lastUpdate = now;
+    }
+
+    const D2D1_RECT_F rect = D2D1::RectF(8.0f, 8.0f, 8.0f + 620.0f, 8.0f + 110.0f);
+
+    m_pRenderTarget->BeginDraw();
+    m_pRenderTarget->FillRectangle(rect, m_pBackgroundBrush);
+    m_pRenderTarget->DrawText(m_text.c_str(), (UINT32)m_text.length(), m_pTextFormat,
+        D2D1::RectF(rect.left + 6.0f, rect.top + 4.0f, rect.right, rect.bottom), m_pTextBrush);
+    return m_pRenderTarget->EndDraw();
+}
+
+void StatsOverlay::UpdateText(const RenderStatsHistory& history)
+{
+    // Counters of the last frame, CPU times averaged over the history to keep them readable
+    RenderStats average = history.GetAverage();
+    RenderStats last = history.GetCount() > 0 ? history.GetFrame(0) : RenderStats();
+
+    wchar_t line[256];
+    m_text = L"pass         draws      prims  updates       KB  shaders  states  binds  culled  cpu ms\n";
+
+    for (size_t passIdx = 0; passIdx <= RenderStats::PassCount; passIdx++)
+    {
+        bool isTotal = passIdx == RenderStats::PassCount;
+        PassStats stats = isTotal ? last.GetTotal() : last.passes[passIdx];
+        double cpuTime = isTotal ? average.GetTotal().cpuTime : average.passes[passIdx].cpuTime;
+        const char* name = isTotal ? "total" : GetRenderPassName(static_cast<RENDER_PASS>(passIdx));
+
+        swprintf_s(line, L"%-11S %6u %10llu %8u %8.1f %8u %7u %6u %7u %7.3f\n", name, stats.drawCalls,
+            static_cast<unsigned long long>(stats.primitives), stats.bufferUpdates, stats.bytesUploaded / 1024.0,
+            stats.shaderBinds, stats.stateBinds, stats.resourceBinds, stats.culledObjects, cpuTime * 1000.0);
+        m_text += line;
+    }
+}
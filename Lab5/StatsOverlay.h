@@ -0,0 +1,37 @@
+#pragma once
+
+#include "framework.h"
+#include "RenderStats.h"
+
+#include <d2d1.h>
+#include <dwrite.h>
+
+// Draws render statistics as text over the swap chain back buffer with Direct2D.
+// The device has to be created with D3D11_CREATE_DEVICE_BGRA_SUPPORT.
+class StatsOverlay
+{
+    ID2D1Factory* m_pFactory = NULL;
+    IDWriteFactory* m_pWriteFactory = NULL;
+    IDWriteTextFormat* m_pTextFormat = NULL;
+
+    ID2D1RenderTarget* m_pRenderTarget = NULL;
+    ID2D1SolidColorBrush* m_pTextBrush = NULL;
+    ID2D1SolidColorBrush* m_pBackgroundBrush = NULL;
+
+    // Text is only rebuilt a few times per second, formatting it every frame would cost more than the counters
+    std::wstring m_text;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+
+public:
+    HRESULT Init();
+    void Term();
+
+    // The target references the back buffer and has to be released before the swap chain is resized
+    HRESULT SetTarget(ID3D11Texture2D* pBackBuffer);
+    void ReleaseTarget();
+
+    HRESULT Draw(const RenderStatsHistory& history);
+
+private:
+    void UpdateText(const RenderStatsHistory& history);
+};
@@ -0,0 +1,144 @@
+#include "TransparencySorter.h"
+
+#include <cstring>
+
+uint32_t TransparencySorter::GetKey(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    // Flipping the sign bit of positive and all bits of negative floats makes them compare as unsigned
+    // integers in ascending order, inverting the result turns that into descending depth
+    uint32_t ascending = (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+    return ~ascending;
+}
+
+void TransparencySorter::Reset()
+{
+    m_entries.clear();
+}
+
+const std::vector<TransparencySorter::Entry>& TransparencySorter::Sort(const float* pDepths, size_t count)
+{
+    m_lastMoves = 0;
+    if (m_entries.size() != count)
+    {
+        m_entries.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            m_entries[i] = { GetKey(pDepths[i]), static_cast<uint32_t>(i) };
+        }
+        RadixSort();
+        m_lastMethod = SORT_METHOD::FULL;
+        return m_entries;
+    }
+
+    // New keys in the previous order, counting how often neighbours swapped places
+    size_t disorder = 0;
+    uint32_t prevKey = 0;
+    for (Entry& entry : m_entries)
+    {
+        entry.key = GetKey(pDepths[entry.index]);
+        disorder += entry.key < prevKey ? 1 : 0;
+        prevKey = entry.key;
+    }
+
+    if (disorder == 0)
+    {
+        m_lastMethod = SORT_METHOD::UNCHANGED;
+        return m_entries;
+    }
+    if (disorder * 1000 > count * MaxDisorderPerMille)
+    {
+        RadixSort();
+        m_lastMethod = SORT_METHOD::FULL;
+        return m_entries;
+    }
+
+    // Every misplaced object travels only a few places, unless the camera jumped
+    uint64_t moveBudget = static_cast<uint64_t>(count) * MaxMovesPerObject;
+    uint64_t moves = 0;
+    Entry* pEntries = m_entries.data();
+    for (size_t i = 1; i < count; i++)
+    {
+        if (pEntries[i].key >= pEntries[i - 1].key)
+        {
+            continue;
+        }
+        Entry entry = pEntries[i];
+        size_t j = i;
+        do
+        {
+            pEntries[j] = pEntries[j - 1];
+            j--;
+        } while (j > 0 && pEntries[j - 1].key > entry.key);
+        pEntries[j] = entry;
+
+        moves += i - j;
+        if (moves > moveBudget)
+        {
+            // The order is still a permutation, radix sort takes it from here
+            RadixSort();
+            m_lastMoves = moves;
+            m_lastMethod = SORT_METHOD::FULL;
+            return m_entries;
+        }
+    }
+    m_lastMoves = moves;
+    m_lastMethod = SORT_METHOD::INCREMENTAL;
+    return m_entries;
+}
+
+void TransparencySorter::RadixSort()
+{
+    // Three passes of 11 bits, least significant digit first, each pass is stable
+    const uint32_t DigitBits = 11;
+    const uint32_t BucketCount = 1 << DigitBits;
+    const uint32_t PassCount = 3;
+
+    size_t count = m_entries.size();
+    m_scratch.resize(count);
+
+    // All histograms in a single read of the keys
+    uint32_t histograms[PassCount][BucketCount] = {};
+    for (const Entry& entry : m_entries)
+    {
+        for (uint32_t pass = 0; pass < PassCount; pass++)
+        {
+            histograms[pass][(entry.key >> (pass * DigitBits)) & (BucketCount - 1)]++;
+        }
+    }
+
+    Entry* pSrc = m_entries.data();
+    Entry* pDst = m_scratch.data();
+    for (uint32_t pass = 0; pass < PassCount; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        uint32_t shift = pass * DigitBits;
+
+        // A digit shared by every key leaves the order as it is
+        if (count == 0 || histogram[(pSrc[0].key >> shift) & (BucketCount - 1)] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < BucketCount; bucket++)
+        {
+            uint32_t bucketSize = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketSize;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            pDst[histogram[(pSrc[i].key >> shift) & (BucketCount - 1)]++] = pSrc[i];
+        }
+        Entry* pTemp = pSrc;
+        pSrc = pDst;
+        pDst = pTemp;
+    }
+
+    if (pSrc != m_entries.data())
+    {
+        m_entries.swap(m_scratch);
+    }
+}
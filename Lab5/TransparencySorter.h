@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Keeps the back to front order of objects between frames. With a smoothly moving camera the order
+// barely changes, so the previous order is repaired with an insertion sort; when too much of it is out
+// of place the objects are radix sorted from scratch instead.
+class TransparencySorter
+{
+public:
+    // Adjacent pairs out of order, per mille of the object count, above which repairing is skipped
+    static const uint32_t MaxDisorderPerMille = 60;
+    // Element moves per object the insertion sort may spend before it gives up
+    static const uint32_t MaxMovesPerObject = 4;
+
+    enum class SORT_METHOD
+    {
+        UNCHANGED,
+        INCREMENTAL,
+        FULL
+    };
+
+    struct Entry
+    {
+        // Orders ascending from the farthest object, see GetKey
+        uint32_t key;
+        uint32_t index;
+    };
+
+    // Objects are identified by their index into pDepths, which holds view space depth of all of them.
+    // A different count than in the previous call starts over. Returns the objects farthest first.
+    const std::vector<Entry>& Sort(const float* pDepths, size_t count);
+    // Forgets the previous order
+    void Reset();
+
+    const std::vector<Entry>& GetOrder() const { return m_entries; }
+    SORT_METHOD GetLastMethod() const { return m_lastMethod; }
+    // Element moves done by the last incremental repair
+    uint64_t GetLastMoveCount() const { return m_lastMoves; }
+
+    // Unsigned integer ordering greater depths first, equal depths keep their relative order
+    static uint32_t GetKey(float depth);
+
+private:
+    void RadixSort();
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_scratch;
+    SORT_METHOD m_lastMethod = SORT_METHOD::FULL;
+    uint64_t m_lastMoves = 0;
+};
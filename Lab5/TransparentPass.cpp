@@ -0,0 +1,36 @@
+#include "TransparentPass.h"
+#include "Profiler.h"
+
+void CollectSortedTransparent(const SceneState& state, const Camera& camera, TransparencySorter& sorter,
+    FrameVector<const SceneObject*>& visible, PassStats& passStats)
+{
+    const std::vector<SceneObject>& objects = *state.pTransparentObjects;
+    const PositionsSoA& positions = *state.pTransparentPositions;
+    assert(positions.GetCount() == objects.size());
+
+    // Depths of all objects in one batch, cheaper than testing visibility first
+    FrameVector<float> depths(objects.size());
+    DirectX::XMFLOAT4 depthRow = camera.GetViewDepthRow();
+    ComputeViewDepths(positions, &depthRow.x, depths.data());
+
+    // Culled objects stay in the order too, so it remains valid for the next frame whatever becomes visible
+    const std::vector<TransparencySorter::Entry>* pOrder = nullptr;
+    {
+        PROFILE_SCOPE("SortTransparent");
+        pOrder = &sorter.Sort(depths.data(), depths.size());
+    }
+
+    visible.clear();
+    visible.reserve(objects.size());
+    const Frustum& frustum = camera.GetFrustum();
+    for (const TransparencySorter::Entry& entry : *pOrder)
+    {
+        const SceneObject& object = objects[entry.index];
+        if (!frustum.IsSphereVisible(DirectX::XMLoadFloat3(&object.position), CubeBoundingRadius))
+        {
+            passStats.culledObjects++;
+            continue;
+        }
+        visible.push_back(&object);
+    }
+}
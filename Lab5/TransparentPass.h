@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Scene.h"
+#include "TransparencySorter.h"
+#include "RenderStats.h"
+#include "FrameArena.h"
+
+// Cubes span [-1, 1] on every axis
+const float CubeBoundingRadius = 1.7320508f;
+
+// Transparent objects of the state inside the frustum of the camera, back to front. Depths of all objects are computed
+// in one batch and ordered by the sorter, culled ones are counted in passStats. Only the submission of the result
+// depends on the graphics API, so the renderer and the headless benchmark share this part of the pass.
+void CollectSortedTransparent(const SceneState& state, const Camera& camera, TransparencySorter& sorter,
+    FrameVector<const SceneObject*>& visible, PassStats& passStats);
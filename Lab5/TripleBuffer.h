@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer handoff of the latest value.
+// Producer and consumer own one slot each and swap it with the shared middle slot,
+// so neither side ever waits and the consumer always sees the most recent published value.
+template <typename T>
+class TripleBuffer
+{
+    static const unsigned IndexMask = 0x3;
+    static const unsigned NewDataBit = 0x4;
+
+    T m_buffers[3];
+    std::atomic<unsigned> m_middle;
+    unsigned m_back = 0;
+    unsigned m_front = 1;
+
+public:
+    TripleBuffer() : m_middle(2) { }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& GetWriteBuffer() { return m_buffers[m_back]; }
+
+    void Publish()
+    {
+        unsigned prev = m_middle.exchange(m_back | NewDataBit, std::memory_order_acq_rel);
+        m_back = prev & IndexMask;
+    }
+
+    // Consumer side, returns false if nothing was published since the last call
+    bool Acquire()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & NewDataBit) == 0)
+        {
+            return false;
+        }
+        unsigned prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & IndexMask;
+        return true;
+    }
+
+    const T& GetReadBuffer() const { return m_buffers[m_front]; }
+};
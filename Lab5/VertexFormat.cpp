@@ -0,0 +1,458 @@
+#include "VertexFormat.h"
+#include "ProceduralMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Round to nearest leaves at most half a unit in the last place of the 11-bit significand
+    const float HalfRelativeError = 1.0f / 2048.0f;
+    const float HalfMax = 65504.0f;
+
+    float Length(float x, float y, float z)
+    {
+        return sqrtf(x * x + y * y + z * z);
+    }
+
+    float SignNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    template <typename T>
+    void Store(uint8_t* pDst, const T* pValues, size_t count)
+    {
+        memcpy(pDst, pValues, count * sizeof(T));
+    }
+
+    template <typename T>
+    void Load(const uint8_t* pSrc, T* pValues, size_t count)
+    {
+        memcpy(pValues, pSrc, count * sizeof(T));
+    }
+
+    float GetMaxAbsUv(const MeshData& mesh, bool& isUnitRange)
+    {
+        float maxAbs = 0.0f;
+        isUnitRange = true;
+        for (float uv : mesh.uvs)
+        {
+            maxAbs = std::max(maxAbs, fabsf(uv));
+            isUnitRange = isUnitRange && uv >= 0.0f && uv <= 1.0f;
+        }
+        return maxAbs;
+    }
+}
+
+uint32_t VertexFormat::GetPositionSize() const
+{
+    return position == POSITION_FORMAT::FLOAT3 ? 12 : 8;
+}
+
+uint32_t VertexFormat::GetNormalSize() const
+{
+    switch (normal)
+    {
+    case NORMAL_FORMAT::FLOAT3:
+        return 12;
+    case NORMAL_FORMAT::OCTAHEDRAL_SNORM16:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint32_t VertexFormat::GetUvSize() const
+{
+    switch (uv)
+    {
+    case UV_FORMAT::FLOAT2:
+        return 8;
+    case UV_FORMAT::UNORM16:
+    case UV_FORMAT::HALF:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000)
+    {
+        // Infinity stays infinity, NaN stays a quiet NaN
+        return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x0200 : 0);
+    }
+    if (magnitude >= 0x477FF000)
+    {
+        // Rounds to 65520 or more
+        return sign | 0x7C00;
+    }
+    if (magnitude < 0x38800000)
+    {
+        // Subnormal half, in units of 2^-24
+        uint32_t exponent = magnitude >> 23;
+        uint32_t shift = 126 - exponent;
+        if (shift > 24)
+        {
+            return sign;
+        }
+        uint32_t mantissa = (magnitude & 0x007FFFFF) | 0x00800000;
+        uint32_t result = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (result & 1)))
+        {
+            result++;
+        }
+        return sign | static_cast<uint16_t>(result);
+    }
+
+    // Rebias the exponent and round the mantissa to nearest even, a carry moves into the exponent correctly
+    uint32_t result = (magnitude - 0x38000000) >> 13;
+    uint32_t remainder = magnitude & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+    {
+        result++;
+    }
+    return sign | static_cast<uint16_t>(result);
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x03FF;
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+        float result = ldexpf(float(mantissa), -24);
+        return sign != 0 ? -result : result;
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+int16_t EncodeSnorm16(float value)
+{
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<int16_t>(lrintf(value * 32767.0f));
+}
+
+float DecodeSnorm16(int16_t value)
+{
+    // -32768 and -32767 both decode to -1, as the input assembler does it
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+uint16_t EncodeUnorm16(float value)
+{
+    value = std::max(0.0f, std::min(1.0f, value));
+    return static_cast<uint16_t>(lrintf(value * 65535.0f));
+}
+
+float DecodeUnorm16(uint16_t value)
+{
+    return value / 65535.0f;
+}
+
+void EncodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+    float l1 = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    float x = l1 > 0.0f ? normal[0] / l1 : 0.0f;
+    float y = l1 > 0.0f ? normal[1] / l1 : 0.0f;
+    if (normal[2] < 0.0f)
+    {
+        // Lower hemisphere folds over the diagonals
+        float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+        float foldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = EncodeSnorm16(x);
+    encoded[1] = EncodeSnorm16(y);
+}
+
+void DecodeOctahedral(const int16_t encoded[2], float normal[3])
+{
+    float x = DecodeSnorm16(encoded[0]);
+    float y = DecodeSnorm16(encoded[1]);
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f)
+    {
+        float unfoldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+        float unfoldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    float length = Length(x, y, z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+float GetPositionErrorBound(POSITION_FORMAT format, const MeshBounds& bounds)
+{
+    float halfExtent[3];
+    float maxAbs[3];
+    for (int i = 0; i < 3; i++)
+    {
+        halfExtent[i] = (bounds.max[i] - bounds.min[i]) * 0.5f;
+        maxAbs[i] = std::max(fabsf(bounds.min[i]), fabsf(bounds.max[i]));
+    }
+    float maxAbsLength = Length(maxAbs[0], maxAbs[1], maxAbs[2]);
+
+    switch (format)
+    {
+    case POSITION_FORMAT::SNORM16:
+        // Half a step of the grid spanning the bounds, plus the float rounding of the decode
+        return Length(halfExtent[0], halfExtent[1], halfExtent[2]) * (0.5f / 32767.0f) + maxAbsLength * 4.0f * FLT_EPSILON;
+    case POSITION_FORMAT::HALF:
+        if (std::max(maxAbs[0], std::max(maxAbs[1], maxAbs[2])) >= HalfMax)
+        {
+            return FLT_MAX;
+        }
+        // Relative rounding for normal values, half the smallest subnormal below them
+        return maxAbsLength * HalfRelativeError + 1.0f / (1 << 24);
+    default:
+        return 0.0f;
+    }
+}
+
+float GetNormalErrorBound(NORMAL_FORMAT format)
+{
+    return format == NORMAL_FORMAT::OCTAHEDRAL_SNORM16 ? OctahedralSnorm16MaxError : 0.0f;
+}
+
+float GetUvErrorBound(UV_FORMAT format, float maxAbsUv)
+{
+    switch (format)
+    {
+    case UV_FORMAT::UNORM16:
+        return 0.5f / 65535.0f + 2.0f * FLT_EPSILON;
+    case UV_FORMAT::HALF:
+        return maxAbsUv >= HalfMax ? FLT_MAX : maxAbsUv * HalfRelativeError + 1.0f / (1 << 24);
+    default:
+        return 0.0f;
+    }
+}
+
+VertexFormat ChooseVertexFormat(const MeshData& mesh, const VertexRequirements& requirements)
+{
+    VertexFormat format;
+
+    format.position = POSITION_FORMAT::FLOAT3;
+    if (requirements.maxPositionError > 0.0f)
+    {
+        if (GetPositionErrorBound(POSITION_FORMAT::SNORM16, mesh.bounds) <= requirements.maxPositionError)
+        {
+            format.position = POSITION_FORMAT::SNORM16;
+        }
+        else if (GetPositionErrorBound(POSITION_FORMAT::HALF, mesh.bounds) <= requirements.maxPositionError)
+        {
+            format.position = POSITION_FORMAT::HALF;
+        }
+    }
+
+    format.normal = NORMAL_FORMAT::NONE;
+    if (requirements.normals && !mesh.normals.empty())
+    {
+        bool isCompact = requirements.maxNormalError > 0.0f && GetNormalErrorBound(NORMAL_FORMAT::OCTAHEDRAL_SNORM16) <= requirements.maxNormalError;
+        format.normal = isCompact ? NORMAL_FORMAT::OCTAHEDRAL_SNORM16 : NORMAL_FORMAT::FLOAT3;
+    }
+
+    format.uv = UV_FORMAT::NONE;
+    if (requirements.uvs && !mesh.uvs.empty())
+    {
+        format.uv = UV_FORMAT::FLOAT2;
+        if (requirements.maxUvError > 0.0f)
+        {
+            bool isUnitRange = false;
+            float maxAbsUv = GetMaxAbsUv(mesh, isUnitRange);
+            if (isUnitRange && GetUvErrorBound(UV_FORMAT::UNORM16, maxAbsUv) <= requirements.maxUvError)
+            {
+                format.uv = UV_FORMAT::UNORM16;
+            }
+            else if (GetUvErrorBound(UV_FORMAT::HALF, maxAbsUv) <= requirements.maxUvError)
+            {
+                format.uv = UV_FORMAT::HALF;
+            }
+        }
+    }
+
+    return format;
+}
+
+void EncodeVertices(const MeshData& mesh, const VertexFormat& format, EncodedVertices& result)
+{
+    size_t vertexCount = mesh.GetVertexCount();
+    uint32_t stride = format.GetStride();
+    result.format = format;
+    result.vertexCount = vertexCount;
+    result.data.assign(vertexCount * stride, 0);
+    result.decode = VertexDecode();
+
+    // Snorm positions span the bounds, a flat axis keeps a unit scale so it still decodes to its single value
+    float invScale[3] = { 1.0f, 1.0f, 1.0f };
+    if (format.position == POSITION_FORMAT::SNORM16)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            float halfExtent = (mesh.bounds.max[i] - mesh.bounds.min[i]) * 0.5f;
+            result.decode.positionOffset[i] = (mesh.bounds.max[i] + mesh.bounds.min[i]) * 0.5f;
+            result.decode.positionScale[i] = halfExtent > 0.0f ? halfExtent : 1.0f;
+            invScale[i] = 1.0f / result.decode.positionScale[i];
+        }
+    }
+
+    bool hasNormals = !mesh.normals.empty();
+    bool hasUvs = !mesh.uvs.empty();
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        uint8_t* pVertex = result.data.data() + vertex * stride;
+        const float* pPosition = &mesh.positions[vertex * 3];
+
+        switch (format.position)
+        {
+        case POSITION_FORMAT::FLOAT3:
+            Store(pVertex, pPosition, 3);
+            break;
+        case POSITION_FORMAT::SNORM16:
+        {
+            int16_t encoded[4];
+            for (int i = 0; i < 3; i++)
+            {
+                encoded[i] = EncodeSnorm16((pPosition[i] - result.decode.positionOffset[i]) * invScale[i]);
+            }
+            encoded[3] = 32767;
+            Store(pVertex, encoded, 4);
+            break;
+        }
+        case POSITION_FORMAT::HALF:
+        {
+            uint16_t encoded[4] = { FloatToHalf(pPosition[0]), FloatToHalf(pPosition[1]), FloatToHalf(pPosition[2]), FloatToHalf(1.0f) };
+            Store(pVertex, encoded, 4);
+            break;
+        }
+        }
+
+        uint8_t* pNormal = pVertex + format.GetNormalOffset();
+        const float DefaultNormal[3] = { 0.0f, 1.0f, 0.0f };
+        const float* pSrcNormal = hasNormals ? &mesh.normals[vertex * 3] : DefaultNormal;
+        if (format.normal == NORMAL_FORMAT::FLOAT3)
+        {
+            Store(pNormal, pSrcNormal, 3);
+        }
+        else if (format.normal == NORMAL_FORMAT::OCTAHEDRAL_SNORM16)
+        {
+            int16_t encoded[2];
+            EncodeOctahedral(pSrcNormal, encoded);
+            Store(pNormal, encoded, 2);
+        }
+
+        uint8_t* pUv = pVertex + format.GetUvOffset();
+        const float DefaultUv[2] = { 0.0f, 0.0f };
+        const float* pSrcUv = hasUvs ? &mesh.uvs[vertex * 2] : DefaultUv;
+        if (format.uv == UV_FORMAT::FLOAT2)
+        {
+            Store(pUv, pSrcUv, 2);
+        }
+        else if (format.uv == UV_FORMAT::UNORM16)
+        {
+            uint16_t encoded[2] = { EncodeUnorm16(pSrcUv[0]), EncodeUnorm16(pSrcUv[1]) };
+            Store(pUv, encoded, 2);
+        }
+        else if (format.uv == UV_FORMAT::HALF)
+        {
+            uint16_t encoded[2] = { FloatToHalf(pSrcUv[0]), FloatToHalf(pSrcUv[1]) };
+            Store(pUv, encoded, 2);
+        }
+    }
+}
+
+void DecodeVertex(const EncodedVertices& vertices, size_t index, float position[3], float normal[3], float uv[2])
+{
+    const VertexFormat& format = vertices.format;
+    const uint8_t* pVertex = vertices.data.data() + index * format.GetStride();
+
+    float stored[3];
+    switch (format.position)
+    {
+    case POSITION_FORMAT::FLOAT3:
+        Load(pVertex, stored, 3);
+        break;
+    case POSITION_FORMAT::SNORM16:
+    {
+        int16_t encoded[3];
+        Load(pVertex, encoded, 3);
+        for (int i = 0; i < 3; i++)
+        {
+            stored[i] = DecodeSnorm16(encoded[i]);
+        }
+        break;
+    }
+    case POSITION_FORMAT::HALF:
+    {
+        uint16_t encoded[3];
+        Load(pVertex, encoded, 3);
+        for (int i = 0; i < 3; i++)
+        {
+            stored[i] = HalfToFloat(encoded[i]);
+        }
+        break;
+    }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        position[i] = stored[i] * vertices.decode.positionScale[i] + vertices.decode.positionOffset[i];
+    }
+
+    const uint8_t* pNormal = pVertex + format.GetNormalOffset();
+    if (format.normal == NORMAL_FORMAT::FLOAT3)
+    {
+        Load(pNormal, normal, 3);
+    }
+    else if (format.normal == NORMAL_FORMAT::OCTAHEDRAL_SNORM16)
+    {
+        int16_t encoded[2];
+        Load(pNormal, encoded, 2);
+        DecodeOctahedral(encoded, normal);
+    }
+
+    const uint8_t* pUv = pVertex + format.GetUvOffset();
+    if (format.uv == UV_FORMAT::FLOAT2)
+    {
+        Load(pUv, uv, 2);
+    }
+    else if (format.uv == UV_FORMAT::UNORM16)
+    {
+        uint16_t encoded[2];
+        Load(pUv, encoded, 2);
+        uv[0] = DecodeUnorm16(encoded[0]);
+        uv[1] = DecodeUnorm16(encoded[1]);
+    }
+    else if (format.uv == UV_FORMAT::HALF)
+    {
+        uint16_t encoded[2];
+        Load(pUv, encoded, 2);
+        uv[0] = HalfToFloat(encoded[0]);
+        uv[1] = HalfToFloat(encoded[1]);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshData;
+struct MeshBounds;
+
+enum class POSITION_FORMAT
+{
+    FLOAT3,
+    // Four 16-bit snorm components relative to the mesh bounds, w is 1
+    SNORM16,
+    // Four half floats, w is 1
+    HALF
+};
+
+enum class NORMAL_FORMAT
+{
+    NONE,
+    FLOAT3,
+    // Unit vector projected onto an octahedron and unfolded into two 16-bit snorm components
+    OCTAHEDRAL_SNORM16
+};
+
+enum class UV_FORMAT
+{
+    NONE,
+    FLOAT2,
+    // Two 16-bit unorm components, only for coordinates within [0, 1]
+    UNORM16,
+    HALF
+};
+
+// Attributes are interleaved in this order, each starting at a multiple of four bytes
+struct VertexFormat
+{
+    POSITION_FORMAT position = POSITION_FORMAT::FLOAT3;
+    NORMAL_FORMAT normal = NORMAL_FORMAT::NONE;
+    UV_FORMAT uv = UV_FORMAT::FLOAT2;
+
+    uint32_t GetStride() const { return GetNormalOffset() + GetNormalSize() + GetUvSize(); }
+    uint32_t GetNormalOffset() const { return GetPositionSize(); }
+    uint32_t GetUvOffset() const { return GetNormalOffset() + GetNormalSize(); }
+
+    uint32_t GetPositionSize() const;
+    uint32_t GetNormalSize() const;
+    uint32_t GetUvSize() const;
+};
+
+// What a mesh is drawn with and the largest errors it tolerates, zero keeps full precision
+struct VertexRequirements
+{
+    bool normals = false;
+    bool uvs = true;
+    // In mesh units
+    float maxPositionError = 0.0f;
+    // Radians
+    float maxNormalError = 0.0f;
+    float maxUvError = 0.0f;
+};
+
+// Maps stored positions back to mesh space: position * scale + offset. Matches MeshDecodeBuffer in the shaders.
+struct VertexDecode
+{
+    float positionScale[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    float positionOffset[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+struct EncodedVertices
+{
+    VertexFormat format;
+    size_t vertexCount = 0;
+    std::vector<uint8_t> data;
+    VertexDecode decode;
+
+    size_t GetSize() const { return data.size(); }
+};
+
+// Octahedral encoding loses at most this angle, rounding included
+const float OctahedralSnorm16MaxError = 1.0e-4f;
+
+// Tolerances of the compact vertex precision: a fraction of the mesh radius, radians and texture units
+const float CompactPositionTolerance = 1.0e-4f;
+const float CompactNormalTolerance = 1.0e-3f;
+const float CompactUvTolerance = 1.0f / 8192.0f;
+
+// Most compact format per attribute whose worst case error on this mesh stays within the requirements
+VertexFormat ChooseVertexFormat(const MeshData& mesh, const VertexRequirements& requirements);
+void EncodeVertices(const MeshData& mesh, const VertexFormat& format, EncodedVertices& result);
+// CPU mirror of the input assembler conversion and the shader decode, attributes missing from the format are left alone
+void DecodeVertex(const EncodedVertices& vertices, size_t index, float position[3], float normal[3], float uv[2]);
+
+// Worst case errors the formats introduce for a mesh with these bounds and texture coordinate magnitude
+float GetPositionErrorBound(POSITION_FORMAT format, const MeshBounds& bounds);
+float GetNormalErrorBound(NORMAL_FORMAT format);
+float GetUvErrorBound(UV_FORMAT format, float maxAbsUv);
+
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+int16_t EncodeSnorm16(float value);
+float DecodeSnorm16(int16_t value);
+uint16_t EncodeUnorm16(float value);
+float DecodeUnorm16(uint16_t value);
+void EncodeOctahedral(const float normal[3], int16_t encoded[2]);
+void DecodeOctahedral(const int16_t encoded[2], float normal[3]);
@@ -0,0 +1,126 @@
+#include "ViewDepth.h"
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX_FUNCTION
+#else
+// GCC and Clang only emit AVX instructions in functions that ask for them
+#define AVX_FUNCTION __attribute__((target("avx")))
+#endif
+
+void PositionsSoA::Reserve(size_t count)
+{
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+}
+
+void PositionsSoA::Clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+void PositionsSoA::PushBack(float px, float py, float pz)
+{
+    x.push_back(px);
+    y.push_back(py);
+    z.push_back(pz);
+}
+
+void ComputeViewDepthsScalar(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        // Same order of operations as the vector versions, so all of them agree bit for bit
+        pDepths[i] = row[3] + row[0] * pX[i] + row[1] * pY[i] + row[2] * pZ[i];
+    }
+}
+
+void ComputeViewDepthsSse(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths)
+{
+    __m128 rowX = _mm_set1_ps(row[0]);
+    __m128 rowY = _mm_set1_ps(row[1]);
+    __m128 rowZ = _mm_set1_ps(row[2]);
+    __m128 rowW = _mm_set1_ps(row[3]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 depth = _mm_add_ps(rowW, _mm_mul_ps(rowX, _mm_loadu_ps(pX + i)));
+        depth = _mm_add_ps(depth, _mm_mul_ps(rowY, _mm_loadu_ps(pY + i)));
+        depth = _mm_add_ps(depth, _mm_mul_ps(rowZ, _mm_loadu_ps(pZ + i)));
+        _mm_storeu_ps(pDepths + i, depth);
+    }
+    ComputeViewDepthsScalar(pX + i, pY + i, pZ + i, count - i, row, pDepths + i);
+}
+
+AVX_FUNCTION void ComputeViewDepthsAvx(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths)
+{
+    __m256 rowX = _mm256_set1_ps(row[0]);
+    __m256 rowY = _mm256_set1_ps(row[1]);
+    __m256 rowZ = _mm256_set1_ps(row[2]);
+    __m256 rowW = _mm256_set1_ps(row[3]);
+
+    // Two independent vectors per iteration hide the latency of the dependent adds
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256 depth0 = _mm256_add_ps(rowW, _mm256_mul_ps(rowX, _mm256_loadu_ps(pX + i)));
+        __m256 depth1 = _mm256_add_ps(rowW, _mm256_mul_ps(rowX, _mm256_loadu_ps(pX + i + 8)));
+        depth0 = _mm256_add_ps(depth0, _mm256_mul_ps(rowY, _mm256_loadu_ps(pY + i)));
+        depth1 = _mm256_add_ps(depth1, _mm256_mul_ps(rowY, _mm256_loadu_ps(pY + i + 8)));
+        depth0 = _mm256_add_ps(depth0, _mm256_mul_ps(rowZ, _mm256_loadu_ps(pZ + i)));
+        depth1 = _mm256_add_ps(depth1, _mm256_mul_ps(rowZ, _mm256_loadu_ps(pZ + i + 8)));
+        _mm256_storeu_ps(pDepths + i, depth0);
+        _mm256_storeu_ps(pDepths + i + 8, depth1);
+    }
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 depth = _mm256_add_ps(rowW, _mm256_mul_ps(rowX, _mm256_loadu_ps(pX + i)));
+        depth = _mm256_add_ps(depth, _mm256_mul_ps(rowY, _mm256_loadu_ps(pY + i)));
+        depth = _mm256_add_ps(depth, _mm256_mul_ps(rowZ, _mm256_loadu_ps(pZ + i)));
+        _mm256_storeu_ps(pDepths + i, depth);
+    }
+    // Avoids the transition penalty when the SSE tail runs on older CPUs
+    _mm256_zeroupper();
+    ComputeViewDepthsSse(pX + i, pY + i, pZ + i, count - i, row, pDepths + i);
+}
+
+namespace
+{
+    bool DetectAvx()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        // The OS must save the upper halves of the registers on context switches
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+        return __builtin_cpu_supports("avx") != 0;
+#endif
+    }
+}
+
+bool IsAvxSupported()
+{
+    static const bool IsSupported = DetectAvx();
+    return IsSupported;
+}
+
+void ComputeViewDepths(const PositionsSoA& positions, const float row[4], float* pDepths)
+{
+    size_t count = positions.GetCount();
+    if (IsAvxSupported())
+    {
+        ComputeViewDepthsAvx(positions.x.data(), positions.y.data(), positions.z.data(), count, row, pDepths);
+    }
+    else
+    {
+        ComputeViewDepthsSse(positions.x.data(), positions.y.data(), positions.z.data(), count, row, pDepths);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Object positions as separate coordinate arrays, so batched kernels load several objects per instruction
+struct PositionsSoA
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    size_t GetCount() const { return x.size(); }
+    void Reserve(size_t count);
+    void Clear();
+    void PushBack(float px, float py, float pz);
+};
+
+// View space depth of every position: depths[i] = row[0] * x[i] + row[1] * y[i] + row[2] * z[i] + row[3],
+// where row is the depth column of a row-vector view matrix. Picks the widest instruction set the CPU supports.
+void ComputeViewDepths(const PositionsSoA& positions, const float row[4], float* pDepths);
+
+// Fixed instruction set variants, exposed for validation and benchmarks
+void ComputeViewDepthsScalar(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths);
+void ComputeViewDepthsSse(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths);
+// Must only be called when IsAvxSupported returns true
+void ComputeViewDepthsAvx(const float* pX, const float* pY, const float* pZ, size_t count, const float row[4], float* pDepths);
+bool IsAvxSupported();
@@ -0,0 +1,54 @@
+#include "WeightedBlendedOit.h"
+
+#include <algorithm>
+#include <cmath>
+
+float GetOitWeight(float viewDepth, float alpha)
+{
+    // Equation 7 of the paper, tuned for depths up to a few hundred units. The clamp keeps the sums
+    // within half float range of the accumulation target.
+    float weight = 10.0f / (1e-5f + powf(viewDepth / 5.0f, 2.0f) + powf(viewDepth / 200.0f, 6.0f));
+    return alpha * std::max(1e-2f, std::min(3e3f, weight));
+}
+
+void OitPixel::AddFragment(const OitFragment& fragment)
+{
+    float weight = GetOitWeight(fragment.viewDepth, fragment.alpha);
+    for (int i = 0; i < 3; i++)
+    {
+        accum[i] += fragment.color[i] * fragment.alpha * weight;
+    }
+    accum[3] += fragment.alpha * weight;
+    revealage *= 1.0f - fragment.alpha;
+}
+
+void OitPixel::Composite(const float background[3], float result[3]) const
+{
+    float coverage = 1.0f - revealage;
+    for (int i = 0; i < 3; i++)
+    {
+        float average = accum[i] / std::max(accum[3], 1e-5f);
+        result[i] = average * coverage + background[i] * revealage;
+    }
+}
+
+void BlendSortedFragments(OitFragment* pFragments, size_t count, const float background[3], float result[3])
+{
+    std::sort(pFragments, pFragments + count, [](const OitFragment& a, const OitFragment& b)
+        {
+            return a.viewDepth > b.viewDepth;
+        });
+
+    for (int i = 0; i < 3; i++)
+    {
+        result[i] = background[i];
+    }
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        const OitFragment& fragment = pFragments[idx];
+        for (int i = 0; i < 3; i++)
+        {
+            result[i] = fragment.color[i] * fragment.alpha + result[i] * (1.0f - fragment.alpha);
+        }
+    }
+}
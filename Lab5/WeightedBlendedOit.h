@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// CPU reference of weighted blended order-independent transparency (McGuire and Bavoil, 2013).
+// Fragments accumulate in any order into a weighted sum of premultiplied colors and the product of
+// their transmittance; the composite resolves the weighted average over the background.
+
+// Depth weight of a fragment, must match OitWeight in WeightedBlendedOit_PS.hlsl
+float GetOitWeight(float viewDepth, float alpha);
+
+struct OitFragment
+{
+    float color[3];
+    float alpha;
+    float viewDepth;
+};
+
+// One pixel of the accumulation and revealage targets
+struct OitPixel
+{
+    // Weighted sum of premultiplied color in rgb and of alpha in a
+    float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    // Product of (1 - alpha), the share of the background that stays visible
+    float revealage = 1.0f;
+
+    void AddFragment(const OitFragment& fragment);
+    // Same math as the composite pass blended over the back buffer
+    void Composite(const float background[3], float result[3]) const;
+};
+
+// Exact result of blending the fragments back to front over the background, what the sorted path renders
+// per pixel when the sort order is right. Sorts the fragments in place.
+void BlendSortedFragments(OitFragment* pFragments, size_t count, const float background[3], float result[3]);
@@ -0,0 +1,37 @@
+Texture2D colorTexture : register (t0);
+
+SamplerState colorSampler : register(s0);
+
+struct VSOutput
+{
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+    float viewDepth : VIEWDEPTH;
+};
+
+struct PSOutput
+{
+    // Blended additively
+    float4 accum : SV_Target0;
+    // Blended as dst * (1 - src)
+    float revealage : SV_Target1;
+};
+
+// Must match GetOitWeight in WeightedBlendedOit.cpp
+float OitWeight(float viewDepth, float alpha)
+{
+    float weight = 10.0 / (1e-5 + pow(viewDepth / 5.0, 2.0) + pow(viewDepth / 200.0, 6.0));
+    return alpha * clamp(weight, 1e-2, 3e3);
+}
+
+PSOutput ps(VSOutput pixel)
+{
+    float4 color = float4(colorTexture.Sample(colorSampler, pixel.uv).xyz, 1.0) * pixel.color;
+    float weight = OitWeight(pixel.viewDepth, color.a);
+
+    PSOutput result;
+    result.accum = float4(color.rgb * color.a, color.a) * weight;
+    result.revealage = color.a;
+    return result;
+}
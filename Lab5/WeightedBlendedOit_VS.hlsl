@@ -0,0 +1,41 @@
+cbuffer ViewTransformsBuffer : register (b0)
+{
+    float4x4 vp;
+};
+
+cbuffer MeshDecodeBuffer : register (b2)
+{
+    float4 positionScale;
+    float4 positionOffset;
+};
+
+struct VSInput
+{
+    float3 pos : POSITION;
+    float2 uv : TEXCOORD;
+    // Per instance, cubes are only translated
+    float3 instancePos : INSTANCEPOS;
+    float4 instanceColor : INSTANCECOLOR;
+};
+
+struct VSOutput
+{
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+    float viewDepth : VIEWDEPTH;
+};
+
+VSOutput vs(VSInput vertex)
+{
+    VSOutput result;
+
+    float3 pos = vertex.pos * positionScale.xyz + positionOffset.xyz;
+    result.pos = mul(vp, float4(pos + vertex.instancePos, 1.0));
+    result.uv = vertex.uv;
+    result.color = vertex.instanceColor;
+    // Clip space w of a perspective projection is the view space depth
+    result.viewDepth = result.pos.w;
+
+    return result;
+}
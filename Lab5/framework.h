@@ -15,6 +15,7 @@
 #include <tchar.h>
 #include <assert.h>
 #include <thread>
+#include <chrono>
 #include <string>
 #include <vector>
 #define _USE_MATH_DEFINES